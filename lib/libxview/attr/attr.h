@@ -203,6 +203,40 @@
  */
 #define	ATTR_NOP(attr)		(ATTR_CODE(attr) | (0x1 << 12))
 #define	ATTR_CONSUME(attr)	(attr) = ((Xv_opaque)ATTR_NOP(attr))
+#define	ATTR_UNCONSUME(attr)	\
+	(attr) = ((Xv_opaque) (ATTR_CODE(attr) & ~(0x1 << 12)))
+
+/*
+ * Building a flat avlist in place, without varargs, for xv_set_frozen():
+ *
+ *	Attr_attribute	avlist[ATTR_STANDARD_SIZE];
+ *	Attr_avlist	ap = avlist;
+ *
+ *	ATTR_PUT2(ap, PANEL_LIST_STRING, row, string);
+ *	ATTR_PUT2(ap, PANEL_LIST_CLIENT_DATA, row, data);
+ *	ATTR_PUT_END(ap);
+ *
+ * attr must be a constant that takes exactly that many values, or the
+ * array in ATTR_CHECK_VALUES has a negative size and the compile fails.
+ */
+#define ATTR_CHECK_VALUES(attr, n)	\
+	((void) sizeof(char[(ATTR_LIST_TYPE(attr) == ATTR_NONE && \
+			     ATTR_CARDINALITY(attr) == (n)) ? 1 : -1]))
+
+#define ATTR_PUT0(ap, attr)	\
+	(ATTR_CHECK_VALUES(attr, 0), *(ap)++ = (Attr_attribute) (attr))
+#define ATTR_PUT1(ap, attr, v1)	\
+	(ATTR_CHECK_VALUES(attr, 1), (ap)[0] = (Attr_attribute) (attr), \
+	 (ap)[1] = (Attr_attribute) (v1), (ap) += 2)
+#define ATTR_PUT2(ap, attr, v1, v2)	\
+	(ATTR_CHECK_VALUES(attr, 2), (ap)[0] = (Attr_attribute) (attr), \
+	 (ap)[1] = (Attr_attribute) (v1), (ap)[2] = (Attr_attribute) (v2), \
+	 (ap) += 3)
+#define ATTR_PUT3(ap, attr, v1, v2, v3)	\
+	(ATTR_CHECK_VALUES(attr, 3), (ap)[0] = (Attr_attribute) (attr), \
+	 (ap)[1] = (Attr_attribute) (v1), (ap)[2] = (Attr_attribute) (v2), \
+	 (ap)[3] = (Attr_attribute) (v3), (ap) += 4)
+#define ATTR_PUT_END(ap)	(*(ap) = (Attr_attribute) 0)
 
 /*
  * For Sunview 1 compatibility
@@ -453,6 +487,9 @@ typedef union {
 #define attr_create_list(...) \
     MACRO_DEF1(_attr_create_list, Attr_attribute, __VA_ARGS__)
 
+#define attr_freeze(...) \
+    MACRO_DEF1(_attr_freeze, Attr_attribute, __VA_ARGS__)
+
 /*
  ***********************************************************************
  *			Globals
@@ -463,5 +500,6 @@ typedef union {
  * Public Functions
  */
 EXTERN_FUNCTION (Attr_avlist _attr_create_list, (Attr_attribute attr1, DOTDOTDOT));
+EXTERN_FUNCTION (Attr_avlist _attr_freeze, (Attr_attribute attr1, DOTDOTDOT));
 
 #endif /* xview_attr_DEFINED */
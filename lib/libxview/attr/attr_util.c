@@ -39,6 +39,29 @@ va_dcl
     return avlist;
 }
 
+/*
+ * attr_freeze makes a flat avlist from the VARARGS, with recursive lists
+ * collapsed inline, in storage of exactly its size.  The result can be
+ * patched through attr_find() and applied repeatedly with xv_set_frozen().
+ */
+Attr_avlist
+#ifdef ANSI_FUNC_PROTO
+_attr_freeze(Attr_attribute attr1, ...)
+#else
+_attr_freeze(attr1, va_alist)
+    Attr_attribute attr1;
+va_dcl
+#endif
+{
+    va_list         valist;
+    Attr_avlist     avlist;
+
+    VA_START(valist, attr1);
+    avlist = copy_va_to_av( valist, (Attr_avlist) NULL, attr1 );
+    va_end(valist);
+    return avlist;
+}
+
 /*
  * attr_find searches and avlist for the first occurrence of a specified
  * attribute.
@@ -4,6 +4,7 @@
 #include <xview_private/attr_.h>
 
 Attr_avlist _attr_create_list(Attr_attribute attr1, ...);
+Attr_avlist _attr_freeze(Attr_attribute attr1, ...);
 Attr_avlist attr_find(register Attr_avlist attrs, register Attr_attribute attr);
 
 #endif
@@ -20,21 +20,35 @@ static char     sccsid[] = "@(#)gen_impl.h 1.4 93/06/28";
 
 #define GEN_PUBLIC(obj)		XV_PUBLIC(obj)
 #define GEN_PRIVATE(obj)	XV_PRIVATE(Generic_info, Xv_generic_struct, obj)
-#define HEAD(obj)		(GEN_PRIVATE(obj))->key_data
+
+/*
+ * Key data is kept in an open-addressed table of node pointers.  The first
+ * GEN_KEY_INLINE keys live in key_inline inside the object and are searched
+ * in order; past that key_data is a hash of key_size slots (a power of 2),
+ * probed linearly and never more than half full.  Neither keeps insertion
+ * order, so each node records when it was added: remove procs run newest
+ * first at destroy, as they did when key data was a list.
+ */
+#define GEN_KEY_INLINE		4
+#define GEN_KEY_HASH_MIN	16
 
 typedef struct _generic_node {
-    struct _generic_node *next;
     Attr_attribute  key;
     Xv_opaque       data;
     void            (*copy_proc) ();
     void            (*remove_proc) ();
+    unsigned        seq;		/* order of addition */
 }Generic_node;
 
 typedef	struct	{
     Xv_object		public_self;	/* back pointer to object */
     Xv_object		owner;		/* owner of object */
 
-    Generic_node	*key_data;
+    Generic_node	**key_data;	/* key_inline or the hash */
+    int			key_count;
+    int			key_size;
+    unsigned		key_seq;	/* seq of the next node added */
+    Generic_node	*key_inline[GEN_KEY_INLINE];
     Xv_opaque		instance_qlist;
     char		*instance_name;
 } Generic_info;
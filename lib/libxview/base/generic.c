@@ -47,8 +47,19 @@ static Attr_attribute xv_next_key;	/* = 0 for -A-R */
 
 static void generic_data_free(Xv_object object, Attr_attribute key, Xv_opaque data);
 static Generic_node *add_node(Xv_object object, Attr_attribute key);
-static Generic_node *find_node(register Xv_object object, register Attr_attribute key, register Generic_node **prev);
-static void delete_node(Xv_object object, register Generic_node *node, register Generic_node *prev);
+static Generic_node *find_node(Xv_object object, register Attr_attribute key, Generic_node ***slot);
+static void delete_node(Xv_object object, Generic_node **slot);
+static void key_insert(Generic_node **table, int size, Generic_node *node);
+static void key_rehash(Generic_info *generic, int size);
+static int key_newer_first(const void *a, const void *b);
+
+typedef struct {
+    Attr_attribute  key;
+    unsigned        seq;
+} Generic_key_order;
+
+#define GEN_KEY_HASH(key, size) \
+	((int) ((((unsigned) (int) (key)) * 0x9e3779b1U) >> 8) & ((size) - 1))
 
 /* ------------------------------------------------------------------------ */
 
@@ -105,9 +116,12 @@ generic_init(parent, object, avlist)
     generic->owner = parent;
 
     /*
-     * Set key data nodes, instance_qlist/name to be NULL
+     * Start key data in the inline slots, instance_qlist/name to be NULL
      */
-    generic->key_data = (Generic_node *)NULL;
+    generic->key_data = generic->key_inline;
+    generic->key_count = 0;
+    generic->key_size = GEN_KEY_INLINE;
+    generic->key_seq = 0;
     generic->instance_qlist = (Xv_opaque)NULL;
     generic->instance_name = (char *)NULL;
 
@@ -185,7 +199,7 @@ generic_set_avlist(object, avlist)
 {
     Attr_attribute  key;
     register Generic_node *node;
-    Generic_node   *prev, *existing_node;
+    Generic_node   **slot, *existing_node;
     int             ref_count;
     Generic_info	*generic = GEN_PRIVATE(object);
     register Xv_opaque error_code = XV_NULL;
@@ -209,7 +223,7 @@ generic_set_avlist(object, avlist)
 	     * meantime, thus aborting the destroy.
 	     */
 	    key = (Attr_attribute) XV_REF_COUNT;
-	    existing_node = node = find_node(object, key, &prev);
+	    existing_node = node = find_node(object, key, &slot);
 	    if (node) {
 		ref_count = (int) node->data;
 	    } else {
@@ -258,7 +272,7 @@ generic_set_avlist(object, avlist)
 #else
 	    key = (int) avlist[1];
 #endif
-	    existing_node = node = find_node(object, key, &prev);
+	    existing_node = node = find_node(object, key, &slot);
 	    if (!node) {
 		node = add_node(object, key);
 	    }
@@ -291,14 +305,14 @@ generic_set_avlist(object, avlist)
 #else
 	    key = (int) avlist[1];
 #endif
-	    node = find_node(object, key, &prev);
+	    node = find_node(object, key, &slot);
 	    if (node) {
 		switch ((Xv_generic_attr) (*avlist)) {
 		  case XV_KEY_DATA_COPY_PROC:
 		    node->copy_proc = (void (*) ()) avlist[2];
 		    break;
 		  case XV_KEY_DATA_REMOVE:
-		    delete_node(object, node, prev);
+		    delete_node(object, slot);
 		    break;
 		  case XV_KEY_DATA_REMOVE_PROC:
 		    node->remove_proc = (void (*) ()) avlist[2];
@@ -373,7 +387,7 @@ generic_get(object, status, attr, args)
     Attr_attribute  key;
     register Xv_opaque result;
     register Generic_node *node;
-    Generic_node   *prev;
+    Generic_node   **slot;
     Generic_info	*generic = GEN_PRIVATE(object);
 
     /* Don't set *status to XV_ERROR unless attribute is unrecognized! */
@@ -382,7 +396,7 @@ generic_get(object, status, attr, args)
       case XV_KEY_DATA_COPY_PROC:
       case XV_KEY_DATA_REMOVE_PROC:
 	key = (int)va_arg(args, Attr_attribute);
-	node = find_node(object, key, &prev);
+	node = find_node(object, key, &slot);
 	if (node) {
 	    switch (attr) {
 	      case XV_KEY_DATA:
@@ -416,7 +430,7 @@ generic_get(object, status, attr, args)
 	}
 
       case XV_REF_COUNT:
-	node = find_node(object, (Attr_attribute) XV_REF_COUNT, &prev);
+	node = find_node(object, (Attr_attribute) XV_REF_COUNT, &slot);
 	if (node) {
 	    result = node->data;
 	} else {
@@ -483,8 +497,10 @@ generic_destroy(object, status)
     Xv_object       object;
     Destroy_status  status;
 {
-    register Generic_node *node;
+    Generic_node	**slot, *node;
     Generic_info	*generic = GEN_PRIVATE(object);
+    Generic_key_order	*order;
+    register int	i, n;
 
     switch ((int)status) {
       case DESTROY_CHECKING:
@@ -493,9 +509,28 @@ generic_destroy(object, status)
 	    return (XV_ERROR);
 	break;
       case DESTROY_CLEANUP:
-	while (node = HEAD(object)) {
-	    delete_node(object, node, (Generic_node *) 0);
+	/*
+	 * Remove newest first.  A remove proc may itself add or remove
+	 * keys, so only keys still holding the node seen are deleted, and
+	 * anything added meanwhile is picked up by another pass.
+	 */
+	while (generic->key_count) {
+	    order = xv_alloc_n(Generic_key_order, generic->key_count);
+	    for (i = n = 0; n < generic->key_count; i++)
+		if ((node = generic->key_data[i])) {
+		    order[n].key = node->key;
+		    order[n++].seq = node->seq;
+		}
+	    qsort((char *) order, n, sizeof(Generic_key_order),
+		  key_newer_first);
+	    for (i = 0; i < n; i++)
+		if ((node = find_node(object, order[i].key, &slot)) &&
+		    node->seq == order[i].seq)
+		    delete_node(object, slot);
+	    free((char *) order);
 	}
+	if (generic->key_data != generic->key_inline)
+	    free((char *) generic->key_data);
 	notify_remove(object);
 	free(generic);
 	break;
@@ -515,54 +550,137 @@ add_node(object, key)
     Attr_attribute  key;
 {
     register Generic_node *node;
-    Generic_info	*gen_private = GEN_PRIVATE(object);;
+    Generic_info	*generic = GEN_PRIVATE(object);
+
+    if (generic->key_data == generic->key_inline) {
+	if (generic->key_count == GEN_KEY_INLINE)
+	    key_rehash(generic, GEN_KEY_HASH_MIN);
+    } else if (2 * (generic->key_count + 1) > generic->key_size)
+	key_rehash(generic, 2 * generic->key_size);
 
     node = xv_alloc(Generic_node);
-    node->next = HEAD(object);
-    gen_private->key_data = node;
     node->key = (int)key;
+    node->seq = generic->key_seq++;
+    if (generic->key_data == generic->key_inline)
+	generic->key_inline[generic->key_count] = node;
+    else
+	key_insert(generic->key_data, generic->key_size, node);
+    generic->key_count++;
 
     return node;
 }
 
 static Generic_node *
-find_node(object, key, prev)
-    register Xv_object object;
+find_node(object, key, slot)
+    Xv_object	    object;
     register Attr_attribute key;
-    register Generic_node **prev;
+    Generic_node ***slot;
 {
-    register Generic_node *node;
-
-    if (HEAD(object)) {
-	if (HEAD(object)->key == key) {
-	    node = HEAD(object);
-	    *prev = (Generic_node *) NULL;
-	} else {
-	    for (*prev = HEAD(object), node = (*prev)->next; node;
-		 *prev = node, node = (*prev)->next) {
-		if ((int)(node->key) == (int)key)
-		    break;
+    Generic_info	*generic = GEN_PRIVATE(object);
+    register Generic_node **table = generic->key_data;
+    register int    i, mask;
+
+    if (table == generic->key_inline) {
+	for (i = 0; i < generic->key_count; i++) {
+	    if ((int)(table[i]->key) == (int)key) {
+		*slot = &table[i];
+		return table[i];
 	    }
 	}
     } else {
-	*prev = node = (Generic_node *) NULL;
+	mask = generic->key_size - 1;
+	for (i = GEN_KEY_HASH(key, generic->key_size); table[i];
+	     i = (i + 1) & mask) {
+	    if ((int)(table[i]->key) == (int)key) {
+		*slot = &table[i];
+		return table[i];
+	    }
+	}
     }
-    return node;
+    *slot = (Generic_node **) NULL;
+    return (Generic_node *) NULL;
 }
 
+/*
+ * Take the node out of its slot, then call its remove proc.  In the hash,
+ * entries further along the probe sequence are shifted back over the hole
+ * so that lookups never need a tombstone.
+ */
 static void
-delete_node(object, node, prev)
+delete_node(object, slot)
     Xv_object       object;
-    register Generic_node *node, *prev;
+    Generic_node  **slot;
 {
-
-    if (prev) {
-	prev->next = node->next;
+    Generic_info	*generic = GEN_PRIVATE(object);
+    register Generic_node **table = generic->key_data;
+    register Generic_node *node = *slot;
+    register int    hole, i, home, mask;
+
+    generic->key_count--;
+    if (table == generic->key_inline) {
+	*slot = table[generic->key_count];
+	table[generic->key_count] = (Generic_node *) NULL;
     } else {
-        Generic_info	*gen_private = GEN_PRIVATE(object);;
-	gen_private->key_data =  node->next;
+	mask = generic->key_size - 1;
+	hole = i = slot - table;
+	for (;;) {
+	    i = (i + 1) & mask;
+	    if (!table[i])
+		break;
+	    home = GEN_KEY_HASH(table[i]->key, generic->key_size);
+	    /* move it back unless its home lies cyclically in (hole, i] */
+	    if ((hole < i) ? (home <= hole || home > i)
+			   : (home <= hole && home > i)) {
+		table[hole] = table[i];
+		hole = i;
+	    }
+	}
+	table[hole] = (Generic_node *) NULL;
     }
     if (node->remove_proc)
 	(node->remove_proc) (object, node->key, node->data);
     xv_free(node);
 }
+
+static void
+key_insert(table, size, node)
+    register Generic_node **table;
+    int             size;
+    Generic_node   *node;
+{
+    register int    i;
+
+    for (i = GEN_KEY_HASH(node->key, size); table[i]; i = (i + 1) & (size - 1))
+	;
+    table[i] = node;
+}
+
+static int
+key_newer_first(a, b)
+    const void     *a, *b;
+{
+    unsigned        seq_a = ((Generic_key_order *) a)->seq;
+    unsigned        seq_b = ((Generic_key_order *) b)->seq;
+
+    return (seq_a < seq_b) ? 1 : (seq_a > seq_b) ? -1 : 0;
+}
+
+static void
+key_rehash(generic, size)
+    Generic_info   *generic;
+    int             size;
+{
+    Generic_node  **old = generic->key_data;
+    int             old_size = generic->key_size;
+    Generic_node  **table;
+    register int    i;
+
+    table = xv_alloc_n(Generic_node *, size);
+    for (i = 0; i < old_size; i++)
+	if (old[i])
+	    key_insert(table, size, old[i]);
+    if (old != generic->key_inline)
+	free((char *) old);
+    generic->key_data = table;
+    generic->key_size = size;
+}
@@ -73,6 +73,7 @@ EXTERN_FUNCTION (Xv_object _xv_create, (Xv_opaque owner, Xv_pkg *pkg, DOTDOTDOT)
 EXTERN_FUNCTION (Xv_object _xv_find, (Xv_opaque owner, Xv_pkg *pkg, DOTDOTDOT));
 EXTERN_FUNCTION (Xv_opaque _xv_set, (Xv_opaque object, DOTDOTDOT));
 EXTERN_FUNCTION (Xv_opaque _xv_get, (Xv_opaque object, Attr_attribute attr, DOTDOTDOT));
+EXTERN_FUNCTION (Xv_opaque xv_set_frozen, (Xv_opaque object, Attr_avlist avlist));
 EXTERN_FUNCTION (int xv_destroy_safe, (Xv_object object));
 EXTERN_FUNCTION (int xv_destroy_check, (Xv_object object));
 EXTERN_FUNCTION (int xv_destroy, (Xv_object object));
@@ -468,6 +468,37 @@ va_dcl
     return xv_set_avlist(object, avlist);
 }
 
+/*
+ * xv_set_frozen applies an avlist that is already flat -- one built with
+ * the ATTR_PUT macros or by attr_freeze() -- without copying it, so that
+ * the caller can change the values and apply it again.  Attributes a set
+ * proc consumed on the last pass are restored first.
+ */
+Xv_public       Xv_opaque
+xv_set_frozen(object, avlist)
+    Xv_opaque       object;
+    Attr_avlist     avlist;
+{
+    Attr_attribute	flat_avlist[ATTR_STANDARD_SIZE];
+    register Attr_avlist attrs;
+
+    if (object == (Xv_object)NULL) {
+	xv_error((Xv_object)NULL,
+	    ERROR_SEVERITY, ERROR_NON_RECOVERABLE,
+	    ERROR_STRING,
+		XV_MSG("NULL pointer passed to xv_set"),
+	    NULL);
+    }
+
+    for (attrs = avlist; *attrs; attrs = attr_next(attrs))
+	ATTR_UNCONSUME(*attrs);
+
+    avlist = attr_customize(object, ((Xv_base *) object)->pkg,
+                        (char *)NULL, (Xv_opaque)NULL, flat_avlist,
+                        ATTR_STANDARD_SIZE, avlist);
+    return xv_set_avlist(object, avlist);
+}
+
 Xv_private      Xv_opaque
 xv_set_pkg_avlist(object, pkg, avlist)
     register Xv_object object;
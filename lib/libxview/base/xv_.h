@@ -12,6 +12,7 @@ Xv_private Xv_object xv_find_avlist(Xv_opaque parent, register Xv_pkg* pkg, Attr
 Xv_public Xv_object _xv_create(Xv_opaque parent, Xv_pkg *pkg, ...);
 Xv_private Xv_object xv_create_avlist(Xv_opaque parent, register Xv_pkg *pkg, Attr_attribute avlist[ATTR_STANDARD_SIZE]);
 Xv_public Xv_opaque _xv_set(Xv_opaque object, ...);
+Xv_public Xv_opaque xv_set_frozen(Xv_opaque object, Attr_avlist avlist);
 Xv_private Xv_opaque xv_set_pkg_avlist(register Xv_object object, register Xv_pkg *pkg, Attr_avlist avlist);
 Xv_private Xv_opaque xv_set_avlist(Xv_opaque passed_object, Attr_avlist avlist);
 Xv_public Xv_opaque xv_super_set_avlist(register Xv_opaque object, register Xv_pkg *pkg, Attr_avlist avlist);
@@ -162,6 +162,43 @@ static char    *sunview1_prefix = "/usr/lib/fonts/fixedwidthfonts/";
 
 #ifndef OW_I18N
 static Font_locale_info         *fs_locales = NULL;
+
+/*
+ * font_find_font looks fonts up by name in font_hash rather than walking
+ * the server's FONT_HEAD list, and remembers in font_memo the name that
+ * font_construct_name made of each request, so that finding a font that
+ * has already been made parses no names at all.
+ */
+#define FONT_HASH_SIZE		127
+#define FONT_MEMO_SIZE		127
+#define FONT_MEMO_MAX		1024	/* requests remembered, at most */
+
+typedef struct font_name_memo {
+    Xv_opaque		 server;	/* whose resources made the name */
+    Font_locale_info	*linfo;
+    char		*name;		/* FONT_NAME asked for, or NULL */
+    char		*family;
+    char		*style;
+    int			 size, scale;
+    int			 sizes[4];	/* FONT_SIZES_FOR_SCALE */
+    unsigned		 hash;
+    char		*constructed;	/* what font_construct_name made */
+    struct font_name_memo *next;
+} Font_name_memo;
+
+static Font_info	*font_hash[FONT_HASH_SIZE];
+static Font_name_memo	*font_memo[FONT_MEMO_SIZE];
+static int		 font_memo_count;
+
+static unsigned font_hash_string(char *str, unsigned hash);
+static Font_info *font_hash_lookup(Xv_opaque server, char *name);
+static void font_hash_insert(Font_info *font);
+static void font_hash_remove(Font_info *font);
+static void font_hash_purge(Xv_opaque server);
+static void font_memo_key(Font_name_memo *key, Xv_opaque server, Font_return_attrs attrs);
+static Font_name_memo *font_memo_find(Font_name_memo *key);
+static void font_memo_add(Font_name_memo *key, char *constructed);
+static void font_memo_purge(Xv_opaque server);
 #endif
 
 typedef struct family_foundry {
@@ -776,6 +813,11 @@ font_list_free(server, key, data)
 #endif
 	}
     }
+#ifndef OW_I18N
+    /* Fonts still referenced outlive the server, but can't be found */
+    font_hash_purge(server);
+    font_memo_purge(server);
+#endif
 }
 
 
@@ -1419,6 +1461,7 @@ font_init(parent_public, font_public, avlist)
 		      XV_KEY_DATA_REMOVE_PROC, (Attr_attribute)FONT_HEAD, font_list_free,
 		      NULL);
     }
+    font_hash_insert(font);
 
     /*
      * SunView1.X compatibility: set this font as default if appropriate.
@@ -1527,6 +1570,9 @@ font_destroy_struct(font_public, status)
 #endif
 	    }
 	}
+#ifndef OW_I18N
+	font_hash_remove(font);
+#endif
 	/* Free the storage allocated for glyphs. */
 	if (zap_font_public)  {
 #ifdef OW_I18N
@@ -2732,6 +2778,8 @@ font_find_font(parent_public, pkg, avlist)
     struct font_return_attrs my_attrs;
     Xv_opaque		server;
     int			error_code;
+    Font_name_memo	key, *memo = NULL;
+    char		*name;
 
 
     if (!parent_public) {
@@ -2756,41 +2804,216 @@ font_find_font(parent_public, pkg, avlist)
     if (!font_attrs_exist)
 	(void) font_default_font(&my_attrs);
 
-    error_code = font_construct_name(&my_attrs);
-
-    if (error_code != XV_OK)  {
-	return(error_code);
+    /* A rescale depends on the font rescaled, so is never remembered. */
+    if (!my_attrs.resize_from_font) {
+	font_memo_key(&key, server, &my_attrs);
+	memo = font_memo_find(&key);
     }
+    if (memo) {
+	name = memo->constructed;
+    } else {
+	error_code = font_construct_name(&my_attrs);
 
-    if ((font_list = (Font_info *) xv_get(server, XV_KEY_DATA, (Attr_attribute)FONT_HEAD)) != NULL) {
-	while (font_list) {
-	    if (((font_string_compare(my_attrs.name, font_list->name) == 0)
-		 && (my_attrs.name != (char *) 0)
-		 && (font_list->name != (char *) 0))
-	    /*
-	     * first above for name, else below for family/style/size/scale
-	     * match
-		|| (((font_string_compare(my_attrs.family, font_list->family) == 0)
-		     && (my_attrs.family != (char *) 0)
-		     && (font_list->family != (char *) 0))
-	     && (font_string_compare(my_attrs.style, font_list->style) == 0)
-		    && ((font_list->size == my_attrs.size) &&
-			(font_list->scale == my_attrs.scale)))
-	     */
-			
-			) {
-		font_free_font_return_attr_strings(&my_attrs);
-		(void) xv_set(FONT_PUBLIC(font_list), XV_INCREMENT_REF_COUNT, NULL);
-		return (FONT_PUBLIC(font_list));
-	    }
-	    font_list = font_list->next;
+	if (error_code != XV_OK)  {
+	    return(error_code);
 	}
+	name = my_attrs.name;
+	if (!my_attrs.resize_from_font)
+	    font_memo_add(&key, name);
     }
+
+    /*
+     * Only the name is matched, not family/style/size/scale: those are
+     * what the name was made from.
+     */
+    font_list = name ? font_hash_lookup(server, name) : (Font_info *) 0;
     font_free_font_return_attr_strings(&my_attrs);
+    if (font_list) {
+	(void) xv_set(FONT_PUBLIC(font_list), XV_INCREMENT_REF_COUNT, NULL);
+	return (FONT_PUBLIC(font_list));
+    }
     return ((Xv_object) 0);
 }
 #endif /*OW_I18N*/
 
+#ifndef OW_I18N
+static unsigned
+font_hash_string(str, hash)
+    register char  *str;
+    register unsigned hash;
+{
+    if (str)
+	while (*str)
+	    hash = hash * 31 + (unsigned char) *str++;
+    return (hash);
+}
+
+static Font_info *
+font_hash_lookup(server, name)
+    Xv_opaque       server;
+    char           *name;
+{
+    register Font_info *font;
+
+    for (font = font_hash[font_hash_string(name, 0) % FONT_HASH_SIZE];
+	 font; font = font->hash_next)
+	if (font->server == server && font->name &&
+	    strcmp(font->name, name) == 0)
+	    return (font);
+    return ((Font_info *) 0);
+}
+
+static void
+font_hash_insert(font)
+    Font_info      *font;
+{
+    register Font_info **bucket;
+
+    if (!font->name)
+	return;
+    bucket = &font_hash[font_hash_string(font->name, 0) % FONT_HASH_SIZE];
+    font->hash_next = *bucket;
+    *bucket = font;
+}
+
+static void
+font_hash_remove(font)
+    Font_info      *font;
+{
+    register Font_info **prev;
+
+    if (!font->name)
+	return;
+    for (prev = &font_hash[font_hash_string(font->name, 0) % FONT_HASH_SIZE];
+	 *prev; prev = &(*prev)->hash_next)
+	if (*prev == font) {
+	    *prev = font->hash_next;
+	    return;
+	}
+}
+
+/* Drop all of server's fonts from font_hash. */
+static void
+font_hash_purge(server)
+    Xv_opaque       server;
+{
+    register Font_info **prev;
+    register int    i;
+
+    for (i = 0; i < FONT_HASH_SIZE; i++)
+	for (prev = &font_hash[i]; *prev;)
+	    if ((*prev)->server == server)
+		*prev = (*prev)->hash_next;
+	    else
+		prev = &(*prev)->hash_next;
+}
+
+/*
+ * Fill in key with what font_construct_name will make a name from.
+ */
+static void
+font_memo_key(key, server, attrs)
+    register Font_name_memo *key;
+    Xv_opaque       server;
+    register Font_return_attrs attrs;
+{
+    register unsigned hash;
+
+    key->server = server;
+    key->linfo = attrs->linfo;
+    key->name = attrs->name;
+    key->family = attrs->family;
+    key->style = attrs->style;
+    key->size = attrs->size;
+    key->scale = attrs->scale;
+    key->sizes[0] = attrs->small_size;
+    key->sizes[1] = attrs->medium_size;
+    key->sizes[2] = attrs->large_size;
+    key->sizes[3] = attrs->extra_large_size;
+    hash = (unsigned) (unsigned long) key->server;
+    hash = hash * 31 + (unsigned) (unsigned long) key->linfo;
+    hash = font_hash_string(key->name, hash);
+    hash = font_hash_string(key->family, hash * 31 + 1);
+    hash = font_hash_string(key->style, hash * 31 + 2);
+    hash = hash * 31 + key->size;
+    hash = hash * 31 + key->scale;
+    key->hash = hash;
+}
+
+static Font_name_memo *
+font_memo_find(key)
+    register Font_name_memo *key;
+{
+    register Font_name_memo *memo;
+
+    for (memo = font_memo[key->hash % FONT_MEMO_SIZE]; memo;
+	 memo = memo->next)
+	if (memo->hash == key->hash && memo->server == key->server &&
+	    memo->linfo == key->linfo &&
+	    memo->size == key->size && memo->scale == key->scale &&
+	    memo->sizes[0] == key->sizes[0] &&
+	    memo->sizes[1] == key->sizes[1] &&
+	    memo->sizes[2] == key->sizes[2] &&
+	    memo->sizes[3] == key->sizes[3] &&
+	    font_string_compare(memo->name, key->name) == 0 &&
+	    font_string_compare(memo->family, key->family) == 0 &&
+	    font_string_compare(memo->style, key->style) == 0)
+	    return (memo);
+    return ((Font_name_memo *) 0);
+}
+
+/*
+ * Remember that key makes the name constructed.  The strings in key
+ * belong to the caller, so are copied.
+ */
+static void
+font_memo_add(key, constructed)
+    Font_name_memo *key;
+    char           *constructed;
+{
+    register Font_name_memo *memo;
+
+    if (!constructed || font_memo_count >= FONT_MEMO_MAX)
+	return;
+    memo = xv_alloc(Font_name_memo);
+    *memo = *key;
+    memo->name = key->name ? xv_strsave(key->name) : (char *) 0;
+    memo->family = key->family ? xv_strsave(key->family) : (char *) 0;
+    memo->style = key->style ? xv_strsave(key->style) : (char *) 0;
+    memo->constructed = xv_strsave(constructed);
+    memo->next = font_memo[key->hash % FONT_MEMO_SIZE];
+    font_memo[key->hash % FONT_MEMO_SIZE] = memo;
+    font_memo_count++;
+}
+
+/* Forget all that font_memo_add remembered for server. */
+static void
+font_memo_purge(server)
+    Xv_opaque       server;
+{
+    register Font_name_memo **prev, *memo;
+    register int    i;
+
+    for (i = 0; i < FONT_MEMO_SIZE; i++)
+	for (prev = &font_memo[i]; (memo = *prev) != NULL;) {
+	    if (memo->server != server) {
+		prev = &memo->next;
+		continue;
+	    }
+	    *prev = memo->next;
+	    if (memo->name)
+		free(memo->name);
+	    if (memo->family)
+		free(memo->family);
+	    if (memo->style)
+		free(memo->style);
+	    free(memo->constructed);
+	    free((char *) memo);
+	    font_memo_count--;
+	}
+}
+#endif /*OW_I18N*/
+
 Pkg_private int
 font_free_font_return_attr_strings(attrs)
     struct font_return_attrs *attrs;
@@ -121,6 +121,7 @@ typedef struct font_info {
     Xv_opaque	 	 display;
     Xv_opaque	 	 server;
     struct font_info	*next;
+    struct font_info	*hash_next;	/* in font_hash, by name */
     
 #ifdef OW_I18N
     char		**names;
@@ -149,6 +149,42 @@ extern	fd_set	ndet_ibits, ndet_obits, ndet_ebits;
 					   ndet_flags & NDET_FD_CHANGE) */
 extern	struct	timeval ndet_polling_tv;/* Tv with select type polling value */
 
+/*
+ * Persistent fd interest (ndet_pollset.c).  Fd conditions are registered
+ * with the kernel as they enter and leave the condition table instead of
+ * being gathered into ndet_*bits for every select.  Epoll is used on Linux,
+ * poll elsewhere; define NDET_NO_POLLSET to stay with select.
+ */
+#if !defined(NDET_NO_POLLSET) && (defined(SVR4) || defined(__linux__))
+#define	NDET_POLLSET
+#if defined(__linux__) && !defined(NDET_NO_EPOLL)
+#define	NDET_EPOLL
+#endif
+#endif
+
+#define	NDET_FD_IN		0x1	/* Fd readable (NTFY_INPUT) */
+#define	NDET_FD_OUT		0x2	/* Fd writable (NTFY_OUTPUT) */
+#define	NDET_FD_EXC		0x4	/* Fd exceptional (NTFY_EXCEPTION) */
+
+extern	int	ndet_pollset_count;	/* Number of fds with fd conditions */
+
+/*
+ * Real itimers (ndet_twheel.c).  Instead of one process ITIMER_REAL that is
+ * recomputed from every real itimer condition and caught as SIGALRM, real
+ * itimers sit on a hierarchical timer wheel and the notification loop waits
+ * for the earliest one, via a timerfd in the pollset when there is one and
+ * via the select/poll timeout otherwise.  Define NDET_NO_TWHEEL to go back
+ * to SIGALRM.  Virtual itimers measure process time and stay on SIGVTALRM.
+ */
+#ifndef NDET_NO_TWHEEL
+#define	NDET_TWHEEL
+#if defined(NDET_POLLSET) && defined(__linux__) && !defined(NDET_NO_TIMERFD)
+#define	NDET_TIMERFD
+#endif
+#endif
+
+extern	int	ndet_twheel_count;	/* Number of real itimers on the wheel */
+
 extern	sigset_t   ndet_sigs_auto;	/* Bits that indicate which signals the
 					   notifier is automatically catching
 					   (SIGIO, SIGURG, SIGCHLD, SIGTERM,
@@ -224,6 +260,12 @@ related to the select timer.
 	b) Granularity of very short intervals may cause overlap
 	   of notification and determining the next one.
 
+With NDET_TWHEEL, 2) and 3) apply only to virtual interval timers.
+A real interval timer is put on the timer wheel when it is set (or reset
+from it_interval) and comes off when it expires or is removed, so neither
+costs a scan of all clients.  set_tv is still maintained as below for
+notify_itimer_value.
+
 For process virtual time interval timers TIME_DIF is the value used
 to set the process timer.
 
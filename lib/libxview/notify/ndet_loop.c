@@ -17,12 +17,16 @@ static char     sccsid[] = "@(#)ndet_loop.c 20.36 93/06/28 Copyr 1985 Sun Micro"
 #include <xview_private/ndet_loop_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/ndet_auto_.h>
+#include <xview_private/ndet_pollset_.h>
+#include <xview_private/ndet_twheel_.h>
 #include <xview_private/ndetitimer_.h>
 #include <xview_private/ndisdispch_.h>
 #include <xview_private/nint_stack_.h>
 #include <xview_private/ntfy_cond_.h>
 #include <xview_private/ntfy_ctbl_.h>
 #include <xview_private/ntfy_debug_.h>
+#include <xview_private/ntfy_node_.h>
+#include <xview_private/ntfy_stats_.h>
 #include <xview_private/ntfyprotec_.h>
 #include <xview_private/i18n_impl.h>
 #include <xview_private/ntfy.h>
@@ -116,6 +120,7 @@ static NTFY_ENUM ndet_destroy_change(NTFY_CLIENT *client, NTFY_CONDITION *condit
 static NTFY_ENUM ndet_sig_change(NTFY_CLIENT *client, NTFY_CONDITION *condition, NTFY_ENUM_DATA context);
 static NTFY_ENUM ndet_sig_send(NTFY_CLIENT *client, register NTFY_CONDITION *condition, NTFY_ENUM_DATA context);
 static NTFY_ENUM ndet_poll_send(NTFY_CLIENT *client, register NTFY_CONDITION *condition, NTFY_ENUM_DATA context);
+static void ndet_pipe_drain(int fd);
 
 #ifdef	lint
 /* VARARGS */
@@ -140,8 +145,12 @@ notify_start()
     NDET_ENUM_SEND  enum_send;
     int             errno_remember = errno;
     Notify_error    return_code;
-    int		    readval;
-    char	    pipebuf[10];
+    int		    watching;
+    int		    pollset = FALSE;
+    u_long	    wait_start;
+#ifdef NDET_TWHEEL
+    struct timeval  wheel_tv;
+#endif
 
     FD_ZERO(&ibits);
     FD_ZERO(&obits);
@@ -157,10 +166,20 @@ notify_start()
         pipe_started = TRUE;
         if( !pipe( pipefds )) {}
         fcntl( pipefds[0], F_SETFL, O_NDELAY);
+#ifdef NDET_POLLSET
+	ndet_pollset_internal(pipefds[0], ndet_pipe_drain);
+#endif
     }
+    ntfy_stats_init();
+#ifdef NDET_POLLSET
+    /* Rpc service fds only come as an fd_set, so rpc stays with select */
+    pollset = !do_rpc && ndet_pollset_init();
+#endif
 
     /* Always go around the loop at least once */
     do {
+	if (ntfy_stats_on)
+	    ntfy_stats_loop();
 	NTFY_BEGIN_CRITICAL;
 	/* Ndet_update_*_itimer (below) may set up NDET_ITIMER_ENQ */
 	ndet_flags &= ~NDET_ITIMER_ENQ;
@@ -197,6 +216,12 @@ notify_start()
 	    (void) ntfy_fd_cpy_or (&ibits, &svc_fdset);
 	obits = ndet_obits;
 	ebits = ndet_ebits;
+	/* Fds past FD_SETSIZE only show up in the pollset */
+	watching = pollset ? (ndet_pollset_count > 0) :
+	    (ntfy_fd_anyset(&ibits) || ntfy_fd_anyset(&obits) ||
+	     ntfy_fd_anyset(&ebits));
+	/* Real itimers don't show up as signals to pause for */
+	watching = watching || ndet_twheel_count > 0;
 	NTFY_END_CRITICAL;
 	/*
 	 * NB! THIS RACE WAS FIXED BY THE USE OF pipefds.
@@ -208,8 +233,7 @@ notify_start()
 	 * blocked signals. We test ndet_sigs_received as late as possible in
 	 * order to reduce this window of vulnerability.
 	 */
-	if (!ntfy_fd_anyset(&ibits) && !ntfy_fd_anyset(&obits) &&
-	    !ntfy_fd_anyset(&ebits) && timer == NTFY_TIMEVAL_NULL &&
+	if (!watching && timer == NTFY_TIMEVAL_NULL &&
             sigisempty( &ndet_sigs_received )) {
 
             if( !sigisempty( &ndet_sigs_managing )) { 
@@ -231,6 +255,14 @@ notify_start()
 	    if ((timer == NTFY_TIMEVAL_NULL) &&
 		(timerisset(&ndet_signal_check)))
 		timer = &ndet_signal_check;
+#ifdef NDET_TWHEEL
+	    /* Wake up for the next real itimer */
+	    timer = ndet_twheel_timeout(timer, &wheel_tv, pollset);
+#endif
+	    /* About to block, give idle node slabs back to the heap */
+	    if (timer == NTFY_TIMEVAL_NULL || timerisset(timer))
+		ntfy_shrink_nodes();
+	    NTFY_STATS_CLOCK(wait_start);
 	    /*
 	     * Wait for select to return.
 	     * 
@@ -240,6 +272,16 @@ notify_start()
 	     * will return with an EINTR when a signal arrives while IN
 	     * select, not ON THE WAY into select).
 	     */
+#ifdef NDET_POLLSET
+	    if (pollset) {
+		/* Results are held by the pollset, see ndet_pollset_send */
+		FD_ZERO(&ibits);
+		FD_ZERO(&obits);
+		FD_ZERO(&ebits);
+		nfds = ndet_pollset_wait(
+		 (sigisempty(&ndet_sigs_received)) ? timer : &ndet_polling_tv);
+	    } else
+#endif
 #ifndef SVR4
 #ifndef __linux__
 	    nfds = syscall(SYS_select,
@@ -255,6 +297,8 @@ notify_start()
 		(sigisempty(&ndet_sigs_received)) ? timer : &ndet_polling_tv);
 #endif /* SVR4 */
 	    errno_remember = errno;
+	    if (wait_start)
+		ntfy_stats_wait(wait_start, nfds, errno_remember);
 	    /* See if select returned unconventionally */
 	    if (nfds == -1) {
 		/* Clear *bits when in an undefined situation */
@@ -308,11 +352,13 @@ notify_start()
 	/* Check for fd related condition */
 	/* if (ibits || obits || ebits) */
 
+#ifdef NDET_POLLSET
+	/* Only the fds that are ready, no walk of the condition table */
+	if (pollset && ndet_pollset_send() == NTFY_ENUM_TERM)
+	    goto Protected_Error;
+#endif
 	if( FD_ISSET( pipefds[0], &ibits )) {
-	    do {
-	        readval = read( pipefds[0], pipebuf, 10 );
-	    }
-	    while( readval && !( readval == -1 ));
+	    ndet_pipe_drain( pipefds[0] );
 	    FD_CLR( pipefds[0], &ibits );
 	}
 
@@ -355,6 +401,10 @@ notify_start()
 					    (NTFY_ENUM_DATA) & enum_send) ==
 		(int) NTFY_ENUM_TERM)
 		goto Protected_Error;
+#ifdef NDET_TWHEEL
+	/* Real itimers that came due */
+	ndet_twheel_expire();
+#endif
 	if (ndet_flags & NDET_POLL)
 	    if (ntfy_enum_conditions(ndet_clients, ndet_poll_send,
 				     NTFY_ENUM_DATA_NULL) == NTFY_ENUM_TERM)
@@ -393,6 +443,23 @@ Finish:
     return (return_code);
 }
 
+/*
+ * Empty the pipe that ndet_signal_catcher writes to in order to break us
+ * out of select.
+ */
+static void
+ndet_pipe_drain(fd)
+    int             fd;
+{
+    int             readval;
+    char            pipebuf[10];
+
+    do {
+	readval = read(fd, pipebuf, 10);
+    }
+    while (readval && !(readval == -1));
+}
+
 /*
  * Set flag indicating that should return from notify_start.
  */
@@ -438,6 +505,10 @@ ndet_fig_fd_change()
 #ifndef __linux__
     ndet_toggle_auto(&sigs_tmp, SIGURG);
 #endif
+#ifdef NDET_POLLSET
+    /* Async fds come and go from the kernel's interest set */
+    ndet_pollset_resync();
+#endif
 }
 
 /* ARGSUSED */
@@ -448,6 +519,9 @@ ndet_fd_change(client, condition, context)
     NTFY_ENUM_DATA  context;
 {
 
+    /* Fds that don't fit an fd_set are only watched by the pollset */
+    if (condition->data.fd >= FD_SETSIZE)
+	return (NTFY_ENUM_NEXT);
     switch (condition->type) {
       case NTFY_INPUT:
 	if (FD_ISSET(condition->data.fd, &ndet_fasync_mask))
@@ -799,7 +873,7 @@ pkg_private void ndet_signal_catcher(sig, info, ucontext)
     newmask = ndet_sigs_managing;    
     sigprocmask(SIG_BLOCK, &newmask, &oldmask);
 
-    if (NTFY_IN_CRITICAL || ntfy_nodes_avail < NTFY_PRE_ALLOCED_MIN) {
+    if (NTFY_IN_CRITICAL || ntfy_nodes_low(NTFY_PRE_ALLOCED_MIN)) {
 	sigaddset( &ntfy_sigs_delayed, sig );
 	sigprocmask(SIG_SETMASK, &oldmask, (sigset_t *) 0);
 #ifdef	NTFY_DEBUG
@@ -902,12 +976,16 @@ ndet_async_sig_send(client, condition, context)
     if (condition->type == NTFY_ASYNC_SIGNAL &&
         (sigismember( sigs, condition->data.signal ))) {
 	Notify_func     func;
+	Notify_client   nclient;
+	u_long          start;
 
 	/* Push condition on interposition stack */
 	func = nint_push_callout(client, condition);
 	/* The notifier doesn't catch any async sigs */
-	(void) func(client->nclient,
+	NTFY_STATS_START(start);
+	(void) func(nclient = client->nclient,
 		    condition->data.signal, NOTIFY_ASYNC);
+	NTFY_STATS_CALLOUT(nclient, NTFY_ASYNC_SIGNAL, start);
 	/* Pop condition from interposition stack */
 	nint_unprotected_pop_callout();
 	/* Note: condition/client may be undefined now! */
@@ -949,6 +1027,8 @@ ndet_fd_send(client, condition, context)
 {
     register NDET_ENUM_SEND *enum_send = (NDET_ENUM_SEND *) context;
 
+    if (condition->data.fd >= FD_SETSIZE)
+	return (NTFY_ENUM_NEXT);
     switch (condition->type) {
       case NTFY_INPUT:
 	if (FD_ISSET(condition->data.fd, &enum_send->ibits))
@@ -1014,8 +1094,14 @@ ndet_poll_send(client, condition, context)
 	     * only to be polling again.
 	     */
 	    if (!ndet_tv_polling(
-			      condition->data.ntfy_itimer->itimer.it_value))
+			      condition->data.ntfy_itimer->itimer.it_value)) {
 		ndet_reset_itimer_set_tv(condition);
+#ifdef NDET_TWHEEL
+		/* No longer polling, on to the timer wheel */
+		if (condition->type == NTFY_REAL_ITIMER)
+		    (void) ndet_twheel_arm(client, condition);
+#endif
+	    }
 	}
 	/*
 	 * Know can skip rest of clients conditions because only one itimer
@@ -0,0 +1,607 @@
+/*
+ * Ndet_pollset.c - Persistent file descriptor interest for the detector.
+ *
+ * The select based loop recomputed ndet_*bits by enumerating every fd
+ * condition whenever one changed and then handed FD_SETSIZE sized masks to
+ * select on every trip around the loop.  Here every fd owns a slot that
+ * lists the conditions watching it, and the kernel's interest set (an epoll
+ * instance, or a pollfd array when epoll is unavailable) is adjusted as
+ * conditions are added to and removed from the condition table.  A trip
+ * around the loop then costs time proportional to the number of ready fds,
+ * and fds beyond FD_SETSIZE can be watched.
+ */
+
+#include <xview_private/ndet_pollset_.h>
+#include <xview_private/ndisdispch_.h>
+#include <xview_private/ntfy_debug_.h>
+#include <xview_private/ntfyprotec_.h>
+#include <xview_private/xv_.h>
+#include <xview_private/ndet.h>
+
+pkg_private_data int ndet_pollset_count = 0;	/* Fds with conditions */
+
+#ifdef NDET_POLLSET
+
+#include <errno.h>
+#include <limits.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <poll.h>
+#ifdef NDET_EPOLL
+#include <sys/epoll.h>
+#endif
+
+/*
+ * Per fd state.  Watch is a list of the fd conditions (all three types) on
+ * this fd; NTFY_CNDTBL is used for its (client, condition, next) shape.
+ */
+typedef struct ndet_fd_slot {
+    NTFY_CNDTBL    *watch;	/* Conditions watching this fd */
+    void	  (*drain)();	/* Internal fd handler (no conditions) */
+    u_short	    events;	/* NDET_FD_* registered with the kernel */
+    u_short	    flags;
+#define	NDET_SLOT_KERNEL	0x1	/* Fd is in the kernel interest set */
+#define	NDET_SLOT_ALWAYS	0x2	/* Fd can't be polled (regular file),
+					 * always ready like select says */
+    int		    index;	/* Index in ndet_pollfds (poll backend) */
+} NDET_FD_SLOT;
+
+typedef enum ndet_backend {
+    NDET_BACKEND_NONE = 0,
+    NDET_BACKEND_EPOLL = 1,
+    NDET_BACKEND_POLL = 2,
+} NDET_BACKEND;
+
+#define	NDET_READY_MAX		64	/* Fds reported per wait; the rest are
+					 * level triggered and show up next
+					 * time around the loop.  The poll
+					 * scan starts after the last fd
+					 * reported, so none is starved. */
+
+static NDET_BACKEND ndet_backend;
+static NDET_FD_SLOT *ndet_slots;
+static int      ndet_slots_size;
+static int      ndet_always_count;
+#ifdef NDET_EPOLL
+static int      ndet_epoll_fd = -1;
+static struct epoll_event ndet_epoll_ready[NDET_READY_MAX];
+#endif
+static struct pollfd *ndet_pollfds;
+static int      ndet_pollfds_used;
+static int      ndet_pollfds_size;
+static int      ndet_pollfds_start;	/* Where the next scan begins */
+
+/* Results of the most recent ndet_pollset_wait */
+static struct {
+    int		    fd;
+    u_int	    events;
+} ndet_ready[NDET_READY_MAX];
+static int      ndet_nready;
+
+static NDET_FD_SLOT *ndet_slot(int fd, int create);
+static void     ndet_slot_sync(int fd, NDET_FD_SLOT *slot);
+static u_int    ndet_slot_wanted(int fd, NDET_FD_SLOT *slot);
+static int      ndet_kernel_update(int fd, NDET_FD_SLOT *slot, u_int events);
+static void     ndet_ready_add(int fd, u_int events);
+#ifdef NDET_EPOLL
+static int      ndet_epoll_create(void);
+static int      ndet_epoll_ctl(int op, int fd, u_int events);
+static void     ndet_epoll_rebuild(void);
+#endif
+
+/*
+ * Pick a backend.  Returns 0 if no persistent backend could be set up, in
+ * which case the caller stays with select and ndet_*bits.
+ */
+pkg_private int
+ndet_pollset_init()
+{
+    if (ndet_backend != NDET_BACKEND_NONE)
+	return (1);
+#ifdef NDET_EPOLL
+    if ((ndet_epoll_fd = ndet_epoll_create()) >= 0) {
+	ndet_backend = NDET_BACKEND_EPOLL;
+	return (1);
+    }
+#endif
+    ndet_backend = NDET_BACKEND_POLL;
+    return (1);
+}
+
+/*
+ * Called by ntfy_add_to_table when an fd condition enters the condition
+ * table.
+ */
+pkg_private void
+ndet_pollset_watch(client, condition)
+    NTFY_CLIENT    *client;
+    NTFY_CONDITION *condition;
+{
+    NDET_FD_SLOT   *slot;
+    NTFY_CNDTBL    *watch;
+    int             fd = condition->data.fd;
+
+    NTFY_BEGIN_CRITICAL;
+    if ((slot = ndet_slot(fd, 1)) == (NDET_FD_SLOT *) 0)
+	goto Done;
+    watch = (NTFY_CNDTBL *) xv_malloc(sizeof(NTFY_CNDTBL));
+    watch->client = client;
+    watch->condition = condition;
+    watch->next = slot->watch;
+    if (slot->watch == (NTFY_CNDTBL *) 0)
+	ndet_pollset_count++;
+    slot->watch = watch;
+    ndet_slot_sync(fd, slot);
+Done:
+    NTFY_END_CRITICAL;
+}
+
+/*
+ * Called by ntfy_remove_from_table when an fd condition leaves the
+ * condition table.
+ */
+pkg_private void
+ndet_pollset_unwatch(client, condition)
+    NTFY_CLIENT    *client;
+    NTFY_CONDITION *condition;
+{
+    NDET_FD_SLOT   *slot;
+    NTFY_CNDTBL   **watch, *dead;
+    int             fd = condition->data.fd;
+
+    NTFY_BEGIN_CRITICAL;
+    if ((slot = ndet_slot(fd, 0)) == (NDET_FD_SLOT *) 0)
+	goto Done;
+    for (watch = &slot->watch; *watch; watch = &(*watch)->next) {
+	if ((*watch)->client == client && (*watch)->condition == condition) {
+	    dead = *watch;
+	    *watch = dead->next;
+	    free((char *) dead);
+	    if (slot->watch == (NTFY_CNDTBL *) 0)
+		ndet_pollset_count--;
+	    ndet_slot_sync(fd, slot);
+	    break;
+	}
+    }
+Done:
+    NTFY_END_CRITICAL;
+}
+
+/*
+ * Register an fd that belongs to the notifier itself (e.g., the pipe the
+ * signal catcher writes to).  Drain is called with the fd when it is ready.
+ * A null drain unregisters the fd.
+ */
+pkg_private void
+ndet_pollset_internal(fd, drain)
+    int             fd;
+    void          (*drain) ();
+{
+    NDET_FD_SLOT   *slot;
+
+    NTFY_BEGIN_CRITICAL;
+    if ((slot = ndet_slot(fd, 1)) != (NDET_FD_SLOT *) 0) {
+	slot->drain = drain;
+	ndet_slot_sync(fd, slot);
+    }
+    NTFY_END_CRITICAL;
+}
+
+/*
+ * The fasync mask changed.  Fds that deliver SIGIO are watched by the
+ * signal machinery instead, so recompute what the kernel waits on.
+ */
+pkg_private void
+ndet_pollset_resync()
+{
+    int             fd;
+
+    for (fd = 0; fd < ndet_slots_size; fd++)
+	if (ndet_slots[fd].watch || ndet_slots[fd].drain)
+	    ndet_slot_sync(fd, &ndet_slots[fd]);
+}
+
+/*
+ * Wait for fd activity or until tv expires (null tv blocks).  Returns the
+ * number of ready fds, 0 on timeout or -1 with errno set.  The results are
+ * held until the next call and delivered by ndet_pollset_send.
+ */
+pkg_private int
+ndet_pollset_wait(tv)
+    struct timeval *tv;
+{
+    int             timeout, n, i, j;
+
+    ndet_nready = 0;
+    if (tv == NTFY_TIMEVAL_NULL)
+	timeout = -1;
+    else if (tv->tv_sec >= INT_MAX / 1000 - 1)
+	timeout = INT_MAX;
+    else
+	timeout = tv->tv_sec * 1000 + (tv->tv_usec + 999) / 1000;
+    /* Unpollable fds are always ready, as select would report them */
+    if (ndet_always_count > 0)
+	timeout = 0;
+
+    switch (ndet_backend) {
+#ifdef NDET_EPOLL
+      case NDET_BACKEND_EPOLL:
+	n = epoll_wait(ndet_epoll_fd, ndet_epoll_ready, NDET_READY_MAX,
+		       timeout);
+	if (n == -1)
+	    return (-1);
+	for (i = 0; i < n; i++) {
+	    u_int           revents = ndet_epoll_ready[i].events;
+	    u_int           events = 0;
+
+	    if (revents & (EPOLLIN | EPOLLHUP | EPOLLERR))
+		events |= NDET_FD_IN;
+	    if (revents & (EPOLLOUT | EPOLLHUP | EPOLLERR))
+		events |= NDET_FD_OUT;
+	    if (revents & EPOLLPRI)
+		events |= NDET_FD_EXC;
+	    ndet_ready_add(ndet_epoll_ready[i].data.fd, events);
+	}
+	break;
+#endif
+      case NDET_BACKEND_POLL:
+	n = poll(ndet_pollfds, (nfds_t) ndet_pollfds_used, timeout);
+	if (n == -1)
+	    return (-1);
+	if (ndet_pollfds_start >= ndet_pollfds_used)
+	    ndet_pollfds_start = 0;
+	for (j = 0; j < ndet_pollfds_used && n > 0; j++) {
+	    short           revents;
+	    u_int           events = 0;
+
+	    i = (ndet_pollfds_start + j) % ndet_pollfds_used;
+	    if ((revents = ndet_pollfds[i].revents) == 0)
+		continue;
+	    if (ndet_nready == NDET_READY_MAX) {
+		/* Full: start with this one next time */
+		ndet_pollfds_start = i;
+		break;
+	    }
+	    n--;
+	    if (revents & POLLNVAL) {
+		/* Same complaint that select makes about a closed fd */
+		errno = EBADF;
+		ndet_nready = 0;
+		return (-1);
+	    }
+	    if (revents & (POLLIN | POLLHUP | POLLERR))
+		events |= NDET_FD_IN;
+	    if (revents & (POLLOUT | POLLHUP | POLLERR))
+		events |= NDET_FD_OUT;
+	    if (revents & POLLPRI)
+		events |= NDET_FD_EXC;
+	    ndet_ready_add(ndet_pollfds[i].fd, events);
+	}
+	break;
+      default:
+	errno = EINVAL;
+	return (-1);
+    }
+    if (ndet_always_count > 0)
+	for (i = 0; i < ndet_slots_size; i++)
+	    if (ndet_slots[i].flags & NDET_SLOT_ALWAYS)
+		ndet_ready_add(i, ndet_slots[i].events);
+    return (ndet_nready);
+}
+
+/*
+ * Hand the results of the last ndet_pollset_wait to the dispatcher.
+ * Internal fds are drained here too.
+ */
+pkg_private     NTFY_ENUM
+ndet_pollset_send()
+{
+    NDET_FD_SLOT   *slot;
+    NTFY_CNDTBL    *watch;
+    u_int           bit;
+    int             i, fd;
+
+    ntfy_assert(NTFY_IN_CRITICAL, 41 /* Unprotected pollset send */);
+    for (i = 0; i < ndet_nready; i++) {
+	fd = ndet_ready[i].fd;
+	if ((slot = ndet_slot(fd, 0)) == (NDET_FD_SLOT *) 0)
+	    continue;
+	if (slot->drain)
+	    slot->drain(fd);
+	/*
+	 * Ndis_enqueue doesn't call out to clients, so the watch list can't
+	 * change underneath us.
+	 */
+	for (watch = slot->watch; watch; watch = watch->next) {
+	    switch (watch->condition->type) {
+	      case NTFY_INPUT:
+		bit = NDET_FD_IN;
+		break;
+	      case NTFY_OUTPUT:
+		bit = NDET_FD_OUT;
+		break;
+	      case NTFY_EXCEPTION:
+		bit = NDET_FD_EXC;
+		break;
+	      default:
+		continue;
+	    }
+	    if ((ndet_ready[i].events & bit) &&
+		ndis_enqueue(watch->client, watch->condition) != NOTIFY_OK)
+		/* Internal fatal error */
+		return (NTFY_ENUM_TERM);
+	}
+    }
+    ndet_nready = 0;
+    return (NTFY_ENUM_NEXT);
+}
+
+static NDET_FD_SLOT *
+ndet_slot(fd, create)
+    int             fd;
+    int             create;
+{
+    int             new_size, i;
+
+    if (fd < 0)
+	return ((NDET_FD_SLOT *) 0);
+    if (fd >= ndet_slots_size) {
+	if (!create)
+	    return ((NDET_FD_SLOT *) 0);
+	for (new_size = ndet_slots_size ? ndet_slots_size : 64;
+	     new_size <= fd; new_size *= 2) {
+	}
+	ndet_slots = (NDET_FD_SLOT *) (ndet_slots ?
+		xv_realloc(ndet_slots, new_size * sizeof(NDET_FD_SLOT)) :
+		xv_malloc(new_size * sizeof(NDET_FD_SLOT)));
+	for (i = ndet_slots_size; i < new_size; i++) {
+	    ndet_slots[i].watch = (NTFY_CNDTBL *) 0;
+	    ndet_slots[i].drain = 0;
+	    ndet_slots[i].events = 0;
+	    ndet_slots[i].flags = 0;
+	    ndet_slots[i].index = -1;
+	}
+	ndet_slots_size = new_size;
+    }
+    return (&ndet_slots[fd]);
+}
+
+/*
+ * Events this fd should be waited on for.  Fasync fds are handled by
+ * SIGIO/SIGURG (see ndet_fig_fd_change) and are left out.
+ */
+static          u_int
+ndet_slot_wanted(fd, slot)
+    int             fd;
+    NDET_FD_SLOT   *slot;
+{
+    NTFY_CNDTBL    *watch;
+    u_int           events = 0;
+
+    if (slot->drain)
+	return (NDET_FD_IN);
+    if (fd < FD_SETSIZE && FD_ISSET(fd, &ndet_fasync_mask))
+	return (0);
+    for (watch = slot->watch; watch; watch = watch->next) {
+	switch (watch->condition->type) {
+	  case NTFY_INPUT:
+	    events |= NDET_FD_IN;
+	    break;
+	  case NTFY_OUTPUT:
+	    events |= NDET_FD_OUT;
+	    break;
+	  case NTFY_EXCEPTION:
+	    events |= NDET_FD_EXC;
+	    break;
+	  default:{
+	    }
+	}
+    }
+    return (events);
+}
+
+/*
+ * Bring the kernel's view of fd in line with its watch list, and keep
+ * ndet_*bits current for the select path (rpc and ndet_auto use them).
+ */
+static void
+ndet_slot_sync(fd, slot)
+    int             fd;
+    NDET_FD_SLOT   *slot;
+{
+    u_int           events = ndet_slot_wanted(fd, slot);
+
+    if (fd < FD_SETSIZE && !slot->drain) {
+	if (events & NDET_FD_IN)
+	    FD_SET(fd, &ndet_ibits);
+	else
+	    FD_CLR(fd, &ndet_ibits);
+	if (events & NDET_FD_OUT)
+	    FD_SET(fd, &ndet_obits);
+	else
+	    FD_CLR(fd, &ndet_obits);
+	if (events & NDET_FD_EXC)
+	    FD_SET(fd, &ndet_ebits);
+	else
+	    FD_CLR(fd, &ndet_ebits);
+    }
+    /* Nothing to do if the kernel already waits on exactly these */
+    if (events == slot->events &&
+	(events == 0 || (slot->flags & (NDET_SLOT_KERNEL | NDET_SLOT_ALWAYS))))
+	return;
+    if (ndet_backend == NDET_BACKEND_NONE)
+	(void) ndet_pollset_init();
+    if (ndet_kernel_update(fd, slot, events) == 0)
+	slot->events = events;
+}
+
+#ifdef NDET_EPOLL
+static int
+ndet_epoll_create()
+{
+    int             epfd;
+
+#ifdef EPOLL_CLOEXEC
+    epfd = epoll_create1(EPOLL_CLOEXEC);
+#else
+    if ((epfd = epoll_create(NDET_READY_MAX)) >= 0)
+	(void) fcntl(epfd, F_SETFD, FD_CLOEXEC);
+#endif
+    return (epfd);
+}
+
+/*
+ * An fd was closed or dup'd behind the notifier's back.  Epoll keys its
+ * registrations on the open file, so a registration made through that fd
+ * can outlive it (and report under its old number) while a dup keeps the
+ * file open, and it can no longer be deleted by number.  Start over with a
+ * fresh instance holding just what the slots say.
+ */
+static void
+ndet_epoll_rebuild()
+{
+    int             epfd, fd;
+
+    if ((epfd = ndet_epoll_create()) < 0)
+	return;
+    (void) close(ndet_epoll_fd);
+    ndet_epoll_fd = epfd;
+    for (fd = 0; fd < ndet_slots_size; fd++)
+	if ((ndet_slots[fd].flags & NDET_SLOT_KERNEL) &&
+	    ndet_epoll_ctl(EPOLL_CTL_ADD, fd, ndet_slots[fd].events) != 0)
+	    ndet_slots[fd].flags &= ~NDET_SLOT_KERNEL;
+}
+
+static int
+ndet_epoll_ctl(op, fd, events)
+    int             op, fd;
+    u_int           events;
+{
+    struct epoll_event ev;
+
+    ev.events = ((events & NDET_FD_IN) ? EPOLLIN : 0) |
+	((events & NDET_FD_OUT) ? EPOLLOUT : 0) |
+	((events & NDET_FD_EXC) ? EPOLLPRI : 0);
+    ev.data.u64 = 0;
+    ev.data.fd = fd;
+    return (epoll_ctl(ndet_epoll_fd, op, fd, &ev));
+}
+#endif
+
+static int
+ndet_kernel_update(fd, slot, events)
+    int             fd;
+    NDET_FD_SLOT   *slot;
+    u_int           events;
+{
+    int             last;
+
+    /* Unpollable fds never made it into the kernel */
+    if (slot->flags & NDET_SLOT_ALWAYS) {
+	if (events)
+	    return (0);
+	slot->flags &= ~NDET_SLOT_ALWAYS;
+	ndet_always_count--;
+	return (0);
+    }
+    switch (ndet_backend) {
+#ifdef NDET_EPOLL
+      case NDET_BACKEND_EPOLL:
+	if (events == 0) {
+	    /*
+	     * A closed fd is gone from the set unless a dup keeps its file
+	     * open, and then only a rebuild gets rid of it.  ENOENT means
+	     * the number has since been reused for another file.
+	     */
+	    if ((slot->flags & NDET_SLOT_KERNEL) &&
+		ndet_epoll_ctl(EPOLL_CTL_DEL, fd, 0) != 0 &&
+		(errno == EBADF || errno == ENOENT)) {
+		slot->flags &= ~NDET_SLOT_KERNEL;
+		ndet_epoll_rebuild();
+	    }
+	    slot->flags &= ~NDET_SLOT_KERNEL;
+	    return (0);
+	}
+	if (slot->flags & NDET_SLOT_KERNEL) {
+	    if (ndet_epoll_ctl(EPOLL_CTL_MOD, fd, events) == 0)
+		return (0);
+	    /* Closed (and perhaps reopened) behind our back */
+	    slot->flags &= ~NDET_SLOT_KERNEL;
+	    if (errno != EBADF && errno != ENOENT)
+		return (-1);
+	    ndet_epoll_rebuild();
+	}
+	if (ndet_epoll_ctl(EPOLL_CTL_ADD, fd, events) == 0) {
+	    slot->flags |= NDET_SLOT_KERNEL;
+	    return (0);
+	}
+	if (errno == EEXIST) {
+	    /* Registered through an fd we no longer know about */
+	    ndet_epoll_rebuild();
+	    if (ndet_epoll_ctl(EPOLL_CTL_ADD, fd, events) == 0) {
+		slot->flags |= NDET_SLOT_KERNEL;
+		return (0);
+	    }
+	}
+	if (errno == EPERM) {
+	    /* Regular files and the like; select calls them ready */
+	    slot->flags &= ~NDET_SLOT_KERNEL;
+	    slot->flags |= NDET_SLOT_ALWAYS;
+	    ndet_always_count++;
+	    return (0);
+	}
+	/* Bad fd: leave it out, the condition stays for notify_remove */
+	slot->flags &= ~NDET_SLOT_KERNEL;
+	return (-1);
+#endif
+      case NDET_BACKEND_POLL:
+	if (events == 0) {
+	    if (slot->index < 0)
+		return (0);
+	    /* Move the last pollfd into the hole */
+	    last = --ndet_pollfds_used;
+	    if (slot->index != last) {
+		ndet_pollfds[slot->index] = ndet_pollfds[last];
+		ndet_slots[ndet_pollfds[slot->index].fd].index = slot->index;
+	    }
+	    slot->index = -1;
+	    slot->flags &= ~NDET_SLOT_KERNEL;
+	    return (0);
+	}
+	if (slot->index < 0) {
+	    if (ndet_pollfds_used == ndet_pollfds_size) {
+		ndet_pollfds_size = ndet_pollfds_size ?
+		    ndet_pollfds_size * 2 : 32;
+		ndet_pollfds = (struct pollfd *) (ndet_pollfds ?
+		    xv_realloc(ndet_pollfds,
+			       ndet_pollfds_size * sizeof(struct pollfd)) :
+		    xv_malloc(ndet_pollfds_size * sizeof(struct pollfd)));
+	    }
+	    slot->index = ndet_pollfds_used++;
+	    ndet_pollfds[slot->index].fd = fd;
+	    ndet_pollfds[slot->index].revents = 0;
+	}
+	ndet_pollfds[slot->index].events =
+	    ((events & NDET_FD_IN) ? POLLIN : 0) |
+	    ((events & NDET_FD_OUT) ? POLLOUT : 0) |
+	    ((events & NDET_FD_EXC) ? POLLPRI : 0);
+	slot->flags |= NDET_SLOT_KERNEL;
+	return (0);
+      default:
+	return (-1);
+    }
+}
+
+static void
+ndet_ready_add(fd, events)
+    int             fd;
+    u_int           events;
+{
+    if (events && ndet_nready < NDET_READY_MAX) {
+	ndet_ready[ndet_nready].fd = fd;
+	ndet_ready[ndet_nready].events = events;
+	ndet_nready++;
+    }
+}
+
+#endif				/* NDET_POLLSET */
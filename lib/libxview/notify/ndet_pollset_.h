@@ -0,0 +1,15 @@
+#if !defined(NDET_POLLSET__H)
+#define NDET_POLLSET__H
+
+#include <xview/pkg.h>
+#include <xview_private/ntfy.h>
+
+pkg_private int ndet_pollset_init(void);
+pkg_private void ndet_pollset_watch(NTFY_CLIENT *client, NTFY_CONDITION *condition);
+pkg_private void ndet_pollset_unwatch(NTFY_CLIENT *client, NTFY_CONDITION *condition);
+pkg_private void ndet_pollset_internal(int fd, void (*drain)());
+pkg_private void ndet_pollset_resync(void);
+pkg_private int ndet_pollset_wait(struct timeval *tv);
+pkg_private NTFY_ENUM ndet_pollset_send(void);
+
+#endif
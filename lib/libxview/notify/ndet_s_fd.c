@@ -47,8 +47,8 @@ ndet_set_fd_func(nclient, func, fd, type)
 				   &ndet_client_latest)) == NTFY_CLIENT_NULL)
 	goto Done;
     /* Find/create condition */
-    if ((condition = ntfy_new_condition(&(client->conditions), type,
-	     &(client->condition_latest), (NTFY_DATA)(long)fd, NTFY_USE_DATA)) ==
+    if ((condition = ntfy_new_condition(client, type,
+					 (NTFY_DATA)(long)fd, NTFY_USE_DATA)) ==
 	NTFY_CONDITION_NULL)
 	goto Done;
     ntfy_add_to_table(client, condition, type);
@@ -61,11 +61,21 @@ ndet_set_fd_func(nclient, func, fd, type)
 	ntfy_unset_condition(&ndet_clients, client, condition,
 			     &ndet_client_latest, NTFY_NDET);
     }
+#ifdef NDET_POLLSET
+    /*
+     * The condition table has already updated the kernel's interest set.
+     * Only async fds need the notifier to adjust signal handling (e.g.,
+     * SIGIO & SIGURG) next time around the loop.
+     */
+    if (fd < FD_SETSIZE && FD_ISSET(fd, &ndet_fasync_mask))
+	ndet_flags |= NDET_FD_CHANGE;
+#else
     /*
      * Have notifier check for fd activity next time around loop. Will notice
      * and adjust signal handling (e.g., SIGIO & SIGURG) at this time.
      */
     ndet_flags |= NDET_FD_CHANGE;
+#endif
 Done:
     NTFY_END_CRITICAL;
     return (old_func);
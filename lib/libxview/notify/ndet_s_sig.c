@@ -53,8 +53,8 @@ notify_set_signal_func(nclient, func, sig, mode)
 				   &ndet_client_latest)) == NTFY_CLIENT_NULL)
 	goto Done;
     /* Find/create condition */
-    if ((condition = ntfy_new_condition(&(client->conditions), type,
-	    &(client->condition_latest), (NTFY_DATA)(long)sig, NTFY_USE_DATA)) ==
+    if ((condition = ntfy_new_condition(client, type,
+					 (NTFY_DATA)(long)sig, NTFY_USE_DATA)) ==
 	NTFY_CONDITION_NULL)
 	goto Done;
     ntfy_add_to_table(client, condition, type);
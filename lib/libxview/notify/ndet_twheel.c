@@ -0,0 +1,544 @@
+/*
+ * Ndet_twheel.c - Real interval timers for the detector.
+ *
+ * Real itimers used to share one process ITIMER_REAL: every change and
+ * every SIGALRM enumerated all real itimer conditions to find the next
+ * expiration and set the process timer again.  Here each real itimer is
+ * linked into a hierarchical timer wheel of millisecond ticks when it is
+ * set, so arming and cancelling don't depend on how many itimers exist.
+ * The notification loop sleeps until the wheel's next event, on a timerfd
+ * in the pollset where available and on the select/poll timeout otherwise,
+ * and then moves the wheel forward and enqueues whatever came due.
+ *
+ * The wheel has NDET_WHEEL_LEVELS levels of NDET_WHEEL_SIZE slots.  A level
+ * 0 slot is one tick, a level n slot spans NDET_WHEEL_SIZE^n ticks, and the
+ * entries of a level n slot are redistributed to lower levels ("cascaded")
+ * when the wheel reaches the start of that slot.  Per level occupancy masks
+ * let the wheel skip empty stretches.
+ */
+
+#include <xview_private/ndet_twheel_.h>
+#include <xview_private/ndet_pollset_.h>
+#include <xview_private/ndetitimer_.h>
+#include <xview_private/ntfy_debug_.h>
+#include <xview_private/ntfy_node_.h>
+#include <xview_private/ntfyprotec_.h>
+#include <xview_private/ndet.h>
+
+pkg_private_data int ndet_twheel_count = 0;	/* Entries on the wheel */
+
+#ifdef NDET_TWHEEL
+
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#ifdef NDET_TIMERFD
+#include <sys/timerfd.h>
+#endif
+
+#define	NDET_WHEEL_BITS		5
+#define	NDET_WHEEL_SIZE		(1 << NDET_WHEEL_BITS)
+#define	NDET_WHEEL_MASK		(NDET_WHEEL_SIZE - 1)
+#define	NDET_WHEEL_LEVELS	6
+#define	NDET_WHEEL_SPAN		(1L << (NDET_WHEEL_BITS * NDET_WHEEL_LEVELS))
+					/* Ticks the wheel can hold (~12 days);
+					 * longer itimers are re-armed when
+					 * they reach the end of it */
+
+#define	NDET_WHEEL_IDLE		0	/* Not linked anywhere */
+#define	NDET_WHEEL_QUEUED	1	/* In a wheel slot */
+#define	NDET_WHEEL_EXPIRED	2	/* On the expired list */
+#define	NDET_WHEEL_POLLING	3	/* Polling itimer (NDET_REAL_POLL) */
+
+static NTFY_WHEEL *ndet_wheel[NDET_WHEEL_LEVELS][NDET_WHEEL_SIZE];
+static u_int    ndet_wheel_bits[NDET_WHEEL_LEVELS];	/* Occupied slots */
+static u_long   ndet_wheel_now;		/* Next tick to be processed */
+static int      ndet_wheel_polling;	/* Polling itimers */
+static struct timespec ndet_wheel_base;	/* Time of tick 0 */
+static int      ndet_wheel_started;
+
+#ifdef NDET_TIMERFD
+static int      ndet_timerfd = -1;	/* -2 when timerfd is unavailable */
+static int      ndet_timerfd_armed;
+static u_long   ndet_timerfd_tick;	/* Tick the timerfd is armed for */
+#endif
+
+static u_long   ndet_wheel_clock(struct timespec *ts);
+static long     ndet_wheel_phase(struct timespec *ts);
+static void     ndet_wheel_link(NTFY_WHEEL *entry);
+static void     ndet_wheel_unlink(NTFY_WHEEL *entry);
+static void     ndet_wheel_cascade(int level, int index);
+static u_long   ndet_wheel_next(void);
+static void     ndet_wheel_advance(u_long target, NTFY_WHEEL **expired);
+#ifdef NDET_TIMERFD
+static int      ndet_timerfd_set(int arm, u_long tick);
+static void     ndet_timerfd_drain(int fd);
+#endif
+
+/*
+ * Put a real itimer condition on the wheel (or take note that it polls)
+ * according to its current it_value.  Returns -1 if no node was available.
+ */
+pkg_private int
+ndet_twheel_arm(client, condition)
+    NTFY_CLIENT    *client;
+    NTFY_CONDITION *condition;
+{
+    NTFY_ITIMER    *ntfy_itimer = condition->data.ntfy_itimer;
+    NTFY_WHEEL     *entry;
+    struct timeval *tv = &ntfy_itimer->itimer.it_value;
+    struct timespec ts;
+    long            ticks;
+    u_long          now;
+    int             rc = 0;
+
+    NTFY_BEGIN_CRITICAL;
+    if ((entry = ntfy_itimer->wheel) == (NTFY_WHEEL *) 0) {
+	if ((entry = ntfy_alloc_wheel()) == (NTFY_WHEEL *) 0) {
+	    rc = -1;
+	    goto Done;
+	}
+	entry->state = NDET_WHEEL_IDLE;
+	ntfy_itimer->wheel = entry;
+    } else
+	ndet_wheel_unlink(entry);
+    entry->client = client;
+    entry->condition = condition;
+    if (ndet_tv_polling(*tv)) {
+	/* Sent every time around the loop by ndet_poll_send */
+	entry->state = NDET_WHEEL_POLLING;
+	ndet_wheel_polling++;
+	ndet_flags |= NDET_REAL_POLL;
+	goto Done;
+    }
+    if (tv->tv_sec >= (NDET_WHEEL_SPAN - 1000) / 1000) {
+	ticks = NDET_WHEEL_SPAN - 1;
+	entry->clamped = 1;
+    } else {
+	ticks = tv->tv_sec * 1000 + (tv->tv_usec + 999) / 1000;
+	entry->clamped = 0;
+    }
+    now = ndet_wheel_clock(&ts);
+    /* Never early: count the part of the current tick as a whole tick */
+    if (ndet_wheel_phase(&ts))
+	ticks++;
+    /* An empty wheel has nothing to catch up on */
+    if (ndet_twheel_count == 0)
+	ndet_wheel_now = now;
+    entry->expires = now + ticks;
+    ndet_wheel_link(entry);
+Done:
+    NTFY_END_CRITICAL;
+    return (rc);
+}
+
+/*
+ * Called by ntfy_remove_from_table when a real itimer condition leaves the
+ * condition table; the node goes with the condition's NTFY_ITIMER.
+ */
+pkg_private void
+ndet_twheel_cancel(condition)
+    NTFY_CONDITION *condition;
+{
+    NTFY_ITIMER    *ntfy_itimer = condition->data.ntfy_itimer;
+
+    if (ntfy_itimer == (NTFY_ITIMER *) 0 ||
+	ntfy_itimer->wheel == (NTFY_WHEEL *) 0)
+	return;
+    NTFY_BEGIN_CRITICAL;
+    ndet_wheel_unlink(ntfy_itimer->wheel);
+    ntfy_free_node((NTFY_NODE *) ntfy_itimer->wheel);
+    ntfy_itimer->wheel = (NTFY_WHEEL *) 0;
+    NTFY_END_CRITICAL;
+}
+
+/*
+ * Move the wheel up to the current time and enqueue notifications for the
+ * itimers that came due.  Periodic itimers are put back on the wheel.
+ */
+pkg_private void
+ndet_twheel_expire()
+{
+    NTFY_WHEEL     *expired = (NTFY_WHEEL *) 0, *entry;
+    NTFY_CLIENT    *client;
+    NTFY_CONDITION *condition;
+    struct timeval  tod;
+
+    ntfy_assert(NTFY_IN_CRITICAL, 43 /* Unprotected itimer expiration */);
+    if (ndet_twheel_count == 0)
+	return;
+    ndet_wheel_advance(ndet_wheel_clock((struct timespec *) 0), &expired);
+    while ((entry = expired) != (NTFY_WHEEL *) 0) {
+	ndet_wheel_unlink(entry);
+	client = entry->client;
+	condition = entry->condition;
+	if (entry->clamped) {
+	    /* Only reached the end of the wheel, see if really due */
+	    (void) gettimeofday(&tod, (struct timezone *) 0);
+	    condition->data.ntfy_itimer->itimer.it_value =
+		ndet_real_min(condition->data.ntfy_itimer, tod);
+	    if (timerisset(&condition->data.ntfy_itimer->itimer.it_value)) {
+		condition->data.ntfy_itimer->set_tv = tod;
+		(void) ndet_twheel_arm(client, condition);
+		continue;
+	    }
+	}
+	/*
+	 * Dispatch notification, reset itimer value, remove if nothing to
+	 * wait for (returns !0, and the entry is gone).
+	 */
+	if (!ndet_itimer_expired(client, condition)) {
+	    ndet_reset_itimer_set_tv(condition);
+	    (void) ndet_twheel_arm(client, condition);
+	}
+    }
+}
+
+/*
+ * Return how long the loop may wait given the wheel, timer being what it
+ * would wait for otherwise.  When the pollset carries the timerfd it is
+ * armed instead and timer is returned unchanged.
+ */
+pkg_private struct timeval *
+ndet_twheel_timeout(timer, tv, pollset)
+    struct timeval *timer;
+    struct timeval *tv;
+    int             pollset;
+{
+    struct timespec ts;
+    u_long          next, now;
+    long            ticks, nsec;
+
+    if (ndet_twheel_count == 0) {
+#ifdef NDET_TIMERFD
+	if (ndet_timerfd_armed)
+	    (void) ndet_timerfd_set(FALSE, (u_long) 0);
+#endif
+	return (timer);
+    }
+    next = ndet_wheel_next();
+#ifdef NDET_TIMERFD
+    if (pollset && ndet_timerfd_set(TRUE, next))
+	return (timer);
+#endif
+    now = ndet_wheel_clock(&ts);
+    ticks = (long) (next - now);
+    if (ticks <= 0)
+	timerclear(tv);
+    else {
+	/* Less the part of the current tick that has gone by */
+	nsec = ndet_wheel_phase(&ts);
+	tv->tv_sec = ticks / 1000;
+	tv->tv_usec = (ticks % 1000) * 1000 - nsec / 1000;
+	if (tv->tv_usec < 0) {
+	    tv->tv_sec--;
+	    tv->tv_usec += 1000000;
+	}
+    }
+    if (timer == NTFY_TIMEVAL_NULL || timercmp(tv, timer, <))
+	return (tv);
+    return (timer);
+}
+
+/*
+ * Ticks (ms) since the wheel started.  The monotonic clock is used where
+ * there is one so that setting the date doesn't move itimers.
+ */
+static          u_long
+ndet_wheel_clock(ts)
+    struct timespec *ts;
+{
+    struct timespec now;
+    long            sec, nsec;
+
+#ifdef CLOCK_MONOTONIC
+    if (clock_gettime(CLOCK_MONOTONIC, &now) == -1)
+#endif
+    {
+	struct timeval  tod;
+
+	(void) gettimeofday(&tod, (struct timezone *) 0);
+	now.tv_sec = tod.tv_sec;
+	now.tv_nsec = tod.tv_usec * 1000;
+    }
+    if (!ndet_wheel_started) {
+	ndet_wheel_base = now;
+	ndet_wheel_started = 1;
+    }
+    if (ts)
+	*ts = now;
+    sec = now.tv_sec - ndet_wheel_base.tv_sec;
+    nsec = now.tv_nsec - ndet_wheel_base.tv_nsec;
+    if (nsec < 0) {
+	sec--;
+	nsec += 1000000000;
+    }
+    return ((u_long) sec * 1000 + nsec / 1000000);
+}
+
+/* Nanoseconds that ts is into its tick */
+static long
+ndet_wheel_phase(ts)
+    struct timespec *ts;
+{
+    long            nsec = (ts->tv_nsec - ndet_wheel_base.tv_nsec) % 1000000;
+
+    return (nsec < 0 ? nsec + 1000000 : nsec);
+}
+
+/* Put entry in the slot that matches its distance from ndet_wheel_now */
+static void
+ndet_wheel_link(entry)
+    NTFY_WHEEL     *entry;
+{
+    long            delta = (long) (entry->expires - ndet_wheel_now);
+    u_long          when = entry->expires;
+    NTFY_WHEEL    **slot;
+    int             level;
+
+    if (delta < 0) {
+	/* Overdue, goes out with the next tick */
+	delta = 0;
+	when = ndet_wheel_now;
+    }
+    for (level = 0; level < NDET_WHEEL_LEVELS - 1; level++)
+	if (delta < (1L << (NDET_WHEEL_BITS * (level + 1))))
+	    break;
+    entry->level = level;
+    entry->index = (when >> (NDET_WHEEL_BITS * level)) & NDET_WHEEL_MASK;
+    slot = &ndet_wheel[level][entry->index];
+    entry->next = *slot;
+    if (*slot)
+	(*slot)->pprev = &entry->next;
+    entry->pprev = slot;
+    *slot = entry;
+    ndet_wheel_bits[level] |= 1 << entry->index;
+    entry->state = NDET_WHEEL_QUEUED;
+    ndet_twheel_count++;
+}
+
+static void
+ndet_wheel_unlink(entry)
+    NTFY_WHEEL     *entry;
+{
+    switch (entry->state) {
+      case NDET_WHEEL_QUEUED:
+	ndet_twheel_count--;
+	if (ndet_wheel[entry->level][entry->index] == entry &&
+	    entry->next == (NTFY_WHEEL *) 0)
+	    ndet_wheel_bits[entry->level] &= ~(1 << entry->index);
+	/* Fall through */
+      case NDET_WHEEL_EXPIRED:
+	*entry->pprev = entry->next;
+	if (entry->next)
+	    entry->next->pprev = entry->pprev;
+	break;
+      case NDET_WHEEL_POLLING:
+	if (--ndet_wheel_polling == 0)
+	    ndet_flags &= ~NDET_REAL_POLL;
+	break;
+      default:{
+	}
+    }
+    entry->state = NDET_WHEEL_IDLE;
+}
+
+/* Redistribute the entries of a level's slot to the levels below */
+static void
+ndet_wheel_cascade(level, index)
+    int             level, index;
+{
+    NTFY_WHEEL     *entry, *next;
+
+    entry = ndet_wheel[level][index];
+    ndet_wheel[level][index] = (NTFY_WHEEL *) 0;
+    ndet_wheel_bits[level] &= ~(1 << index);
+    for (; entry; entry = next) {
+	next = entry->next;
+	ndet_twheel_count--;
+	ndet_wheel_link(entry);
+    }
+}
+
+/* Offset from start to the first set bit of bits, going around */
+static int
+ndet_wheel_first(bits, start)
+    u_int           bits;
+    int             start;
+{
+    int             n;
+
+    if (start)
+	bits = (bits >> start) | (bits << (NDET_WHEEL_SIZE - start));
+    for (n = 0; !(bits & 1); n++)
+	bits >>= 1;
+    return (n);
+}
+
+/*
+ * The next tick at which the wheel has something to do: a level 0 slot to
+ * expire or a higher level slot to cascade.  Only valid if entries are on
+ * the wheel.
+ */
+static          u_long
+ndet_wheel_next()
+{
+    u_long          next = 0, tick, base;
+    int             level, shift, index, d, found = 0;
+
+    for (level = 0; level < NDET_WHEEL_LEVELS; level++) {
+	if (!ndet_wheel_bits[level])
+	    continue;
+	shift = NDET_WHEEL_BITS * level;
+	base = ndet_wheel_now >> shift;
+	index = base & NDET_WHEEL_MASK;
+	if (level == 0 || !(ndet_wheel_now & ((1UL << shift) - 1)))
+	    /* The current slot hasn't been processed yet */
+	    d = ndet_wheel_first(ndet_wheel_bits[level], index);
+	else
+	    /* The current slot is a full turn away */
+	    d = ndet_wheel_first(ndet_wheel_bits[level],
+				 (index + 1) & NDET_WHEEL_MASK) + 1;
+	tick = (base + d) << shift;
+	if (!found || (long) (tick - next) < 0) {
+	    next = tick;
+	    found = 1;
+	}
+    }
+    return (next);
+}
+
+/*
+ * Process ticks up to and including target.  Due entries are moved to the
+ * expired list rather than being sent from here so that the caller can
+ * deal with itimers that are reset or removed while they are sent.
+ */
+static void
+ndet_wheel_advance(target, expired)
+    u_long          target;
+    NTFY_WHEEL    **expired;
+{
+    NTFY_WHEEL     *entry, *next, **tail;
+    u_long          tick;
+    int             level, index;
+
+    for (tail = expired; *tail; tail = &(*tail)->next) {
+    }
+    while (ndet_twheel_count > 0) {
+	tick = ndet_wheel_next();
+	if ((long) (tick - target) > 0)
+	    break;
+	ndet_wheel_now = tick;
+	index = tick & NDET_WHEEL_MASK;
+	if (index == 0)
+	    for (level = 1; level < NDET_WHEEL_LEVELS; level++) {
+		int             i = (tick >> (NDET_WHEEL_BITS * level)) &
+		NDET_WHEEL_MASK;
+
+		ndet_wheel_cascade(level, i);
+		if (i)
+		    break;
+	    }
+	entry = ndet_wheel[0][index];
+	ndet_wheel[0][index] = (NTFY_WHEEL *) 0;
+	ndet_wheel_bits[0] &= ~(1 << index);
+	for (; entry; entry = next) {
+	    next = entry->next;
+	    ndet_twheel_count--;
+	    entry->state = NDET_WHEEL_EXPIRED;
+	    entry->next = (NTFY_WHEEL *) 0;
+	    entry->pprev = tail;
+	    *tail = entry;
+	    tail = &entry->next;
+	}
+	ndet_wheel_now = tick + 1;
+    }
+    if ((long) (target + 1 - ndet_wheel_now) > 0)
+	ndet_wheel_now = target + 1;
+}
+
+#ifdef NDET_TIMERFD
+/*
+ * Arm the timerfd for tick, or disarm it.  The timerfd is created and added
+ * to the pollset on first use.  Returns 0 if there is no timerfd.
+ */
+static int
+ndet_timerfd_set(arm, tick)
+    int             arm;
+    u_long          tick;
+{
+    struct itimerspec its;
+    struct timespec ts;
+    u_long          now;
+    long            ticks, nsec;
+
+    if (ndet_timerfd == -1) {
+#ifdef TFD_CLOEXEC
+	ndet_timerfd = timerfd_create(CLOCK_MONOTONIC,
+				      TFD_CLOEXEC | TFD_NONBLOCK);
+#else
+	if ((ndet_timerfd = timerfd_create(CLOCK_MONOTONIC, 0)) >= 0) {
+	    (void) fcntl(ndet_timerfd, F_SETFD, FD_CLOEXEC);
+	    (void) fcntl(ndet_timerfd, F_SETFL, O_NDELAY);
+	}
+#endif
+	if (ndet_timerfd < 0) {
+	    ndet_timerfd = -2;
+	    return (0);
+	}
+	ndet_pollset_internal(ndet_timerfd, ndet_timerfd_drain);
+    }
+    if (ndet_timerfd == -2)
+	return (0);
+    if (arm && ndet_timerfd_armed && tick == ndet_timerfd_tick)
+	return (1);
+    its.it_interval.tv_sec = its.it_interval.tv_nsec = 0;
+    its.it_value.tv_sec = its.it_value.tv_nsec = 0;
+    if (arm) {
+	/* Absolute, so the deadline falls on the tick boundary */
+	now = ndet_wheel_clock(&ts);
+	ticks = (long) (tick - now);
+	nsec = ndet_wheel_phase(&ts);
+	its.it_value.tv_sec = ts.tv_sec + ticks / 1000;
+	its.it_value.tv_nsec = ts.tv_nsec - nsec + (ticks % 1000) * 1000000;
+	while (its.it_value.tv_nsec < 0) {
+	    its.it_value.tv_sec--;
+	    its.it_value.tv_nsec += 1000000000;
+	}
+	while (its.it_value.tv_nsec >= 1000000000) {
+	    its.it_value.tv_sec++;
+	    its.it_value.tv_nsec -= 1000000000;
+	}
+	/* A zero it_value would disarm; anything in the past fires now */
+	if (its.it_value.tv_sec <= 0 && its.it_value.tv_nsec == 0)
+	    its.it_value.tv_nsec = 1;
+    }
+    if (timerfd_settime(ndet_timerfd, arm ? TFD_TIMER_ABSTIME : 0,
+			&its, (struct itimerspec *) 0) == -1) {
+	/* Fall back to the loop timeout */
+	ndet_pollset_internal(ndet_timerfd, (void (*) ()) 0);
+	(void) close(ndet_timerfd);
+	ndet_timerfd = -2;
+	ndet_timerfd_armed = 0;
+	return (0);
+    }
+    ndet_timerfd_armed = arm;
+    ndet_timerfd_tick = tick;
+    return (1);
+}
+
+/* ARGSUSED */
+static void
+ndet_timerfd_drain(fd)
+    int             fd;
+{
+    char            buf[8];
+
+    /* Expirations are picked up by ndet_twheel_expire */
+    (void) read(fd, buf, sizeof(buf));
+    ndet_timerfd_armed = 0;
+}
+#endif				/* NDET_TIMERFD */
+
+#endif				/* NDET_TWHEEL */
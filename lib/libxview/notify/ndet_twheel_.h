@@ -0,0 +1,12 @@
+#if !defined(NDET_TWHEEL__H)
+#define NDET_TWHEEL__H
+
+#include <xview/pkg.h>
+#include <xview_private/ntfy.h>
+
+pkg_private int ndet_twheel_arm(NTFY_CLIENT *client, NTFY_CONDITION *condition);
+pkg_private void ndet_twheel_cancel(NTFY_CONDITION *condition);
+pkg_private void ndet_twheel_expire(void);
+pkg_private struct timeval *ndet_twheel_timeout(struct timeval *timer, struct timeval *tv, int pollset);
+
+#endif
@@ -50,8 +50,8 @@ notify_itimer_value(nclient, which, value)
 	goto Error;
     }
     /* Find condition */
-    if ((condition = ntfy_find_condition(client->conditions, type,
-	  &(client->condition_latest), NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
+    if ((condition = ntfy_find_condition(client, type,
+					 NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
 	NTFY_CONDITION_NULL) {
 	ntfy_set_warning(NOTIFY_NO_CONDITION);
 	goto Error;
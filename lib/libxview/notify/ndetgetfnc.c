@@ -42,8 +42,7 @@ ndet_get_func(nclient, type, data, use_data)
 	goto Done;
     }
     /* Find condition */
-    if ((condition = ntfy_find_condition(client->conditions, type,
-			    &(client->condition_latest), data, use_data)) ==
+    if ((condition = ntfy_find_condition(client, type, data, use_data)) ==
 	NTFY_CONDITION_NULL) {
 	ntfy_set_warning(NOTIFY_NO_CONDITION);
 	goto Done;
@@ -47,8 +47,8 @@ notify_post_destroy(nclient, status, when)
 	goto Error;
     }
     /* Find condition that matches type */
-    if ((condition = ntfy_find_condition(client->conditions, NTFY_DESTROY,
-	  &(client->condition_latest), NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
+    if ((condition = ntfy_find_condition(client, NTFY_DESTROY,
+					 NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
 	NTFY_CONDITION_NULL) {
 	ntfy_set_errno(NOTIFY_NO_CONDITION);
 	goto Error;
@@ -21,6 +21,7 @@ static char     sccsid[] = "@(#)ndetpevent.c 20.14 93/06/28 Copyr 1985 Sun Micro
 #include <xview_private/ntfy_debug_.h>
 #include <xview_private/ntfyclient_.h>
 #include <xview_private/ntfy_cond_.h>
+#include <xview_private/ntfy_stats_.h>
 #include <xview_private/ntfyprotec_.h>
 #include <xview_private/ndet.h>
 #include <xview_private/ndis.h>
@@ -123,8 +124,8 @@ ndet_p_event(nclient, event, cond_type, arg, copy_func, release_func,
 	goto Error;
     }
     /* Find condition that matches condition type */
-    if ((condition = ntfy_find_condition(client->conditions, cond_type,
-	  &(client->condition_latest), NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
+    if ((condition = ntfy_find_condition(client, cond_type,
+					 NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
 	NTFY_CONDITION_NULL) {
 	ntfy_set_warning(NOTIFY_NO_CONDITION);
 	goto Error;
@@ -133,6 +134,7 @@ ndet_p_event(nclient, event, cond_type, arg, copy_func, release_func,
     if (cond_type == NTFY_IMMEDIATE_EVENT) {
 	Notify_client   nclient_now;
 	Notify_func     func;
+	u_long          start;
 
 	now_type = NOTIFY_IMMEDIATE;
 Now:
@@ -146,7 +148,9 @@ Now:
 	/* Push condition on interposition stack */
 	func = nint_push_callout(client, condition);
 	NTFY_END_CRITICAL;
+	NTFY_STATS_START(start);
 	*rc = func(nclient_now, event, arg, now_type);
+	NTFY_STATS_CALLOUT(nclient_now, cond_type, start);
 	/* Pop condition from interposition stack */
 	nint_pop_callout();
 	/* Don't protect client from recursive safe events anymore */
@@ -177,8 +181,7 @@ Now:
 		goto Error;
 	    }
 	    /* Check to see if condition still exists */
-	    if (ntfy_find_condition(client->conditions, cond_type,
-				&(client->condition_latest), NTFY_DATA_NULL,
+	    if (ntfy_find_condition(client, cond_type, NTFY_DATA_NULL,
 				    NTFY_IGNORE_DATA) != condition) {
 		ntfy_set_warning(NOTIFY_NO_CONDITION);
 		goto Error;
@@ -17,6 +17,7 @@ static char     sccsid[] = "@(#)ndetremove.c 20.13 93/06/28 Copyr 1985 Sun Micro
 #include <xview_private/ndetremove_.h>
 #include <xview_private/ntfyclient_.h>
 #include <xview_private/ntfyprotec_.h>
+#include <xview_private/ntfy_stats_.h>
 #include <xview_private/ndet.h>
 #include <xview_private/ndis.h>
 
@@ -42,6 +43,7 @@ notify_remove(nclient)
 	 */
 	ndet_flags |= NDET_CONDITION_CHANGE;
     }
+    ntfy_stats_remove(nclient);
     NTFY_END_CRITICAL;
     return (NOTIFY_OK);
 }
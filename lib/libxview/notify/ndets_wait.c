@@ -47,8 +47,8 @@ notify_set_wait3_func(nclient, func, pid)
 				   &ndet_client_latest)) == NTFY_CLIENT_NULL)
 	goto Done;
     /* Find/create condition */
-    if ((condition = ntfy_new_condition(&(client->conditions), NTFY_WAIT3,
-	    &(client->condition_latest), (NTFY_DATA)(long)pid, NTFY_USE_DATA)) ==
+    if ((condition = ntfy_new_condition(client, NTFY_WAIT3,
+					 (NTFY_DATA)(long)pid, NTFY_USE_DATA)) ==
 	NTFY_CONDITION_NULL)
 	goto Done;
     ntfy_add_to_table(client, condition, NTFY_WAIT3);
@@ -41,8 +41,8 @@ notify_set_destroy_func(nclient, func)
 				   &ndet_client_latest)) == NTFY_CLIENT_NULL)
 	goto Done;
     /* Find/create condition */
-    if ((condition = ntfy_new_condition(&(client->conditions), NTFY_DESTROY,
-	  &(client->condition_latest), NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
+    if ((condition = ntfy_new_condition(client, NTFY_DESTROY,
+					 NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
 	NTFY_CONDITION_NULL)
 	goto Done;
     /* Exchange functions */
@@ -45,8 +45,8 @@ notify_set_event_func(nclient, func, when)
 				   &ndet_client_latest)) == NTFY_CLIENT_NULL)
 	goto Done;
     /* Find/create condition */
-    if ((condition = ntfy_new_condition(&(client->conditions), type,
-	  &(client->condition_latest), NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
+    if ((condition = ntfy_new_condition(client, type,
+					 NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
 	NTFY_CONDITION_NULL)
 	goto Done;
     /* Exchange functions */
@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)ndetsitimr.c 20.13 93/06/28 Copyr 1985 Sun Micro
  */
 
 #include <xview_private/ndetsitimr_.h>
+#include <xview_private/ndet_twheel_.h>
 #include <xview_private/ndetitimer_.h>
 #include <xview_private/ndisdispch_.h>
 #include <xview_private/nint_set_.h>
@@ -56,8 +57,8 @@ notify_set_itimer_func(nclient, func, which, value, ovalue)
 				   &ndet_client_latest)) == NTFY_CLIENT_NULL)
 	goto Done;
     /* Find/create condition */
-    if ((condition = ntfy_new_condition(&(client->conditions), type,
-	  &(client->condition_latest), NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
+    if ((condition = ntfy_new_condition(client, type,
+					 NTFY_DATA_NULL, NTFY_IGNORE_DATA)) ==
 	NTFY_CONDITION_NULL)
 	goto Done;
     ntfy_add_to_table(client, condition, type);
@@ -73,8 +74,10 @@ notify_set_itimer_func(nclient, func, which, value, ovalue)
 	    (void) notify_itimer_value(nclient, which, ovalue);
     }
     /* Set condition data */
-    if (condition->data.ntfy_itimer == (struct ntfy_itimer *) 0)
+    if (condition->data.ntfy_itimer == (struct ntfy_itimer *) 0) {
 	condition->data.ntfy_itimer = ntfy_alloc_ntfy_itimer();
+	condition->data.ntfy_itimer->wheel = (NTFY_WHEEL *) 0;
+    }
     condition->data.ntfy_itimer->itimer = *value;
     ndet_reset_itimer_set_tv(condition);
     /* Exchange functions */
@@ -86,6 +89,17 @@ notify_set_itimer_func(nclient, func, which, value, ovalue)
 	ntfy_unset_condition(&ndet_clients, client, condition,
 			     &ndet_client_latest, NTFY_NDET);
     }
+#ifdef NDET_TWHEEL
+    /* Real itimers go straight onto the timer wheel */
+    else if (type == NTFY_REAL_ITIMER &&
+	     ndet_twheel_arm(client, condition)) {
+	ntfy_unset_condition(&ndet_clients, client, condition,
+			     &ndet_client_latest, NTFY_NDET);
+	old_func = NOTIFY_FUNC_NULL;
+	goto Done;
+    }
+    if (type == NTFY_VIRTUAL_ITIMER)
+#endif
     /*
      * Have notifier check for itimer changes next time around loop. Will
      * notice and adjust signal handling at this time.
@@ -29,6 +29,7 @@ static char     sccsid[] = "@(#)ndisdispch.c 20.22 93/06/28 Copyr 1985 Sun Micro
 #include <xview_private/ntfy_debug_.h>
 #include <xview_private/ntfy_list_.h>
 #include <xview_private/ntfy_node_.h>
+#include <xview_private/ntfy_stats_.h>
 #include <xview_private/ntfyprotec_.h>
 #include <xview_private/i18n_impl.h>
 #include <xview_private/ndis.h>
@@ -50,7 +51,9 @@ int             dtablesize_cache = 0;
 #endif /* SVR4 */
 
 static NTFY_ENUM ndis_setup_sched_clients(NTFY_CLIENT *client, NTFY_CONDITION *condition, NTFY_ENUM_DATA context);
+static void ndis_stats_queue(void);
 static Notify_error notify_fd(Notify_client nclient, int fd, NTFY_TYPE type);
+static NTFY_CONDITION *ndis_find_wide_fd(Notify_client nclient);
 static Notify_error ndis_send_func(Notify_client nclient, NTFY_TYPE type, NTFY_DATA data, int use_data, Notify_func *func_ptr, NTFY_DATA *data_ptr, Notify_release *release_func_ptr);
 
 pkg_private_data u_int ndis_flags = 0;
@@ -98,7 +101,7 @@ ndis_enqueue(ndet_client, ndet_condition)
 	goto Error;
     client->prioritizer = ndet_client->prioritizer;
     /* Allocate condition */
-    if ((condition = ntfy_alloc_condition()) == NTFY_CONDITION_NULL)
+    if ((condition = ntfy_alloc_event()) == NTFY_CONDITION_NULL)
 	goto Error;
     /* Initialize condition */
     condition->next = NTFY_CONDITION_NULL;
@@ -125,7 +128,7 @@ ndis_enqueue(ndet_client, ndet_condition)
     if (nint_copy_callout(condition, ndet_condition) != NOTIFY_OK)
 	goto Error;
     /* Append to condition list */
-    ntfy_append_condition(&(client->conditions), condition);
+    ntfy_add_condition(client, condition);
     /* Set up condition hint */
     client->condition_latest = condition;
     /* Set dispatcher flag */
@@ -145,6 +148,8 @@ ndis_dispatch()
 		/* In critical when dispatch */);
     ntfy_assert((!NTFY_IN_INTERRUPT || NTFY_DEAF_INTERRUPT), 20
 		/* In interrupt when dispatch */);
+    /* Clients can dispatch before the notifier is started */
+    ntfy_stats_init();
     NTFY_BEGIN_CRITICAL;
     /* Build nclient list for scheduler */
     for (;;) {
@@ -167,6 +172,8 @@ ndis_dispatch()
 	} else
 	    break;
     }
+    if (ntfy_stats_on)
+	ndis_stats_queue();
     /* Call scheduler */
     sched_func = ndis_scheduler;
     NTFY_END_CRITICAL;
@@ -180,6 +187,21 @@ ndis_dispatch()
     return (NOTIFY_OK);
 }
 
+/* Record how many conditions wait in the dispatcher */
+static void
+ndis_stats_queue()
+{
+    register NTFY_CLIENT *client;
+    register NTFY_CONDITION *condition;
+    int             depth = 0;
+
+    for (client = ndis_clients; client; client = client->next)
+	for (condition = client->conditions; condition;
+	     condition = condition->next)
+	    depth++;
+    ntfy_stats_queue(depth);
+}
+
 /* ARGSUSED */
 static          NTFY_ENUM
 ndis_setup_sched_clients(client, condition, context)
@@ -238,6 +260,12 @@ notify_client(nclient)
     /* Don't make register because take address of them */
     Notify_value(*pri_func) ();
     int             maxfds = GETDTABLESIZE();
+    NTFY_TYPE       type;
+    int             fd;
+
+    /* The prioritizer only gets fd_sets, don't let it walk off the end */
+    if (maxfds > FD_SETSIZE)
+	maxfds = FD_SETSIZE;
 
     /* Check if heap access protected */
     ntfy_assert((!NTFY_IN_INTERRUPT || NTFY_DEAF_INTERRUPT), 21
@@ -263,13 +291,16 @@ Retry_Conditions:
     for (cdn = client->conditions; cdn; cdn = cdn->next) {
 	switch (cdn->type) {
 	  case NTFY_INPUT:
-	    FD_SET(cdn->data.fd, &ibits);
+	    if (cdn->data.fd < FD_SETSIZE)
+		FD_SET(cdn->data.fd, &ibits);
 	    break;
 	  case NTFY_OUTPUT:
-	    FD_SET(cdn->data.fd, &obits);
+	    if (cdn->data.fd < FD_SETSIZE)
+		FD_SET(cdn->data.fd, &obits);
 	    break;
 	  case NTFY_EXCEPTION:
-	    FD_SET(cdn->data.fd, &ebits);
+	    if (cdn->data.fd < FD_SETSIZE)
+		FD_SET(cdn->data.fd, &ebits);
 	    break;
 	  case NTFY_SYNC_SIGNAL:
 	    sigaddset( &sigbits, cdn->data.signal);
@@ -341,6 +372,20 @@ Retry_Conditions:
 	      NSIG, &sigbits, &auto_sigbits, &ndis_event_count, ndis_events,
 		    ndis_args);
     NTFY_BEGIN_CRITICAL;
+    /*
+     * Fds past FD_SETSIZE can't be described to the prioritizer, so send
+     * them directly (by order queued).
+     */
+    while ((cdn = ndis_find_wide_fd(nclient)) != NTFY_CONDITION_NULL) {
+	type = cdn->type;
+	fd = cdn->data.fd;
+	NTFY_END_CRITICAL;
+	if (notify_fd(nclient, fd, type) != NOTIFY_OK) {
+	    NTFY_BEGIN_CRITICAL;
+	    break;
+	}
+	NTFY_BEGIN_CRITICAL;
+    }
     /* Check for NDIS_EVENT_QUEUED and redo loop */
     if (ndis_flags & NDIS_EVENT_QUEUED)
 	goto Retry_Client;
@@ -352,6 +397,31 @@ Error:
     return (notify_errno);
 }
 
+static NTFY_CONDITION *
+ndis_find_wide_fd(nclient)
+    Notify_client   nclient;
+{
+    NTFY_CLIENT    *client;
+    register NTFY_CONDITION *cdn;
+
+    ntfy_assert(NTFY_IN_CRITICAL, 42 /* Unprotected wide fd search */);
+    if ((client = ntfy_find_nclient(ndis_clients, nclient,
+				  &ndis_client_latest)) == NTFY_CLIENT_NULL)
+	return (NTFY_CONDITION_NULL);
+    for (cdn = client->conditions; cdn; cdn = cdn->next)
+	switch (cdn->type) {
+	  case NTFY_INPUT:
+	  case NTFY_OUTPUT:
+	  case NTFY_EXCEPTION:
+	    if (cdn->data.fd >= FD_SETSIZE)
+		return (cdn);
+	    break;
+	  default:{
+	    }
+	}
+    return (NTFY_CONDITION_NULL);
+}
+
 static
                 Notify_error
 notify_fd(nclient, fd, type)
@@ -360,13 +430,16 @@ notify_fd(nclient, fd, type)
     NTFY_TYPE       type;
 {
     Notify_func     func;
+    u_long          start;
 
     /* Check arguments and get function to call */
     if (ndet_check_fd(fd) ||
 	ndis_send_func(nclient, type, (NTFY_DATA)(long)fd, NTFY_USE_DATA,
 		 &func, NTFY_DATA_PTR_NULL, NDIS_RELEASE_NULL) != NOTIFY_OK)
 	return (notify_errno);
+    NTFY_STATS_START(start);
     (void) func(nclient, fd);
+    NTFY_STATS_CALLOUT(nclient, type, start);
     /* Pop condition off interposition stack */
     nint_pop_callout();
     return (NOTIFY_OK);
@@ -403,13 +476,16 @@ notify_itimer(nclient, which)
 {
     NTFY_TYPE       type;
     Notify_func     func;
+    u_long          start;
 
     /* Check arguments and get function to call */
     if (ndet_check_which(which, &type) ||
 	ndis_send_func(nclient, type, NTFY_DATA_NULL, NTFY_IGNORE_DATA,
 		 &func, NTFY_DATA_PTR_NULL, NDIS_RELEASE_NULL) != NOTIFY_OK)
 	return (notify_errno);
+    NTFY_STATS_START(start);
     (void) func(nclient, which);
+    NTFY_STATS_CALLOUT(nclient, type, start);
     /* Pop condition off interposition stack */
     nint_pop_callout();
     return (NOTIFY_OK);
@@ -423,6 +499,7 @@ notify_event(nclient, event, arg)
 {
     Notify_func     func;
     Notify_release  release_func;
+    u_long          start;
 
     /* Get function to call */
     if (ndis_send_func(nclient, NTFY_SAFE_EVENT, (NTFY_DATA) event,
@@ -430,7 +507,9 @@ notify_event(nclient, event, arg)
 	NOTIFY_OK)
 	return (notify_errno);
     (void) ndet_set_event_processing(nclient, 1);
+    NTFY_STATS_START(start);
     (void) func(nclient, event, arg, NOTIFY_SAFE);
+    NTFY_STATS_CALLOUT(nclient, NTFY_SAFE_EVENT, start);
     (void) ndet_set_event_processing(nclient, 0);
     /* Pop condition off interposition stack */
     nint_pop_callout();
@@ -446,6 +525,7 @@ notify_signal(nclient, sig)
     int             sig;
 {
     Notify_func     func;
+    u_long          start;
 
     /* Check arguments and get function to call */
     if (ndet_check_sig(sig) ||
@@ -453,7 +533,9 @@ notify_signal(nclient, sig)
 	     NTFY_USE_DATA, &func, NTFY_DATA_PTR_NULL, NDIS_RELEASE_NULL) !=
 	NOTIFY_OK)
 	return (notify_errno);
+    NTFY_STATS_START(start);
     (void) func(nclient, sig, NOTIFY_SYNC);
+    NTFY_STATS_CALLOUT(nclient, NTFY_SYNC_SIGNAL, start);
     /* Pop condition off interposition stack */
     nint_pop_callout();
     return (NOTIFY_OK);
@@ -465,6 +547,7 @@ notify_destroy(nclient, status)
     Destroy_status  status;
 {
     Notify_func     func;
+    u_long          start;
 
     /* Check arguments and get function to call */
     if (ndet_check_status(status) ||
@@ -473,7 +556,9 @@ notify_destroy(nclient, status)
 	NOTIFY_OK)
 	return (notify_errno);
     ndet_flags &= ~NDET_VETOED;	/* Note: Unprotected */
+    NTFY_STATS_START(start);
     (void) func(nclient, status);
+    NTFY_STATS_CALLOUT(nclient, NTFY_DESTROY, start);
     /* Pop condition off interposition stack */
     nint_pop_callout();
     if ((status == DESTROY_CHECKING) || (status == DESTROY_SAVE_YOURSELF)) {
@@ -499,6 +584,7 @@ notify_wait3(nclient)
     Notify_func     func;
     NTFY_WAIT3_DATA *wd;
     NTFY_CLIENT    *client;
+    u_long          start;
 
     /* Loop until no more wait conditions to notify */
     for (;;) {
@@ -513,8 +599,7 @@ notify_wait3(nclient)
 	NTFY_BEGIN_CRITICAL;
 	if ((client = ntfy_find_nclient(ndis_clients, nclient,
 				&ndis_client_latest)) == NTFY_CLIENT_NULL ||
-	    ntfy_find_condition(client->conditions, NTFY_WAIT3,
-				&(client->condition_latest), NTFY_DATA_NULL,
+	    ntfy_find_condition(client, NTFY_WAIT3, NTFY_DATA_NULL,
 				NTFY_IGNORE_DATA) == NTFY_CONDITION_NULL) {
 	    NTFY_END_CRITICAL;
 	    break;
@@ -525,7 +610,9 @@ notify_wait3(nclient)
 			   NTFY_IGNORE_DATA, &func, (NTFY_DATA *) & wd,
 			   NDIS_RELEASE_NULL) != NOTIFY_OK)
 	    return (notify_errno);
+	NTFY_STATS_START(start);
 	(void) func(nclient, wd->pid, &wd->status, &wd->rusage);
+	NTFY_STATS_CALLOUT(nclient, NTFY_WAIT3, start);
 	/* Free wait record */
 	NTFY_BEGIN_CRITICAL;
 	/* Pop condition off interposition stack */
@@ -558,8 +645,7 @@ ndis_send_func(nclient, type, data, use_data, func_ptr, data_ptr,
 	goto Error;
     }
     /* Find condition */
-    if ((condition = ntfy_find_condition(client->conditions, type,
-			    &(client->condition_latest), data, use_data)) ==
+    if ((condition = ntfy_find_condition(client, type, data, use_data)) ==
 	NTFY_CONDITION_NULL) {
 	ntfy_set_warning(NOTIFY_NO_CONDITION);
 	goto Error;
@@ -603,8 +689,7 @@ ndis_flush_condition(nclient, type, data, use_data)
 				  &ndis_client_latest)) == NTFY_CLIENT_NULL)
 	    break;
 	/* Find condition */
-	if ((condition = ntfy_find_condition(client->conditions, type,
-			    &(client->condition_latest), data, use_data)) ==
+	if ((condition = ntfy_find_condition(client, type, data, use_data)) ==
 	    NTFY_CONDITION_NULL)
 	    break;
 	/* Remove condition */
@@ -43,8 +43,7 @@ nint_remove_func(nclient, func, type, data, use_data)
 	goto Error;
     }
     /* Find condition using data */
-    if ((cond = ntfy_find_condition(client->conditions, type,
-			    &(client->condition_latest), data, use_data)) ==
+    if ((cond = ntfy_find_condition(client, type, data, use_data)) ==
 	NTFY_CONDITION_NULL) {
 	ntfy_set_errno(NOTIFY_NO_CONDITION);
 	goto Error;
@@ -124,9 +124,59 @@ typedef void (*Notify_release)();
 typedef enum notify_dump_type {
 	NOTIFY_ALL = 0,
 	NOTIFY_DETECT = 1,
-	NOTIFY_DISPATCH = 2
+	NOTIFY_DISPATCH = 2,
+	NOTIFY_NODES = 3,	/* Storage allocator counters */
+	NOTIFY_STATS = 4	/* Callout latency summary */
 } Notify_dump_type;
 
+/*
+ * Dispatch statistics (see notify_set_stats).  Times are in microseconds
+ * and are kept in log-linear histograms with 3 significant bits, i.e.,
+ * every bucket is within 12.5% of the values it holds.
+ */
+#define	NOTIFY_HIST_BUCKETS	240
+
+typedef struct notify_histogram {
+	u_long	count;		/* Samples */
+	u_long	total;		/* Sum of samples */
+	u_long	max;		/* Largest sample */
+	u_int	buckets[NOTIFY_HIST_BUCKETS];
+} Notify_histogram;
+
+typedef enum notify_callout_type {	/* Same order as the notifier's */
+	NOTIFY_CALLOUT_INPUT = 1,	/* condition types */
+	NOTIFY_CALLOUT_OUTPUT = 2,
+	NOTIFY_CALLOUT_EXCEPTION = 3,
+	NOTIFY_CALLOUT_SYNC_SIGNAL = 4,
+	NOTIFY_CALLOUT_ASYNC_SIGNAL = 5,
+	NOTIFY_CALLOUT_REAL_ITIMER = 6,
+	NOTIFY_CALLOUT_VIRTUAL_ITIMER = 7,
+	NOTIFY_CALLOUT_WAIT3 = 8,
+	NOTIFY_CALLOUT_SAFE_EVENT = 9,
+	NOTIFY_CALLOUT_IMMEDIATE_EVENT = 10,
+	NOTIFY_CALLOUT_DESTROY = 11,
+	NOTIFY_CALLOUT_TYPES = 12
+} Notify_callout_type;
+
+typedef struct notify_stats {
+	int		enabled;
+	u_long		loops;		/* Times around the notification loop */
+	u_long		wakeups;	/* Returns from select */
+	u_long		wakeups_fd;	/*   with descriptors ready */
+	u_long		wakeups_timeout;/*   when the timeout expired */
+	u_long		wakeups_signal;	/*   interrupted by a signal */
+	u_long		clients_untracked; /* Callouts not in a client entry */
+	Notify_histogram blocked;	/* Time spent waiting in select */
+	Notify_histogram queue_depth;	/* Conditions queued per dispatch */
+	Notify_histogram callouts[NOTIFY_CALLOUT_TYPES];
+					/* Callout time by condition type */
+} Notify_stats;
+
+typedef struct notify_client_stats {
+	Notify_client	client;
+	Notify_histogram callouts;	/* Callout time for the client */
+} Notify_client_stats;
+
 #endif /* ~_NOTIFY_MIN_SYMBOLS */
 
 /*
@@ -427,6 +477,12 @@ EXTERN_FUNCTION(fd_set *ntfy_fd_cpy_xor, (fd_set * a, fd_set *b));
 
 EXTERN_FUNCTION(void notify_dump,
 		(Notify_client nclient, Notify_dump_type type, FILE *file));
+EXTERN_FUNCTION(void notify_set_stats, (int on));
+EXTERN_FUNCTION(Notify_error notify_get_stats, (Notify_stats *stats));
+EXTERN_FUNCTION(int notify_get_client_stats,
+		(Notify_client_stats *clients, int count));
+EXTERN_FUNCTION(u_long notify_histogram_percentile,
+		(Notify_histogram *hist, double percent));
 
 #endif /* ~_NOTIFY_MIN_SYMBOLS */
 
@@ -96,6 +96,8 @@ typedef struct	ntfy_client {
 	u_int	flags;			/* Per client boolean state */
 #define	NCLT_EVENT_PROCESSING	0x01	/* Dispatcher in process of notifying
 					   client of client event */
+	struct	ntfy_client *hash_next;	/* Next client in nclient hash chain
+					   (see ntfy_client.c) */
 } NTFY_CLIENT;
 #define	NTFY_CLIENT_NULL	((NTFY_CLIENT *)0)
 
@@ -155,6 +157,12 @@ typedef struct ntfy_condition {
 	} data;
 	Notify_arg arg;			/* Event arg (ndis only) */
 	Notify_release release;		/* arg release func (ndis only) */
+	struct	ntfy_condition *hash_next;
+					/* Next condition in (client, type,
+					   data) hash chain (see ntfy_cond.c) */
+	struct	ntfy_client *client;	/* Client whose list this is on */
+	u_int	hash_key;		/* Hash of (client, type, data) when
+					   added (data may be snatched later) */
 } NTFY_CONDITION;
 #define	NTFY_CONDITION_NULL	((NTFY_CONDITION *)0)
 #define	NTFY_ITIMER_NULL	((struct itimerval *)0)
@@ -189,8 +197,28 @@ typedef	struct ntfy_itimer {
 					/* VIRTUAL: Most recent interval to
 					   which the process virtual itimer
 					   was set */
+	struct	ntfy_wheel *wheel;	/* REAL: Timer wheel linkage (see
+					   ndet_twheel.c), null until armed */
 } NTFY_ITIMER;
 
+/*
+ * Ntfy_wheel links a NTFY_REAL_ITIMER into the detector's timer wheel.  It
+ * is a node so that itimers can be armed from signal handlers.
+ */
+typedef	struct ntfy_wheel {
+	struct	ntfy_wheel *next;	/* Next in wheel slot (or expired
+					   list) */
+	struct	ntfy_wheel **pprev;	/* Link that points at this entry */
+	NTFY_CLIENT	*client;	/* Owner of the itimer */
+	NTFY_CONDITION	*condition;	/* The NTFY_REAL_ITIMER condition */
+	u_long	expires;		/* Wheel tick (ms) of expiration */
+	u_char	level;			/* Wheel level and slot index */
+	u_char	index;
+	u_char	state;			/* NDET_WHEEL_* in ndet_twheel.c */
+	u_char	clamped;		/* Expiration is past the wheel's span;
+					   recheck set_tv when it comes due */
+} NTFY_WHEEL;
+
 /*
  * Shared global private data
  */
@@ -198,9 +226,10 @@ extern	int ntfy_sigs_blocked;	/* count of nesting of signal blocking*/
 extern	int ntfy_interrupts;	/* count of interrupts handling (0 or 1) */
 extern	int ntfy_deaf_interrupts;	/* are interrupt handlers deaf? */
 extern	int ntfy_nodes_avail;	/* count of nodes available without having
-				   to go to the system heap */
+				   to go to the system heap (all caches) */
 extern	sigset_t ntfy_sigs_delayed;/* Bit mask of signals received while in
 				      critical section */
+extern	int ntfy_stats_on;	/* recording dispatch statistics */
 
 #if defined(__linux__) && defined(__GLIBC__)
 /* martin.buck@bigfoot.com */
@@ -245,6 +274,7 @@ typedef	struct	ntfy_node {
 	union {	/* List all data types that use the allocator */
 		/* Extra data for NTFY_CONDITION */
 		NTFY_ITIMER ntfy_itimer;
+		NTFY_WHEEL wheel;
 		/* Other structs that use nodes */
 		NTFY_CLIENT client;
 		NTFY_CONDITION condition;
@@ -277,16 +307,39 @@ typedef	caddr_t	NTFY_DATA;
 #define	NTFY_NODE_BYTES		sizeof(NTFY_NODE)
 					/* NTFY_NODE_BYTES is the node size
 					   that use the storage allocator */
-#define	NTFY_MIN_NODES		22	/* Reasonable number of conditions per
-					   normal application */
-#define	NTFY_NODES_PER_BLOCK	(NTFY_PRE_ALLOCED+(NTFY_MIN_NODES*2))
-					/* Number of nodes allocated every time
-					   go to heap (2 accounts for each
-					   condition taking 2 nodes, one for
-					   detector and one for dispatcher) */
-
-
-#define	ntfy_alloc_client()		(NTFY_CLIENT *)ntfy_alloc_node()
+#define	NTFY_SLAB_BYTES		4096	/* Size (and alignment) of each block
+					   the node caches get from the heap */
+
+typedef	enum ntfy_node_kind {		/* Node caches, see ntfy_node.c */
+	NTFY_NODE_CLIENT=0,		/* NTFY_CLIENT */
+	NTFY_NODE_CONDITION=1,		/* NTFY_CONDITION held by the detector
+					   or set directly in the dispatcher */
+	NTFY_NODE_EVENT=2,		/* NTFY_CONDITION queued for dispatch */
+	NTFY_NODE_MISC=3,		/* NTFY_ITIMER, NTFY_WHEEL, functions */
+	NTFY_NODE_KINDS=4,
+} NTFY_NODE_KIND;
+
+typedef	struct ntfy_node_stats {	/* Per cache allocator counters */
+	char	*name;
+	int	object_bytes;		/* Size of each object */
+	int	objects_per_slab;
+	int	in_use;			/* Objects handed out */
+	int	in_use_max;		/* High water mark of in_use */
+	int	avail;			/* Free objects held by the cache */
+	int	slabs;			/* Slabs held by the cache */
+	int	slabs_empty;		/* Slabs with no objects in use */
+	int	slab_allocs;		/* Trips to the heap */
+	int	slab_frees;		/* Slabs given back when idle */
+	u_long	allocs;
+	u_long	frees;
+	u_long	failures;		/* Allocations refused */
+} NTFY_NODE_STATS;
+
+extern	int ntfy_node_blocks;	/* count of trips to heap for nodes */
+extern	int ntfy_nodes_short;	/* a node cache is below NTFY_PRE_ALLOCED */
+
+#define	ntfy_alloc_client()		\
+			(NTFY_CLIENT *)ntfy_alloc_node(NTFY_NODE_CLIENT)
 #define	ntfy_free_client(client)	ntfy_free_node((NTFY_NODE *)(client))
 
 #define	ntfy_append_client(client_list, client) \
@@ -305,7 +358,10 @@ typedef	enum ntfy_who {
 } NTFY_WHO;
 
 
-#define	ntfy_alloc_condition()		(NTFY_CONDITION *)ntfy_alloc_node()
+#define	ntfy_alloc_condition()		\
+			(NTFY_CONDITION *)ntfy_alloc_node(NTFY_NODE_CONDITION)
+#define	ntfy_alloc_event()		\
+			(NTFY_CONDITION *)ntfy_alloc_node(NTFY_NODE_EVENT)
 #define	ntfy_free_condition(condition)	ntfy_free_node((NTFY_NODE *)(condition))
 
 #define	ntfy_append_condition(condition_list, condition) \
@@ -314,9 +370,13 @@ typedef	enum ntfy_who {
 #define	ntfy_free_condition_list(condition_list) \
 			node_free_list((NTFY_NODE **)(condition_list))
 
-#define	ntfy_alloc_ntfy_itimer()	(NTFY_ITIMER *)ntfy_alloc_node()
+#define	ntfy_alloc_ntfy_itimer()	\
+			(NTFY_ITIMER *)ntfy_alloc_node(NTFY_NODE_MISC)
+#define	ntfy_alloc_wheel()		\
+			(NTFY_WHEEL *)ntfy_alloc_node(NTFY_NODE_MISC)
 
-#define	ntfy_alloc_functions()		(Notify_func *)ntfy_alloc_node()
+#define	ntfy_alloc_functions()		\
+			(Notify_func *)ntfy_alloc_node(NTFY_NODE_MISC)
 #define	ntfy_free_functions(functions)	ntfy_free_node((NTFY_NODE *)(functions))
 #define	NTFY_FUNC_PTR_NULL	((Notify_func *)0)
 
@@ -341,20 +401,20 @@ It will be very fast by taking advantage of fixed size of nodes.
 It will be safe by refusing to interact with the system heap during
 signal interrupts.
 
-A single fixed size block of data is managed by the storage manager.
-Its size is the max of sizeof(NTFY_CLIENT)[12],
-sizeof(NTFY_CONDITION)[16], and sizeof(NTFY_ITIMER)[24].
-Typically, there will be approximately twice the number of
-NTFY_CONDITION nodes compared to the total of all
-the other nodes.  The 8 byte slop is judged to be acceptable
-(the notifer could go to a multiple fixed size block mechanism if the
-slop situation enlarges).  Allocating an fixed size node is done by 
-taking a node off the free list.  If the free list is empty, then
-the notifier allocates a large chunk from the system heap that is
-subdivided into fixed size nodes.  Freeing an object is done by
-putting it back on a linked list of available nodes.  The heap storage
-used for this fixed size block mechanism is never returned to the system
-heap.
+Nodes come from a small set of slab caches, one per NTFY_NODE_KIND:
+clients, conditions, queued events and everything else (itimers, wheel
+entries and function stacks, which are sizeof(NTFY_NODE)).  Each cache
+hands out objects of one fixed size.  A cache gets NTFY_SLAB_BYTES
+aligned slabs from the system heap and carves them into objects; the
+slab header sits at the start of the slab, so freeing an object finds
+its slab (and cache) by masking the object's address.  Allocating
+takes an object from the first slab on the cache's list of slabs with
+free objects, which keeps partly used slabs ahead of empty ones.  Slabs
+that become entirely free are kept at the end of that list and handed
+back to the system heap by ntfy_shrink_nodes when the notifier goes
+idle, as long as the cache keeps its pre-allocated reserve (below)
+plus one spare slab.  The per cache counters can be read with
+ntfy_get_node_stats or printed with notify_dump(..., NOTIFY_NODES, ...).
 
 Unfortunately, we can't cavalierly call the system heap from a signal
 interrupt.  If we call the system heap while someone else is in the
@@ -373,8 +433,8 @@ The contents of the pending-free list is emptied and returned to
 the system heap every time around the notification loop.  This is
 to accomodate notify_remove being called from an interrupt.
 
-The number of pre-allocated nodes is replenished back up to
-NTFY_PRE_ALLOCED every time a critical section is exited.
+The number of pre-allocated nodes in each cache is replenished back up
+to NTFY_PRE_ALLOCED every time a critical section is exited.
 Another number, NTFY_PRE_ALLOCED_MIN is the minimum number of
 pre-allocated nodes that need be on hand before notifying during
 a signal interrupt.  If this number is not on hand, then the
@@ -394,6 +454,19 @@ notify_post_* calls among all their conditions (immediate client events
 as well as asynchronous signal conditions).
 */
 
+/*
+ * Dispatch statistics (ntfy_stats.c).  Wrap a callout to a client with
+ *	NTFY_STATS_START(start); func(...); NTFY_STATS_CALLOUT(nclient, type, start);
+ * where start is a u_long.  Costs a test of ntfy_stats_on when turned off.
+ * NTFY_STATS_CLOCK just reads the clock, for timing anything else.
+ */
+#define	NTFY_STATS_START(start)	\
+	((start) = ntfy_stats_on ? ntfy_stats_begin() : 0)
+#define	NTFY_STATS_CLOCK(start)	\
+	((start) = ntfy_stats_on ? ntfy_stats_clock() : 0)
+#define	NTFY_STATS_CALLOUT(nclient, type, start) \
+	((start) ? ntfy_stats_callout((nclient), (type), (start)) : (void) 0)
+
 /*
  * Debugging aids.
  */
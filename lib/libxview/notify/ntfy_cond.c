@@ -16,12 +16,14 @@ static char     sccsid[] = "@(#)ntfy_cond.c 20.19 93/06/28 Copyr 1985 Sun Micro"
  */
 
 #include <xview_private/ntfy_cond_.h>
+#include <xview_private/gettext_.h>
 #include <xview_private/ntfyclient_.h>
 #include <xview_private/ntfy_ctbl_.h>
 #include <xview_private/ntfy_debug_.h>
 #include <xview_private/ntfy_list_.h>
 #include <xview_private/ntfy_node_.h>
 #include <xview_private/ntfyprotec_.h>
+#include <xview_private/i18n_impl.h>
 #include <stdio.h>		/* For NULL */
 #include <signal.h>
 
@@ -37,54 +39,165 @@ static int ntfy_paranoid_count;
 static NTFY_CONDITION *ntfy_enum_condition;
 static NTFY_CONDITION *ntfy_enum_condition_next;
 
+/*
+ * Conditions are hashed on (client, type, data) as well as being on their
+ * client's list, so that finding one doesn't walk the list.  The lists are
+ * still what the enumerators (paranoid or not) walk.  Only types whose data
+ * identifies the condition (fds, signals, pids) hash on it; the data of the
+ * others is either zero or changes after the condition is created.
+ */
+#define	NTFY_HASH_MIN		256	/* Buckets in the initial table */
+#define	ntfy_type_keyed(type) \
+	((type) == NTFY_INPUT || (type) == NTFY_OUTPUT || \
+	 (type) == NTFY_EXCEPTION || (type) == NTFY_SYNC_SIGNAL || \
+	 (type) == NTFY_ASYNC_SIGNAL || (type) == NTFY_WAIT3)
+
+static NTFY_CONDITION *ntfy_cond_hash_min[NTFY_HASH_MIN];
+static NTFY_CONDITION **ntfy_cond_hash = ntfy_cond_hash_min;
+static u_int    ntfy_cond_hash_size = NTFY_HASH_MIN;
+static u_int    ntfy_cond_hash_count;
+
+static u_int    ntfy_cond_key(NTFY_CLIENT *client, NTFY_TYPE type, NTFY_DATA data);
+static void     ntfy_cond_unhash(NTFY_CONDITION *condition);
+static void     ntfy_cond_hash_grow(void);
+
+static          u_int
+ntfy_cond_key(client, type, data)
+    NTFY_CLIENT    *client;
+    NTFY_TYPE       type;
+    NTFY_DATA       data;
+{
+    u_long          key;
+
+    key = ((u_long) client >> 4) ^ ((u_long) type << 24);
+    if (ntfy_type_keyed(type))
+	key ^= (u_long) data * 0x9e3779b1UL;
+    key ^= key >> 16;
+    key *= 0x45d9f3bUL;
+    key ^= key >> 16;
+    return ((u_int) key);
+}
+
+/*
+ * Put condition on its client's list and into the hash table.  Conditions
+ * of the same key stay in list order so that a search finds the oldest.
+ */
+pkg_private void
+ntfy_add_condition(client, condition)
+    NTFY_CLIENT    *client;
+    NTFY_CONDITION *condition;
+{
+    NTFY_CONDITION **chain;
+
+    ntfy_append_condition(&(client->conditions), condition);
+    condition->client = client;
+    condition->hash_next = NTFY_CONDITION_NULL;
+    condition->hash_key = ntfy_cond_key(client, condition->type,
+				    (NTFY_DATA) condition->data.an_u_int);
+    if (ntfy_cond_hash_count >= ntfy_cond_hash_size && !NTFY_IN_INTERRUPT)
+	ntfy_cond_hash_grow();
+    chain = &ntfy_cond_hash[condition->hash_key & (ntfy_cond_hash_size - 1)];
+    while (*chain)
+	chain = &(*chain)->hash_next;
+    *chain = condition;
+    ntfy_cond_hash_count++;
+}
+
+static void
+ntfy_cond_unhash(condition)
+    NTFY_CONDITION *condition;
+{
+    NTFY_CONDITION **chain;
+
+    chain = &ntfy_cond_hash[condition->hash_key & (ntfy_cond_hash_size - 1)];
+    for (; *chain; chain = &(*chain)->hash_next)
+	if (*chain == condition) {
+	    *chain = condition->hash_next;
+	    ntfy_cond_hash_count--;
+	    return;
+	}
+    ntfy_fatal_error(XV_MSG("Tried to unhash condition that wasn't hashed"));
+}
+
+/* Double the table (never at interrupt level, as it goes to the heap) */
+static void
+ntfy_cond_hash_grow()
+{
+    NTFY_CONDITION **table, *condition, *next, **chain;
+    u_int           size = ntfy_cond_hash_size * 2, i;
+
+    if ((table = (NTFY_CONDITION **) ntfy_malloc(
+			    size * sizeof(NTFY_CONDITION *))) == 0)
+	return;
+    for (i = 0; i < size; i++)
+	table[i] = NTFY_CONDITION_NULL;
+    for (i = 0; i < ntfy_cond_hash_size; i++)
+	for (condition = ntfy_cond_hash[i]; condition; condition = next) {
+	    next = condition->hash_next;
+	    /* Append, to keep list order within a key */
+	    chain = &table[condition->hash_key & (size - 1)];
+	    while (*chain)
+		chain = &(*chain)->hash_next;
+	    condition->hash_next = NTFY_CONDITION_NULL;
+	    *chain = condition;
+	}
+    if (ntfy_cond_hash != ntfy_cond_hash_min)
+	ntfy_free_malloc((NTFY_DATA) ntfy_cond_hash);
+    ntfy_cond_hash = table;
+    ntfy_cond_hash_size = size;
+}
+
 pkg_private NTFY_CONDITION *
-ntfy_find_condition(condition_list, type, condition_latest, data, use_data)
-    NTFY_CONDITION *condition_list;
+ntfy_find_condition(client, type, data, use_data)
+    NTFY_CLIENT    *client;
     NTFY_TYPE       type;
-    register NTFY_CONDITION **condition_latest;
     NTFY_DATA       data;
     int             use_data;
 {
     register NTFY_CONDITION *condition;
-    NTFY_CONDITION *next;
+    NTFY_CONDITION *latest = client->condition_latest;
 
     ntfy_assert(NTFY_IN_CRITICAL, 23 /* Unprotected list search */);
     /* See if hint matches */
-    if (*condition_latest && (*condition_latest)->type == type) {
+    if (latest && latest->type == type) {
 	if (!use_data ||
-	    (NTFY_DATA) (*condition_latest)->data.an_u_int == data)
-	    return (*condition_latest);
+	    (NTFY_DATA) latest->data.an_u_int == data)
+	    return (latest);
     }
-    /* Search entire list */
-    for (condition = condition_list; condition; condition = next) {
-	next = condition->next;
-	if (condition->type == type) {
-	    if (!use_data ||
-		(NTFY_DATA) condition->data.an_u_int == data) {
-		/* Set up hint for next time */
-		*condition_latest = condition;
-		return (condition);
-	    }
-	}
+    if (!use_data && ntfy_type_keyed(type)) {
+	/* Any condition of this type will do, search client's list */
+	for (condition = client->conditions; condition;
+	     condition = condition->next)
+	    if (condition->type == type)
+		break;
+    } else {
+	condition = ntfy_cond_hash[ntfy_cond_key(client, type, data) &
+				   (ntfy_cond_hash_size - 1)];
+	for (; condition; condition = condition->hash_next)
+	    if (condition->client == client && condition->type == type &&
+		(!use_data || (NTFY_DATA) condition->data.an_u_int == data))
+		break;
     }
-    return (NTFY_CONDITION_NULL);
+    /* Set up hint for next time */
+    if (condition)
+	client->condition_latest = condition;
+    return (condition);
 }
 
 /*
  * Find/create condition defined by type and data (if use_data TRUE)
  */
 pkg_private NTFY_CONDITION *
-ntfy_new_condition(condition_list, type, condition_latest, data, use_data)
-    NTFY_CONDITION **condition_list;
+ntfy_new_condition(client, type, data, use_data)
+    NTFY_CLIENT    *client;
     NTFY_TYPE       type;
-    NTFY_CONDITION **condition_latest;
     NTFY_DATA       data;
     int             use_data;
 {
     register NTFY_CONDITION *condition;
 
-    if ((condition = ntfy_find_condition(*condition_list, type,
-		condition_latest, data, use_data)) == NTFY_CONDITION_NULL) {
+    if ((condition = ntfy_find_condition(client, type, data, use_data)) ==
+	NTFY_CONDITION_NULL) {
 	/* Allocate condition */
 	if ((condition = ntfy_alloc_condition()) == NTFY_CONDITION_NULL)
 	    return (NTFY_CONDITION_NULL);
@@ -98,9 +211,9 @@ ntfy_new_condition(condition_list, type, condition_latest, data, use_data)
 	condition->arg = (Notify_arg) 0;
 	condition->release = NOTIFY_RELEASE_NULL;
 	/* Append to condition list */
-	ntfy_append_condition(condition_list, condition);
+	ntfy_add_condition(client, condition);
 	/* Set up condition hint */
-	*condition_latest = condition;
+	client->condition_latest = condition;
     }
     return (condition);
 }
@@ -132,6 +245,7 @@ ntfy_remove_condition(client, condition, who)
     if (condition == ntfy_enum_condition_next)
 	ntfy_enum_condition_next = ntfy_enum_condition_next->next;
     ntfy_remove_from_table(client, condition);
+    ntfy_cond_unhash(condition);
     /* Free data portion of condition if dynamically allocated */
     /* First, check to see if might be non-null pointer */
     if (condition->data.an_u_int != 0) {
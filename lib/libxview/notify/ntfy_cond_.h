@@ -4,8 +4,9 @@
 #include <xview/pkg.h>
 #include <xview_private/ntfy.h>
 
-pkg_private NTFY_CONDITION *ntfy_find_condition(NTFY_CONDITION *condition_list, NTFY_TYPE type, register NTFY_CONDITION **condition_latest, NTFY_DATA data, int use_data);
-pkg_private NTFY_CONDITION *ntfy_new_condition(NTFY_CONDITION **condition_list, NTFY_TYPE type, NTFY_CONDITION **condition_latest, NTFY_DATA data, int use_data);
+pkg_private void ntfy_add_condition(NTFY_CLIENT *client, NTFY_CONDITION *condition);
+pkg_private NTFY_CONDITION *ntfy_find_condition(NTFY_CLIENT *client, NTFY_TYPE type, NTFY_DATA data, int use_data);
+pkg_private NTFY_CONDITION *ntfy_new_condition(NTFY_CLIENT *client, NTFY_TYPE type, NTFY_DATA data, int use_data);
 pkg_private void ntfy_unset_condition(NTFY_CLIENT **client_list, NTFY_CLIENT *client, NTFY_CONDITION *condition, NTFY_CLIENT **client_latest, NTFY_WHO who);
 pkg_private void ntfy_remove_condition(NTFY_CLIENT *client, NTFY_CONDITION *condition, NTFY_WHO who);
 pkg_private NTFY_ENUM ntfy_paranoid_enum_conditions(NTFY_CLIENT *clients, NTFY_ENUM_FUNC enum_func, NTFY_ENUM_DATA context);
@@ -5,14 +5,32 @@ static char     sccsid[] = "@(#)ntfy_ctbl.c 1.22 93/06/28";
 #endif
 
 #include <xview_private/ntfy_ctbl_.h>
+#include <xview_private/ndet_pollset_.h>
+#include <xview_private/ndet_twheel_.h>
 #include <xview_private/ntfy_debug_.h>
 #include <xview_private/ntfyprotec_.h>
 #include <xview_private/xv_.h>
+#include <xview_private/ndet.h>
 #include <stdio.h>
 #include <signal.h>
 
 NTFY_CNDTBL *ntfy_cndtbl[NTFY_LAST_CND];
 
+/*
+ * Fd conditions are also tracked per fd so that the detector's interest
+ * set can follow the table (see ndet_pollset.c).
+ */
+#ifdef NDET_POLLSET
+#define	ntfy_table_watch(client, condition, type) \
+	do { \
+	    if ((type) == (int) NTFY_INPUT || (type) == (int) NTFY_OUTPUT || \
+		(type) == (int) NTFY_EXCEPTION) \
+		ndet_pollset_watch((client), (condition)); \
+	} while (0)
+#else
+#define	ntfy_table_watch(client, condition, type)	do { } while (0)
+#endif
+
 /*
  * Add a client into the condition table (ntfy_cndtbl) for the condition it
  * has an interest in.
@@ -43,6 +61,7 @@ ntfy_add_to_table(client, condition, type)
 	cnd_list->condition = condition;
 	cnd_list->next = ntfy_cndtbl[type]->next;
 	ntfy_cndtbl[type]->next = cnd_list;
+	ntfy_table_watch(client, condition, type);
 	NTFY_END_CRITICAL;
 	return;
     }
@@ -64,6 +83,7 @@ ntfy_add_to_table(client, condition, type)
     cnd_list->condition = condition;
     cnd_list->next = ntfy_cndtbl[type]->next;
     ntfy_cndtbl[type]->next = cnd_list;
+    ntfy_table_watch(client, condition, type);
     NTFY_END_CRITICAL;
     return;
 }
@@ -95,6 +115,22 @@ ntfy_remove_from_table(client, condition)
 	    (cnd_list->condition == condition)) {
 	    last_cnd->next = cnd_list->next;
 	    free(cnd_list);
+	    switch (condition->type) {
+#ifdef NDET_POLLSET
+	      case NTFY_INPUT:
+	      case NTFY_OUTPUT:
+	      case NTFY_EXCEPTION:
+		ndet_pollset_unwatch(client, condition);
+		break;
+#endif
+#ifdef NDET_TWHEEL
+	      case NTFY_REAL_ITIMER:
+		ndet_twheel_cancel(condition);
+		break;
+#endif
+	      default:{
+		}
+	    }
 	    NTFY_END_CRITICAL;
 	    return;
 	}
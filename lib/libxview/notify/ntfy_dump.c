@@ -16,12 +16,15 @@ static char     sccsid[] = "@(#)ntfy_dump.c 20.12 93/06/28 Copyr 1985 Sun Micro"
 
 #include <xview_private/ntfy_dump_.h>
 #include <xview_private/ntfy_cond_.h>
+#include <xview_private/ntfy_node_.h>
+#include <xview_private/ntfy_stats_.h>
 #include <xview_private/ndet.h>
 #include <xview_private/ndis.h>
 #include <stdio.h>		/* For output */
 
 
 static NTFY_ENUM ntfy_dump(register NTFY_CLIENT *client, register NTFY_CONDITION *cond, NTFY_ENUM_DATA context);
+static void ntfy_dump_nodes(FILE *file);
 
 typedef struct ntfy_dump_data {
     Notify_dump_type type;
@@ -60,9 +63,39 @@ notify_dump(nclient, type, file)
 	(void) ntfy_enum_conditions(ndis_clients, ntfy_dump,
 				    (NTFY_ENUM_DATA) & data);
     }
+    if (type == NOTIFY_NODES)
+	ntfy_dump_nodes(file);
+    if (type == NOTIFY_STATS)
+	ntfy_stats_dump(file);
     return;
 }
 
+static void
+ntfy_dump_nodes(file)
+    FILE           *file;
+{
+    NTFY_NODE_STATS stats[NTFY_NODE_KINDS];
+    register NTFY_NODE_STATS *s;
+    int             count;
+
+    count = ntfy_get_node_stats(stats, NTFY_NODE_KINDS);
+    (void) fprintf(file, "NODE CACHES (%d free, %d slabs from heap):\n",
+		   ntfy_nodes_avail, ntfy_node_blocks);
+    for (s = stats; s < stats + count; s++) {
+	(void) fprintf(file,
+		       "\t%s: %d bytes, %d in use (max %d), %d free\n",
+		       s->name, s->object_bytes, s->in_use, s->in_use_max,
+		       s->avail);
+	(void) fprintf(file,
+		       "\t\tslabs %d (%d empty), %d allocated, %d released\n",
+		       s->slabs, s->slabs_empty, s->slab_allocs,
+		       s->slab_frees);
+	(void) fprintf(file,
+		       "\t\tallocs %lu, frees %lu, failures %lu\n",
+		       s->allocs, s->frees, s->failures);
+    }
+}
+
 static          NTFY_ENUM
 ntfy_dump(client, cond, context)
     register NTFY_CLIENT *client;
@@ -12,47 +12,105 @@ static char     sccsid[] = "@(#)ntfy_node.c 20.16 93/06/28 Copyr 1985 Sun Micro"
 
 /*
  * Ntfy_node.c - Storage management for the notifier.
+ *
+ * Nodes come from one slab cache per NTFY_NODE_KIND (see the storage
+ * management notes in ntfy.h).
  */
 
+#include <stdlib.h>
 #include <xview_private/ntfy_node_.h>
 #include <xview_private/ntfy_debug_.h>
 #include <xview_private/ntfyprotec_.h>
 #include <xview_private/xv_.h>
 
-pkg_private_data int ntfy_nodes_avail = 0;	/* Count of nodes in
-						 * ntfy_node_free */
+pkg_private_data int ntfy_nodes_avail = 0;	/* Count of free nodes in
+						 * all caches */
 pkg_private_data int ntfy_node_blocks = 0;	/* Count of trips to heap for
 						 * nodes (used for statistics
 						 * & possibly run away
 						 * process detection) */
+pkg_private_data int ntfy_nodes_short = 0;	/* Set when a cache falls
+						 * below NTFY_PRE_ALLOCED */
 
-static NTFY_NODE *ntfy_node_free;	/* List of free nodes */
+typedef struct ntfy_slab {
+    struct ntfy_cache *cache;	/* Owner */
+    struct ntfy_slab *next;	/* Cache's list of slabs with free objects */
+    struct ntfy_slab *prev;
+    NTFY_NODE      *free;	/* Free objects in this slab */
+    int             in_use;	/* Objects handed out from this slab */
+}               NTFY_SLAB;
+
+typedef struct ntfy_cache {
+    NTFY_NODE_STATS stats;
+    NTFY_SLAB      *head;	/* Partly used slabs, then empty ones */
+    NTFY_SLAB      *tail;
+}               NTFY_CACHE;
+
+/* Objects start past the slab header, suitably aligned */
+#define	NTFY_SLAB_ALIGN		(2 * sizeof(double))
+#define	NTFY_SLAB_HEADER	\
+	((sizeof(NTFY_SLAB) + NTFY_SLAB_ALIGN - 1) & ~(NTFY_SLAB_ALIGN - 1))
+#define	NTFY_SLAB_OBJECTS(size)	((NTFY_SLAB_BYTES - NTFY_SLAB_HEADER) / (size))
+#define	ntfy_node_slab(node)	\
+	((NTFY_SLAB *) ((u_long) (node) & ~((u_long) NTFY_SLAB_BYTES - 1)))
+
+static NTFY_CACHE ntfy_caches[NTFY_NODE_KINDS] = {
+    {{"client", sizeof(NTFY_CLIENT),
+      NTFY_SLAB_OBJECTS(sizeof(NTFY_CLIENT))}},
+    {{"condition", sizeof(NTFY_CONDITION),
+      NTFY_SLAB_OBJECTS(sizeof(NTFY_CONDITION))}},
+    {{"event", sizeof(NTFY_CONDITION),
+      NTFY_SLAB_OBJECTS(sizeof(NTFY_CONDITION))}},
+    {{"misc", sizeof(NTFY_NODE),
+      NTFY_SLAB_OBJECTS(sizeof(NTFY_NODE))}},
+};
+
+static void     ntfy_cache_grow(NTFY_CACHE *cache);
+static void     ntfy_cache_unlink(NTFY_CACHE *cache, NTFY_SLAB *slab);
+static void     ntfy_cache_append(NTFY_CACHE *cache, NTFY_SLAB *slab);
+static void     ntfy_cache_push(NTFY_CACHE *cache, NTFY_SLAB *slab);
 
 /*
  * Caller must initialize data returned from ntfy_alloc_node. NTFY_NODE_NULL
  * is possible.
  */
 pkg_private NTFY_NODE *
-ntfy_alloc_node()
+ntfy_alloc_node(kind)
+    NTFY_NODE_KIND  kind;
 {
+    register NTFY_CACHE *cache = &ntfy_caches[kind];
+    register NTFY_SLAB *slab;
     NTFY_NODE      *node;
 
-    if (ntfy_node_free == NTFY_NODE_NULL) {
-	if (NTFY_IN_INTERRUPT)
+    if (cache->head == (NTFY_SLAB *) 0) {
+	if (NTFY_IN_INTERRUPT) {
+	    cache->stats.failures++;
 	    return (NTFY_NODE_NULL);
-	else
-	    ntfy_replenish_nodes();
+	} else
+	    ntfy_cache_grow(cache);
     }
     NTFY_BEGIN_CRITICAL;	/* Protect node pool */
-    if (ntfy_node_free == NTFY_NODE_NULL) {
+    if ((slab = cache->head) == (NTFY_SLAB *) 0) {
+	cache->stats.failures++;
 	ntfy_set_errno(NOTIFY_NOMEM);
 	NTFY_END_CRITICAL;
 	return (NTFY_NODE_NULL);
     }
-    ntfy_assert(ntfy_nodes_avail > 0, 33 /* Node count wrong */);
-    node = ntfy_node_free;
-    ntfy_node_free = ntfy_node_free->n.next;
+    ntfy_assert(cache->stats.avail > 0 && slab->free != NTFY_NODE_NULL, 33
+		/* Node count wrong */);
+    node = slab->free;
+    slab->free = node->n.next;
+    if (slab->in_use++ == 0)
+	cache->stats.slabs_empty--;
+    if (slab->free == NTFY_NODE_NULL)
+	ntfy_cache_unlink(cache, slab);
+    cache->stats.avail--;
     ntfy_nodes_avail--;
+    if (++cache->stats.in_use > cache->stats.in_use_max)
+	cache->stats.in_use_max = cache->stats.in_use;
+    cache->stats.allocs++;
+    if (cache->stats.avail < NTFY_PRE_ALLOCED)
+	ntfy_nodes_short = 1;
     NTFY_END_CRITICAL;
     return (node);
 }
@@ -60,26 +118,192 @@ ntfy_alloc_node()
 pkg_private void
 ntfy_replenish_nodes()
 {
-    register NTFY_NODE *new_nodes, *node;
+    register NTFY_CACHE *cache;
 
     ntfy_assert((!NTFY_IN_INTERRUPT || NTFY_DEAF_INTERRUPT), 34
 		/* Interrupt access to heap */);
-    ntfy_assert(ntfy_nodes_avail <= NTFY_PRE_ALLOCED, 35
-		/* Unnecessary node replenishment */);
-    new_nodes = (NTFY_NODE *) xv_calloc(
-			       1, NTFY_NODES_PER_BLOCK * sizeof(NTFY_NODE));
-    for (node = new_nodes; node < new_nodes + NTFY_NODES_PER_BLOCK; node++)
-	ntfy_free_node(node);
-    ntfy_node_blocks++;
+    ntfy_assert(ntfy_nodes_short, 35 /* Unnecessary node replenishment */);
+    ntfy_nodes_short = 0;
+    for (cache = ntfy_caches; cache < ntfy_caches + NTFY_NODE_KINDS; cache++)
+	while (cache->stats.avail < NTFY_PRE_ALLOCED) {
+	    ntfy_cache_grow(cache);
+	    if (cache->stats.avail < NTFY_PRE_ALLOCED) {
+		/* Out of memory, try again next time */
+		ntfy_nodes_short = 1;
+		break;
+	    }
+	}
 }
 
 pkg_private void
 ntfy_free_node(node)
     register NTFY_NODE *node;
 {
+    register NTFY_SLAB *slab = ntfy_node_slab(node);
+    register NTFY_CACHE *cache = slab->cache;
+
     NTFY_BEGIN_CRITICAL;	/* Protect node pool */
-    node->n.next = ntfy_node_free;
-    ntfy_node_free = node;
+    ntfy_assert(slab->in_use > 0, 44 /* Freed node twice */);
+    if (slab->free == NTFY_NODE_NULL)
+	/* Was full, put it back in front of the empty slabs */
+	ntfy_cache_push(cache, slab);
+    node->n.next = slab->free;
+    slab->free = node;
+    if (--slab->in_use == 0) {
+	/* Keep empty slabs at the end so they get a chance to drain */
+	ntfy_cache_unlink(cache, slab);
+	ntfy_cache_append(cache, slab);
+	cache->stats.slabs_empty++;
+    }
+    cache->stats.avail++;
     ntfy_nodes_avail++;
+    cache->stats.in_use--;
+    cache->stats.frees++;
+    NTFY_END_CRITICAL;
+}
+
+/*
+ * Returns TRUE if any cache has fewer than min free nodes, i.e., an
+ * interrupt time notification might not be able to get the nodes it needs.
+ */
+pkg_private int
+ntfy_nodes_low(min)
+    int             min;
+{
+    register NTFY_CACHE *cache;
+
+    for (cache = ntfy_caches; cache < ntfy_caches + NTFY_NODE_KINDS; cache++)
+	if (cache->stats.avail < min)
+	    return (1);
+    return (0);
+}
+
+/*
+ * Give empty slabs back to the system heap.  Called when the notifier is
+ * about to block.  Each cache keeps its pre-allocated reserve and one
+ * spare empty slab so that a client that churns through conditions does
+ * not go to the heap every time around the loop.
+ */
+pkg_private void
+ntfy_shrink_nodes()
+{
+    register NTFY_CACHE *cache;
+    register NTFY_SLAB *slab;
+    int             per_slab;
+
+    if (NTFY_IN_INTERRUPT || NTFY_IN_CRITICAL)
+	return;
+    NTFY_BEGIN_CRITICAL;
+    for (cache = ntfy_caches; cache < ntfy_caches + NTFY_NODE_KINDS; cache++) {
+	per_slab = cache->stats.objects_per_slab;
+	while (cache->stats.slabs_empty > 1 &&
+	       cache->stats.avail - per_slab >= NTFY_PRE_ALLOCED) {
+	    slab = cache->tail;
+	    ntfy_assert(slab && slab->in_use == 0, 45 /* Empty slab lost */);
+	    ntfy_cache_unlink(cache, slab);
+	    cache->stats.slabs_empty--;
+	    cache->stats.slabs--;
+	    cache->stats.slab_frees++;
+	    cache->stats.avail -= per_slab;
+	    ntfy_nodes_avail -= per_slab;
+	    free((char *) slab);
+	}
+    }
+    NTFY_END_CRITICAL;
+}
+
+/*
+ * Copy the counters of up to count caches into stats.  Returns the number
+ * of caches.
+ */
+pkg_private int
+ntfy_get_node_stats(stats, count)
+    NTFY_NODE_STATS *stats;
+    int             count;
+{
+    register int    i;
+
+    for (i = 0; i < count && i < NTFY_NODE_KINDS; i++)
+	stats[i] = ntfy_caches[i].stats;
+    return (NTFY_NODE_KINDS);
+}
+
+static void
+ntfy_cache_grow(cache)
+    register NTFY_CACHE *cache;
+{
+    register NTFY_SLAB *slab;
+    register char  *object;
+    void           *block;
+    int             i;
+
+    ntfy_assert((!NTFY_IN_INTERRUPT || NTFY_DEAF_INTERRUPT), 34
+		/* Interrupt access to heap */);
+    if (posix_memalign(&block, NTFY_SLAB_BYTES, NTFY_SLAB_BYTES) != 0) {
+	ntfy_set_errno(NOTIFY_NOMEM);
+	return;
+    }
+    slab = (NTFY_SLAB *) block;
+    slab->cache = cache;
+    slab->free = NTFY_NODE_NULL;
+    slab->in_use = 0;
+    object = (char *) slab + NTFY_SLAB_HEADER +
+	(cache->stats.objects_per_slab - 1) * cache->stats.object_bytes;
+    for (i = 0; i < cache->stats.objects_per_slab; i++) {
+	((NTFY_NODE *) object)->n.next = slab->free;
+	slab->free = (NTFY_NODE *) object;
+	object -= cache->stats.object_bytes;
+    }
+    NTFY_BEGIN_CRITICAL;
+    ntfy_cache_append(cache, slab);
+    cache->stats.slabs++;
+    cache->stats.slabs_empty++;
+    cache->stats.slab_allocs++;
+    cache->stats.avail += cache->stats.objects_per_slab;
+    ntfy_nodes_avail += cache->stats.objects_per_slab;
+    ntfy_node_blocks++;
     NTFY_END_CRITICAL;
 }
+
+static void
+ntfy_cache_unlink(cache, slab)
+    register NTFY_CACHE *cache;
+    register NTFY_SLAB *slab;
+{
+    if (slab->prev)
+	slab->prev->next = slab->next;
+    else
+	cache->head = slab->next;
+    if (slab->next)
+	slab->next->prev = slab->prev;
+    else
+	cache->tail = slab->prev;
+}
+
+static void
+ntfy_cache_append(cache, slab)
+    register NTFY_CACHE *cache;
+    register NTFY_SLAB *slab;
+{
+    slab->next = (NTFY_SLAB *) 0;
+    slab->prev = cache->tail;
+    if (cache->tail)
+	cache->tail->next = slab;
+    else
+	cache->head = slab;
+    cache->tail = slab;
+}
+
+static void
+ntfy_cache_push(cache, slab)
+    register NTFY_CACHE *cache;
+    register NTFY_SLAB *slab;
+{
+    slab->prev = (NTFY_SLAB *) 0;
+    slab->next = cache->head;
+    if (cache->head)
+	cache->head->prev = slab;
+    else
+	cache->tail = slab;
+    cache->head = slab;
+}
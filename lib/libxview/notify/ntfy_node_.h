@@ -4,9 +4,11 @@
 #include <xview/pkg.h>
 #include <xview_private/ntfy.h>
 
-pkg_private NTFY_NODE *ntfy_alloc_node(void);
+pkg_private NTFY_NODE *ntfy_alloc_node(NTFY_NODE_KIND kind);
 pkg_private void ntfy_replenish_nodes(void);
 pkg_private void ntfy_free_node(register NTFY_NODE *node);
+pkg_private int ntfy_nodes_low(int min);
+pkg_private void ntfy_shrink_nodes(void);
+pkg_private int ntfy_get_node_stats(NTFY_NODE_STATS *stats, int count);
 
 #endif
-
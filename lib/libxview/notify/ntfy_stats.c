@@ -0,0 +1,499 @@
+/*
+ * Ntfy_stats.c - Dispatch statistics for the notifier.
+ *
+ * When turned on (notify_set_stats, or Notify_stats_DUMP=y in the
+ * environment) the notifier times every callout to a client and keeps the
+ * durations in log-linear histograms, one per condition type and one per
+ * client.  The notification loop adds its select wake-ups, the time spent
+ * blocked and the depth of the dispatch queue.  With Notify_stats_DUMP a
+ * summary is printed on stderr when the process exits.
+ *
+ * Callout times are exclusive: time spent in callouts nested inside one
+ * (a handler that dispatches, or an interrupt-level callout) and time
+ * blocked in a nested wait are charged to those and not to the caller.
+ *
+ * Recording takes a critical section since callouts also happen at
+ * interrupt level.  The client table is only grown outside of interrupts;
+ * callouts that find no room are counted as untracked.  A client's entry
+ * goes away with notify_remove, as its handle may be reused.
+ */
+
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <xview_private/ntfy_stats_.h>
+#include <xview_private/ntfy_debug_.h>
+#include <xview_private/ntfy_node_.h>
+#include <xview_private/ntfyprotec_.h>
+#include <xview_private/ntfy.h>
+
+pkg_private_data int ntfy_stats_on = -1;	/* Record statistics, -1 until
+						 * the environment is read */
+
+static Notify_stats ntfy_stats;
+static Notify_client_stats *ntfy_stats_clients;	/* Open addressed on
+						 * client handle */
+static int      ntfy_stats_clients_size;
+static int      ntfy_stats_clients_used;
+
+#define	NTFY_STATS_CLIENTS_MIN	64
+#define	NTFY_STATS_DEPTH_MAX	32	/* Deeper callouts time inclusively */
+#define	NTFY_STATS_TOP		10	/* Clients in the summary */
+
+static u_long   ntfy_stats_nested[NTFY_STATS_DEPTH_MAX];	/* Time spent
+						 * below each open callout */
+static int      ntfy_stats_depth;	/* Open callouts */
+#define	ntfy_stats_hash(nclient, mask)	\
+	((((u_long) (nclient) >> 3) * 2654435761UL) & (mask))
+
+static char    *ntfy_stats_type_names[NOTIFY_CALLOUT_TYPES] = {
+    "unknown", "input", "output", "exception", "signal (sync)",
+    "signal (async)", "itimer (real)", "itimer (virtual)", "wait3",
+    "event (safe)", "event (immediate)", "destroy",
+};
+
+static void     ntfy_stats_exit(void);
+static void     ntfy_stats_nest(u_long usec);
+static void     ntfy_hist_add(Notify_histogram *hist, u_long value);
+static int      ntfy_hist_bucket(u_long value);
+static u_long   ntfy_hist_value(int bucket);
+static void     ntfy_hist_print(FILE *file, char *name, Notify_histogram *hist);
+static Notify_client_stats *ntfy_stats_client(Notify_client nclient);
+static int      ntfy_stats_clients_grow(void);
+static int      ntfy_stats_by_total(const void *a, const void *b);
+
+/*
+ * Called when the notifier starts or dispatches, and by the first timed
+ * callout.
+ */
+pkg_private void
+ntfy_stats_init()
+{
+    char           *str;
+
+    if (ntfy_stats_on >= 0)
+	return;
+    ntfy_stats_on = 0;
+    str = getenv("Notify_stats_DUMP");
+    if (str && (str[0] == 'y' || str[0] == 'Y')) {
+	notify_set_stats(1);
+	(void) atexit(ntfy_stats_exit);
+    }
+}
+
+static void
+ntfy_stats_exit()
+{
+    notify_dump(NOTIFY_CLIENT_NULL, NOTIFY_STATS, stderr);
+    notify_dump(NOTIFY_CLIENT_NULL, NOTIFY_NODES, stderr);
+}
+
+extern void
+notify_set_stats(on)
+    int             on;
+{
+    ntfy_stats_on = (on != 0);
+    ntfy_stats.enabled = (on != 0);
+}
+
+extern          Notify_error
+notify_get_stats(stats)
+    Notify_stats   *stats;
+{
+    NTFY_BEGIN_CRITICAL;
+    *stats = ntfy_stats;
+    NTFY_END_CRITICAL;
+    return (NOTIFY_OK);
+}
+
+/*
+ * Copy the statistics of up to count clients, the ones that spent the most
+ * time in callouts first.  Returns the number of clients with statistics.
+ */
+extern int
+notify_get_client_stats(clients, count)
+    Notify_client_stats *clients;
+    int             count;
+{
+    Notify_client_stats **sorted;
+    register int    i, n;
+
+    ntfy_assert((!NTFY_IN_INTERRUPT || NTFY_DEAF_INTERRUPT), 46
+		/* Client stats from interrupt level */);
+    NTFY_BEGIN_CRITICAL;
+    if (ntfy_stats_clients_used == 0) {
+	NTFY_END_CRITICAL;
+	return (0);
+    }
+    if ((sorted = (Notify_client_stats **) ntfy_malloc((u_int)
+	 (ntfy_stats_clients_used * sizeof(Notify_client_stats *)))) ==
+	(Notify_client_stats **) 0) {
+	NTFY_END_CRITICAL;
+	return (-1);
+    }
+    for (i = n = 0; i < ntfy_stats_clients_size; i++)
+	if (ntfy_stats_clients[i].client != NOTIFY_CLIENT_NULL)
+	    sorted[n++] = &ntfy_stats_clients[i];
+    qsort((char *) sorted, n, sizeof(Notify_client_stats *),
+	  ntfy_stats_by_total);
+    for (i = 0; i < count && i < n; i++)
+	clients[i] = *sorted[i];
+    NTFY_END_CRITICAL;
+    ntfy_free_malloc((NTFY_DATA) sorted);
+    return (n);
+}
+
+/*
+ * Returns the value below which percent of the samples fall (as the upper
+ * end of the bucket holding it).
+ */
+extern          u_long
+notify_histogram_percentile(hist, percent)
+    Notify_histogram *hist;
+    double          percent;
+{
+    u_long          want, seen = 0;
+    u_long          value;
+    register int    i;
+
+    if (hist->count == 0)
+	return (0);
+    want = (u_long) (hist->count * percent / 100.0 + 0.5);
+    if (want < 1)
+	want = 1;
+    for (i = 0; i < NOTIFY_HIST_BUCKETS; i++) {
+	seen += hist->buckets[i];
+	if (seen >= want) {
+	    value = ntfy_hist_value(i);
+	    return ((value < hist->max) ? value : hist->max);
+	}
+    }
+    return (hist->max);
+}
+
+/*
+ * Microseconds on a clock that doesn't jump.  Never 0, which callers use
+ * to mean "not timed".
+ */
+pkg_private     u_long
+ntfy_stats_clock()
+{
+    struct timespec ts;
+    u_long          usec;
+
+    if (ntfy_stats_on < 0) {
+	ntfy_stats_init();
+	if (!ntfy_stats_on)
+	    return (0);
+    }
+    (void) clock_gettime(CLOCK_MONOTONIC, &ts);
+    usec = (u_long) ts.tv_sec * 1000000 + ts.tv_nsec / 1000;
+    return (usec ? usec : 1);
+}
+
+/*
+ * Start timing a callout.  Returns its start time for ntfy_stats_callout,
+ * 0 if statistics are off.
+ */
+pkg_private     u_long
+ntfy_stats_begin()
+{
+    u_long          start = ntfy_stats_clock();
+
+    if (start) {
+	NTFY_BEGIN_CRITICAL;
+	if (ntfy_stats_depth < NTFY_STATS_DEPTH_MAX)
+	    ntfy_stats_nested[ntfy_stats_depth] = 0;
+	ntfy_stats_depth++;
+	NTFY_END_CRITICAL;
+    }
+    return (start);
+}
+
+/* Charge usec to the innermost open callout as nested time */
+static void
+ntfy_stats_nest(usec)
+    u_long          usec;
+{
+    if (ntfy_stats_depth > 0 && ntfy_stats_depth <= NTFY_STATS_DEPTH_MAX)
+	ntfy_stats_nested[ntfy_stats_depth - 1] += usec;
+}
+
+pkg_private void
+ntfy_stats_callout(nclient, type, start)
+    Notify_client   nclient;
+    NTFY_TYPE       type;
+    u_long          start;
+{
+    Notify_client_stats *entry;
+    u_long          total = ntfy_stats_clock() - start;
+    u_long          usec = total;
+
+    NTFY_BEGIN_CRITICAL;
+    if (ntfy_stats_depth > 0) {
+	ntfy_stats_depth--;
+	if (ntfy_stats_depth < NTFY_STATS_DEPTH_MAX)
+	    usec = (ntfy_stats_nested[ntfy_stats_depth] < total) ?
+		total - ntfy_stats_nested[ntfy_stats_depth] : 0;
+	ntfy_stats_nest(total);
+    }
+    if ((int) type > 0 && (int) type < NOTIFY_CALLOUT_TYPES)
+	ntfy_hist_add(&ntfy_stats.callouts[(int) type], usec);
+    if ((entry = ntfy_stats_client(nclient)) != (Notify_client_stats *) 0)
+	ntfy_hist_add(&entry->callouts, usec);
+    else
+	ntfy_stats.clients_untracked++;
+    NTFY_END_CRITICAL;
+}
+
+pkg_private void
+ntfy_stats_loop()
+{
+    ntfy_stats.loops++;
+}
+
+/*
+ * Record a return from select: nfds and error are its result and errno.
+ */
+pkg_private void
+ntfy_stats_wait(start, nfds, error)
+    u_long          start;
+    int             nfds;
+    int             error;
+{
+    u_long          usec = ntfy_stats_clock() - start;
+
+    NTFY_BEGIN_CRITICAL;
+    ntfy_hist_add(&ntfy_stats.blocked, usec);
+    /* Not the fault of a callout that runs a nested loop */
+    ntfy_stats_nest(usec);
+    ntfy_stats.wakeups++;
+    if (nfds > 0)
+	ntfy_stats.wakeups_fd++;
+    else if (nfds == 0)
+	ntfy_stats.wakeups_timeout++;
+    else if (error == EINTR)
+	ntfy_stats.wakeups_signal++;
+    NTFY_END_CRITICAL;
+}
+
+pkg_private void
+ntfy_stats_queue(depth)
+    int             depth;
+{
+    ntfy_hist_add(&ntfy_stats.queue_depth, (u_long) depth);
+}
+
+pkg_private void
+ntfy_stats_dump(file)
+    FILE           *file;
+{
+    Notify_stats    stats;
+    Notify_client_stats top[NTFY_STATS_TOP];
+    char            name[40];
+    register int    i, n;
+
+    (void) notify_get_stats(&stats);
+    (void) fprintf(file, "NOTIFIER STATISTICS (%s):\n",
+		   stats.enabled ? "on" : "off");
+    (void) fprintf(file,
+		   "\tloops %lu, wakeups %lu (fd %lu, timeout %lu, signal %lu)\n",
+		   stats.loops, stats.wakeups, stats.wakeups_fd,
+		   stats.wakeups_timeout, stats.wakeups_signal);
+    ntfy_hist_print(file, "blocked (usec)", &stats.blocked);
+    ntfy_hist_print(file, "queue depth", &stats.queue_depth);
+    (void) fprintf(file, "CALLOUTS BY TYPE (usec):\n");
+    for (i = 1; i < NOTIFY_CALLOUT_TYPES; i++)
+	if (stats.callouts[i].count)
+	    ntfy_hist_print(file, ntfy_stats_type_names[i],
+			    &stats.callouts[i]);
+    n = notify_get_client_stats(top, NTFY_STATS_TOP);
+    if (n <= 0)
+	return;
+    (void) fprintf(file,
+		   "CALLOUTS BY CLIENT (usec, %d of %d by total time):\n",
+		   (n < NTFY_STATS_TOP) ? n : NTFY_STATS_TOP, n);
+    for (i = 0; i < n && i < NTFY_STATS_TOP; i++) {
+	(void) sprintf(name, "client %lx", top[i].client);
+	ntfy_hist_print(file, name, &top[i].callouts);
+    }
+    if (stats.clients_untracked)
+	(void) fprintf(file, "\t%lu callouts untracked\n",
+		       stats.clients_untracked);
+}
+
+static void
+ntfy_hist_print(file, name, hist)
+    FILE           *file;
+    char           *name;
+    Notify_histogram *hist;
+{
+    (void) fprintf(file,
+		   "\t%s: count %lu, mean %lu, p50 %lu, p90 %lu, p99 %lu, max %lu\n",
+		   name, hist->count,
+		   hist->count ? hist->total / hist->count : 0,
+		   notify_histogram_percentile(hist, 50.0),
+		   notify_histogram_percentile(hist, 90.0),
+		   notify_histogram_percentile(hist, 99.0), hist->max);
+}
+
+static void
+ntfy_hist_add(hist, value)
+    register Notify_histogram *hist;
+    u_long          value;
+{
+    hist->count++;
+    hist->total += value;
+    if (value > hist->max)
+	hist->max = value;
+    hist->buckets[ntfy_hist_bucket(value)]++;
+}
+
+/*
+ * Values below 16 have a bucket each.  Above that, value >> e falls in
+ * [8, 16) for some e and there are 8 buckets per e.
+ */
+static int
+ntfy_hist_bucket(value)
+    u_long          value;
+{
+    register int    e;
+
+    if (value > 0xffffffffUL)
+	value = 0xffffffffUL;
+    if (value < 16)
+	return ((int) value);
+    for (e = 1; (value >> e) >= 16; e++)
+	;
+    return (e * 8 + (int) (value >> e));
+}
+
+/* Largest value that goes in bucket */
+static          u_long
+ntfy_hist_value(bucket)
+    int             bucket;
+{
+    int             e, m;
+
+    if (bucket < 16)
+	return ((u_long) bucket);
+    e = (bucket - 8) / 8;
+    m = bucket - e * 8;
+    return ((((u_long) m + 1) << e) - 1);
+}
+
+/*
+ * Find or make the entry for nclient.  Caller is in a critical section.
+ */
+static Notify_client_stats *
+ntfy_stats_client(nclient)
+    Notify_client   nclient;
+{
+    register Notify_client_stats *entry;
+    register u_long i, mask;
+    int             full;
+
+    if (nclient == NOTIFY_CLIENT_NULL)
+	return ((Notify_client_stats *) 0);
+    /* Keep the table at most half full, 3/4 full when it can't grow */
+    if (ntfy_stats_clients_used * 2 >= ntfy_stats_clients_size &&
+	!NTFY_IN_INTERRUPT)
+	(void) ntfy_stats_clients_grow();
+    if (ntfy_stats_clients_size == 0)
+	return ((Notify_client_stats *) 0);
+    full = ntfy_stats_clients_used * 4 >= ntfy_stats_clients_size * 3;
+    mask = ntfy_stats_clients_size - 1;
+    for (i = ntfy_stats_hash(nclient, mask);; i = (i + 1) & mask) {
+	entry = &ntfy_stats_clients[i];
+	if (entry->client == nclient)
+	    return (entry);
+	if (entry->client == NOTIFY_CLIENT_NULL) {
+	    if (full)
+		return ((Notify_client_stats *) 0);
+	    bzero((char *) entry, sizeof(Notify_client_stats));
+	    entry->client = nclient;
+	    ntfy_stats_clients_used++;
+	    return (entry);
+	}
+    }
+}
+
+/*
+ * Forget nclient, which notify_remove is done with.  Later entries of its
+ * probe run are moved up into the hole so that lookups still find them.
+ */
+pkg_private void
+ntfy_stats_remove(nclient)
+    Notify_client   nclient;
+{
+    register u_long i, j, k, mask;
+
+    if (ntfy_stats_clients_used == 0 || nclient == NOTIFY_CLIENT_NULL)
+	return;
+    NTFY_BEGIN_CRITICAL;
+    mask = ntfy_stats_clients_size - 1;
+    for (i = ntfy_stats_hash(nclient, mask);
+	 ntfy_stats_clients[i].client != nclient; i = (i + 1) & mask)
+	if (ntfy_stats_clients[i].client == NOTIFY_CLIENT_NULL) {
+	    NTFY_END_CRITICAL;
+	    return;
+	}
+    for (j = (i + 1) & mask;
+	 ntfy_stats_clients[j].client != NOTIFY_CLIENT_NULL;
+	 j = (j + 1) & mask) {
+	k = ntfy_stats_hash(ntfy_stats_clients[j].client, mask);
+	/* Move j unless its home lies cyclically in (i, j] */
+	if ((i < j) ? (k <= i || k > j) : (k <= i && k > j)) {
+	    ntfy_stats_clients[i] = ntfy_stats_clients[j];
+	    i = j;
+	}
+    }
+    ntfy_stats_clients[i].client = NOTIFY_CLIENT_NULL;
+    ntfy_stats_clients_used--;
+    NTFY_END_CRITICAL;
+}
+
+static int
+ntfy_stats_clients_grow()
+{
+    Notify_client_stats *old = ntfy_stats_clients;
+    int             old_size = ntfy_stats_clients_size;
+    register Notify_client_stats *entry;
+    register u_long i, mask;
+    int             size;
+
+    size = old_size ? old_size * 2 : NTFY_STATS_CLIENTS_MIN;
+    if ((ntfy_stats_clients = (Notify_client_stats *) ntfy_malloc((u_int)
+	 (size * sizeof(Notify_client_stats)))) ==
+	(Notify_client_stats *) 0) {
+	ntfy_stats_clients = old;
+	return (0);
+    }
+    bzero((char *) ntfy_stats_clients, size * sizeof(Notify_client_stats));
+    ntfy_stats_clients_size = size;
+    mask = size - 1;
+    for (entry = old; entry < old + old_size; entry++) {
+	if (entry->client == NOTIFY_CLIENT_NULL)
+	    continue;
+	for (i = ntfy_stats_hash(entry->client, mask);
+	     ntfy_stats_clients[i].client != NOTIFY_CLIENT_NULL;
+	     i = (i + 1) & mask)
+	    ;
+	ntfy_stats_clients[i] = *entry;
+    }
+    if (old)
+	ntfy_free_malloc((NTFY_DATA) old);
+    return (1);
+}
+
+static int
+ntfy_stats_by_total(a, b)
+    const void     *a;
+    const void     *b;
+{
+    u_long          ta = (*(Notify_client_stats **) a)->callouts.total;
+    u_long          tb = (*(Notify_client_stats **) b)->callouts.total;
+
+    return ((ta < tb) ? 1 : (ta > tb) ? -1 : 0);
+}
@@ -0,0 +1,17 @@
+#if !defined(NTFY_STATS__H)
+#define NTFY_STATS__H
+
+#include <xview/pkg.h>
+#include <xview_private/ntfy.h>
+
+pkg_private void ntfy_stats_init(void);
+pkg_private u_long ntfy_stats_clock(void);
+pkg_private u_long ntfy_stats_begin(void);
+pkg_private void ntfy_stats_callout(Notify_client nclient, NTFY_TYPE type, u_long start);
+pkg_private void ntfy_stats_loop(void);
+pkg_private void ntfy_stats_wait(u_long start, int nfds, int error);
+pkg_private void ntfy_stats_queue(int depth);
+pkg_private void ntfy_stats_remove(Notify_client nclient);
+pkg_private void ntfy_stats_dump(FILE *file);
+
+#endif
@@ -15,74 +15,111 @@ static char     sccsid[] = "@(#)ntfyclient.c 20.18 93/06/28 Copyr 1985 Sun Micro
  * dispatcher share.
  */
 
-/* This file seems to implement some kind of speed hack using b-trees
- * to locate notifier clients. Linux does not have the search code in
- * the libs, so I removed it in the hope that it keeps working, albeit
- * slower. Of course it would be nice if someone added tsearch() & friends
- * for linux (see <search.h> on Solaris). (lmfken) */
-/* Newsflash: As of libc-5.0.9, Linux has tsearch() & friends, so we define
- * HAVE_TSEARCH here.                  <martin-2.buck@student.uni-ulm.de>
- */
-#define HAVE_TSEARCH
-
 #include <xview_private/ntfyclient_.h>
 #include <xview_private/ndis_d_pri_.h>
 #include <xview_private/ntfy_cond_.h>
 #include <xview_private/ntfy_debug_.h>
 #include <xview_private/ntfy_list_.h>
 #include <xview_private/ntfy_node_.h>
+#include <xview_private/ntfyprotec_.h>
 #include <xview_private/ndis.h>	/* For ndis_default_prioritizer */
 #include <xview_private/ndet.h>	
-#ifdef HAVE_TSEARCH
-#include <search.h>
-#endif
 #include <xview_private/portable.h>
 
-#ifdef HAVE_TSEARCH
-static int ndet_compar(const void *key1, const void *key2);
-#endif 
-
 /* Variables used in paranoid enumerator (see ntfy_condition) */
 pkg_private_data NTFY_CLIENT *ntfy_enum_client = 0;
 pkg_private_data NTFY_CLIENT *ntfy_enum_client_next = 0;
 
-static NTFY_CLIENT dummy_client;
-static void *ndet_rootv;
-static void **ndet_root = &ndet_rootv;
+/*
+ * The detector's and the dispatcher's client lists are also hashed on
+ * nclient, so that finding a client costs the same with thousands of
+ * clients as with a few.  The lists themselves keep the order that the
+ * enumerators walk.  (The detector's list used to be indexed with tsearch.)
+ */
+#define	NTFY_HASH_MIN		256	/* Buckets in the initial tables */
+
+typedef struct ntfy_client_hash {
+    NTFY_CLIENT   **buckets;
+    u_int           size;		/* Power of 2 */
+    u_int           count;
+} NTFY_CLIENT_HASH;
+
+static NTFY_CLIENT *ntfy_ndet_hash_min[NTFY_HASH_MIN];
+static NTFY_CLIENT *ntfy_ndis_hash_min[NTFY_HASH_MIN];
+static NTFY_CLIENT_HASH ntfy_ndet_hash = {ntfy_ndet_hash_min, NTFY_HASH_MIN};
+static NTFY_CLIENT_HASH ntfy_ndis_hash = {ntfy_ndis_hash_min, NTFY_HASH_MIN};
+
+#define	ntfy_client_hash(client_list) \
+	(((client_list) == &ndet_clients) ? &ntfy_ndet_hash : \
+	 ((client_list) == &ndis_clients) ? &ntfy_ndis_hash : \
+	 (NTFY_CLIENT_HASH *) 0)
+
+static u_int    ntfy_client_key(Notify_client nclient);
+static void     ntfy_client_hash_add(NTFY_CLIENT_HASH *hash, NTFY_CLIENT *client);
+static void     ntfy_client_hash_remove(NTFY_CLIENT_HASH *hash, NTFY_CLIENT *client);
+
+static          u_int
+ntfy_client_key(nclient)
+    Notify_client   nclient;
+{
+    u_long          key = (u_long) nclient >> 3;
 
-#ifdef HAVE_TSEARCH
+    key ^= key >> 16;
+    key *= 0x45d9f3bUL;
+    key ^= key >> 16;
+    return ((u_int) key);
+}
 
-static int ndet_compar( key1, key2 )
-   const void *key1, *key2;
+static void
+ntfy_client_hash_add(hash, client)
+    NTFY_CLIENT_HASH *hash;
+    NTFY_CLIENT    *client;
 {
-   u_int key1a, key2a, tmp, tmp1;
-
-   key1a = (u_int)(((NTFY_CLIENT*)key1)->nclient);
-   key2a = (u_int)(((NTFY_CLIENT*)key2)->nclient);
-   tmp = key1a >> 16;
-   tmp1 = key1a << 21;
-   key1a = tmp1 | ((key1a << 5) & 0x001f0000) | tmp;
-   tmp = key2a >> 16;
-   tmp1 = key2a << 21;
-   key2a = tmp1 | ((key2a << 5) & 0x001f0000) | tmp;
-#if 1
-   /* OUCH, trying to store the result of the subtraction of two unsigned
-    * ints (which potentially can use the whole range of an unsigned int, due
-    * to the bit-shifting above) in a signed int is not a very clever idea.
-    * But we only have to return *any* positive value if key1a is greater than
-    * key2a, 0 if they're equal or *any* negatve value if key1a is less than
-    * key2a; the actual difference doesn't matter. So let's use a simple
-    * comparison.
-    * <mbuck@debian.org>
-    */
-   return  (key1a < key2a) ? -1 :
-          ((key1a > key2a) ?  1 :
-                              0);
-#else
-   return key1a - key2a;
-#endif
+    NTFY_CLIENT   **buckets, *clt, *next;
+    u_int           size, i, b;
+
+    /* Double the table, but never go to the heap at interrupt level */
+    if (hash->count >= hash->size && !NTFY_IN_INTERRUPT &&
+	(buckets = (NTFY_CLIENT **) ntfy_malloc(
+		    2 * hash->size * sizeof(NTFY_CLIENT *))) != 0) {
+	size = 2 * hash->size;
+	for (i = 0; i < size; i++)
+	    buckets[i] = NTFY_CLIENT_NULL;
+	for (i = 0; i < hash->size; i++)
+	    for (clt = hash->buckets[i]; clt; clt = next) {
+		next = clt->hash_next;
+		b = ntfy_client_key(clt->nclient) & (size - 1);
+		clt->hash_next = buckets[b];
+		buckets[b] = clt;
+	    }
+	if (hash->buckets != ntfy_ndet_hash_min &&
+	    hash->buckets != ntfy_ndis_hash_min)
+	    ntfy_free_malloc((NTFY_DATA) hash->buckets);
+	hash->buckets = buckets;
+	hash->size = size;
+    }
+    b = ntfy_client_key(client->nclient) & (hash->size - 1);
+    client->hash_next = hash->buckets[b];
+    hash->buckets[b] = client;
+    hash->count++;
+}
+
+static void
+ntfy_client_hash_remove(hash, client)
+    NTFY_CLIENT_HASH *hash;
+    NTFY_CLIENT    *client;
+{
+    NTFY_CLIENT   **chain;
+
+    chain = &hash->buckets[ntfy_client_key(client->nclient) &
+			   (hash->size - 1)];
+    for (; *chain; chain = &(*chain)->hash_next)
+	if (*chain == client) {
+	    *chain = client->hash_next;
+	    hash->count--;
+	    return;
+	}
 }
-#endif /* HAVE_TSEARCH */
 
 pkg_private NTFY_CLIENT *
 ntfy_find_nclient(client_list, nclient, client_latest)
@@ -91,41 +128,30 @@ ntfy_find_nclient(client_list, nclient, client_latest)
     register NTFY_CLIENT **client_latest;
 {
     register NTFY_CLIENT *client;
-    NTFY_CLIENT    *next;
+    NTFY_CLIENT_HASH *hash;
 
     ntfy_assert(NTFY_IN_CRITICAL, 36 /* Unprotected list search */);
     /* See if hint matches */
     if (*client_latest && (*client_latest)->nclient == nclient)
 	return (*client_latest);
-
-#ifdef HAVE_TSEARCH
-    if(( client_list == ndet_clients ) && ndet_clients ) {
-       dummy_client.nclient = nclient;
-       /* Find client */
-       if( client = (NTFY_CLIENT *)tfind( &dummy_client, ndet_root,
-           ndet_compar )) {
-	       /* This is a weird hack to get the actual client handle back out
-                  of the B tree node returned by tsearch */
-           client = client->next;
-
-           *client_latest = client;
-           return (client);
-       }
-    }
-
-    else 
-#endif /* HAVE_TSEARCH */
-        /* Search entire list */
-        for (client = client_list; client; client = next) {
-            next = client->next;
-            if (client->nclient == nclient) {
-                /* Set up hint for next time */
-                *client_latest = client;
-                return (client);
-            }
-        }    
-
-    return (NTFY_CLIENT_NULL);
+    /* The list head is passed by value, so go by the hint's address */
+    hash = (client_latest == &ndet_client_latest) ? &ntfy_ndet_hash :
+	(client_latest == &ndis_client_latest) ? &ntfy_ndis_hash :
+	(NTFY_CLIENT_HASH *) 0;
+    if (hash) {
+	client = hash->buckets[ntfy_client_key(nclient) & (hash->size - 1)];
+	for (; client; client = client->hash_next)
+	    if (client->nclient == nclient)
+		break;
+    } else
+	/* Search entire list */
+	for (client = client_list; client; client = client->next)
+	    if (client->nclient == nclient)
+		break;
+    /* Set up hint for next time */
+    if (client)
+	*client_latest = client;
+    return (client);
 }
 
 /*
@@ -138,38 +164,14 @@ ntfy_new_nclient(client_list, nclient, client_latest)
     NTFY_CLIENT   **client_latest;
 {
     register NTFY_CLIENT *client;
-    static NTFY_CLIENT *new_client = NTFY_CLIENT_NULL;
-
-#ifdef HAVE_TSEARCH
-    if( client_list == &ndet_clients ) {
-        if( new_client  == NTFY_CLIENT_NULL ) {
-            if ((new_client = ntfy_alloc_client()) == NTFY_CLIENT_NULL)
-                return (NTFY_CLIENT_NULL);
-        }
-        new_client->nclient = nclient;
-        client = (NTFY_CLIENT *)tsearch( new_client, ndet_root, ndet_compar );
-
-	    /* This is a weird hack to get the actual client handle back out
-               of the B tree node returned by tsearch */
-        client = client->next;
-
-        if( client == new_client ) {
-            if ((new_client = ntfy_alloc_client()) == NTFY_CLIENT_NULL)
-                return (NTFY_CLIENT_NULL);
-        }
-        else
-            return client;
-    }
+    NTFY_CLIENT_HASH *hash;
 
-    else
-#endif /* HAVE_TSEARCH */
-      if ((client = ntfy_find_nclient(*client_list, nclient,
+    if ((client = ntfy_find_nclient(*client_list, nclient,
 				    client_latest)) != NTFY_CLIENT_NULL)
-        return client;
+	return (client);
     /* Allocate client */
-    else if ((client = ntfy_alloc_client()) == NTFY_CLIENT_NULL)
-        return (NTFY_CLIENT_NULL);
-
+    if ((client = ntfy_alloc_client()) == NTFY_CLIENT_NULL)
+	return (NTFY_CLIENT_NULL);
     /* Initialize client */
     client->next = NTFY_CLIENT_NULL;
     client->conditions = NTFY_CONDITION_NULL;
@@ -177,8 +179,11 @@ ntfy_new_nclient(client_list, nclient, client_latest)
     client->nclient = nclient;
     client->prioritizer = ndis_default_prioritizer;
     client->flags = 0;
+    client->hash_next = NTFY_CLIENT_NULL;
     /* Append to client list */
     ntfy_append_client(client_list, client);
+    if ((hash = ntfy_client_hash(client_list)) != (NTFY_CLIENT_HASH *) 0)
+	ntfy_client_hash_add(hash, client);
     /* Set up client hint */
     *client_latest = client;
 
@@ -194,6 +199,7 @@ ntfy_remove_client(client_list, client, client_latest, who)
 {
     register NTFY_CONDITION *condition;
     NTFY_CONDITION *next;
+    NTFY_CLIENT_HASH *hash;
 
     /* Fixup enumeration variables if client matches one of them */
     if (client == ntfy_enum_client)
@@ -205,11 +211,9 @@ ntfy_remove_client(client_list, client, client_latest, who)
 	next = condition->next;
 	ntfy_remove_condition(client, condition, who);
     }
-#ifdef HAVE_TSEARCH
+    if ((hash = ntfy_client_hash(client_list)) != (NTFY_CLIENT_HASH *) 0)
+	ntfy_client_hash_remove(hash, client);
     /* Remove & free client from client_list */
-    if( client_list == &ndet_clients )
-        tdelete( client, ndet_root, ndet_compar );
-#endif /* HAVE_TSEARCH */
     ntfy_remove_node((NTFY_NODE **) client_list, (NTFY_NODE *) client);
     /* Invalidate condition hint */
     *client_latest = NTFY_CLIENT_NULL;
@@ -46,7 +46,7 @@ ntfy_end_critical()
     /* See if about to exit critical section while not at interrupt level */
     if (ntfy_sigs_blocked == 1 && !NTFY_IN_INTERRUPT) {
 	/* See if the pre-alloced pool of nodes has fallen low */
-	if (ntfy_nodes_avail < NTFY_PRE_ALLOCED)
+	if (ntfy_nodes_short)
 	    ntfy_replenish_nodes();
     }
     ntfy_sigs_blocked--;
@@ -57,6 +57,10 @@ static char     sccsid[] = "@(#)p_list.c 1.142 93/06/28";
 #define RETURN '\r'
 #define TAB '\t'
 
+/* rows from which_row on are about to be renumbered */
+#define ROW_INDEX_CUT(dp, which_row)	\
+	((dp)->row_index_count = MIN((dp)->row_index_count, (which_row)))
+
 static void panel_list_handle_event(Panel_item item_public, Event *event);
 static void panel_list_paint(Panel_item item_public);
 static void panel_list_resize(Panel_item item_public);
@@ -77,7 +81,20 @@ static Xv_opaque enter_read_mode(Menu menu, Menu_item menu_item);
 static Row_info *find_or_create_nth_row(Panel_list_info *dp, int which_row, int create);
 static Row_info *gimme_the_next_row(Panel_list_info *dp, Row_info *prev);
 static Row_info *create_next_row(Panel_list_info *dp, Row_info *prev);
-static int fit_list_box_to_rows(Panel_list_info *dp);
+static Row_info *row_at(Panel_list_info *dp, int which_row);
+static Row_info *row_alloc(Panel_list_info *dp);
+static void row_free(Panel_list_info *dp, Row_info *row);
+static void row_chain_free(Panel_list_info *dp);
+static void vrow_set_count(Panel_list_info *dp);
+static Row_info *vrow_fetch(Panel_list_info *dp, int which_row);
+static void vrow_load(Panel_list_info *dp, Row_info *row, int which_row);
+static void vrow_drop(Panel_list_info *dp, int i);
+static void vrow_flush(Panel_list_info *dp);
+static void fit_list_box_to_rows(Panel_list_info *dp);
+static void row_widths_drop(Panel_list_info *dp, Row_info *row);
+static void row_widths_add(Panel_list_info *dp, Row_info *row);
+static void list_widths_update(Panel_list_info *dp);
+static int row_by_string(const void *a, const void *b);
 static int get_row_rect(Panel_list_info *dp, Row_info *row, Rect *rect);
 static void handle_menu_event(Panel_list_info *dp, Event *event);
 static Panel_setting insert_done(Panel_item text_item, Event *event);
@@ -103,6 +120,8 @@ static void show_feedback(Panel_list_info *dp, Row_info *row, Event *event);
 static void list_menu_done_proc(Menu menu, Xv_opaque result);
 static int is_dbl_click(Panel_list_info *dp, Row_info *row, Event *event);
 
+static int	row_sort_forward;	/* PANEL_LIST_SORT direction */
+
 #ifdef OW_I18N
 extern	  wchar_t	 _xv_null_string_wc[];
 #endif /* OW_I18N */
@@ -227,21 +246,20 @@ panel_list_set_avlist(panel_list_public, avlist)
 {
     register Panel_list_info *dp = PANEL_LIST_PRIVATE(panel_list_public);
     register int i;
-    int		    forward;
     int		    insert_glyphs;
     Item_info      *ip = ITEM_PRIVATE(panel_list_public);
-    int             max_glyph_width;
     Row_info	   *next;	/* next node in list */
     Row_info       *node;	/* current node in list */
     Xv_opaque	   *obj_ptr;	/* array of strings or glyphs */
     Attr_avlist     orig_avlist = avlist;
     Row_info	   *prev;	/* previous node in list */
     int             reset_rows = FALSE;
+    int             repaint_rows = FALSE;
+    int             batch_ended = FALSE;
     Xv_opaque	    result;
-    Row_info	    row_tmp;
     Xv_Server	    server;
     struct pr_size  size;
-    int		    sort_count;
+    int		    focus_nbr;
     int		    which_row;
     int             xv_end_create = FALSE;
 #ifdef OW_I18N
@@ -266,8 +284,12 @@ panel_list_set_avlist(panel_list_public, avlist)
     for ( ; *avlist; avlist = attr_next(avlist)) {
 	switch ((int) avlist[0]) {
 	  case PANEL_LIST_ROW_HEIGHT:
-	    if (!dp->initialized)
+	    if (!dp->initialized &&
+		dp->row_height != (unsigned short) avlist[1]) {
 		dp->row_height = (unsigned short) avlist[1];
+		/* Cached virtual rows have string_y at the old height */
+		vrow_flush(dp);
+	    }
 	    break;
 	  case PANEL_LIST_INSERT_DUPLICATE:
 	    dp->insert_duplicate = avlist[1] ? TRUE : FALSE;
@@ -346,20 +368,19 @@ panel_list_set_avlist(panel_list_public, avlist)
 		      check_for_duplicate(dp, pswcs.value))
 		      break;  /* don't insert a duplicate string */
 
+		  row_widths_drop(dp, node);
                   _xv_set_wcs_attr_dup(&node->string, pswcs.value);
-		  if (pswcs.value)
-		      node->display_str_len = 0;
 #else /* OW_I18N */
 		  if (!dp->insert_duplicate &&
 		      check_for_duplicate(dp, entry->string))
 		      break;  /* don't insert a duplicate string */
 
+		  row_widths_drop(dp, node);
 		  if (node->f.free_string)
 		      xv_free(node->string);
 
 		  if (entry->string) {
 		      node->string = panel_strsave(entry->string);
-		      node->display_str_len = 0;  /* force recomputation */
 		      node->f.free_string = TRUE;
 		  } else {
 
@@ -375,6 +396,7 @@ panel_list_set_avlist(panel_list_public, avlist)
 		      set_row_glyph(dp, node, (Pixrect *) entry->glyph);
 		  else
 		      node->glyph = NULL;
+		  row_widths_add(dp, node);
 		  
 		  /*
 		   * Do PANEL_LIST_MASK_GLYPH stuff
@@ -496,7 +518,7 @@ panel_list_set_avlist(panel_list_public, avlist)
 	        break;
 
 	  case PANEL_LIST_MODE:
-		if (!dp->initialized || dp->read_only)
+		if (!dp->initialized || dp->read_only || VIRTUAL_LIST(dp))
 		    break;
 		if ((Panel_list_mode) avlist[1] == PANEL_LIST_READ &&
 		    dp->edit_mode)
@@ -532,8 +554,9 @@ panel_list_set_avlist(panel_list_public, avlist)
 			check_for_duplicate(dp, pswcs.value))
 			continue;  /* don't insert a duplicate string */
 		    node = next_row(dp, node, i);
+		    row_widths_drop(dp, node);
 		    _xv_set_wcs_attr_dup(&node->string, pswcs.value);
-		    node->display_str_len = 0;  /* force recomputation */
+		    row_widths_add(dp, node);
 		}
 		break;
 
@@ -549,9 +572,9 @@ pls:
 		    break;  /* don't insert a duplicate string */
 		which_row = (int) avlist[1];
 		node = find_or_create_nth_row(dp, which_row, TRUE);
-		if (avlist[2])
-		    node->display_str_len = 0;  /* force recomputation */
+		row_widths_drop(dp, node);
 		_xv_set_wcs_attr_dup(&node->string, pswcs.value);
+		row_widths_add(dp, node);
 		break;
 
 #else /* OW_I18N */
@@ -563,11 +586,12 @@ pls:
 			check_for_duplicate(dp, (char *) avlist[i+1]))
 			continue;  /* don't insert a duplicate string */
 		    node = next_row(dp, node, i);
+		    row_widths_drop(dp, node);
 		    if (node->f.free_string)
 			free(node->string);
 		    node->string = panel_strsave((char *) avlist[i+1]);
-		    node->display_str_len = 0;  /* force recomputation */
 		    node->f.free_string = TRUE;
+		    row_widths_add(dp, node);
 		}
     		if (dp->rows_displayed == 0) {
 		    if (dp->nrows < PANEL_LIST_DEFAULT_ROW)
@@ -585,16 +609,17 @@ pls:
 		which_row = (int) avlist[1];
 		node = find_or_create_nth_row(dp, which_row,
 					     TRUE);
+		row_widths_drop(dp, node);
 		if (node->f.free_string)
 		    free(node->string);
 		if (avlist[2]) {
 		    node->string = panel_strsave((char *) avlist[2]);
-		    node->display_str_len = 0;  /* force recomputation */
 		    node->f.free_string = TRUE;
 		} else {
 		    node->string = (char *) avlist[2];
 		    node->f.free_string = FALSE;
 		}
+		row_widths_add(dp, node);
 		break;
 #endif /* OW_I18N */
 
@@ -603,7 +628,9 @@ pls:
 		node = dp->rows;
 		while (avlist[i+1]) {
 		    node = next_row(dp, node, i++);
+		    row_widths_drop(dp, node);
 		    set_row_glyph(dp, node, (Pixrect *) avlist[i]);
+		    row_widths_add(dp, node);
 		}
 		break;
 
@@ -611,10 +638,12 @@ pls:
 		which_row = (int) avlist[1];
 		node = find_or_create_nth_row(dp,
 					     which_row, TRUE);
+		row_widths_drop(dp, node);
 		if (avlist[2])
 		    set_row_glyph(dp, node, (Pixrect *) avlist[2]);
 		else
 		    node->glyph = NULL;
+		row_widths_add(dp, node);
 		break;
 
 	  case PANEL_LIST_MASK_GLYPHS:
@@ -704,14 +733,16 @@ pls:
 		}
 		which_row = (int) avlist[1];
 		/* Find node in list to insert new nodes before */
-		prev = NULL;
-		for (next = dp->rows; next && next->row != which_row;
-		     next = next->next)
-		    prev = next;
+		next = row_at(dp, which_row);
+		if (next)
+		    prev = next->prev;
+		else
+		    prev = row_at(dp, dp->nrows - 1);
 		if (prev)
 		    which_row = prev->row + 1; /* in case we're appending */
 		else
 		    which_row = 0;
+		ROW_INDEX_CUT(dp, which_row);
 		/* Insert new rows */
 		insert_glyphs = (int)avlist[0] == PANEL_LIST_INSERT_GLYPHS;
 		node = NULL;
@@ -731,7 +762,7 @@ pls:
 			check_for_duplicate(dp, (char *) *obj_ptr))
 			continue;  /* don't insert duplicate string */
 #endif /* OW_I18N */
-		    node = xv_alloc(Row_info);
+		    node = row_alloc(dp);
 		    if (prev)
 			prev->next = node;
 		    else {
@@ -756,6 +787,7 @@ pls:
 			node->f.free_string = TRUE;
 #endif /* OW_I18N */
 		    }
+		    row_widths_add(dp, node);
 		    prev = node;
 		}
 		if (!node)
@@ -773,7 +805,7 @@ pls:
 		}
 		/* Update Scrolling List and it's scrollbar */
 		dp->nrows = which_row;
-		if (dp->list_sb)
+		if (dp->list_sb && !dp->batch)
 		    xv_set(dp->list_sb,
 			   SCROLLBAR_OBJECT_LENGTH, dp->nrows,
 			   NULL);
@@ -788,11 +820,7 @@ pls:
 			NULL);
 		    break;
 		}
-		which_row = (int) avlist[1];
-		node = dp->rows;
-
-		while (node && (node->row != which_row))
-		    node = node->next;
+		node = row_at(dp, (int) avlist[1]);
 		if (node)
 		    panel_list_delete_row(dp, node, DO_NOT_REPAINT_LIST);
 		break;
@@ -807,17 +835,17 @@ pls:
 		    break;
 		}
 		which_row = (int) avlist[1];
-		node = dp->rows;
 
 		/* Find the first row to delete */
-		while (node && (node->row != which_row))
-		    node = node->next;
+		node = row_at(dp, which_row);
 		if (!node)
 		    break;
+		ROW_INDEX_CUT(dp, which_row);
 		prev = node->prev;
 		/* Delete the requested number of rows */
 		for (i = 1; node && i <= (int) avlist[2]; i++) {
 		    next = node->next;
+		    row_widths_drop(dp, node);
 #ifdef OW_I18N
 		    _xv_free_ps_string_attr_dup(&node->string);
 #else
@@ -828,7 +856,7 @@ pls:
 			dp->focus_row = NULL;
 		    if (dp->current_row == node)
 			dp->current_row = NULL;
-		    xv_free(node);
+		    row_free(dp, node);
 		    node = next;
 		}
 		if (prev)
@@ -848,7 +876,7 @@ pls:
 		}
 		/* Update Scrolling List and it's scrollbar */
 		dp->nrows = which_row;
-		if (dp->list_sb)
+		if (dp->list_sb && !dp->batch)
 		    xv_set(dp->list_sb,
 			   SCROLLBAR_OBJECT_LENGTH, dp->nrows,
 			   NULL);
@@ -935,51 +963,75 @@ pls:
 	    dp->read_only = avlist[1] ? TRUE : FALSE;
 	    break;
 
+	  case PANEL_LIST_FETCH_PROC:
+	    /* The client owns the rows from now on */
+	    if (avlist[1] && !VIRTUAL_LIST(dp))
+		row_chain_free(dp);
+	    dp->fetch_proc = (Panel_list_fetch_proc) avlist[1];
+	    if (VIRTUAL_LIST(dp))
+		vrow_set_count(dp);
+	    else {
+		vrow_flush(dp);
+		dp->nrows = 0;
+	    }
+	    repaint_rows = TRUE;
+	    break;
+
+	  case PANEL_LIST_VIRTUAL_ROWS:
+	    /* Kept until the fetch proc arrives, whatever the order */
+	    dp->virtual_rows = MAX((int) avlist[1], 0);
+	    if (VIRTUAL_LIST(dp)) {
+		vrow_set_count(dp);
+		repaint_rows = TRUE;
+	    }
+	    break;
+
+	  case PANEL_LIST_BATCH:
+	    if (avlist[1])
+		dp->batch++;
+	    else if (dp->batch && --dp->batch == 0)
+		batch_ended = TRUE;
+	    break;
+
+	  case PANEL_LIST_SORT_PROC:
+	    dp->sort_proc = (Panel_list_sort_proc) avlist[1];
+	    break;
+
+	  case PANEL_LIST_SEARCH_PROC:
+	    dp->search_proc = (Panel_list_search_proc) avlist[1];
+	    break;
+
 	  case PANEL_LIST_SORT:
 	    if (!created(ip))
 		break;	/* not valid on xv_create */
-	    forward = (Panel_setting) avlist[1] == PANEL_FORWARD;
-	    do {
-		sort_count = 0;
-		for (node = dp->rows; node && node->next; node = node->next) {
-		    if (!node->STRING)
-			continue;
-		    next = node->next;
-#ifdef OW_I18N
-		    if (!next->STRING ||
-		         (forward ? (wscoll(node->string.pswcs.value,
-					    next->string.pswcs.value) > 0)
-				  : (wscoll(node->string.pswcs.value,
-					    next->string.pswcs.value) < 0)))
-#else
-		    if (!next->string ||
-			(forward ? (strcmp(node->string, next->string) > 0)
-				 : (strcmp(node->string, next->string) < 0)))
-#endif /* OW_I18N */
-		    {
-			sort_count++;
-			/* Swap contents of nodes */
-			row_tmp = *node;
-			node->client_data = next->client_data;
-			node->display_str_len = next->display_str_len;
-			node->font = next->font;
-			node->glyph = next->glyph;
-			node->string = next->string;
-			node->f = next->f;
-			next->client_data = row_tmp.client_data;
-			next->display_str_len = row_tmp.display_str_len;
-			next->font = row_tmp.font;
-			next->glyph = row_tmp.glyph;
-			next->string = row_tmp.string;
-			next->f = row_tmp.f;
-
-			if ( node == dp->current_row )
-			    dp->current_row = next;
-			else if ( next == dp->current_row )
-			    dp->current_row = node;
-		    }
+	    if (VIRTUAL_LIST(dp)) {
+		if (dp->sort_proc) {
+		    (*dp->sort_proc) (panel_list_public,
+				      (Panel_setting) avlist[1]);
+		    vrow_flush(dp);
+		    repaint_rows = TRUE;
 		}
-	    } while (sort_count);
+		break;
+	    }
+	    /* Sort the row index, then relink the rows in its order */
+	    if (dp->nrows < 2 || !row_at(dp, dp->nrows - 1))
+		break;
+	    row_sort_forward = (Panel_setting) avlist[1] == PANEL_FORWARD;
+	    focus_nbr = dp->focus_row ? dp->focus_row->row : -1;
+	    qsort((char *) dp->row_index, dp->nrows, sizeof(Row_info *),
+		  row_by_string);
+	    for (i = 0; i < dp->nrows; i++) {
+		node = dp->row_index[i];
+		node->row = i;
+		node->string_y = LIST_BOX_BORDER_WIDTH + ROW_MARGIN +
+		    i*dp->row_height;
+		node->prev = i > 0 ? dp->row_index[i - 1] : NULL;
+		node->next = i < dp->nrows - 1 ? dp->row_index[i + 1] : NULL;
+	    }
+	    dp->rows = dp->row_index[0];
+	    /* The location cursor stays where it was */
+	    if (focus_nbr >= 0)
+		dp->focus_row = dp->row_index[focus_nbr];
 	    break;
 
 	  case PANEL_VALUE_STORED_LENGTH:
@@ -1038,6 +1090,23 @@ pls:
         }
     }
 
+    /*
+     * Inside a batch the rows are kept up to date but the layout,
+     * scrollbar and painting wait for the batch to end.
+     */
+    if (dp->batch && dp->initialized && !xv_end_create) {
+	dp->batch_reset_rows |= reset_rows;
+#ifdef OW_I18N
+	if (pswcs.storage != NULL)
+	    xv_free(pswcs.storage);
+#endif
+	return XV_OK;
+    }
+    if (batch_ended) {
+	reset_rows |= dp->batch_reset_rows;
+	dp->batch_reset_rows = FALSE;
+    }
+
     if (reset_rows && dp->initialized) {
 	dp->list_box.r_height = 2*LIST_BOX_BORDER_WIDTH +
 	    2*ROW_MARGIN + dp->rows_displayed*dp->row_height;
@@ -1049,15 +1118,10 @@ pls:
     }
 
     /* Horizontally align strings in row panel */
-    max_glyph_width = 0;
-    for (node = dp->rows; node; node = node->next)
-	if (node->glyph) {
-	    if (node->glyph->pr_width > max_glyph_width)
-		max_glyph_width = node->glyph->pr_width;
-	}
+    list_widths_update(dp);
     dp->string_x = LIST_BOX_BORDER_WIDTH + ROW_MARGIN + PANEL_LIST_COL_GAP;
-    if (max_glyph_width) {
-	dp->string_x += max_glyph_width;
+    if (dp->max_glyph_width) {
+	dp->string_x += dp->max_glyph_width;
     }
 
     if (dp->initialized) {
@@ -1203,6 +1267,13 @@ pls:
 	    xv_set(dp->list_sb,
 		   SCROLLBAR_OBJECT_LENGTH, dp->nrows,
 		   NULL);
+	    if (batch_ended && ip->panel->status.painted && !hidden(ip))
+		panel_redisplay_item(ip, PANEL_CLEAR);
+	    else if (repaint_rows && ip->panel->status.painted &&
+		     !hidden(ip)) {
+		panel_clear_rect(ip->panel, dp->list_box);
+		paint_list_box(dp);
+	    }
 	}
     }   /* if (dp->initialized) */
 
@@ -1265,6 +1336,21 @@ panel_list_get_attr(panel_list_public, status, which_attr, valist)
       case PANEL_LIST_SCROLLBAR:
 	return (Xv_opaque) dp->list_sb;
 
+      case PANEL_LIST_FETCH_PROC:
+	return (Xv_opaque) dp->fetch_proc;
+
+      case PANEL_LIST_VIRTUAL_ROWS:
+	return (Xv_opaque) dp->virtual_rows;
+
+      case PANEL_LIST_SORT_PROC:
+	return (Xv_opaque) dp->sort_proc;
+
+      case PANEL_LIST_SEARCH_PROC:
+	return (Xv_opaque) dp->search_proc;
+
+      case PANEL_LIST_BATCH:
+	return (Xv_opaque) (dp->batch != 0);
+
       case PANEL_LIST_SELECTED:
 /* Alpha compatibility, mbuck@debian.org */
 #if 1
@@ -1464,23 +1550,32 @@ panel_list_destroy(item_public, status)
     Destroy_status  status;
 {
     Panel_list_info *dp = PANEL_LIST_PRIVATE(item_public);
-    Row_info       *row = dp->rows;
-    Row_info       *next;
+    Row_info       *row;
+    Row_chunk      *chunk;
 
     if ((status == DESTROY_CHECKING) || (status == DESTROY_SAVE_YOURSELF)) {
 	return XV_OK;
     }
     panel_list_remove(item_public);
-    while (row) {
-	next = row->next;
+    for (row = dp->rows; row; row = row->next) {
 #ifdef OW_I18N
 	_xv_free_ps_string_attr_dup(&row->string);
 #else
 	if (row->f.free_string)
 	    xv_free(row->string);
 #endif /* OW_I18N */
-	xv_free(row);
-	row = next;
+    }
+    while ((chunk = dp->row_chunks)) {
+	dp->row_chunks = chunk->next;
+	xv_free(chunk);
+    }
+    if (dp->row_index)
+	xv_free(dp->row_index);
+    dp->fetch_proc = NULL;
+    vrow_flush(dp);
+    if (dp->vrows) {
+	xv_free(dp->vrows);
+	xv_free(dp->vrows_used);
     }
 #ifdef OW_I18N
     _xv_free_ps_string_attr_dup(&dp->title);
@@ -1515,7 +1610,6 @@ panel_list_handle_event(item_public, event)
     Event          *event;
 {
     Panel_list_info *dp = PANEL_LIST_PRIVATE(item_public);
-    int		    i;
     Item_info	   *ip = ITEM_PRIVATE(item_public);
     int		    navigation_cmd;
     Panel_info	   *panel = PANEL_PRIVATE(dp->parent_panel);
@@ -1557,9 +1651,17 @@ panel_list_handle_event(item_public, event)
             return;
 	/* Move the Location Cursor to the row starting with the character
 	 * typed that is after the current focus row, if any.
-	 * Match is case-insensitive.
+	 * Match is case-insensitive.  A virtual list asks its search proc.
 	 */
-	if (dp->focus_row && dp->focus_row->next) {
+	if (VIRTUAL_LIST(dp)) {
+	    if (dp->search_proc && dp->focus_row &&
+		(row = find_or_create_nth_row(dp, (*dp->search_proc)
+			(item_public, dp->focus_row->row + 1, event), FALSE))) {
+		dp->focus_row = row;
+		show_focus_win(item_public);
+		return;
+	    }
+	} else if (dp->focus_row && dp->focus_row->next) {
 #ifdef OW_I18N
 	    if (event_is_string(event)) {
 		if (mbtowc(&wc, event_string(event), MB_CUR_MAX) <= 0)
@@ -1608,6 +1710,8 @@ beep:
 	win_bell(event_window(event), wait, 0);
 	return;
     } else if (!event_is_button(event) && event_action(event) != LOC_DRAG) {
+	if (!dp->focus_row && VIRTUAL_LIST(dp))
+	    dp->focus_row = find_or_create_nth_row(dp, 0, FALSE);
 	if (event_action(event) != ACTION_MENU &&
 	    (!dp->focus_row ||
 	     (event_action(event) != ACTION_ADJUST && event_is_up(event))))
@@ -1619,20 +1723,19 @@ beep:
 	row = NULL;
 	switch (event_action(event)) {
 	  case ACTION_UP:
-	    row = dp->focus_row->prev;
+	    row = find_or_create_nth_row(dp, dp->focus_row->row - 1, FALSE);
 	    break;
 	  case ACTION_DOWN:
-	    row = dp->focus_row->next;
+	    row = find_or_create_nth_row(dp, dp->focus_row->row + 1, FALSE);
 	    break;
 	  case ACTION_JUMP_UP:
-	    for (i=1, row=dp->focus_row; (unsigned)i<=dp->rows_displayed && row->prev;
-		 i++)
-		row = row->prev;
+	    row = find_or_create_nth_row(dp,
+		MAX(dp->focus_row->row - (int) dp->rows_displayed, 0), FALSE);
 	    break;
 	  case ACTION_JUMP_DOWN:
-	    for (i=1, row=dp->focus_row; (unsigned)i<=dp->rows_displayed && row->next;
-		 i++)
-		row = row->next;
+	    row = find_or_create_nth_row(dp,
+		MIN(dp->focus_row->row + (int) dp->rows_displayed,
+		    dp->nrows - 1), FALSE);
 	    break;
 	  case ACTION_PANE_UP:
 	  case ACTION_SCROLL_UP:	/* USE_SCROLL_WHEEL */
@@ -1646,11 +1749,10 @@ beep:
 	    row = find_or_create_nth_row(dp, row_nbr, FALSE);
 	    break;
 	  case ACTION_DATA_START:
-	    row = dp->rows;
+	    row = find_or_create_nth_row(dp, 0, FALSE);
 	    break;
 	  case ACTION_DATA_END:
-	    for (row = dp->focus_row; row->next;)
-		row = row->next;
+	    row = find_or_create_nth_row(dp, dp->nrows - 1, FALSE);
 	    break;
 	  case ACTION_SELECT:
 	  case ACTION_ADJUST:
@@ -1686,9 +1788,7 @@ beep:
 	    y_offset = dp->rows_displayed*dp->row_height - 1;
 	row_nbr = (unsigned) xv_get(dp->list_sb, SCROLLBAR_VIEW_START) +
 	    (unsigned)y_offset / dp->row_height;
-	for (row=dp->rows; row; row=row->next)
-	    if (row->row == row_nbr)
-		break;
+	row = find_or_create_nth_row(dp, row_nbr, FALSE);
 	if (event_action(event) != ACTION_MENU) {
 	    if (!row) {
 		/* Non-menu event not over a row: ignore all but SELECT-down */
@@ -1960,6 +2060,7 @@ accept_change(text_item, edit_row)
     xv_set(text_item, XV_SHOW, FALSE, NULL);
     xv_set(dp->list_sb, SCROLLBAR_INACTIVE, FALSE, NULL);
     dp->text_item_row = NULL;   /* no row being edited */
+    row_widths_drop(dp, edit_row);
 #ifdef OW_I18N
     _xv_set_wcs_attr_dup(&edit_row->string,
 			 (wchar_t *) xv_get(text_item, PANEL_VALUE_WCS));
@@ -1970,7 +2071,7 @@ accept_change(text_item, edit_row)
     edit_row->f.free_string = TRUE;
 #endif /* OW_I18N */
     edit_row->f.show = TRUE;
-    set_row_display_str_length(dp, edit_row);
+    row_widths_add(dp, edit_row);
     paint_row(dp, edit_row);
 }
 
@@ -1984,6 +2085,7 @@ accept_insert(dp, row)
     xv_set(dp->text_item, XV_SHOW, FALSE, NULL);
     xv_set(dp->list_sb, SCROLLBAR_INACTIVE, FALSE, NULL);
     dp->text_item_row = NULL;   /* no row being edited */
+    row_widths_drop(dp, row);
 #ifdef OW_I18N
     _xv_set_wcs_attr_dup(&row->string,
 			 (wchar_t *) xv_get(dp->text_item, PANEL_VALUE_WCS));
@@ -1994,7 +2096,7 @@ accept_insert(dp, row)
     row->f.free_string = TRUE;
 #endif /* OW_I18N */
     row->f.show = TRUE;
-    set_row_display_str_length(dp, row);
+    row_widths_add(dp, row);
     paint_row(dp, row);
 }
 
@@ -2153,7 +2255,6 @@ compute_dimensions(ip, dp)
 #else
     XFontStruct	   *font_struct;
 #endif /* OW_I18N */
-    int		    list_box_width_changed;
     int		    max_string_width;
     Row_info       *node;	/* current node in list */
     Rect	   *view_rect;
@@ -2171,22 +2272,21 @@ compute_dimensions(ip, dp)
     } else
 	/* An explicit width was specified */
 	ext_width = 0;
-    list_box_width_changed = fit_list_box_to_rows(dp);
-    if (ext_width > dp->list_box.r_width) {
+    fit_list_box_to_rows(dp);
+    if (ext_width > dp->list_box.r_width)
 	dp->list_box.r_width = ext_width;
-	list_box_width_changed = TRUE;
-    }
     dp->title_rect.r_width = dp->list_box.r_width;
 
     /*
-     * Calculate the string y-coordinate and displayed string length
-     * of each row.
+     * Rows get their string y-coordinate as they are inserted and
+     * moved; it need only be redone for a new row height.  Displayed
+     * string lengths are worked out as rows are painted.
      */
-    for (node=dp->rows; node; node=node->next) {
-	node->string_y = LIST_BOX_BORDER_WIDTH + ROW_MARGIN +
-	    node->row*dp->row_height;
-	if (!node->display_str_len || list_box_width_changed)
-	    set_row_display_str_length(dp, node);
+    if (dp->string_y_height != dp->row_height) {
+	for (node=dp->rows; node; node=node->next)
+	    node->string_y = LIST_BOX_BORDER_WIDTH + ROW_MARGIN +
+		node->row*dp->row_height;
+	dp->string_y_height = dp->row_height;
     }
     /* Calculate the displayed string length of the title */
     if (dp->TITLE) {
@@ -2495,19 +2595,286 @@ find_or_create_nth_row(dp, which_row, create)
      int             	which_row;
      int             	create;
 {
-    Row_info       *prev = NULL;
-    Row_info       *node = dp->rows;
+    Row_info       *node;
 
+    if (VIRTUAL_LIST(dp))
+	return (vrow_fetch(dp, which_row));
+    node = row_at(dp, which_row);
+    if (!node && create)
+	node = create_next_row(dp, row_at(dp, dp->nrows - 1));
 
-    while (node && (node->row != which_row)) {
-	prev = node;
-	node = node->next;
+    return (node);
+}
+
+
+/*
+ * Row which_row, through row_index.  The index is extended from its
+ * last valid entry by following the list, so a run of lookups and
+ * appends costs one pass over the rows in all.
+ */
+static Row_info *
+row_at(dp, which_row)
+     Panel_list_info	*dp;
+     int             	which_row;
+{
+    Row_info       *node;
+    int		    size;
+
+    if (!dp->rows || which_row < 0 || which_row >= dp->nrows)
+	return (NULL);
+    if (which_row >= dp->row_index_count) {
+	if (which_row >= dp->row_index_size) {
+	    for (size = MAX(dp->row_index_size, PANEL_LIST_ROW_CHUNK);
+		 size <= which_row; size *= 2)
+		;
+	    dp->row_index = dp->row_index ?
+		xv_realloc(dp->row_index, size * sizeof(Row_info *)) :
+		xv_malloc(size * sizeof(Row_info *));
+	    dp->row_index_size = size;
+	}
+	node = dp->row_index_count ?
+	    dp->row_index[dp->row_index_count - 1]->next : dp->rows;
+	while (node && dp->row_index_count <= which_row) {
+	    dp->row_index[dp->row_index_count++] = node;
+	    node = node->next;
+	}
+	if (dp->row_index_count <= which_row)
+	    return (NULL);
     }
+    return (dp->row_index[which_row]);
+}
 
-    if (!node && create)
-	node = create_next_row(dp, prev);
 
-    return (node);
+/*
+ * Rows are carved out of chunks of PANEL_LIST_ROW_CHUNK rather than
+ * allocated one by one; they come back zeroed, as from xv_alloc.
+ */
+static Row_info *
+row_alloc(dp)
+     Panel_list_info	*dp;
+{
+    Row_chunk      *chunk;
+    Row_info       *row;
+    int		    i;
+
+    if (!dp->row_free) {
+	chunk = xv_alloc(Row_chunk);
+	chunk->next = dp->row_chunks;
+	dp->row_chunks = chunk;
+	for (i = PANEL_LIST_ROW_CHUNK - 1; i >= 0; i--) {
+	    chunk->rows[i].next = dp->row_free;
+	    dp->row_free = &chunk->rows[i];
+	}
+    }
+    row = dp->row_free;
+    dp->row_free = row->next;
+    memset((char *) row, 0, sizeof(Row_info));
+    return (row);
+}
+
+
+static void
+row_free(dp, row)
+     Panel_list_info	*dp;
+     Row_info		*row;
+{
+    if (dp->last_click_row == row)
+	dp->last_click_row = NULL;
+    row->next = dp->row_free;
+    dp->row_free = row;
+}
+
+
+/*
+ * Free every row of the chain, leaving an empty list.
+ */
+static void
+row_chain_free(dp)
+     Panel_list_info	*dp;
+{
+    Row_info       *row, *next;
+
+    for (row = dp->rows; row; row = next) {
+	next = row->next;
+#ifdef OW_I18N
+	_xv_free_ps_string_attr_dup(&row->string);
+#else
+	if (row->f.free_string)
+	    xv_free(row->string);
+#endif /* OW_I18N */
+	row_free(dp, row);
+    }
+    dp->rows = NULL;
+    dp->nrows = 0;
+    ROW_INDEX_CUT(dp, 0);
+    dp->max_glyph_width = dp->max_string_width = 0;
+    dp->glyph_width_stale = dp->string_width_stale = FALSE;
+    dp->focus_row = NULL;
+    dp->current_row = NULL;
+    dp->last_edit_row = NULL;
+    if (dp->text_item_row) {
+	xv_set(dp->text_item, XV_SHOW, FALSE, NULL);
+	dp->text_item_row = NULL;
+    }
+}
+
+
+/*
+ * Take the row count of a virtual list from PANEL_LIST_VIRTUAL_ROWS.
+ */
+static void
+vrow_set_count(dp)
+     Panel_list_info	*dp;
+{
+    dp->nrows = dp->virtual_rows;
+    vrow_flush(dp);
+    if (dp->rows_displayed == 0) {
+	if (dp->nrows < PANEL_LIST_DEFAULT_ROW)
+	    dp->rows_displayed = dp->nrows;
+	else
+	    dp->rows_displayed = PANEL_LIST_DEFAULT_ROW;
+    }
+}
+
+
+/*
+ * Row which_row of a virtual list, from the cache or from the client.
+ * The rows the list holds pointers to (focus, current, last click) are
+ * never the ones evicted.
+ */
+static Row_info *
+vrow_fetch(dp, which_row)
+     Panel_list_info	*dp;
+     int             	which_row;
+{
+    Row_info       *row;
+    int		    i, victim;
+
+    if (which_row < 0 || which_row >= dp->nrows)
+	return (NULL);
+    if (dp->vrows_size < (int) dp->rows_displayed + 4) {
+	for (i = 0; i < dp->vrows_size; i++)
+	    vrow_drop(dp, i);
+	if (dp->vrows) {
+	    xv_free(dp->vrows);
+	    xv_free(dp->vrows_used);
+	}
+	dp->vrows_size = MAX(PANEL_LIST_ROW_CHUNK, 2 * dp->rows_displayed);
+	dp->vrows = xv_alloc_n(Row_info, dp->vrows_size);
+	dp->vrows_used = xv_alloc_n(unsigned, dp->vrows_size);
+    }
+    victim = -1;
+    for (i = 0; i < dp->vrows_size; i++) {
+	row = &dp->vrows[i];
+	if (dp->vrows_used[i] && row->row == which_row) {
+	    dp->vrows_used[i] = ++dp->vrows_clock;
+	    return (row);
+	}
+	if (row == dp->focus_row || row == dp->current_row ||
+	    row == dp->last_click_row)
+	    continue;
+	if (victim < 0 || dp->vrows_used[i] < dp->vrows_used[victim])
+	    victim = i;
+    }
+    vrow_drop(dp, victim);
+    row = &dp->vrows[victim];
+    vrow_load(dp, row, which_row);
+    dp->vrows_used[victim] = ++dp->vrows_clock;
+    return (row);
+}
+
+
+static void
+vrow_load(dp, row, which_row)
+     Panel_list_info	*dp;
+     Row_info		*row;
+     int             	which_row;
+{
+    Panel_list_row_values values;
+
+#ifdef OW_I18N
+    _xv_free_ps_string_attr_dup(&row->string);
+#else
+    if (row->f.free_string)
+	xv_free(row->string);
+#endif /* OW_I18N */
+    memset((char *) row, 0, sizeof(Row_info));
+    memset((char *) &values, 0, sizeof(values));
+    (*dp->fetch_proc) (PANEL_LIST_PUBLIC(dp), which_row, &values);
+
+    row->row = which_row;
+    row->string_y = LIST_BOX_BORDER_WIDTH + ROW_MARGIN +
+	which_row*dp->row_height;
+    row->f.show = TRUE;
+#ifdef OW_I18N
+    _xv_set_mbs_attr_dup(&row->string, values.string);
+#else
+    if (values.string) {
+	row->string = panel_strsave(values.string);
+	row->f.free_string = TRUE;
+    }
+#endif /* OW_I18N */
+    if (values.glyph)
+	set_row_glyph(dp, row, (Pixrect *) values.glyph);
+    set_row_mask_glyph(dp, row, (Pixrect *) values.mask_glyph);
+    set_row_font(dp, row, values.font);
+    row->client_data = values.client_data;
+    row->exten_data = values.extension_data;
+    row->f.row_inactive = values.inactive;
+    row->f.selected = values.selected && !values.inactive;
+}
+
+
+/*
+ * Empty slot i of the virtual row cache.
+ */
+static void
+vrow_drop(dp, i)
+     Panel_list_info	*dp;
+     int		 i;
+{
+    Row_info       *row = &dp->vrows[i];
+
+    if (!dp->vrows_used[i])
+	return;
+    dp->vrows_used[i] = 0;
+#ifdef OW_I18N
+    _xv_free_ps_string_attr_dup(&row->string);
+#else
+    if (row->f.free_string)
+	xv_free(row->string);
+    row->string = NULL;
+    row->f.free_string = FALSE;
+#endif /* OW_I18N */
+    if (dp->focus_row == row)
+	dp->focus_row = NULL;
+    if (dp->current_row == row)
+	dp->current_row = NULL;
+    if (dp->last_click_row == row)
+	dp->last_click_row = NULL;
+}
+
+
+/*
+ * The client's rows have changed: refetch the rows the list points at
+ * and forget the rest.
+ */
+static void
+vrow_flush(dp)
+     Panel_list_info	*dp;
+{
+    Row_info       *row;
+    int		    i;
+
+    for (i = 0; i < dp->vrows_size; i++) {
+	row = &dp->vrows[i];
+	if (dp->vrows_used[i] && VIRTUAL_LIST(dp) && row->row < dp->nrows &&
+	    (row == dp->focus_row || row == dp->current_row ||
+	     row == dp->last_click_row))
+	    vrow_load(dp, row, row->row);
+	else
+	    vrow_drop(dp, i);
+    }
 }
 
 
@@ -2537,7 +2904,7 @@ create_next_row(dp, prev)
 {
     Row_info *node;
 
-    node = xv_alloc(Row_info);
+    node = row_alloc(dp);
     if (prev) {
 	node->row = prev->row + 1;
 	prev->next = node;
@@ -2574,32 +2941,124 @@ create_next_row(dp, prev)
 /*
  * fit the scrolling list
  */
-static int	/* returns TRUE if dp->list_box.r_width changed */
+static void
 fit_list_box_to_rows(dp)
     Panel_list_info *dp;
 {
-    int		    max_str_size;
-    int		    new_width;
+    if (dp->width <= 0) {
+	list_widths_update(dp);
+	dp->list_box.r_width = dp->string_x + dp->max_string_width +
+	    ROW_MARGIN + LIST_BOX_BORDER_WIDTH;
+    } else
+	dp->list_box.r_width = dp->width;
+}
+
+
+/*
+ * dp->max_glyph_width and dp->max_string_width follow the rows of the
+ * chain: row_widths_drop is called before a row's string or glyph
+ * changes or the row goes away, row_widths_add after.  Losing the
+ * widest row only marks the maximum stale; list_widths_update then
+ * rescans the rows once, at the next layout.  String widths are left
+ * stale while the list has a width of its own.
+ */
+static void
+row_widths_drop(dp, row)
+    Panel_list_info *dp;
+    Row_info       *row;
+{
+    struct pr_size  str_size;
+
+    if (VIRTUAL_LIST(dp))
+	return;
+    if (row->glyph && row->glyph->pr_width >= dp->max_glyph_width)
+	dp->glyph_width_stale = TRUE;
+    if (row->STRING && !dp->string_width_stale) {
+	str_size = XV_PF_TEXTWIDTH(STRLEN(row->STRING), dp->font,
+				   row->STRING);
+	if (dp->width > 0 || str_size.x >= dp->max_string_width)
+	    dp->string_width_stale = TRUE;
+    }
+}
+
+
+static void
+row_widths_add(dp, row)
+    Panel_list_info *dp;
     Row_info       *row;
-    struct pr_size  str_size;	/* width & height of row string */
-    int		    width_changed;
+{
+    struct pr_size  str_size;
 
-    if (dp->width <= 0) {
-	max_str_size = 0;
-	for (row=dp->rows; row; row=row->next) {
+    if (VIRTUAL_LIST(dp))
+	return;
+    if (row->glyph)
+	dp->max_glyph_width = MAX(dp->max_glyph_width, row->glyph->pr_width);
+    if (row->STRING && !dp->string_width_stale) {
+	if (dp->width > 0) {
+	    dp->string_width_stale = TRUE;
+	    return;
+	}
+	str_size = XV_PF_TEXTWIDTH(STRLEN(row->STRING), dp->font,
+				   row->STRING);
+	dp->max_string_width = MAX(dp->max_string_width, str_size.x);
+    }
+}
+
+
+static void
+list_widths_update(dp)
+    Panel_list_info *dp;
+{
+    Row_info       *row;
+    struct pr_size  str_size;
+
+    if (dp->glyph_width_stale) {
+	dp->max_glyph_width = 0;
+	for (row = dp->rows; row; row = row->next)
+	    if (row->glyph)
+		dp->max_glyph_width = MAX(dp->max_glyph_width,
+					  row->glyph->pr_width);
+	dp->glyph_width_stale = FALSE;
+    }
+    if (dp->string_width_stale && dp->width <= 0) {
+	dp->max_string_width = 0;
+	for (row = dp->rows; row; row = row->next)
 	    if (row->STRING) {
 		str_size = XV_PF_TEXTWIDTH(STRLEN(row->STRING), dp->font,
-		    row->STRING);
-		max_str_size = MAX(max_str_size, str_size.x);
+					   row->STRING);
+		dp->max_string_width = MAX(dp->max_string_width, str_size.x);
 	    }
-	}
-	new_width = dp->string_x + max_str_size + ROW_MARGIN +
-	    LIST_BOX_BORDER_WIDTH;
-    } else
-	new_width = dp->width;
-    width_changed = new_width != dp->list_box.r_width;
-    dp->list_box.r_width = new_width;
-    return (width_changed);
+	dp->string_width_stale = FALSE;
+    }
+}
+
+
+/*
+ * PANEL_LIST_SORT order: by string, in row_sort_forward's direction,
+ * rows without a string first and rows that compare equal in their
+ * old order.
+ */
+static int
+row_by_string(a, b)
+    const void     *a;
+    const void     *b;
+{
+    Row_info       *r1 = *(Row_info **) a;
+    Row_info       *r2 = *(Row_info **) b;
+    int		    cmp;
+
+    if (!r1->STRING || !r2->STRING)
+	cmp = (r1->STRING != NULL) - (r2->STRING != NULL);
+    else {
+#ifdef OW_I18N
+	cmp = wscoll(r1->STRING, r2->STRING);
+#else
+	cmp = strcmp(r1->STRING, r2->STRING);
+#endif /* OW_I18N */
+	if (!row_sort_forward)
+	    cmp = -cmp;
+    }
+    return (cmp ? cmp : r1->row - r2->row);
 }
 
 
@@ -2963,7 +3422,7 @@ next_row(dp, row, n)
     Row_info       *node = NULL;
 
     if (!row) {
-	dp->rows = row = xv_alloc(Row_info);
+	dp->rows = row = row_alloc(dp);
 	dp->nrows = 1;
 	row->prev = NULL;
 	if (!dp->focus_row)
@@ -2975,7 +3434,7 @@ next_row(dp, row, n)
 	} else if (row->next)	/* Already created */
 	    return (row->next);
 	else {
-	    node = xv_alloc(Row_info);
+	    node = row_alloc(dp);
 	    node->prev = row;
 	    row->next = node;
 	    row = node;
@@ -2985,7 +3444,7 @@ next_row(dp, row, n)
     row->next = NULL;
     row->f.selected = FALSE;
     row->f.show = TRUE;
-    row->row = n;
+    row->row = row->prev ? row->prev->row + 1 : 0;
 #ifdef OW_I18N
     /*
      * xv_alloc uses calloc therefor all fields are zeroed alreday.
@@ -3006,19 +3465,25 @@ paint_list_box(dp)
     Xv_Drawable_info *info;
     Item_info	   *ip = ITEM_FROM_PANEL_LIST(dp);
     Row_info	   *row;
+    int		    first, i;
     Xv_Window	    pw;
     Xv_Screen      screen;
     GC             *gc_list;
 
+    if (dp->batch)
+	return;		/* repainted when the batch ends */
+
     /* Paint list box border.
      *   Dashed = Scrolling List does not have keyboard focus
      *   Solid = Scrolling List has keyboard focus
      */
     paint_list_box_border(dp);
 
-    /* Paint (visible) rows */
-    for (row=dp->rows; row; row=row->next)
-	paint_row(dp, row);
+    /* Paint the rows in view */
+    first = dp->list_sb ? (int) xv_get(dp->list_sb, SCROLLBAR_VIEW_START) : 0;
+    for (i = 0; i < (int) dp->rows_displayed; i++)
+	if ((row = find_or_create_nth_row(dp, first + i, FALSE)))
+	    paint_row(dp, row);
 
     if (ip->panel->status.has_input_focus && ip->panel->kbd_focus_item == ip) {
 	if (!dp->focus_row || row_visible(dp, dp->focus_row->row))
@@ -3129,10 +3594,11 @@ paint_row(dp, row)
     XFontSet	    font_set;
 #endif /* OW_I18N */
 
-    if (!get_row_rect(dp, row, &row_rect))
+    if (dp->batch || !get_row_rect(dp, row, &row_rect))
 	return;
     if (row->STRING)
     {
+	set_row_display_str_length(dp, row);
 	string_rect.r_left = dp->list_box.r_left + dp->string_x;
 	string_rect.r_top = row_rect.r_top;
 	string_rect.r_width = row_rect.r_width - dp->string_x +
@@ -3413,6 +3879,7 @@ panel_list_delete_row(dp, node, repaint)
 {
     Row_info       *prev = node->prev;
 
+    ROW_INDEX_CUT(dp, node->row);
     if (prev) {
 	prev->next = node->next;
     } else {
@@ -3435,20 +3902,21 @@ panel_list_delete_row(dp, node, repaint)
     /* Adjust the row numbers */
     prev = node;
     node = node->next;
+    row_widths_drop(dp, prev);
 #ifdef OW_I18N
     _xv_free_ps_string_attr_dup(&prev->string);
 #else
     if (prev->f.free_string)
 	xv_free(prev->string);
 #endif /* OW_I18N */
-    xv_free(prev);
+    row_free(dp, prev);
     while (node) {
 	node->row--;
 	node->string_y -= dp->row_height;
 	node = node->next;
     }
     dp->nrows--;
-    if (dp->list_sb)
+    if (dp->list_sb && !dp->batch)
 	xv_set(dp->list_sb,
 	       SCROLLBAR_OBJECT_LENGTH, dp->nrows,  /* in rows */
 	       NULL);
@@ -3469,14 +3937,12 @@ panel_list_insert_row(dp, which_row, show, repaint)
     int		    show;
     int		    repaint;
 {
-    Row_info       *node = dp->rows;
-    Row_info       *prev = NULL;
-    Row_info       *row = xv_alloc(Row_info);
+    Row_info       *node = row_at(dp, which_row);
+    Row_info       *prev;
+    Row_info       *row = row_alloc(dp);
 
-    while (node && (node->row != which_row)) {
-	prev = node;
-	node = node->next;
-    }
+    prev = node ? node->prev : row_at(dp, dp->nrows - 1);
+    ROW_INDEX_CUT(dp, node ? which_row : dp->nrows);
     row->f.selected = FALSE;
     row->f.show = show;
     row->next = node;
@@ -3515,7 +3981,7 @@ panel_list_insert_row(dp, which_row, show, repaint)
 	node = node->next;
     }
     dp->nrows++;
-    if (dp->list_sb)
+    if (dp->list_sb && !dp->batch)
 	xv_set(dp->list_sb,
 	       SCROLLBAR_OBJECT_LENGTH, dp->nrows,  /* in rows */
 	       NULL);
@@ -3661,8 +4127,6 @@ set_row_font(dp, row, font)
     Row_info	   *row;
     Xv_Font	    font;
 {
-    Xv_Font	    old_font = row->font;
-
     if (!font)
 	row->font = font;
     else if ((unsigned)xv_get(font, FONT_DEFAULT_CHAR_HEIGHT) <= dp->row_height)
@@ -3675,8 +4139,6 @@ set_row_font(dp, row, font)
 		 NULL);
 	row->font = (Xv_Font)NULL;
     }
-    if (row->font != old_font)
-	row->display_str_len = 0;   /* force recomputation */
 }
 
 
@@ -3841,21 +4303,21 @@ is_dbl_click(dp, row, event)
     /* make sure both click's occured on the same row */
     if ( !dp->last_click_row || (dp->last_click_row != row) ) {
 	dp->last_click_row = row;
-	dp->last_click_row->click_time = event_time(event);
+	dp->last_click_time = event_time(event);
 	return FALSE;
     }
     
 
     /* weigh timeval's against multiclick-timeout resource */
     is_multiclick = panel_is_multiclick(ip->panel, 
-					&dp->last_click_row->click_time,
+					&dp->last_click_time,
 					&event_time(event)
 					);
 
     if ( is_multiclick )
-	dp->last_click_row->click_time = empty_time; 	/* reset timeval */
+	dp->last_click_time = empty_time; 	/* reset timeval */
     else
-	dp->last_click_row->click_time = event_time(event);
+	dp->last_click_time = event_time(event);
 
     return is_multiclick;
 
@@ -16,6 +16,7 @@
 
 typedef struct panel_list_struct		Panel_list_info;
 typedef struct panel_list_row_struct		Row_info;
+typedef struct panel_list_chunk_struct		Row_chunk;
 
 typedef enum {
     OP_NONE,
@@ -27,8 +28,8 @@ typedef enum {
 #define PRIMARY_CHOICE	0
 #define SHELF_CHOICE	1
 #define PANEL_LIST_DEFAULT_ROW	5
+#define PANEL_LIST_ROW_CHUNK	64	/* rows allocated at a time */
 
-/*** Note: Update PANEL_LIST_SORT code when changing this structure. ***/
 struct panel_list_row_struct {
 	Xv_opaque	client_data;	/* Client data with each row */
 	int		display_str_len; /* length of displayed string */
@@ -44,7 +45,6 @@ struct panel_list_row_struct {
 #endif
 	int		string_y;
 	Xv_opaque	exten_data;	/* client data for extensions */
-	struct timeval	click_time; 	/* double-click detection */
 
 	struct {
 	  unsigned edit_selected : 1;	/* selected in edit mode */
@@ -60,6 +60,11 @@ struct panel_list_row_struct {
 	struct panel_list_row_struct *next;
 	struct panel_list_row_struct *prev;
 };
+
+struct panel_list_chunk_struct {
+	Row_chunk	*next;
+	Row_info	rows[PANEL_LIST_ROW_CHUNK];
+};
  
 struct panel_list_struct {
 	Panel_item	public_self;
@@ -119,18 +124,54 @@ struct panel_list_struct {
 	int	width;		/* -1 = extend width to edge of panel
 				 * 0 = fit width to widest row
 				 * other = list box width */
-	unsigned short	nrows;		/* Number of rows */
+	int		nrows;		/* Number of rows */
 	unsigned short	rows_displayed;	/* Number of rows displayed */
 	unsigned short	row_height;  /* Height of each row. 0 => font height */
 	unsigned short  string_x;	/* left margin of each row's string */
+	unsigned short	string_y_height; /* row_height of rows' string_y */
+	int		max_glyph_width;  /* widest glyph of any row */
+	int		max_string_width; /* widest string, in dp->font */
+	unsigned glyph_width_stale : 1;	 /* max_glyph_width needs a rescan */
+	unsigned string_width_stale : 1; /* max_string_width needs one */
 
 	/* Current data */
 	Row_info	*rows;
 	Row_info	*current_row;	/* last row selected */
 	Row_info	*last_edit_row; /* last row selected for editing */
 	Row_info	*last_click_row;	/* last row click'd in */
+	struct timeval	last_click_time;	/* double-click detection */
+
+	/*
+	 * Row storage: rows come from chunks, freed rows are kept on
+	 * row_free (chained through next).  row_index[n] is row n for
+	 * n < row_index_count; it is filled in from the list on demand
+	 * and cut back to n whenever rows from n on are renumbered.
+	 */
+	Row_chunk	*row_chunks;
+	Row_info	*row_free;
+	Row_info	**row_index;
+	int		row_index_count;
+	int		row_index_size;
+
+	/*
+	 * Virtual list: nrows is the client's count and the chain is
+	 * empty.  vrows caches fetched rows, vrows_used[i] is the LRU
+	 * stamp of vrows[i] (0 = empty).
+	 */
+	Panel_list_fetch_proc	fetch_proc;
+	Panel_list_sort_proc	sort_proc;
+	Panel_list_search_proc	search_proc;
+	Row_info	*vrows;
+	unsigned	*vrows_used;
+	int		vrows_size;
+	int		virtual_rows;	/* PANEL_LIST_VIRTUAL_ROWS */
+	unsigned	vrows_clock;
+	int		batch;		/* PANEL_LIST_BATCH nesting depth */
+	int		batch_reset_rows;
 };
 
+#define VIRTUAL_LIST(dp)	((dp)->fetch_proc != NULL)
+
 #ifdef OW_I18N
 #define	STRING	string.pswcs.value
 #define	TITLE	title.pswcs.value
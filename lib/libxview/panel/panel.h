@@ -349,6 +349,14 @@ typedef enum {
 	PANEL_LIST_MASK_GLYPHS	=
        		PANEL_ATTR(ATTR_LIST_INLINE(ATTR_NULL, ATTR_PIXRECT_PTR),217),
 
+	/* Virtual lists: rows are fetched from the client as needed */
+	PANEL_LIST_FETCH_PROC	= PANEL_ATTR(ATTR_FUNCTION_PTR,		 219),
+	PANEL_LIST_VIRTUAL_ROWS	= PANEL_ATTR(ATTR_INT,			 220),
+	PANEL_LIST_SORT_PROC	= PANEL_ATTR(ATTR_FUNCTION_PTR,		 221),
+	PANEL_LIST_SEARCH_PROC	= PANEL_ATTR(ATTR_FUNCTION_PTR,		 222),
+	/* TRUE opens a batch of changes, FALSE closes it and relays out */
+	PANEL_LIST_BATCH	= PANEL_ATTR(ATTR_BOOLEAN,		 223),
+
 
 	/* Panel_list_item, Panel_multiline_text_item,
 	 * Panel_numeric_text_item, Panel_slider_item and
@@ -570,6 +578,25 @@ typedef struct {
     Xv_opaque		reserved;	/* reserved for future use */
 } Panel_list_row_values;
 
+/*
+ * Virtual lists (PANEL_LIST_FETCH_PROC with PANEL_LIST_VIRTUAL_ROWS).
+ * The list keeps only the rows it is painting, and asks for them with
+ *	fetch_proc(list, row, values)
+ * which fills in *values (zeroed beforehand); the string is copied.
+ * Selection belongs to the client: the notify proc is told of SELECT and
+ * DESELECT as usual, and later fetches should report it in values->selected.
+ * Setting PANEL_LIST_VIRTUAL_ROWS, even to the same count, refetches rows;
+ * it may be given before or after the fetch proc.  Installing a fetch proc
+ * discards any rows the list already holds.
+ * PANEL_LIST_SORT calls sort_proc(list, PANEL_FORWARD or PANEL_REVERSE)
+ * to reorder the client's records; a typed character calls
+ *	search_proc(list, from_row, event)
+ * which returns the row to move the location cursor to, or -1.
+ */
+typedef void (*Panel_list_fetch_proc)();
+typedef void (*Panel_list_sort_proc)();
+typedef int (*Panel_list_search_proc)();
+
 #ifdef OW_I18N
 typedef struct {
     wchar_t *		string_wcs;
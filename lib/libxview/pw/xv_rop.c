@@ -16,6 +16,7 @@ static char     sccsid[] = "@(#)xv_rop.c 20.55 89/07/31";
  */
 
 #include <xview_private/xv_rop_.h>
+#include <xview_private/xv_shm_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/screen_.h>
 #include <xview_private/svr_get_.h>
@@ -41,6 +42,37 @@ int   GC_CHAIN_KEY;
 
 #define INVALID_XID		0
 
+/*
+ * Memory pixrects that are painted over and over (gray patterns, menu and
+ * scrollbar marks, list glyphs) are kept on the server as bitmaps, one
+ * cache per screen.  Entries are matched on the pixrect's bits rather than
+ * its address, so a pixrect that is drawn into simply stops matching and
+ * its entry ages out.  A pixrect becomes a pixmap the second time it is
+ * painted; one-shot images are never uploaded twice.
+ */
+#define MPR_CACHE_SIZE		64
+#define MPR_CACHE_MAX_BYTES	2048	/* larger images go by XPutImage */
+
+typedef struct {
+    unsigned	    hash;
+    int		    width, height, linebytes;
+    int		    byte_order, bit_order;	/* how bits was uploaded */
+    char	   *bits;	/* copy of the image, NULL if slot is free */
+    Pixmap	    pixmap;	/* None until the second use */
+    unsigned	    stamp;
+} Mpr_cache_entry;
+
+typedef struct {
+    Mpr_cache_entry entry[MPR_CACHE_SIZE];
+    unsigned	    clock;
+    Display	   *display;
+} Mpr_cache;
+
+static int	MPR_CACHE_KEY;
+
+static Pixmap	mpr_cache_pixmap();
+static void	mpr_cache_free();
+
 Xv_private_data int xv_to_xop[16];
 
 Xv_private void
@@ -322,8 +354,26 @@ xv_rop_mpr_internal(display, d, gc, x, y, width, height, src, xr, yr,
     }
 
     if (src_depth == 1) {
-	XPutImage(display, d, gc, ximage, xr, yr, x, y,
-	    MIN(width, ximage->width), MIN(height, ximage->height));
+	Pixmap		 pixmap;
+	XGCValues	 changes;
+
+	if (mpr_bits == TRUE &&
+	    (pixmap = mpr_cache_pixmap(display, d, ximage, dest_info))) {
+	    /* Opaque stipple paints 1 bits in fg and 0 bits in bg, as
+	     * XPutImage of an XYBitmap does, without a NoExpose event. */
+	    changes.stipple = pixmap;
+	    changes.fill_style = FillOpaqueStippled;
+	    changes.ts_x_origin = x - xr;
+	    changes.ts_y_origin = y - yr;
+	    XChangeGC(display, gc, GCStipple | GCFillStyle |
+		      GCTileStipXOrigin | GCTileStipYOrigin, &changes);
+	    XFillRectangle(display, d, gc, x, y,
+		MIN(width, ximage->width), MIN(height, ximage->height));
+	    XSetFillStyle(display, gc, FillSolid);
+	} else
+	    xv_put_image(display, d, gc, ximage, xr, yr, x, y,
+		MIN(width, ximage->width), MIN(height, ximage->height),
+		dest_info);
     } else {
 	register int     i, j;
 	unsigned long    index;
@@ -353,13 +403,120 @@ xv_rop_mpr_internal(display, d, gc, x, y, width, height, src, xr, yr,
 	}
 	
 	ximage->data = (char *)data;
-	XPutImage(display, d, gc, ximage, xr, yr, x, y,
-		  MIN(width, ximage->width), MIN(height, ximage->height));
+	xv_put_image(display, d, gc, ximage, xr, yr, x, y,
+		     MIN(width, ximage->width), MIN(height, ximage->height),
+		     dest_info);
 	ximage->data = image_data;
     }
     return (XV_OK);
 }
 
+/*
+ * Return the server copy of the depth 1 image in ximage, or None if it
+ * should be sent with XPutImage this time.
+ */
+static Pixmap
+mpr_cache_pixmap(display, d, ximage, dest_info)
+    Display		*display;
+    Drawable		 d;
+    XImage		*ximage;
+    Xv_Drawable_info	*dest_info;
+{
+    Xv_Screen		 screen = xv_screen(dest_info);
+    Mpr_cache		*cache;
+    Mpr_cache_entry	*e, *victim;
+    unsigned char	*bits = (unsigned char *) ximage->data;
+    unsigned		 hash;
+    int			 size, i;
+    GC			 gc;
+
+    size = ximage->bytes_per_line * ximage->height;
+    if (size <= 0 || size > MPR_CACHE_MAX_BYTES)
+	return None;
+
+    if (!MPR_CACHE_KEY)
+	MPR_CACHE_KEY = xv_unique_key();
+    cache = (Mpr_cache *) xv_get(screen, XV_KEY_DATA,
+				 (Attr_attribute) MPR_CACHE_KEY);
+    if (!cache) {
+	cache = xv_alloc(Mpr_cache);
+	cache->display = display;
+	xv_set(screen,
+	       XV_KEY_DATA, (Attr_attribute) MPR_CACHE_KEY, cache,
+	       XV_KEY_DATA_REMOVE_PROC, (Attr_attribute) MPR_CACHE_KEY,
+		   mpr_cache_free,
+	       NULL);
+    }
+
+    hash = 2166136261U;
+    for (i = 0; i < size; i++)
+	hash = (hash ^ bits[i]) * 16777619U;
+
+    victim = &cache->entry[0];
+    for (e = cache->entry; e < &cache->entry[MPR_CACHE_SIZE]; e++) {
+	if (e->bits && e->hash == hash && e->width == ximage->width &&
+	    e->height == ximage->height &&
+	    e->linebytes == ximage->bytes_per_line &&
+	    e->byte_order == ximage->byte_order &&
+	    e->bit_order == ximage->bitmap_bit_order &&
+	    !memcmp(e->bits, (char *) bits, size))
+	    break;
+	if (e->stamp < victim->stamp)
+	    victim = e;
+    }
+
+    if (e < &cache->entry[MPR_CACHE_SIZE]) {
+	e->stamp = ++cache->clock;
+	if (e->pixmap == None) {
+	    e->pixmap = XCreatePixmap(display, d, e->width, e->height, 1);
+	    if (e->pixmap == None)
+		return None;
+	    gc = XCreateGC(display, e->pixmap, 0, 0);
+	    XSetForeground(display, gc, 1);
+	    XSetBackground(display, gc, 0);
+	    XPutImage(display, e->pixmap, gc, ximage, 0, 0, 0, 0,
+		      e->width, e->height);
+	    XFreeGC(display, gc);
+	}
+	return e->pixmap;
+    }
+
+    /* First sighting: remember it in place of the least recently used */
+    if (victim->pixmap != None)
+	XFreePixmap(display, victim->pixmap);
+    if (victim->bits)
+	xv_free(victim->bits);
+    victim->hash = hash;
+    victim->width = ximage->width;
+    victim->height = ximage->height;
+    victim->linebytes = ximage->bytes_per_line;
+    victim->byte_order = ximage->byte_order;
+    victim->bit_order = ximage->bitmap_bit_order;
+    victim->bits = xv_malloc(size);
+    XV_BCOPY((char *) bits, victim->bits, size);
+    victim->pixmap = None;
+    victim->stamp = ++cache->clock;
+    return None;
+}
+
+/*ARGSUSED*/
+static void
+mpr_cache_free(screen, key, cache)
+    Xv_Screen		 screen;
+    int			 key;
+    Mpr_cache		*cache;
+{
+    Mpr_cache_entry	*e;
+
+    for (e = cache->entry; e < &cache->entry[MPR_CACHE_SIZE]; e++) {
+	if (e->pixmap != None)
+	    XFreePixmap(cache->display, e->pixmap);
+	if (e->bits)
+	    xv_free(e->bits);
+    }
+    xv_free(cache);
+}
+
 Pkg_private void
 xv_to_x_convert_image(ximage, val)
     XImage         *ximage;
@@ -0,0 +1,270 @@
+/*
+ * xv_shm.c: Sends large images to a local X server through MIT-SHM
+ * shared memory segments instead of the connection.
+ *
+ * Each server object keeps a small pool of segments, used round robin so
+ * that the client can fill one while the server is still reading another.
+ * A segment is only reused once the server has processed the request that
+ * last read it.  If the extension is missing, the segment cannot be
+ * created, or the server refuses to attach it (a remote display), the
+ * pool is marked unusable and every put goes by XPutImage.
+ */
+
+#include <xview_private/xv_shm_.h>
+#include <xview_private/xv_.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+#ifdef XV_USE_SHM
+#include <sys/types.h>
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+#ifndef X_ShmAttach
+#define X_ShmAttach	1	/* minor opcode, from shmproto.h */
+#endif
+
+#define SHM_MIN_BYTES	(64 * 1024)	/* smaller images use the socket */
+#define SHM_POOL_SIZE	4
+#define SHM_SEG_ROUND	(256 * 1024)
+
+typedef struct {
+    XShmSegmentInfo info;	/* info.shmaddr is NULL if not allocated */
+    unsigned	    size;
+    unsigned long   serial;	/* request that last read the segment */
+} Shm_segment;
+
+typedef struct {
+    int		    usable;
+    int		    major_opcode;
+    int		    next;
+    Shm_segment	    seg[SHM_POOL_SIZE];
+} Shm_pool;
+
+static int	SHM_POOL_KEY;
+static int	shm_major_opcode;
+static int	shm_attach_failed;
+static int	(*shm_old_handler) ();
+
+static Shm_pool	*shm_pool();
+static Shm_segment *shm_segment();
+static void	shm_segment_free();
+static void	shm_pool_free();
+static int	shm_put_image();
+static int	shm_error_handler();
+#endif /* XV_USE_SHM */
+
+
+Xv_private void
+xv_put_image(display, d, gc, ximage, src_x, src_y, dest_x, dest_y,
+	     width, height, dest_info)
+    Display		*display;
+    Drawable		 d;
+    GC			 gc;
+    XImage		*ximage;
+    int			 src_x, src_y, dest_x, dest_y;
+    unsigned int	 width, height;
+    Xv_Drawable_info	*dest_info;
+{
+#ifdef XV_USE_SHM
+    if (width && height &&
+	ximage->bytes_per_line * (int) height >= SHM_MIN_BYTES &&
+	shm_put_image(display, d, gc, ximage, src_x, src_y, dest_x, dest_y,
+		      width, height, dest_info))
+	return;
+#endif /* XV_USE_SHM */
+    XPutImage(display, d, gc, ximage, src_x, src_y, dest_x, dest_y,
+	      width, height);
+}
+
+#ifdef XV_USE_SHM
+
+static int
+shm_put_image(display, d, gc, ximage, src_x, src_y, dest_x, dest_y,
+	      width, height, dest_info)
+    Display		*display;
+    Drawable		 d;
+    GC			 gc;
+    XImage		*ximage;
+    int			 src_x, src_y, dest_x, dest_y;
+    unsigned int	 width, height;
+    Xv_Drawable_info	*dest_info;
+{
+    Shm_pool		*pool;
+    Shm_segment		*seg;
+    XImage		*shm_image;
+    int			 same_layout;
+    unsigned		 size;
+
+    if (src_y < 0 || src_y + (int) height > ximage->height)
+	return FALSE;
+    pool = shm_pool(display, xv_server(dest_info));
+    if (!pool->usable)
+	return FALSE;
+
+    /*
+     * The server reads a shared image in its own layout; only socket
+     * puts are converted by Xlib.  Let Xlib tell us that layout.
+     */
+    shm_image = XShmCreateImage(display, (Visual *) NULL, ximage->depth,
+				ximage->format, (char *) NULL,
+				(XShmSegmentInfo *) NULL,
+				ximage->width, height);
+    if (!shm_image)
+	return FALSE;
+    if (ximage->format == ZPixmap)
+	same_layout = shm_image->bits_per_pixel == ximage->bits_per_pixel &&
+	    (ximage->bits_per_pixel <= 8 ||
+	     shm_image->byte_order == ximage->byte_order);
+    else
+	same_layout = shm_image->bitmap_bit_order == ximage->bitmap_bit_order &&
+	    shm_image->bitmap_unit == ximage->bitmap_unit &&
+	    (ximage->bitmap_unit <= 8 ||
+	     shm_image->byte_order == ximage->byte_order);
+    same_layout = same_layout &&
+	shm_image->bytes_per_line == ximage->bytes_per_line;
+
+    size = ximage->bytes_per_line * height;
+    if (!same_layout || !(seg = shm_segment(display, pool, size))) {
+	XFree((char *) shm_image);
+	return FALSE;
+    }
+
+    XV_BCOPY(ximage->data + src_y * ximage->bytes_per_line,
+	     seg->info.shmaddr, size);
+    shm_image->data = seg->info.shmaddr;
+    shm_image->obdata = (char *) &seg->info;
+    seg->serial = NextRequest(display);
+    XShmPutImage(display, d, gc, shm_image, src_x, 0, dest_x, dest_y,
+		 width, height, False);
+    XFree((char *) shm_image);
+    return TRUE;
+}
+
+
+static Shm_pool *
+shm_pool(display, server)
+    Display	   *display;
+    Xv_opaque	    server;
+{
+    Shm_pool	   *pool;
+    int		    first_event, first_error;
+
+    if (!SHM_POOL_KEY)
+	SHM_POOL_KEY = xv_unique_key();
+    pool = (Shm_pool *) xv_get(server, XV_KEY_DATA,
+			       (Attr_attribute) SHM_POOL_KEY);
+    if (!pool) {
+	pool = xv_alloc(Shm_pool);
+	pool->usable = XShmQueryExtension(display) &&
+	    XQueryExtension(display, "MIT-SHM", &pool->major_opcode,
+			    &first_event, &first_error);
+	xv_set(server,
+	       XV_KEY_DATA, (Attr_attribute) SHM_POOL_KEY, pool,
+	       XV_KEY_DATA_REMOVE_PROC, (Attr_attribute) SHM_POOL_KEY,
+		   shm_pool_free,
+	       NULL);
+    }
+    return pool;
+}
+
+
+/*
+ * Return the next segment of the pool, at least size bytes long and no
+ * longer being read by the server, or NULL if none can be had.
+ */
+static Shm_segment *
+shm_segment(display, pool, size)
+    Display	   *display;
+    Shm_pool	   *pool;
+    unsigned	    size;
+{
+    Shm_segment    *seg = &pool->seg[pool->next];
+
+    pool->next = (pool->next + 1) % SHM_POOL_SIZE;
+    if (seg->info.shmaddr && LastKnownRequestProcessed(display) < seg->serial)
+	XSync(display, False);
+    if (seg->info.shmaddr && seg->size < size)
+	shm_segment_free(display, seg);
+    if (seg->info.shmaddr)
+	return seg;
+
+    size = (size + SHM_SEG_ROUND - 1) / SHM_SEG_ROUND * SHM_SEG_ROUND;
+    seg->info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (seg->info.shmid < 0) {
+	pool->usable = FALSE;
+	return NULL;
+    }
+    seg->info.shmaddr = (char *) shmat(seg->info.shmid, (char *) 0, 0);
+    if (seg->info.shmaddr == (char *) -1) {
+	shmctl(seg->info.shmid, IPC_RMID, (struct shmid_ds *) 0);
+	seg->info.shmaddr = NULL;
+	pool->usable = FALSE;
+	return NULL;
+    }
+    seg->info.readOnly = True;
+
+    /* A remote server fails the attach with BadAccess */
+    shm_attach_failed = FALSE;
+    shm_major_opcode = pool->major_opcode;
+    shm_old_handler = XSetErrorHandler(shm_error_handler);
+    XShmAttach(display, &seg->info);
+    XSync(display, False);
+    (void) XSetErrorHandler(shm_old_handler);
+
+    /* The segment now goes away once both sides have detached */
+    shmctl(seg->info.shmid, IPC_RMID, (struct shmid_ds *) 0);
+    if (shm_attach_failed) {
+	shmdt(seg->info.shmaddr);
+	seg->info.shmaddr = NULL;
+	pool->usable = FALSE;
+	return NULL;
+    }
+    seg->size = size;
+    return seg;
+}
+
+
+static void
+shm_segment_free(display, seg)
+    Display	   *display;
+    Shm_segment    *seg;
+{
+    XShmDetach(display, &seg->info);
+    shmdt(seg->info.shmaddr);
+    seg->info.shmaddr = NULL;
+    seg->size = 0;
+}
+
+
+/*ARGSUSED*/
+static void
+shm_pool_free(server, key, pool)
+    Xv_opaque	    server;
+    int		    key;
+    Shm_pool	   *pool;
+{
+    int		    i;
+
+    /* The connection is going away; the server detaches on its own */
+    for (i = 0; i < SHM_POOL_SIZE; i++)
+	if (pool->seg[i].info.shmaddr)
+	    shmdt(pool->seg[i].info.shmaddr);
+    xv_free(pool);
+}
+
+
+static int
+shm_error_handler(display, error)
+    Display	   *display;
+    XErrorEvent	   *error;
+{
+    if (error->request_code == shm_major_opcode &&
+	error->minor_code == X_ShmAttach)
+	shm_attach_failed = TRUE;
+    else
+	(*shm_old_handler) (display, error);
+    return 0;
+}
+
+#endif /* XV_USE_SHM */
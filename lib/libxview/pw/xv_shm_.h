@@ -0,0 +1,9 @@
+#if !defined(XV_SHM__H)
+#define XV_SHM__H
+
+#include <xview/pkg.h>
+#include <xview_private/draw_impl.h>
+
+Xv_private void xv_put_image(Display *display, Drawable d, GC gc, XImage *ximage, int src_x, int src_y, int dest_x, int dest_y, unsigned int width, unsigned int height, Xv_Drawable_info *dest_info);
+
+#endif
@@ -14,6 +14,7 @@ static char     sccsid[] = "@(#)server.c 20.157 93/04/28";
 #include <xview_private/attr_.h>
 #include <xview_private/defaults_.h>
 #include <xview_private/gettext_.h>
+#include <xview_private/svr_atom_.h>
 /*#include <xview_private/sel_agent_.h>*/
 #include <xview_private/svr_x_.h>
 #include <xview_private/win_input_.h>
@@ -825,6 +826,7 @@ server_init(parent, server_public, avlist)
                                                atom_list, NULL);
 
     server_init_atoms(server_public);
+    server_prefetch_atoms(server);
 
     server->idproclist = NULL;
     server->xidlist    = NULL;
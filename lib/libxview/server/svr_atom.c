@@ -18,8 +18,97 @@ static char     sccsid[] = "@(#)svr_atom.c 1.7 93/06/28";
 #include <X11/Xutil.h>
 #include <X11/Xresource.h>
 #include <xview/server.h>
+#include <xview_private/portable.h>
 
 static void update_atom_list(Server_info *server, Atom atom);
+static void save_atom_name(Server_info *server, XrmQuark quark, char *atomName, Atom atom);
+static void server_intern_atoms(Server_info *server, char **names, int count);
+
+/*
+ * The atoms the toolkit's own packages ask for as an application starts
+ * up, interned in one batch.  The list is fixed; anything else is
+ * interned by server_intern_atom when first asked for.
+ */
+static char    *server_startup_atoms[] = {
+    /* selections */
+    "COMPOUND_TEXT", "DELETE", "FILE_NAME", "INCR", "INTEGER", "LENGTH",
+    "LENGTH_CHARS", "MULTIPLE", "NULL", "SECONDARY", "STRING", "TARGETS",
+    "TEXT", "TIMESTAMP", "_SUN_SELECTION_END", "_SUN_SELN_YIELD",
+    /* window manager */
+    "WM_CHANGE_STATE", "WM_COMMAND", "WM_DELETE_WINDOW", "WM_PROTOCOLS",
+    "WM_SAVE_YOURSELF", "WM_STATE", "WM_TAKE_FOCUS", "_SUN_WM_PROTOCOLS",
+    "_OL_WIN_ATTR", "_SUN_OL_WIN_ATTR_5", "_OL_WIN_BUSY", "_OL_PIN_STATE",
+    "_OL_DECOR_ADD", "_OL_DECOR_DEL", "_OL_DECOR_CLOSE", "_OL_DECOR_FOOTER",
+    "_OL_DECOR_HEADER", "_OL_DECOR_ICON_NAME", "_OL_DECOR_PIN",
+    "_OL_DECOR_RESIZE", "_OL_WT_BASE", "_OL_WT_CMD", "_OL_WT_HELP",
+    "_OL_WT_NOTICE", "_OL_WT_OTHER", "_OL_MENU_FULL", "_OL_MENU_LIMITED",
+    "_OL_NONE", "_OL_WIN_DISMISS", "_OL_WINMSG_STATE", "_OL_WINMSG_ERROR",
+    "_OL_DFLT_BTN", "_XVIEW_V2_APP",
+    /* drag and drop */
+    "_SUN_DRAGDROP_ACK", "_SUN_DRAGDROP_DONE", "_SUN_DRAGDROP_DSDM",
+    "_SUN_DRAGDROP_INTEREST", "_SUN_DRAGDROP_PREVIEW",
+    "_SUN_DRAGDROP_TRIGGER",
+};
+
+/*
+ * Intern the startup atoms on a new server, in one XInternAtoms call and
+ * so one round trip.
+ */
+Xv_private void
+server_prefetch_atoms(server)
+    Server_info	*server;
+{
+    server_intern_atoms(server, server_startup_atoms,
+			sizeof(server_startup_atoms) / sizeof(char *));
+}
+
+/*
+ * Intern those of names the server does not know yet, all in one go.
+ * A name given twice is asked for once.
+ */
+static void
+server_intern_atoms(server, names, count)
+    Server_info	*server;
+    char	**names;
+    int		  count;
+{
+    char	**unknown;
+    XrmQuark	*quarks;
+    Atom	*atoms;
+    XPointer	 data;
+    int		 i, j, n = 0;
+
+    if (count <= 0)
+	return;
+    unknown = (char **) xv_malloc(count * sizeof(char *));
+    quarks = (XrmQuark *) xv_malloc(count * sizeof(XrmQuark));
+    atoms = (Atom *) xv_malloc(count * sizeof(Atom));
+    for (i = 0; i < count; i++) {
+	quarks[n] = XrmStringToQuark(names[i]);
+	if (XFindContext(server->xdisplay, server->atom_mgr[ATOM],
+			 (XContext)quarks[n], &data) != XCNOENT)
+	    continue;
+	for (j = 0; j < n && quarks[j] != quarks[n]; j++)
+	    ;
+	if (j == n)
+	    unknown[n++] = names[i];
+    }
+    if (n > 0) {
+#ifdef X11R6
+	if (!XInternAtoms(server->xdisplay, unknown, n, False, atoms))
+	    n = 0;
+#else
+	for (i = 0; i < n; i++)
+	    atoms[i] = XInternAtom(server->xdisplay, unknown[i], False);
+#endif
+	for (i = 0; i < n; i++)
+	    if (atoms[i] != None)
+		save_atom_name(server, quarks[i], unknown[i], atoms[i]);
+    }
+    xv_free(unknown);
+    xv_free(quarks);
+    xv_free(atoms);
+}
 
 Xv_private Atom 
 server_intern_atom(server, atomName)
@@ -41,25 +130,33 @@ server_intern_atom(server, atomName)
 		     (XContext)quark, &data) == XCNOENT) {
 
 	atom = XInternAtom(server->xdisplay, atomName, False);
+	save_atom_name(server, quark, atomName, atom);
+    }
+    else
+        atom = (Atom)data;
+    return ((Atom)atom);
+}
 
+static void
+save_atom_name(server, quark, atomName, atom)
+    Server_info	*server;
+    XrmQuark	 quark;
+    char	*atomName;
+    Atom	 atom;
+{
 			/* We don't care if SaveContext fails (no mem).  It
 			 * just means that FindContext will return XCNOENT and
 			 * the atom will need to be interned again.
 			 */
 			/* Support lookup by atom name */
-	(void)XSaveContext(server->xdisplay, server->atom_mgr[ATOM],
-			   (XContext)quark, (XPointer)atom);
+    (void)XSaveContext(server->xdisplay, server->atom_mgr[ATOM],
+		       (XContext)quark, (XPointer)atom);
 
 			/* Support lookup by atom value */
-	(void)XSaveContext(server->xdisplay, server->atom_mgr[NAME],
-			   (XContext)atom, (caddr_t)strdup(atomName));
-
-	update_atom_list(server, atom);
+    (void)XSaveContext(server->xdisplay, server->atom_mgr[NAME],
+		       (XContext)atom, (caddr_t)strdup(atomName));
 
-    }
-    else
-        atom = (Atom)data;
-    return ((Atom)atom);
+    update_atom_list(server, atom);
 }
 
 Xv_private char *
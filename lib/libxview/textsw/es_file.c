@@ -36,6 +36,19 @@ static char     sccsid[] = "@(#)es_file.c 20.49 93/06/28";
  * are not valid positions for the underlying file! For an original stream,
  * the write buffer is NULL, and length == length_on_disk.
  * 
+ * Where the system has mmap(2) (OS_HAS_MMAP), an original stream whose disk
+ * contents are already CHARs is mapped read-only instead, and reads copy
+ * straight out of the mapping: no read buffer is allocated and no lseek or
+ * read calls are made, so opening even a very large file costs only the
+ * mapping.  Touching a mapped page past the end of a file that another
+ * process has truncated raises SIGBUS, so the copy runs with a SIGBUS
+ * handler that jumps back out of it; the mapping is then dropped and the
+ * read goes through the read buffer, where a short read is an ordinary
+ * error.  A file rewritten in place without shrinking is not noticed: as
+ * with the read buffer, later reads simply see the new contents.  Saving
+ * overwrites the original file, so es_file_make_backup drops the mapping
+ * and reverts to the read buffer before that can happen.
+ * 
  * --- Misc. notes that may result in changes ... --- An empty original stream
  * need not be open except to prevent another process or some piece of client
  * code ripping it out from under this module. However, delayed opening moves
@@ -104,6 +117,11 @@ static char     sccsid[] = "@(#)es_file.c 20.49 93/06/28";
 #ifdef __linux__
 #include <unistd.h>
 #endif
+#ifdef OS_HAS_MMAP
+#include <sys/mman.h>
+#include <setjmp.h>
+#include <signal.h>
+#endif
 #include <xview/pkg.h>
 #include <xview/attrol.h>
 #include <xview_private/primal.h>
@@ -145,6 +163,10 @@ struct private_data {
 #endif
     es_file_buf     read_buf;	/* cache for read's */
     es_file_buf     write_buf;	/* cache for replace's */
+#ifdef OS_HAS_MMAP
+    CHAR           *map;	/* Non-null iff original is mapped */
+    size_t          map_len;
+#endif
 #ifdef OW_I18N
     int             mb_fd;	/* Original multi-bytes file */
     int             skipped;
@@ -160,6 +182,12 @@ static int es_file_fill_buf(register Es_file_data private, register Es_file_buf
 static int es_file_flush_write_buf(register Es_file_data private, register Es_file_buf buf);
 static int es_file_move_write_buf(register Es_file_data private, register Es_index include, register Es_index also_include, CHAR **include_offset);
 static void es_file_maybe_truncate_buf(register Es_file_buf buf, register Es_index new_last_plus_one);
+#ifdef OS_HAS_MMAP
+static void es_file_map(register Es_file_data private);
+static int es_file_unmap(register Es_file_data private);
+static int es_file_map_copy(register Es_file_data private, Es_index pos, CHAR *buf, int count);
+static void es_file_map_bus(int sig);
+#endif
 static Es_status es_file_commit(Es_handle esh);
 static Es_handle es_file_destroy(Es_handle esh);
 static Es_index es_file_get_length(Es_handle esh);
@@ -384,9 +412,6 @@ es_file_create(name, options, status)
      private->mb_fd = -1;	/* In case of later AllocFailed */
 #endif
     BUF_INVALIDATE(&private->read_buf);
- 
-    if ((private->read_buf.chars = MALLOC(ES_READ_BUF_LEN)) == NULL)
-	goto AllocFailed;
     BUF_INVALIDATE(&private->write_buf);
     if (options & ES_OPT_APPEND) {
     if ((private->write_buf.chars = MALLOC(ES_WRITE_BUF_LEN)) == NULL)
@@ -490,6 +515,13 @@ es_file_create(name, options, status)
 	private->length_on_disk = private->length;
     }
 #endif /* OW_I18N */
+#ifdef OS_HAS_MMAP
+    if ((private->options & ES_OPT_APPEND) == 0)
+	es_file_map(private);
+    if (private->map == NULL)
+#endif
+    if ((private->read_buf.chars = MALLOC(ES_READ_BUF_LEN)) == NULL)
+	goto AllocFailed;
     *status = private->status = ES_SUCCESS;
     return (esh);
 
@@ -826,6 +858,82 @@ es_file_maybe_truncate_buf(buf, new_last_plus_one)
     }
 }
 
+#ifdef OS_HAS_MMAP
+static void
+es_file_map(private)
+    register Es_file_data private;
+/* Failure is not an error: the caller just falls back to the read_buf. */
+{
+    caddr_t         addr;
+
+    private->map = NULL;
+    if (private->length_on_disk <= 0)
+	return;			/* mmap(2) refuses an empty mapping */
+#ifdef OW_I18N
+    /* Only a file that already holds CHARs can be used in place. */
+    if (!multibyte && (private->options & ES_OPT_BACKUPFILE) == 0)
+	return;
+#endif
+    private->map_len = private->length_on_disk * sizeof(CHAR);
+    addr = (caddr_t) mmap(0, private->map_len, PROT_READ, MAP_PRIVATE,
+			  private->fd, 0);
+    if (addr == (caddr_t) MAP_FAILED)
+	return;
+    private->map = (CHAR *) addr;
+}
+
+static sigjmp_buf es_file_map_jmp;
+
+/* ARGSUSED */
+static void
+es_file_map_bus(sig)
+    int             sig;
+{
+    siglongjmp(es_file_map_jmp, 1);
+}
+
+static int
+es_file_map_copy(private, pos, buf, count)
+    register Es_file_data private;
+    Es_index        pos;
+    CHAR           *buf;
+    int             count;
+/* Returns 0, or -1 iff the file has shrunk out from under the mapping. */
+{
+    struct sigaction bus_action, old_action;
+    volatile int    result = 0;
+
+    bus_action.sa_handler = es_file_map_bus;
+    (void) sigemptyset(&bus_action.sa_mask);
+    bus_action.sa_flags = 0;
+    (void) sigaction(SIGBUS, &bus_action, &old_action);
+    if (sigsetjmp(es_file_map_jmp, 1) == 0)
+	BCOPY(private->map + pos, buf, count);
+    else
+	result = -1;
+    (void) sigaction(SIGBUS, &old_action, (struct sigaction *) 0);
+    return (result);
+}
+
+static int
+es_file_unmap(private)
+    register Es_file_data private;
+/* Returns 0 iff the stream can now be read through the read_buf. */
+{
+    if (private->map == NULL)
+	return (0);
+    if (private->read_buf.chars == NULL &&
+	(private->read_buf.chars = MALLOC(ES_READ_BUF_LEN)) == NULL) {
+	errno = ENOMEM;
+	return (-1);
+    }
+    (void) munmap((caddr_t) private->map, private->map_len);
+    private->map = NULL;
+    BUF_INVALIDATE(&private->read_buf);
+    return (0);
+}
+#endif
+
 static          Es_status
 es_file_commit(esh)
     Es_handle       esh;
@@ -854,6 +962,10 @@ es_file_destroy(esh)
 {
     register Es_file_data private = ABS_TO_REP(esh);
 
+#ifdef OS_HAS_MMAP
+    if (private->map)
+	(void) munmap((caddr_t) private->map, private->map_len);
+#endif
     if (private->write_buf.chars) {
 #ifdef XV_DEBUG
 	if ((private->write_buf.used > 0) &&
@@ -956,6 +1068,20 @@ es_file_read(esh, count, buf, count_read)
      */
     *count_read = (count > private->length - pos)
 	? (private->length - pos) : count;
+#ifdef OS_HAS_MMAP
+    if (private->map) {
+	/* A mapped original has no write_buf: copy straight out. */
+	if (es_file_map_copy(private, pos, buf, *count_read) == 0) {
+	    private->pos = pos + *count_read;
+	    return (private->pos);
+	}
+	/* Truncated by someone else: let read(2) report it */
+	if (es_file_unmap(private) != 0) {
+	    *count_read = 0;
+	    return (private->pos);
+	}
+    }
+#endif
     for (still_needed = *count_read;
 	 still_needed > 0;
 	 still_needed -= to_read, pos += to_read) {
@@ -1218,6 +1344,14 @@ es_file_make_backup(esh, backup_pattern, status)
     *status = ES_CHECK_ERRNO;
     errno = 0;
     private = ABS_TO_REP(esh);
+#ifdef OS_HAS_MMAP
+    /*
+     * The caller is about to overwrite the file, which would pull the pages
+     * out from under the mapping, so read it the old way from now on.
+     */
+    if (es_file_unmap(private) != 0)
+	return (NULL);
+#endif
 #ifdef BACKUP_AT_HEAD_OF_LINK
     (void) SPRINTF(backup_name, backup_pattern, private->name);
 #else
@@ -132,7 +132,9 @@ typedef enum {
 	 */
   EV_ACTION_SCROLL	= EV_ATTR(EV_ATTR_RECT_PAIR,	3),
 	/* Args are: from_rect, to_rect */
-  EV_ACTION_PAINT	= EV_ATTR(ATTR_RECT_PTR,	4)
+  EV_ACTION_PAINT	= EV_ATTR(ATTR_RECT_PTR,	4),
+  EV_ACTION_MATCH	= EV_ATTR(ATTR_NO_VALUE,	5)
+	/* Sent after an edit while a background find is active */
 } Ev_notify_action;
 
 	/* Possible editing actions */
@@ -178,6 +180,9 @@ typedef enum {
 #define EV_FIND_BACKWARD	1
 #define EV_FIND_RE		2
 
+	/* Entries in the table filled in by ev_find_skip_table */
+#define EV_FIND_SKIP_SIZE	256
+
 
 /* Status values for ev_set. */
 typedef enum {
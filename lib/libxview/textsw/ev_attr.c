@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)ev_attr.c 20.27 93/06/28";
 #include <xview_private/ev_attr_.h>
 #include <xview_private/attr_.h>
 #include <xview_private/ev_display_.h>
+#include <xview_private/ev_lines_.h>
 #include <xview_private/finger_tbl_.h>
 #include <xview/attrol.h>
 #include <xview_private/primal.h>
@@ -252,7 +253,7 @@ ev_set_internal(view, chain, attrs)
 		FORALLVIEWS(chain, next) {
 		    EV_FLUSH_VIEW_CACHES(EV_PRIVATE(next));
 		}
-		chain_private->cache_pos_for_file_line.edit_number = 0;
+		ev_lines_destroy(chain);
 		break;
 	    }
 	  case EV_CHAIN_AUTO_SCROLL_BY:{
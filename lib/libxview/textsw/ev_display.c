@@ -1108,22 +1108,39 @@ TryRead:
  * ev_range_info was originally only called by ev_display_internal, which
  * only uses ei_op and last_plus_one, and ignores op_bdry_state and next_i
  * completely.  on first call to ev_op_bdry_info_merge, range->next_i isn't
- * even set.
+ * even set.  A pos of ES_INFINITY steps over the next boundary in either
+ * of the chain's op_bdry and match_bdry tables.
  */
 Pkg_private	void
-ev_range_info(op_bdry, pos, range)
-    Ev_line_table   op_bdry;
+ev_range_info(private, pos, range)
+    Ev_chain_pd_handle private;
     Es_index        pos;
     register struct range *range;
 {
+    Ev_line_table   op_bdry;
+    Ev_line_table   match_bdry;
     register unsigned op_bdry_state;	/* Optimization  */
     register int    ei_op;	/* temporaries */
+    Es_index        op_pos, match_pos;
 
+    op_bdry = private->op_bdry;
+    match_bdry = private->match_bdry;
     if (pos == ES_INFINITY) {
-	op_bdry_state = ev_op_bdry_info_merge(
-	      op_bdry, range->next_i, &range->next_i, range->op_bdry_state);
+	op_bdry_state = range->op_bdry_state;
+	op_pos = (range->next_i < op_bdry.last_plus_one)
+	    ? ft_position_for_index(op_bdry, range->next_i) : ES_INFINITY;
+	match_pos = (range->match_next_i < match_bdry.last_plus_one)
+	    ? ft_position_for_index(match_bdry, range->match_next_i)
+	    : ES_INFINITY;
+	if (op_pos <= match_pos && op_pos != ES_INFINITY)
+	    op_bdry_state = ev_op_bdry_info_merge(
+		op_bdry, range->next_i, &range->next_i, op_bdry_state);
+	if (match_pos <= op_pos && match_pos != ES_INFINITY)
+	    op_bdry_state = ev_op_bdry_info_merge(match_bdry,
+		range->match_next_i, &range->match_next_i, op_bdry_state);
     } else
-	op_bdry_state = ev_op_bdry_info(op_bdry, pos, &range->next_i);
+	op_bdry_state = ev_op_bdry_info(op_bdry, pos, &range->next_i) |
+	    ev_match_info(match_bdry, pos, &range->match_next_i);
     ei_op = 0;
     if (op_bdry_state & EV_SEL_PRIMARY)
 	/* invert destination (primary) selection */
@@ -1138,13 +1155,16 @@ ev_range_info(op_bdry, pos, range)
 	ei_op |= EI_OP_INVERT;
     if (op_bdry_state & EV_BDRY_OVERLAY)
 	ei_op |= EI_OP_EV_OVERLAY;
+    if (op_bdry_state & EV_BDRY_MATCH)
+	ei_op |= EI_OP_LIGHT_GRAY;
     range->op_bdry_state = op_bdry_state;
     range->ei_op = ei_op;
-    if (range->next_i < op_bdry.last_plus_one)
-	range->last_plus_one =
-	    ft_position_for_index(op_bdry, range->next_i);
-    else
-	range->last_plus_one = ES_INFINITY;
+    op_pos = (range->next_i < op_bdry.last_plus_one)
+	? ft_position_for_index(op_bdry, range->next_i) : ES_INFINITY;
+    match_pos = (range->match_next_i < match_bdry.last_plus_one)
+	? ft_position_for_index(match_bdry, range->match_next_i)
+	: ES_INFINITY;
+    range->last_plus_one = MIN(op_pos, match_pos);
 }
 
 /*
@@ -1599,7 +1619,7 @@ Glyph_restart:
 	goto Done;
 	}
     if ((ei_op & EI_OP_MEASURE) == 0) {
-	ev_range_info(chain_private->op_bdry, last_plus_one, &range);
+	ev_range_info(chain_private, last_plus_one, &range);
 	range.ei_op |= ei_op;
 	if (range.ei_op & EI_OP_EV_OVERLAY) {
 	    if (last_plus_one != line_seq[line].pos) {
@@ -1689,7 +1709,7 @@ Glyph_restart:
 		    ev_do_glyph(view, &glyph_pos, &glyph, &result);
 		}
 		if (esbuf.last_plus_one == range.last_plus_one) {
-		    ev_range_info(chain_private->op_bdry,
+		    ev_range_info(chain_private,
 				  ES_INFINITY, &range);
 		    range.ei_op |= ei_op;
 		}
@@ -1706,7 +1726,7 @@ Glyph_restart:
 		rect->r_width += (rect->r_left - view->rect.r_left);
 		rect->r_left = view->rect.r_left;
 		if (result.last_plus_one == range.last_plus_one) {
-		    ev_range_info(chain_private->op_bdry,
+		    ev_range_info(chain_private,
 				  ES_INFINITY, &range);
 		    range.ei_op |= ei_op;
 		}
@@ -1728,7 +1748,7 @@ Glyph_restart:
 			    result.last_plus_one = span_result.last_plus_one;
 			    ESBUF_SET_POSITION(result.last_plus_one);
 			    if (result.last_plus_one >= range.last_plus_one) {
-				ev_range_info(chain_private->op_bdry,
+				ev_range_info(chain_private,
 					      result.last_plus_one, &range);
 				range.ei_op |= ei_op;
 			    }
@@ -1752,7 +1772,7 @@ Glyph_restart:
 			}
 			ESBUF_SET_POSITION(result.last_plus_one);
 			if (result.last_plus_one >= range.last_plus_one) {
-			    ev_range_info(chain_private->op_bdry,
+			    ev_range_info(chain_private,
 					  result.last_plus_one, &range);
 			    range.ei_op |= ei_op;
 			}
@@ -36,7 +36,7 @@ Pkg_private void ev_display_fixup(register Ev_handle view);
 Pkg_private Es_index ev_scroll_lines(register Ev_handle view, int line_count, int scroll_by_display_lines);
 Pkg_private void ev_display_in_rect(register Ev_handle view, register Rect *rect);
 Pkg_private int ev_fill_esbuf(Es_buf_handle esbuf, Es_index *ptr_to_last_plus_one);
-Pkg_private void ev_range_info(Ev_line_table op_bdry, Es_index pos, register struct range *range);
+Pkg_private void ev_range_info(Ev_chain_pd_handle private, Es_index pos, register struct range *range);
 Pkg_private Ev_process_handle ev_process_init(register Ev_process_handle ph, Ev_handle view, Es_index first, Es_index stop_plus_one, Rect *rect, CHAR *buf, int sizeof_buf);
 Pkg_private int ev_process_update_buf(register Ev_process_handle ph);
 Pkg_private unsigned long ev_process(register Ev_process_handle ph, long unsigned flags, int op, int rop, Xv_Window pw);
@@ -16,7 +16,9 @@ static char     sccsid[] = "@(#)ev_edit.c 20.27 93/06/28";
 #include <xview_private/ev_edit_.h>
 #include <xview_private/ev_attr_.h>
 #include <xview_private/ev_display_.h>
+#include <xview_private/ev_lines_.h>
 #include <xview_private/ev_once_.h>
+#include <xview_private/ev_op_bdry_.h>
 #include <xview_private/ev_update_.h>
 #include <xview_private/finger_tbl_.h>
 #include <xview/pkg.h>
@@ -435,8 +437,12 @@ ev_update_after_edit(views, last_plus_one, delta, old_length, min_insert_pos)
 	chain->updated = TRUE;
 #endif
 	ev_update_lt_after_edit(&chain->op_bdry, last_plus_one, delta);
+	ev_update_lt_after_edit(&chain->match_bdry, last_plus_one, delta);
 	ev_update_fingers_after_edit(&views->fingers, last_plus_one, delta);
+	ev_lines_after_edit(views, last_plus_one, delta, min_insert_pos);
     }
+    if (chain->match_scanned != ES_CANNOT_SET)
+	ev_match_after_edit(views, last_plus_one, delta, min_insert_pos);
     FORALLVIEWS(views, view) {
 	if (ev_lt_delta(view, last_plus_one, delta)) {
 	    private = EV_PRIVATE(view);
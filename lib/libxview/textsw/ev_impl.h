@@ -78,6 +78,8 @@ typedef Ev_overlay_object *	Ev_overlay_handle;
 #define EV_BDRY_END		EV_SEL_CLIENT_FLAG(0x1)
 				/* ... otherwise _BEGIN */
 #define	EV_BDRY_OVERLAY		EV_SEL_CLIENT_FLAG(0x2)
+#define	EV_BDRY_MATCH		EV_SEL_CLIENT_FLAG(0x4)
+				/* found by a background find */
 #define EV_BDRY_TYPE_ONLY	(EV_BDRY_END|EV_SEL_BASE_TYPE(0xFFFFFFFF))
 #define EV_BDRY_EXACT_MATCH	(EV_BDRY_TYPE_ONLY|EV_SEL_PENDING_DELETE)
 
@@ -97,13 +99,6 @@ typedef struct ev_pos_info {
 /*   The following struct is used to cache information about the physical
  * lines that are visible in a view.  The definition of when the cache is
  * valid is encapsulated in the EV_CACHED_LINE_INFO_IS_VALID macro below.
- *
- *   It is also used to cache the last sought line number from
- * ev_position_for_physical_line().  If the next sought line number
- * is greater than the cached one and the cache is valid, then the
- * search may be started from the cached position.  In this usage,
- * line_count is ignored, and cache validity is only based on
- * EV_CHAIN_PRIVATE->edit_number.
  */
 typedef struct ev_physical_line_info {
 	Es_index		 index_of_first;
@@ -150,6 +145,7 @@ struct ev_chain_private_data_object {
 	Ev_mark_object		  selection[2];
 	Ev_mark_object		  secondary[2];
 	Ev_line_table		  op_bdry;
+	Ev_line_table		  match_bdry;	/* See ev_add_match */
 	int			  auto_scroll_by,
 				  lower_context, upper_context;
 	int			(*notify_proc)();
@@ -161,7 +157,10 @@ struct ev_chain_private_data_object {
 	struct pr_pos		  caret_hotpoint;
 	struct pixrect		 *ghost_pr;
 	struct pr_pos		  ghost_hotpoint;
-	Ev_physical_line_info	  cache_pos_for_file_line;
+	struct ev_line_index	 *line_index;	/* See ev_lines.c */
+	Es_index		  match_scanned; /* ES_CANNOT_SET unless finding */
+	Es_index		  match_resume;	/* next scan starts here */
+	Ev_range		  match_dirty;	/* edited since scanned */
 #ifdef OW_I18N
 	int			  updated;	/* contents update flag */
 #endif
@@ -199,6 +198,7 @@ struct range {
 	int		ei_op;
 	int		last_plus_one;
 	int		next_i;
+	int		match_next_i;	/* next_i into match_bdry */
 	unsigned	op_bdry_state;
 };
 
@@ -0,0 +1,513 @@
+#ifndef lint
+#ifdef sccs
+static char     sccsid[] = "@(#)ev_lines.c 1.1 93/06/28";
+#endif
+#endif
+
+/*
+ *	(c) Copyright 1989 Sun Microsystems, Inc. Sun design patents
+ *	pending in the U.S. and foreign countries. See LEGAL NOTICE
+ *	file for terms of the license.
+ */
+
+/*
+ * Index of the physical lines of a chain's entity stream.
+ *
+ * The stream is divided into consecutive blocks of about EV_LINES_BLOCK
+ * characters, each knowing its length and how many newlines it holds.  The
+ * blocks' lengths and newline counts are also summed in two Fenwick trees,
+ * so the block holding a given position, or a given newline, is found in
+ * O(log blocks), and at most one block then has to be read.
+ *
+ * The index is built the first time a line number is asked for, and from
+ * then on ev_update_after_edit brings it up to date after every edit by
+ * recounting only the blocks the edit touched, each recount a point update
+ * of the trees.  Blocks emptied by a delete are kept, empty, and a block
+ * that grows too long is halved into an empty block at most EV_LINES_SLACK
+ * blocks away, moving the ones in between over by one.  Only when there is
+ * none that close are the blocks respread, with an empty one after each,
+ * in O(blocks).
+ */
+
+#include <xview_private/ev_lines_.h>
+#include <xview_private/ev_once_.h>
+#include <xview_private/primal.h>
+#include <xview_private/ev_impl.h>
+#include <xview_private/portable.h>
+
+#define EV_LINES_BLOCK		4096
+#define EV_LINES_MAX_BLOCK	(4 * EV_LINES_BLOCK)	/* Split beyond this */
+#define EV_LINES_SLACK		8	/* How far a split looks for room */
+
+struct ev_line_block {
+    Es_index        length;
+    int             newlines;
+};
+
+struct ev_line_index {
+    Es_index        length;	/* of the stream it describes */
+    int             count, max_count;	/* of blocks */
+    struct ev_line_block *blocks;
+    Es_index       *length_sums;/* Fenwick trees over blocks, 1-origin */
+    int            *newline_sums;
+};
+typedef struct ev_line_index *Ev_line_index;
+
+static Ev_line_index ev_lines_get(Ev_chain chain);
+static int ev_lines_fill(Es_handle esh, Es_index first, Es_index length, struct ev_line_block *blocks);
+static void ev_lines_replace(Ev_chain chain, Ev_line_index index, int first_block, int blocks_gone, Es_index start, Es_index length);
+static void ev_lines_sum(Ev_line_index index);
+static void ev_lines_add(Ev_line_index index, int block, Es_index length, int newlines);
+static void ev_lines_recount(Es_handle esh, Ev_line_index index, int block, Es_index start, Es_index length);
+static void ev_lines_move(Ev_line_index index, int to, int from);
+static int ev_lines_split(Es_handle esh, Ev_line_index index, int block, Es_index start, Es_index length);
+static int ev_lines_spread(Ev_chain chain, Ev_line_index index, int block);
+static int ev_lines_block_for_position(Ev_line_index index, Es_index pos, Es_index *start, int *newlines);
+static int ev_lines_block_for_newline(Ev_line_index index, int count, Es_index *start, int *newlines);
+
+/*
+ * Returns the 0-origin number of the physical line that pos is in, i.e.
+ * the number of newlines in front of it.
+ */
+Pkg_private int
+ev_line_for_position(chain, pos)
+    Ev_chain        chain;
+    Es_index        pos;
+{
+    Ev_line_index   index;
+    Es_index        start;
+    int             newlines;
+
+    if (pos <= 0)
+	return (0);
+    if ((index = ev_lines_get(chain)) == NULL)
+	return (ev_newlines_in_esh(chain->esh, 0, pos));
+    if (pos > index->length)
+	pos = index->length;
+    (void) ev_lines_block_for_position(index, pos, &start, &newlines);
+    return (newlines + ev_newlines_in_esh(chain->esh, start, pos));
+}
+
+/*
+ * Returns the position just after the count'th newline, or ES_CANNOT_SET
+ * if the stream holds fewer.
+ */
+Pkg_private     Es_index
+ev_position_after_newlines(chain, count)
+    Ev_chain        chain;
+    int             count;
+{
+    Ev_line_index   index;
+    Es_index        start, first, last_plus_one;
+    int             newlines;
+    CHAR            newline_str[2];
+
+    if (count <= 0)
+	return (0);
+    newline_str[0] = '\n';
+    newline_str[1] = '\0';
+    start = 0;
+    newlines = 0;
+    if ((index = ev_lines_get(chain)) != NULL) {
+	if (ev_lines_block_for_newline(index, count, &start, &newlines) < 0)
+	    return (ES_CANNOT_SET);
+    }
+    ev_find_in_esh(chain->esh, newline_str, 1, start,
+		   (unsigned) (count - newlines), 0, &first, &last_plus_one);
+    return ((first == ES_CANNOT_SET) ? ES_CANNOT_SET : last_plus_one);
+}
+
+/*
+ * Called for every edit, with the same arguments as ev_update_after_edit.
+ * The blocks that the edit touched are recounted from the text as it now
+ * is, so a keystroke reads a block at most.
+ */
+Pkg_private void
+ev_lines_after_edit(chain, last_plus_one, delta, min_insert_pos)
+    Ev_chain        chain;
+    Es_index        last_plus_one, delta, min_insert_pos;
+{
+    register Ev_line_index index = EV_CHAIN_PRIVATE(chain)->line_index;
+    Es_index        start, last_start, length, first_length;
+    int             block, last_block, newlines;
+
+    if (index == NULL || delta == 0)
+	return;
+    if (index->length + delta != es_get_length(chain->esh)) {
+	/* The stream changed behind our back: start over when next asked. */
+	ev_lines_destroy(chain);
+	return;
+    }
+    if (delta > 0) {
+	block = ev_lines_block_for_position(index, min_insert_pos, &start,
+					    &newlines);
+	index->length += delta;
+	length = index->blocks[block].length + delta;
+	if (length <= EV_LINES_MAX_BLOCK) {
+	    ev_lines_add(index, block, delta,
+			 ev_newlines_in_esh(chain->esh, min_insert_pos,
+					    min_insert_pos + delta));
+	} else if (length > 2 * EV_LINES_MAX_BLOCK) {
+	    /* A big paste: it costs more than the O(blocks) anyway */
+	    ev_lines_replace(chain, index, block, 1, start, length);
+	} else if (!ev_lines_split(chain->esh, index, block, start, length)) {
+	    if ((block = ev_lines_spread(chain, index, block)) >= 0)
+		(void) ev_lines_split(chain->esh, index, block, start,
+				      length);
+	}
+	return;
+    }
+    /*
+     * The deleted text is gone, so recount what is left of its blocks into
+     * the first and last of them, emptying any in between.
+     */
+    block = ev_lines_block_for_position(index, min_insert_pos, &start,
+					&newlines);
+    last_block = ev_lines_block_for_position(index, last_plus_one - 1,
+					     &last_start, &newlines);
+    index->length += delta;
+    length = last_start + index->blocks[last_block].length + delta - start;
+    first_length = (block == last_block) ? length :
+	MIN(length, EV_LINES_MAX_BLOCK);
+    ev_lines_recount(chain->esh, index, block, start, first_length);
+    if (block != last_block) {
+	for (block++; block < last_block; block++)
+	    ev_lines_add(index, block, -index->blocks[block].length,
+			 -index->blocks[block].newlines);
+	ev_lines_recount(chain->esh, index, last_block, start + first_length,
+			 length - first_length);
+    }
+}
+
+Pkg_private void
+ev_lines_destroy(chain)
+    Ev_chain        chain;
+{
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    register Ev_line_index index = private->line_index;
+
+    if (index == NULL)
+	return;
+    free((char *) index->blocks);
+    free((char *) index->length_sums);
+    free((char *) index->newline_sums);
+    free((char *) index);
+    private->line_index = NULL;
+}
+
+static          Ev_line_index
+ev_lines_get(chain)
+    Ev_chain        chain;
+{
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    register Ev_line_index index = private->line_index;
+    Es_index        length = es_get_length(chain->esh);
+
+    if (index != NULL) {
+	if (index->length == length)
+	    return (index);
+	ev_lines_destroy(chain);
+    }
+    if ((index = NEW(struct ev_line_index)) == NULL)
+	return (NULL);
+    index->length = length;
+    private->line_index = index;
+    ev_lines_replace(chain, index, 0, 0, 0, length);
+    return (private->line_index);
+}
+
+/*
+ * Divides the text in [first, first + length) into blocks, returning how
+ * many.  blocks == NULL only counts them.
+ */
+static int
+ev_lines_fill(esh, first, length, blocks)
+    Es_handle       esh;
+    Es_index        first, length;
+    register struct ev_line_block *blocks;
+{
+    register int    i, count;
+    Es_index        block_length;
+
+    /* An empty stream still has one (empty) block. */
+    count = (length + EV_LINES_BLOCK - 1) / EV_LINES_BLOCK;
+    if (count == 0)
+	count = 1;
+    if (blocks == NULL)
+	return (count);
+    for (i = 0; i < count; i++) {
+	block_length = MIN(EV_LINES_BLOCK, length);
+	blocks[i].length = block_length;
+	blocks[i].newlines =
+	    ev_newlines_in_esh(esh, first, first + block_length);
+	first += block_length;
+	length -= block_length;
+    }
+    return (count);
+}
+
+/*
+ * Replaces the blocks_gone blocks at first_block, which start at start, by
+ * fresh ones covering the length characters there now.
+ */
+static void
+ev_lines_replace(chain, index, first_block, blocks_gone, start, length)
+    Ev_chain        chain;
+    register Ev_line_index index;
+    int             first_block, blocks_gone;
+    Es_index        start, length;
+{
+    int             count, new_count;
+
+    count = (length == 0 && index->count > blocks_gone) ? 0 :
+	ev_lines_fill(chain->esh, start, length,
+		      (struct ev_line_block *) 0);
+    new_count = index->count - blocks_gone + count;
+    if (new_count > index->max_count) {
+	struct ev_line_block *blocks;
+
+	index->max_count = MAX(new_count, 2 * index->max_count);
+	blocks = (struct ev_line_block *) (index->blocks ?
+	    realloc((char *) index->blocks,
+		    (unsigned) index->max_count * sizeof(*blocks)) :
+	    malloc((unsigned) index->max_count * sizeof(*blocks)));
+	if (blocks != NULL)
+	    index->blocks = blocks;
+	free((char *) index->length_sums);
+	free((char *) index->newline_sums);
+	index->length_sums = (Es_index *)
+	    malloc((unsigned) (index->max_count + 1) * sizeof(Es_index));
+	index->newline_sums = (int *)
+	    malloc((unsigned) (index->max_count + 1) * sizeof(int));
+	if (blocks == NULL || index->length_sums == NULL ||
+	    index->newline_sums == NULL) {
+	    ev_lines_destroy(chain);
+	    return;
+	}
+    }
+    if (count != blocks_gone) {
+	XV_BCOPY((char *) (index->blocks + first_block + blocks_gone),
+		 (char *) (index->blocks + first_block + count),
+		 (index->count - first_block - blocks_gone) *
+		 sizeof(*index->blocks));
+    }
+    if (count > 0)
+	(void) ev_lines_fill(chain->esh, start, length,
+			     index->blocks + first_block);
+    index->count = new_count;
+    ev_lines_sum(index);
+}
+
+/* Rebuilds both Fenwick trees from the blocks, in O(blocks). */
+static void
+ev_lines_sum(index)
+    register Ev_line_index index;
+{
+    register int    i, j;
+
+    for (i = 1; i <= index->count; i++) {
+	index->length_sums[i] = index->blocks[i - 1].length;
+	index->newline_sums[i] = index->blocks[i - 1].newlines;
+    }
+    for (i = 1; i <= index->count; i++) {
+	j = i + (i & -i);
+	if (j <= index->count) {
+	    index->length_sums[j] += index->length_sums[i];
+	    index->newline_sums[j] += index->newline_sums[i];
+	}
+    }
+}
+
+static void
+ev_lines_add(index, block, length, newlines)
+    register Ev_line_index index;
+    int             block;
+    Es_index        length;
+    int             newlines;
+{
+    register int    i;
+
+    index->blocks[block].length += length;
+    index->blocks[block].newlines += newlines;
+    for (i = block + 1; i <= index->count; i += i & -i) {
+	index->length_sums[i] += length;
+	index->newline_sums[i] += newlines;
+    }
+}
+
+/* Makes block hold the length characters at start. */
+static void
+ev_lines_recount(esh, index, block, start, length)
+    Es_handle       esh;
+    register Ev_line_index index;
+    int             block;
+    Es_index        start, length;
+{
+    int             newlines;
+
+    newlines = (length > 0) ? ev_newlines_in_esh(esh, start, start + length)
+	: 0;
+    ev_lines_add(index, block, length - index->blocks[block].length,
+		 newlines - index->blocks[block].newlines);
+}
+
+/* Copies block from over block to, leaving from as it was. */
+static void
+ev_lines_move(index, to, from)
+    register Ev_line_index index;
+    int             to, from;
+{
+    ev_lines_add(index, to,
+		 index->blocks[from].length - index->blocks[to].length,
+		 index->blocks[from].newlines - index->blocks[to].newlines);
+}
+
+/*
+ * block, which starts at start, now holds length characters, too many for
+ * one block but no more than two.  Halves it with an empty block at most
+ * EV_LINES_SLACK blocks away, moving those in between over to make the
+ * empty one its neighbour.  Returns FALSE, changing nothing, if there is
+ * no empty block that close.
+ */
+static int
+ev_lines_split(esh, index, block, start, length)
+    Es_handle       esh;
+    register Ev_line_index index;
+    int             block;
+    Es_index        start, length;
+{
+    register int    empty, i;
+
+    for (empty = block + 1;
+	 empty < index->count && empty <= block + EV_LINES_SLACK; empty++)
+	if (index->blocks[empty].length == 0)
+	    break;
+    if (empty < index->count && empty <= block + EV_LINES_SLACK) {
+	for (i = empty; i > block + 1; i--)
+	    ev_lines_move(index, i, i - 1);
+    } else {
+	for (empty = block - 1; empty >= 0 && empty >= block - EV_LINES_SLACK;
+	     empty--)
+	    if (index->blocks[empty].length == 0)
+		break;
+	if (empty < 0 || empty < block - EV_LINES_SLACK)
+	    return (FALSE);
+	for (i = empty; i < block - 1; i++)
+	    ev_lines_move(index, i, i + 1);
+	block--;
+    }
+    ev_lines_recount(esh, index, block, start, length / 2);
+    ev_lines_recount(esh, index, block + 1, start + length / 2,
+		     length - length / 2);
+    return (TRUE);
+}
+
+/*
+ * Drops the empty blocks, then puts an empty one after each of the rest
+ * (and after block, even if it is empty) for ev_lines_split to use.
+ * Returns the new number of block, or -1 if the index had to be dropped.
+ */
+static int
+ev_lines_spread(chain, index, block)
+    Ev_chain        chain;
+    register Ev_line_index index;
+    int             block;
+{
+    struct ev_line_block *blocks;
+    register int    i, count;
+    int             max_count, new_block = 0;
+
+    for (i = count = 0; i < index->count; i++)
+	if (index->blocks[i].length > 0)
+	    count++;
+    max_count = 2 * (count + 1);
+    blocks = (struct ev_line_block *)
+	malloc((unsigned) max_count * sizeof(*blocks));
+    free((char *) index->length_sums);
+    free((char *) index->newline_sums);
+    index->length_sums = (Es_index *)
+	malloc((unsigned) (max_count + 1) * sizeof(Es_index));
+    index->newline_sums = (int *)
+	malloc((unsigned) (max_count + 1) * sizeof(int));
+    if (blocks == NULL || index->length_sums == NULL ||
+	index->newline_sums == NULL) {
+	if (blocks)
+	    free((char *) blocks);
+	ev_lines_destroy(chain);
+	return (-1);
+    }
+    for (i = count = 0; i < index->count; i++) {
+	if (index->blocks[i].length == 0 && i != block)
+	    continue;
+	if (i == block)
+	    new_block = count;
+	blocks[count++] = index->blocks[i];
+	blocks[count].length = 0;
+	blocks[count++].newlines = 0;
+    }
+    free((char *) index->blocks);
+    index->blocks = blocks;
+    index->count = count;
+    index->max_count = max_count;
+    ev_lines_sum(index);
+    return (new_block);
+}
+
+/*
+ * Returns the last block that starts at or before pos, setting *start to
+ * where it starts and *newlines to the newlines in front of it.
+ */
+static int
+ev_lines_block_for_position(index, pos, start, newlines)
+    register Ev_line_index index;
+    Es_index        pos;
+    Es_index       *start;
+    int            *newlines;
+{
+    register int    block = 0, step;
+    Es_index        sum = 0;
+    int             newline_sum = 0;
+
+    for (step = 1; 2 * step <= index->count; step *= 2);
+    for (; step > 0; step /= 2) {
+	/* Never past the last block, which holds the end of the stream. */
+	if (block + step < index->count &&
+	    sum + index->length_sums[block + step] <= pos) {
+	    block += step;
+	    sum += index->length_sums[block];
+	    newline_sum += index->newline_sums[block];
+	}
+    }
+    *start = sum;
+    *newlines = newline_sum;
+    return (block);
+}
+
+/*
+ * Returns the block holding the count'th newline, or -1 if there are fewer,
+ * setting *start and *newlines as ev_lines_block_for_position does.
+ */
+static int
+ev_lines_block_for_newline(index, count, start, newlines)
+    register Ev_line_index index;
+    int             count;
+    Es_index       *start;
+    int            *newlines;
+{
+    register int    block = 0, step;
+    Es_index        sum = 0;
+    int             newline_sum = 0;
+
+    for (step = 1; 2 * step <= index->count; step *= 2);
+    for (; step > 0; step /= 2) {
+	if (block + step <= index->count &&
+	    newline_sum + index->newline_sums[block + step] < count) {
+	    block += step;
+	    sum += index->length_sums[block];
+	    newline_sum += index->newline_sums[block];
+	}
+    }
+    *start = sum;
+    *newlines = newline_sum;
+    return ((block < index->count) ? block : -1);
+}
@@ -0,0 +1,12 @@
+#if !defined(EV_LINES__H)
+#define EV_LINES__H
+
+#include <xview/pkg.h>
+#include <xview_private/ev.h>
+
+Pkg_private int ev_line_for_position(Ev_chain chain, Es_index pos);
+Pkg_private Es_index ev_position_after_newlines(Ev_chain chain, int count);
+Pkg_private void ev_lines_after_edit(Ev_chain chain, Es_index last_plus_one, Es_index delta, Es_index min_insert_pos);
+Pkg_private void ev_lines_destroy(Ev_chain chain);
+
+#endif
@@ -18,8 +18,10 @@ static char     sccsid[] = "@(#)ev_once.c 20.28 93/06/28";
 #include <xview_private/es_util_.h>
 #include <xview_private/ev_display_.h>
 #include <xview_private/ev_edit_.h>
+#include <xview_private/ev_lines_.h>
 #include <xview_private/finger_tbl_.h>
 #include <xview_private/primal.h>
+#include <string.h>
 #include <sys/time.h>
 #include <pixrect/pixrect.h>
 #include <pixrect/pr_util.h>
@@ -46,6 +48,8 @@ static unsigned short    caret_image[7] = {
 };
 
 
+static int ev_find_backward_in_buf(register CHAR *buf, int from, register CHAR *pattern, register int pattern_length, register int *skip);
+
 mpr_static(ev_caret_mpr, 7, 7, 1, caret_image);
 static unsigned short    ghost_caret[7] = {
     0x1000, 0x2800, 0x5400, 0xAA00, 0x5400, 0x2800, 0x1000
@@ -72,6 +76,8 @@ ev_create_chain(esh, eih)
     EV_INIT_MARK(private->selection[1]);
     private->op_bdry = FT_CLIENT_CREATE(10, struct op_bdry_datum);
     FT_CLEAR_ALL(private->op_bdry);
+    private->match_bdry = FT_CLIENT_CREATE(10, struct op_bdry_datum);
+    FT_CLEAR_ALL(private->match_bdry);
     private->lower_context = EV_NO_CONTEXT;
     private->upper_context = EV_NO_CONTEXT;
     private->notify_level = 0;
@@ -84,10 +90,9 @@ ev_create_chain(esh, eih)
     private->ghost_pr = &ev_ghost_mpr;
     private->ghost_hotpoint.x = (ev_ghost_mpr.pr_size.x + 1) >> 1;
     private->ghost_hotpoint.y = 2;
-    private->cache_pos_for_file_line.index_of_first = ES_CANNOT_SET;
-    private->cache_pos_for_file_line.edit_number = 0;
-    private->cache_pos_for_file_line.first_line_number = 0;
-    private->cache_pos_for_file_line.line_count = 0;
+    private->match_scanned = ES_CANNOT_SET;
+    private->match_dirty.first = ES_INFINITY;
+    private->match_dirty.last_plus_one = ES_INFINITY;
 #ifdef OW_I18N
     private->updated = TRUE;
 #endif
@@ -157,6 +162,8 @@ ev_destroy_chain_and_views(chain)
     }
     ft_destroy(&chain->fingers);
     ft_destroy(&((Ev_chain_pd_handle)(chain->private_data))->op_bdry);
+    ft_destroy(&((Ev_chain_pd_handle)(chain->private_data))->match_bdry);
+    ev_lines_destroy(chain);
     free(chain->private_data);
     free((char *) chain);
     return (0);
@@ -229,7 +236,7 @@ ev_line_info(view, top, bottom)
  * first and last screen lines of the view.
  */
 {
-    Es_index        last_plus_one, old_first, delta_first;
+    Es_index        last_plus_one;
     Ev_pd_handle    private = EV_PRIVATE(view);
     register Ev_chain chain = view->view_chain;
     Ev_chain_pd_handle chain_private = EV_CHAIN_PRIVATE(chain);
@@ -240,30 +247,9 @@ ev_line_info(view, top, bottom)
     edit_number_ok = (cache->edit_number == chain_private->edit_number);
     first_ok = (cache->index_of_first == EV_VIEW_FIRST(view));
     if (!(first_ok && edit_number_ok)) {
-	/*
-	 * Cache is invalid - incremental fix is: a) possible iff
-	 * edit_number_ok; b) worthwhile unless view moved closer to start of
-	 * file and view is now closer to start than to old position.
-	 */
-	old_first = cache->index_of_first;
 	ev_view_range(view, &cache->index_of_first, &last_plus_one);
-	delta_first = old_first - cache->index_of_first;
-	if ((edit_number_ok) && (
-	      (delta_first < 0) || (delta_first < cache->index_of_first))) {
-	    if (delta_first < 0) {
-		cache->first_line_number +=
-		    ev_newlines_in_esh(chain->esh,
-				       old_first, cache->index_of_first);
-	    } else {
-		cache->first_line_number -=
-		    ev_newlines_in_esh(chain->esh,
-				       cache->index_of_first, old_first);
-	    }
-	} else {
-	    cache->first_line_number =
-		ev_newlines_in_esh(chain->esh, 0L,
-				   cache->index_of_first);
-	}
+	cache->first_line_number =
+	    ev_line_for_position(chain, cache->index_of_first);
 	cache->line_count =
 	    ev_newlines_in_esh(chain->esh,
 			       cache->index_of_first,
@@ -362,47 +348,13 @@ ev_position_for_physical_line(chain, line, skip_white_space)
     register int    line;
     int             skip_white_space;
 {
-    register        Ev_chain_pd_handle
-                    chain_private = EV_CHAIN_PRIVATE(chain);
-    register        Ev_physical_line_info
-    *               cache = &chain_private->cache_pos_for_file_line;
     Es_index        first, last_plus_one;
-    Es_index        start_search;
-    register int    count;
-    CHAR            buf[2];
 
     if (line > 0) {
-	count = line;
-	if (cache->edit_number == chain_private->edit_number &&
-	    line >= cache->first_line_number) {
-	    start_search = cache->index_of_first;
-	    count -= cache->first_line_number;
-	} else {
-	    start_search = 0L;
-	}
-	if (count) {
-	    buf[0] = '\n';
-	    ev_find_in_esh(chain->esh, buf, 1, start_search, count, 0,
-			   &first, &last_plus_one);
-	} else {
-	    /*
-	     * Consecutive identical queries: make sure that following tests
-	     * and assignments on first and last_plus_one will generate the
-	     * correct result.
-	     */
-	    first = last_plus_one = start_search;
-	}
-	if (first != ES_CANNOT_SET) {
-	    /* Check for match at end-of-stream. */
-	    if (last_plus_one < es_get_length(chain->esh)) {
-		first = last_plus_one;
-		cache->edit_number = chain_private->edit_number;
-		cache->first_line_number = line;
-		cache->index_of_first = first;
-	    } else {
-		first = ES_CANNOT_SET;
-	    }
-	}
+	first = ev_position_after_newlines(chain, line);
+	/* Check for match at end-of-stream. */
+	if (first != ES_CANNOT_SET && first >= es_get_length(chain->esh))
+	    first = ES_CANNOT_SET;
     } else if (line < 0) {
 	first = ES_CANNOT_SET;
     } else {
@@ -418,6 +370,114 @@ ev_position_for_physical_line(chain, line, skip_white_space)
     return (first);
 }
 
+/*
+ * ev_find_in_esh streams the text through a buffer and matches the pattern
+ * with Boyer-Moore-Horspool: the window is compared only when its last
+ * (first, for a backward search) character agrees with the pattern, and
+ * otherwise slides by the distance to that character's nearest occurrence
+ * in the pattern.  Patterns too short for the skips to pay off instead scan
+ * for their first character with memchr, which the C library vectorizes.
+ * The skip tables are indexed by the low byte of a CHAR, keeping the
+ * minimum shift of all CHARs that share it, so they also serve OW_I18N.
+ *
+ * Consecutive buffers overlap by pattern_length - 1 characters, so matches
+ * that straddle a buffer boundary are found without re-reading the stream.
+ */
+#define EV_FIND_BUFSIZE		8192
+#define EV_FIND_SKIP_INDEX(_c)	((unsigned) (_c) & (EV_FIND_SKIP_SIZE - 1))
+#define EV_FIND_MIN_BMH		4	/* Shorter patterns use memchr */
+#define EV_FIND_EQUAL(_a, _b, _len)					\
+	(memcmp((char *) (_a), (char *) (_b), (_len) * sizeof(CHAR)) == 0)
+
+Pkg_private void
+ev_find_skip_table(pattern, pattern_length, backward, skip)
+    register CHAR  *pattern;
+    register int    pattern_length;
+    int             backward;
+    register int   *skip;
+{
+    register int    i;
+
+    for (i = 0; i < EV_FIND_SKIP_SIZE; i++)
+	skip[i] = pattern_length;
+    if (backward) {
+	for (i = pattern_length - 1; i > 0; i--)
+	    skip[EV_FIND_SKIP_INDEX(pattern[i])] = i;
+    } else {
+	for (i = 0; i < pattern_length - 1; i++)
+	    skip[EV_FIND_SKIP_INDEX(pattern[i])] = pattern_length - 1 - i;
+    }
+}
+
+/* Returns the first i in [from, fill - pattern_length] that matches, or -1. */
+Pkg_private int
+ev_find_forward_in_buf(buf, from, fill, pattern, pattern_length, skip)
+    register CHAR  *buf;
+    int             from, fill;
+    register CHAR  *pattern;
+    register int    pattern_length;
+    register int   *skip;
+{
+    register int    i = from, last = pattern_length - 1;
+    register CHAR   c;
+
+#ifndef OW_I18N
+    if (pattern_length < EV_FIND_MIN_BMH) {
+	register CHAR  *found;
+
+	while (i + last < fill) {
+	    found = (CHAR *) memchr((char *) buf + i, pattern[0],
+				   (unsigned) (fill - last - i));
+	    if (found == NULL)
+		return (-1);
+	    i = found - buf;
+	    if (EV_FIND_EQUAL(buf + i + 1, pattern + 1, last))
+		return (i);
+	    i++;
+	}
+	return (-1);
+    }
+#endif
+    while (i + last < fill) {
+	c = buf[i + last];
+	if (c == pattern[last] && EV_FIND_EQUAL(buf + i, pattern, last))
+	    return (i);
+	i += skip[EV_FIND_SKIP_INDEX(c)];
+    }
+    return (-1);
+}
+
+/* Returns the last i in [0, from] that matches, or -1. */
+static int
+ev_find_backward_in_buf(buf, from, pattern, pattern_length, skip)
+    register CHAR  *buf;
+    int             from;
+    register CHAR  *pattern;
+    register int    pattern_length;
+    register int   *skip;
+{
+    register int    i = from;
+    register CHAR   c;
+
+    if (pattern_length < EV_FIND_MIN_BMH) {
+	/* There is no portable memrchr, but a plain loop is close. */
+	for (c = pattern[0]; i >= 0; i--) {
+	    if (buf[i] == c &&
+		EV_FIND_EQUAL(buf + i + 1, pattern + 1, pattern_length - 1))
+		return (i);
+	}
+	return (-1);
+    }
+    while (i >= 0) {
+	c = buf[i];
+	if (c == pattern[0] &&
+	    EV_FIND_EQUAL(buf + i + 1, pattern + 1, pattern_length - 1))
+	    return (i);
+	i -= skip[EV_FIND_SKIP_INDEX(c)];
+    }
+    return (-1);
+}
+
 Pkg_private void
 ev_find_in_esh(esh, pattern, pattern_length, position, count, flags,
 	       first, last_plus_one)
@@ -431,145 +491,126 @@ ev_find_in_esh(esh, pattern, pattern_length, position, count, flags,
     Es_index       *last_plus_one;	/* end of found pattern   */
 {
     /*
-     * Currently only simple patterns are supported.
+     * Currently only simple patterns are supported.  Overlapping matches
+     * are not counted, and no match spans a gap in the entity indices
+     * (hopefully due to wrap-around of a bounded stream).
      */
-#define BUFSIZE 2096
-    CHAR            buf[BUFSIZE + 4];
-    register CHAR  *in_buf, *buf_last_plus_one, *matched_to, *done_match;
-    register Es_index new_pos, pos, start_pattern = position;
-    Es_index        length;
+    CHAR            stack_buf[EV_FIND_BUFSIZE];
+    register CHAR  *buf = stack_buf;
+    int             bufsize = EV_FIND_BUFSIZE;
+    int             skip[EV_FIND_SKIP_SIZE];
+    register Es_index pos, next, base;
+    Es_index        limit, gap;
+    register int    found, from, fill;
     int             read;
-    int             useful_bufsize = BUFSIZE;
 
     *first = ES_CANNOT_SET;
-    if (flags & EV_FIND_RE)
+    if ((flags & EV_FIND_RE) || pattern_length <= 0 || count == 0)
 	goto Return;
-    matched_to = pattern;
-    done_match = pattern + pattern_length;
+    /* Make sure that every buffer holds more than the carried overlap. */
+    if (bufsize < 2 * pattern_length) {
+	bufsize = 2 * pattern_length;
+	if ((buf = (CHAR *) xv_malloc(bufsize * sizeof(CHAR))) == NULL)
+	    goto Return;
+    }
+    ev_find_skip_table(pattern, pattern_length,
+		       (flags & EV_FIND_BACKWARD), skip);
     if (flags & EV_FIND_BACKWARD) {
-	struct es_buf_object esbuf;
-	esbuf.esh = esh;
-	esbuf.buf = buf;
-	esbuf.sizeof_buf = BUFSIZE;
-	esbuf.first = ES_INFINITY;
-	start_pattern--;
-Init_Backward:
-	FOREVER {
-	    if (start_pattern < 0)
-		goto Return;
-	    switch (es_make_buf_include_index(&esbuf,
-		start_pattern + (long) (pattern_length - 1), BUFSIZE - 1)) {
-	      case 0:
-		pos = esbuf.first;
-		read = esbuf.last_plus_one - pos;
-		in_buf = buf + (start_pattern - pos);
-		FOREVER {
-		    ASSERT(in_buf <= buf + read);
-		    if (*matched_to++ != *in_buf++) {
-			start_pattern--;
-		    } else if (matched_to == done_match) {
-			if (--count == 0) {
-			    *first = start_pattern;
-			    *last_plus_one = pos + (in_buf - buf);
-			    goto Return;
-			}
-			start_pattern -= pattern_length;
-			/* Overlap matches are not found. */
-		    } else
-			continue;
-		    matched_to = pattern;
-		    if (start_pattern >= pos) {
-			in_buf = buf + (start_pattern - pos);
-		    } else {
-			/*
-			 * We need to back up as start_pattern is not in the
-			 * current buffer.
-			 */
-			goto Init_Backward;
-		    }
+	/*
+	 * Fill the buffer with [base, next) and try every match start in
+	 * [base, limit], from the right.  A match may start anywhere before
+	 * position, even if it then extends past it.
+	 */
+	limit = position - 1;
+	next = es_get_length(esh);
+	if (next > limit + pattern_length)
+	    next = limit + pattern_length;
+	while (limit >= 0) {
+	    base = (next > bufsize) ? next - bufsize : 0;
+	    gap = ES_CANNOT_SET;
+	    pos = es_set_position(esh, base);
+	    while (pos < next) {
+		Es_index        new_pos;
+
+		new_pos = es_read(esh, (int) (next - pos),
+				  buf + (pos - base), &read);
+		if (read == 0 && new_pos == pos) {
+		    next = pos;	/* Stream shrank under us */
+		    break;
 		}
-		/* break; */
-	      case 1:
-		length = es_get_length(esh);
-		if ((start_pattern + pattern_length - 1) < length)
-		    goto Return;
-		goto Skip_Backward;
-	      case 2:
-		/*
-		 * Gap in entity indices (hopefully due to wrap-around of
-		 * bounded stream).  Move start_pattern over gap. NOTE: this
-		 * implies that we never match a pattern against a span of
-		 * indices containing a gap.
-		 */
-		length = esbuf.last_plus_one;
-	Skip_Backward:
-		/*
-		 * Following test is paranoia to detect infinite loop in
-		 * "impossible" case.
-		 */
-		if (esbuf.first == ES_CANNOT_SET)
-		    goto Return;
-		esbuf.first = ES_CANNOT_SET;
-		start_pattern = length - pattern_length;
-		break;
+		if (new_pos != pos + read && pos + read < next) {
+		    /* Keep only what follows the gap. */
+		    gap = pos + read;
+		    base = new_pos;
+		}
+		pos = new_pos;
+	    }
+	    if (limit > next - pattern_length)
+		limit = next - pattern_length;
+	    while (limit >= base) {
+		found = ev_find_backward_in_buf(buf, (int) (limit - base),
+					pattern, pattern_length, skip);
+		if (found < 0)
+		    break;
+		if (--count == 0) {
+		    *first = base + found;
+		    *last_plus_one = *first + pattern_length;
+		    goto Done;
+		}
+		limit = base + found - pattern_length;
+	    }
+	    if (gap != ES_CANNOT_SET) {
+		next = gap;
+	    } else {
+		if (base == 0)
+		    break;
+		next = base + pattern_length - 1;
 	    }
+	    if (limit > next - pattern_length)
+		limit = next - pattern_length;
 	}
     } else {
-	if (pattern_length == 1 && count == 1)
-	    useful_bufsize = 256;
-Init_Forward:
-	new_pos = start_pattern;
-	es_set_position(esh, new_pos);
+	/*
+	 * buf holds [base, base + fill), and match starts before from have
+	 * already been tried or are ruled out by an earlier match.
+	 */
+	base = pos = es_set_position(esh, position);
+	from = fill = 0;
 	FOREVER {
-	    pos = new_pos;
-	    new_pos = es_read(esh, useful_bufsize, buf, &read);
-	    if (read == 0) {
-		if (pos == new_pos)
-		    goto Return;
-		/*
-		 * Gap in entity indices (hopefully due to wrap-around of
-		 * bounded stream).  Move start_pattern over gap. NOTE: this
-		 * implies that we never match a pattern against a span of
-		 * indices containing a gap.
-		 */
-		start_pattern = new_pos;
-		goto Init_Forward;
-	    } else {
-		in_buf = buf;
-		buf_last_plus_one = buf + read;
-		FOREVER {
-		    if (*matched_to++ == *in_buf++) {
-			if (matched_to == done_match) {
-			    if (--count == 0) {
-				*first = start_pattern;
-				*last_plus_one = pos + (in_buf - buf);
-				goto Return;
-			    } else {
-				matched_to = pattern;
-				start_pattern = pos + (in_buf - buf);
-				/* Overlap matches are not found. */
-			    }
-			}
-		    } else {
-			matched_to = pattern;
-			start_pattern++;
-			if (start_pattern >= pos) {
-			    in_buf = buf + (start_pattern - pos);
-			} else {
-			    /*
-			     * We need to back up as start_pattern is not in
-			     * the current buffer.
-			     */
-			    goto Init_Forward;
-			}
-		    }
-		    if (in_buf == buf_last_plus_one)
-			break;	/* Next buffer */
+	    next = es_read(esh, bufsize - fill, buf + fill, &read);
+	    if (read == 0 && next == pos)
+		break;
+	    fill += read;
+	    while ((found = ev_find_forward_in_buf(buf, from, fill,
+			      pattern, pattern_length, skip)) >= 0) {
+		if (--count == 0) {
+		    *first = base + found;
+		    *last_plus_one = *first + pattern_length;
+		    goto Done;
 		}
+		from = found + pattern_length;
 	    }
+	    if (next != pos + read) {
+		/* Gap in entity indices: start afresh after it. */
+		base = next;
+		from = fill = 0;
+	    } else {
+		/* Carry over the tail that may start a match. */
+		if (from < fill - pattern_length + 1)
+		    from = fill - pattern_length + 1;
+		fill -= from;
+		if (fill > 0)
+		    (void) memmove((char *) buf, (char *) (buf + from),
+				   fill * sizeof(CHAR));
+		base += from;
+		from = 0;
+	    }
+	    pos = next;
 	}
     }
+Done:
+    if (buf != stack_buf)
+	free((char *) buf);
 Return:
     return;
-#undef BUFSIZE
 }
@@ -17,6 +17,8 @@ Pkg_private void ev_line_info(register Ev_handle view, int *top, int *bottom);
 Pkg_private int ev_newlines_in_esh(Es_handle esh, Es_index first, Es_index last_plus_one);
 Pkg_private int ev_rect_for_ith_physical_line(register Ev_handle view, int phys_line, register Es_index *first, Rect *rect, int skip_white_space);
 Pkg_private Es_index ev_position_for_physical_line(Ev_chain chain, register int line, int skip_white_space);
+Pkg_private void ev_find_skip_table(register CHAR *pattern, register int pattern_length, int backward, register int *skip);
+Pkg_private int ev_find_forward_in_buf(register CHAR *buf, int from, int fill, register CHAR *pattern, register int pattern_length, register int *skip);
 Pkg_private void ev_find_in_esh(Es_handle esh, CHAR *pattern, int pattern_length, Es_index position, unsigned count, int flags, Es_index *first, Es_index *last_plus_one);
 
 #endif
@@ -29,6 +29,8 @@ static Ev_finger_handle ev_insert_finger(register Ev_finger_table *fingers, Es_i
 static int ev_find_finger_internal(Ev_finger_table *fingers, Ev_mark mark);
 static void ev_remove_finger_internal(register Ev_finger_table *fingers, int i);
 static void ev_clear_margins(register Ev_handle view, register Es_index pos, register int lt_index, register Rect *rect);
+static int ev_match_is_empty(Op_bdry_handle seq, int i);
+static Es_index ev_match_map(Es_index pos, Es_index last_plus_one, Es_index delta, Es_index min_insert_pos);
 
 static Ev_mark_object last_generated_id;
 
@@ -232,6 +234,31 @@ ev_op_bdry_info(op_bdry, pos, next_i)
     return (result);
 }
 
+/*
+ * ev_op_bdry_info for a match_bdry table.  Matches never overlap, so the last
+ * entry at or before pos alone says whether pos is in one, and a binary
+ * search finds it however many matches there are.
+ */
+Pkg_private	unsigned
+ev_match_info(match_bdry, pos, next_i)
+    Ev_finger_table match_bdry;
+    Es_index        pos;
+    int            *next_i;
+{
+    register Op_bdry_handle seq = (Op_bdry_handle) match_bdry.seq;
+    int             i = ft_bounding_index(&match_bdry, pos);
+
+    if (i == match_bdry.last_plus_one) {
+	/* pos is ahead of every entry */
+	if (next_i)
+	    *next_i = 0;
+	return (0);
+    }
+    if (next_i)
+	*next_i = i + 1;
+    return ((seq[i].flags & EV_BDRY_END) ? 0 : EV_BDRY_MATCH);
+}
+
 Pkg_private	void
 ev_remove_op_bdry(op_bdry, pos, type, mask)
     Ev_finger_table *op_bdry;
@@ -555,3 +582,136 @@ ev_set_glyph_pr(chain, mark, pr)
     }
     (void) ev_display_range(chain, line_start, stop_pos);
 }
+
+/*
+ * The matches of a background find (see txt_findall.c) are recorded as
+ * EV_BDRY_MATCH begin/end pairs in the chain's match_bdry table, apart from
+ * the op_bdry table so that there can be many of them without slowing
+ * ev_op_bdry_info.  Matches never overlap, so their entries alternate.  A
+ * begin is flagged move-at-insert only so that ev_add_finger files a later
+ * end at the same position ahead of it.
+ */
+Pkg_private void
+ev_add_match(chain, first, last_plus_one)
+    Ev_chain        chain;
+    Es_index        first, last_plus_one;
+{
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    Ev_mark_object  begin, end;
+
+    EV_INIT_MARK(begin);
+    EV_INIT_MARK(end);
+    EV_MARK_SET_MOVE_AT_INSERT(begin);
+    (void) ev_add_op_bdry(&private->match_bdry, first, EV_BDRY_MATCH,
+			  &begin);
+    (void) ev_add_op_bdry(&private->match_bdry, last_plus_one,
+			  EV_BDRY_MATCH | EV_BDRY_END, &end);
+}
+
+/*
+ * Removes every match that overlaps [first, last_plus_one) or ends at first,
+ * widening *removed to cover the text they spanned.  Returns how many went.
+ */
+Pkg_private int
+ev_remove_matches(chain, first, last_plus_one, removed)
+    Ev_chain        chain;
+    Es_index        first, last_plus_one;
+    register Ev_range *removed;
+{
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    Ev_finger_table *match_bdry = &private->match_bdry;
+    register Op_bdry_handle seq = (Op_bdry_handle) match_bdry->seq;
+    register int    i;
+    int             from, in_match = FALSE, count = 0;
+
+    i = (first > 0) ? ft_bounding_index(match_bdry, first - 1)
+		    : match_bdry->last_plus_one;
+    if (i == match_bdry->last_plus_one) {
+	from = 0;
+    } else if (seq[i].flags & EV_BDRY_END) {
+	from = i + 1;
+    } else {
+	/* A match that straddles first goes, one that ends at it stays. */
+	from = (seq[i + 1].pos <= first) ? i + 2 : i;
+    }
+    /* The matches' entries are contiguous: close up the hole once. */
+    for (i = from; i < match_bdry->last_plus_one; i++) {
+	/* Matches that an edit has emptied are removed even at the end. */
+	if (!in_match && seq[i].pos >= last_plus_one &&
+	    (seq[i].pos > last_plus_one || !ev_match_is_empty(seq, i)))
+	    break;
+	if (seq[i].flags & EV_BDRY_END) {
+	    if (seq[i].pos > removed->last_plus_one)
+		removed->last_plus_one = seq[i].pos;
+	    in_match = FALSE;
+	} else {
+	    if (seq[i].pos < removed->first)
+		removed->first = seq[i].pos;
+	    in_match = TRUE;
+	    count++;
+	}
+    }
+    if (from != i)
+	ft_shift_out(match_bdry, from, i);
+    return (count);
+}
+
+static int
+ev_match_is_empty(seq, i)
+    register Op_bdry_handle seq;
+    register int    i;
+{
+    if (seq[i].pos == ES_INFINITY || (seq[i].flags & EV_BDRY_END))
+	return (FALSE);
+    return (seq[i + 1].pos == seq[i].pos);
+}
+
+static Es_index
+ev_match_map(pos, last_plus_one, delta, min_insert_pos)
+    Es_index        pos, last_plus_one, delta, min_insert_pos;
+{
+    if (delta > 0)
+	return ((pos > last_plus_one) ? pos + delta : pos);
+    if (pos >= last_plus_one)
+	return (pos + delta);
+    return ((pos > min_insert_pos) ? min_insert_pos : pos);
+}
+
+/*
+ * Called for every edit while a background find is active, with the same
+ * arguments as ev_update_after_edit.  Edits to text the find has already
+ * looked at are accumulated in match_dirty for it to rescan; the client is
+ * told in either case, as its scan may have gone idle.
+ */
+Pkg_private void
+ev_match_after_edit(chain, last_plus_one, delta, min_insert_pos)
+    Ev_chain        chain;
+    Es_index        last_plus_one, delta, min_insert_pos;
+{
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    register Ev_range *dirty = &private->match_dirty;
+    Es_index        edit_lpo;
+
+    if (min_insert_pos <= private->match_scanned) {
+	private->match_scanned = ev_match_map(private->match_scanned,
+				      last_plus_one, delta, min_insert_pos);
+	private->match_resume = ev_match_map(private->match_resume,
+				      last_plus_one, delta, min_insert_pos);
+	edit_lpo = (delta > 0) ? min_insert_pos + delta : min_insert_pos;
+	if (dirty->first == ES_INFINITY) {
+	    dirty->first = min_insert_pos;
+	    dirty->last_plus_one = edit_lpo;
+	} else {
+	    dirty->first = ev_match_map(dirty->first,
+				      last_plus_one, delta, min_insert_pos);
+	    dirty->last_plus_one = ev_match_map(dirty->last_plus_one,
+				      last_plus_one, delta, min_insert_pos);
+	    if (min_insert_pos < dirty->first)
+		dirty->first = min_insert_pos;
+	    if (edit_lpo > dirty->last_plus_one)
+		dirty->last_plus_one = edit_lpo;
+	}
+    }
+    if (chain->first_view)
+	ev_notify(chain->first_view, EV_ACTION_MATCH, NULL);
+}
@@ -11,6 +11,7 @@ Pkg_private Op_bdry_handle ev_add_op_bdry(Ev_finger_table *op_bdry, Es_index pos
 Pkg_private Op_bdry_handle ev_find_op_bdry(Ev_finger_table op_bdry, Ev_mark_object mark);
 Pkg_private unsigned ev_op_bdry_info_merge(Ev_finger_table op_bdry, register int i, int *next_i, unsigned prior);
 Pkg_private unsigned ev_op_bdry_info(Ev_finger_table op_bdry, Es_index pos, int *next_i);
+Pkg_private unsigned ev_match_info(Ev_finger_table match_bdry, Es_index pos, int *next_i);
 Pkg_private void ev_remove_op_bdry(Ev_finger_table *op_bdry, register Es_index pos, unsigned type, register unsigned mask);
 #ifdef OW_I18N
 Pkg_private void ev_remove_all_op_bdry(Ev_chain chain, register Es_index start, register Es_index end, unsigned type, register unsigned mask);
@@ -20,6 +21,9 @@ Pkg_private Ev_mark_object ev_add_glyph_on_line(register Ev_chain chain, int lin
 Pkg_private Op_bdry_handle ev_find_glyph(Ev_chain chain, Es_index line_start);
 Pkg_private void ev_remove_glyph(Ev_chain chain, Ev_mark_object mark, unsigned flags);
 Pkg_private void ev_set_glyph_pr(Ev_chain chain, Ev_mark_object mark, struct pixrect *pr);
+Pkg_private void ev_add_match(Ev_chain chain, Es_index first, Es_index last_plus_one);
+Pkg_private int ev_remove_matches(Ev_chain chain, Es_index first, Es_index last_plus_one, register Ev_range *removed);
+Pkg_private void ev_match_after_edit(Ev_chain chain, Es_index last_plus_one, Es_index delta, Es_index min_insert_pos);
 
 #endif
 
@@ -398,7 +398,7 @@ ev_display_line(view, width_before, lt_index, first, last_plus_one)
     }
     result.pos.x = rect.r_left;
     result.pos.y = rect.r_top;
-    ev_range_info(chain_private->op_bdry, first, &range);
+    ev_range_info(chain_private, first, &range);
     range.last_plus_one = MIN(range.last_plus_one, last_plus_one);
     esbuf.esh = chain->esh;
     es_set_position(esbuf.esh, first);
@@ -473,7 +473,7 @@ ev_display_line(view, width_before, lt_index, first, last_plus_one)
 	    if (esbuf.last_plus_one < last_plus_one) {
 		esbuf.buf += esbuf.sizeof_buf;
 		esbuf.first = esbuf.last_plus_one;
-		ev_range_info(chain_private->op_bdry, esbuf.first, &range);
+		ev_range_info(chain_private, esbuf.first, &range);
 		range.last_plus_one =
 		    MIN(range.last_plus_one, last_plus_one);
 	    }
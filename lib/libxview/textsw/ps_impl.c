@@ -78,14 +78,12 @@ static Es_index ps_read(Es_handle esh, unsigned int len, register CHAR *bufp, un
 static Es_index ps_debug_read(Es_handle esh, unsigned int len, register CHAR *bufp, unsigned int *resultp);
 static Es_index ps_replace(Es_handle esh, Es_index last_plus_one, int count, CHAR *buf, int *count_used);
 static Es_index ps_debug_replace(Es_handle esh, Es_index last_plus_one, int count, CHAR *buf, int *count_used);
-static Es_index write_record_header(Es_handle esh, register Piece_table private, Es_index last_plus_one, int dp_count);
 static int record_deleted_pieces(Es_handle esh, Piece pieces, int first, int last_plus_one, Es_index *next);
 static Es_index write_header_etc(Es_handle esh, register Piece_table private, Es_index last_plus_one, int count, CHAR *buf, int *count_used, Es_index *contents_start, int *deleted_pieces_length, int first_deleted, int last_plus_one_deleted);
 static Es_handle ps_pieces_for_span(Es_handle esh, Es_index first, Es_index last_plus_one, Es_handle to_recycle);
 static void copy_pieces(register ft_handle to_table, int to_index, register ft_handle from_table, int first, int last_plus_one);
 static int get_current_offset(register Piece_table private);
 static void ps_insert_pieces(Es_handle esh, Es_handle to_insert);
-static Es_index adjust_pos_after_edit(register Es_index pos, register Es_index start, register Es_index delta);
 static void ps_undo_to_mark(Es_handle esh, Es_index mark, int (*notify_proc)(), caddr_t notify_data);
 static int ps_set(Es_handle esh, Attr_attribute *attrs);
 
@@ -596,9 +594,6 @@ ps_debug_read(esh, len, bufp, resultp)
     register Es_handle current_esh;
     register Piece  pieces;
     register Piece_table private = ABS_TO_REP(esh);
-#ifdef OW_I18N
-    static CHAR    *wrap_msg_wcs;
-#endif    
 
     if (private->length - private->position < len) {
 	len = private->length - private->position;
@@ -717,45 +712,9 @@ ps_debug_read(esh, len, bufp, resultp)
 		current = private->pieces.last_plus_one;
 		INVALIDATE_CURRENT(private);
 		ASSUME(original_len <= current_pos);
-#ifdef OW_I18N
-		wrap_msg_wcs = _xv_mbstowcsdup(wrap_msg);
-		read_count = STRLEN(wrap_msg_wcs);
-#else
-		read_count = strlen(wrap_msg);
-#endif		
-		if (*resultp == 0 &&
-		    current_pos < original_len + read_count) {
-		    FILE           *console_fd;
-
-		    if (private->position < original_len + read_count)
-			read_count = private->position - original_len;
-		    read_count -= current_pos - original_len;
-		    if (len < read_count)
-			read_count = len;
-#ifdef OW_I18N
-		    BCOPY(wrap_msg_wcs + current_pos, bufp, read_count);
-#else
-		    XV_BCOPY(wrap_msg + current_pos, bufp, read_count);
-#endif
-
-		    *resultp = read_count;
-		    /* tell user that they are going to wrap */
-
-		    /* Use the same flag for console error message */
-		    if (max_transcript_alert_displayed != 1) {
-                        if(console_fd = fopen("/dev/console", "a")) {
-			    fprintf(console_fd, 
-			        XV_MSG("Text has been lost in a cmdtool transcript because the maximum edit log size has been exceeded.\n"));
-			    fflush(console_fd);
-			    max_transcript_alert_displayed = 1;
-			    fclose(console_fd);
-			}
-		    }
-		}
-#ifdef OW_I18N
-		if (wrap_msg_wcs)
-		    free((char *)wrap_msg_wcs);
-#endif
+		if (*resultp == 0)
+		    *resultp = ps_wrap_msg_read(current_pos, original_len,
+						private->position, len, bufp);
 	    }
 	    /*
 	     * All of the above code is free and easy with local variables
@@ -777,6 +736,62 @@ ps_debug_read(esh, len, bufp, resultp)
     return (private->position);
 }
 
+/*
+ * Fills bufp with the part of wrap_msg that covers a read starting at
+ * hole_start, where [original_len..next_valid) is the hole that the wrapped
+ * scratch stream has left after the leading original text.  Returns the
+ * number of entities put into bufp.
+ */
+Pkg_private int
+ps_wrap_msg_read(hole_start, original_len, next_valid, len, bufp)
+    Es_index        hole_start, original_len, next_valid;
+    unsigned int    len;
+    CHAR           *bufp;
+{
+    int             read_count;
+    FILE           *console_fd;
+#ifdef OW_I18N
+    CHAR           *wrap_msg_wcs;
+
+    wrap_msg_wcs = _xv_mbstowcsdup(wrap_msg);
+    read_count = STRLEN(wrap_msg_wcs);
+#else
+    read_count = strlen(wrap_msg);
+#endif
+    if (hole_start >= original_len + read_count) {
+	read_count = 0;
+	goto Return;
+    }
+    if (next_valid < original_len + read_count)
+	read_count = next_valid - original_len;
+    read_count -= hole_start - original_len;
+    if (len < read_count)
+	read_count = len;
+#ifdef OW_I18N
+    BCOPY(wrap_msg_wcs + hole_start, bufp, read_count);
+#else
+    XV_BCOPY(wrap_msg + hole_start, bufp, read_count);
+#endif
+    /* tell user that they are going to wrap */
+
+    /* Use the same flag for console error message */
+    if (max_transcript_alert_displayed != 1) {
+	if(console_fd = fopen("/dev/console", "a")) {
+	    fprintf(console_fd, 
+		XV_MSG("Text has been lost in a cmdtool transcript because the maximum edit log size has been exceeded.\n"));
+	    fflush(console_fd);
+	    max_transcript_alert_displayed = 1;
+	    fclose(console_fd);
+	}
+    }
+Return:
+#ifdef OW_I18N
+    if (wrap_msg_wcs)
+	free((char *)wrap_msg_wcs);
+#endif
+    return (read_count);
+}
+
 /*
  * The routines ps_replace, ps_insert_pieces, and ps_undo_to_mark all perform
  * similar functions and a fix to one needs to be reflected in the others.
@@ -1069,8 +1084,8 @@ Error_Return:
     return (ES_CANNOT_SET);
 }
 
-static          Es_index
-write_record_header(esh, private, last_plus_one, dp_count)
+Pkg_private          Es_index
+ps_write_record_header(esh, private, last_plus_one, dp_count)
     Es_handle       esh;
     register Piece_table private;
     Es_index        last_plus_one;
@@ -1146,7 +1161,7 @@ write_header_etc(esh, private, last_plus_one, count, buf, count_used,
     int             replace_used;
 
     /* Write the record header (and possibly) deleted pieces. */
-    result = write_record_header(esh, private, last_plus_one,
+    result = ps_write_record_header(esh, private, last_plus_one,
 				 last_plus_one_deleted - first_deleted);
     if (result == ES_CANNOT_SET)
 	return (ES_CANNOT_SET);
@@ -1362,7 +1377,7 @@ ps_insert_pieces(esh, to_insert)
     ASSERT(long_temp == pieces[current + last_valid + 1].pos);
     /* Write header info to scratch. */
     scratch_length = es_set_position(scratch, ES_INFINITY);
-    es_temp = write_record_header(scratch, private, private->position,
+    es_temp = ps_write_record_header(scratch, private, private->position,
 				  last_valid + 1);
     if (es_temp != ES_CANNOT_SET) {
 	/* Can modify private->... iff es_replace succeeds */
@@ -1397,8 +1412,8 @@ ps_insert_pieces(esh, to_insert)
     SET_POSITION(private, private->position + delta);
 }
 
-static          Es_index
-adjust_pos_after_edit(pos, start, delta)
+Pkg_private          Es_index
+ps_adjust_pos_after_edit(pos, start, delta)
     register Es_index pos, start, delta;
 {
     if (delta > 0)
@@ -1522,7 +1537,7 @@ ps_undo_to_mark(esh, mark, notify_proc, notify_data)
 			 current + piece_count);
 	    if (current < private->pieces.last_plus_one)
 		ft_add_delta(private->pieces, current, delta);
-	    save_pos = adjust_pos_after_edit(save_pos, current_pos, delta);
+	    save_pos = ps_adjust_pos_after_edit(save_pos, current_pos, delta);
 	    private->length += delta;
 	    if (notify_proc) {
 		scratch_pos = es_get_position(scratch);
@@ -1545,7 +1560,7 @@ ps_undo_to_mark(esh, mark, notify_proc, notify_data)
 	    pieces = PIECES_IN_TABLE(private);
 	    this_piece = &pieces[current];
 	    delta = r_header.stop_plus_one - current_pos;
-	    save_pos = adjust_pos_after_edit(save_pos, current_pos, delta);
+	    save_pos = ps_adjust_pos_after_edit(save_pos, current_pos, delta);
 	    for (i = 0; i < r_header.dp_count; i++, this_piece++) {
 	    /*
 	     *  BIG BUG:  sizeof(d_header) has to be divisable by 
@@ -1592,7 +1607,7 @@ ps_undo_to_mark(esh, mark, notify_proc, notify_data)
 	    if (current < private->pieces.last_plus_one)
 		ft_add_delta(private->pieces, current, -insert_len);
 	    save_pos =
-		adjust_pos_after_edit(save_pos, current_pos, -insert_len);
+		ps_adjust_pos_after_edit(save_pos, current_pos, -insert_len);
 	    private->length -= insert_len;
 	    if (notify_proc)
 		notify_proc(notify_data, current_pos, -insert_len);
@@ -1662,6 +1677,44 @@ va_dcl
     }
 }
 
+/*
+ * Bounds the scratch stream of esh to max_len entities by interposing the
+ * ps_scratch_* routines on its ops vector.  Any stream whose private data
+ * starts with a struct piece_table_object can use this.
+ */
+Pkg_private          Es_status
+ps_set_scratch_max_len(esh, max_len)
+    Es_handle       esh;
+    Es_index        max_len;
+{
+    register Piece_table private = ABS_TO_REP(esh);
+
+    if (max_len < SCRATCH_MIN_LEN ||
+	max_len < es_get_length(private->scratch)) {
+	return (ES_INCONSISTENT_LENGTH);
+    } else if (max_len >= ES_INFINITY) {
+	if (private->scratch_max_len != ES_INFINITY) {
+	    return (ES_INCONSISTENT_LENGTH);
+	}
+    } else if (private->scratch_max_len == ES_INFINITY) {
+	es_set(private->scratch, ES_CLIENT_DATA, esh, 0);
+	private->scratch_max_len = max_len;
+	private->scratch_length = es_get_length(private->scratch);
+	private->scratch_position = es_get_position(private->scratch);
+	/* Modify the scratch ops vector. */
+	private->scratch_ops = private->scratch->ops;
+	private->scratch->ops = (Es_ops) malloc(sizeof(struct es_ops));
+	*private->scratch->ops = *private->scratch_ops;
+	private->scratch->ops->destroy = ps_scratch_destroy;
+	private->scratch->ops->get_length = ps_scratch_get_length;
+	private->scratch->ops->get_position = ps_scratch_get_position;
+	private->scratch->ops->set_position = ps_scratch_set_position;
+	private->scratch->ops->read = ps_scratch_read;
+	private->scratch->ops->replace = ps_scratch_replace;
+    }
+    return (ES_SUCCESS);
+}
+
 static int
 ps_set(esh, attrs)
     Es_handle       esh;
@@ -1713,38 +1766,7 @@ ps_set(esh, attrs)
 	    }
 	    break;
 	  case ES_PS_SCRATCH_MAX_LEN:
-	    first = (Es_index) attrs[1];
-	    if (first < SCRATCH_MIN_LEN ||
-		first < es_get_length(private->scratch)) {
-		*status = ES_INCONSISTENT_LENGTH;
-	    } else if (first >= ES_INFINITY) {
-		if (private->scratch_max_len != ES_INFINITY) {
-		    *status = ES_INCONSISTENT_LENGTH;
-		}
-	    } else {
-		if (private->scratch_max_len == ES_INFINITY) {
-		    es_set(private->scratch, ES_CLIENT_DATA, esh, 0);
-		    private->scratch_max_len = first;
-		    private->scratch_length =
-			es_get_length(private->scratch);
-		    private->scratch_position =
-			es_get_position(private->scratch);
-		    /* Modify the scratch ops vector. */
-		    private->scratch_ops = private->scratch->ops;
-		    private->scratch->ops =
-			(Es_ops) malloc(sizeof(struct es_ops));
-		    *private->scratch->ops = *private->scratch_ops;
-		    private->scratch->ops->destroy = ps_scratch_destroy;
-		    private->scratch->ops->get_length =
-			ps_scratch_get_length;
-		    private->scratch->ops->get_position =
-			ps_scratch_get_position;
-		    private->scratch->ops->set_position =
-			ps_scratch_set_position;
-		    private->scratch->ops->read = ps_scratch_read;
-		    private->scratch->ops->replace = ps_scratch_replace;
-		}
-	    }
+	    *status = ps_set_scratch_max_len(esh, (Es_index) attrs[1]);
 	    break;
 	  case ES_STATUS:
 	    private->status = (Es_status) attrs[1];
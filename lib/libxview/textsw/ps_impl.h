@@ -60,6 +60,34 @@ typedef struct piece_table_object *Piece_table;
 #define	CURRENT_NULL	0x7FFFFFFF
 #define	SCRATCH_MIN_LEN	8096
 
+/*
+ * The piece tree (ps_tree.c) is an alternative to the finger table above:
+ * its pieces are the nodes of a rope, a binary tree ordered by position in
+ * which every node caches the total length of its subtree.  A piece's
+ * position is therefore implicit, and an edit only touches the nodes on one
+ * root-to-leaf path.  The rope is kept balanced as a treap (heap ordered on
+ * random priorities), so splitting and joining it are O(log n) expected.
+ */
+typedef struct piece_tree_node {
+	struct piece_tree_node	*left, *right;
+	Es_index	length;			/* of this piece */
+	Es_index	source_and_pos;		/* as in piece_object */
+	Es_index	weight;			/* total length of subtree */
+	unsigned int	priority;
+} Piece_tree_node;
+typedef Piece_tree_node *Pt_node;
+
+struct piece_tree_object {
+	struct piece_table_object table;	/* .pieces is unused */
+	Pt_node		root;
+	Es_index	first;			/* position of first piece */
+	Pt_node		current;		/* piece at current_pos */
+	Es_index	current_pos;		/* valid iff current */
+};
+typedef struct piece_tree_object *Piece_tree;
+#define	ABS_TO_TREE(esh)	(Piece_tree)esh->data
+#define	PT_MAGIC	0x71625354
+
 #ifdef notdef
 The original is read-only, the scratch is read-write-append.
 
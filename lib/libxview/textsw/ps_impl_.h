@@ -3,9 +3,14 @@
 
 #include <xview/pkg.h>
 #include <xview_private/es.h>
+#include <xview_private/ps_impl.h>
 
 Pkg_private Es_handle ps_create(Xv_opaque client_data, Es_handle original, Es_handle scratch);
 caddr_t _ps_get(Es_handle esh, Es_attribute attribute, ...);
+Pkg_private int ps_wrap_msg_read(Es_index hole_start, Es_index original_len, Es_index next_valid, unsigned int len, CHAR *bufp);
+Pkg_private Es_index ps_write_record_header(Es_handle esh, register Piece_table private, Es_index last_plus_one, int dp_count);
+Pkg_private Es_index ps_adjust_pos_after_edit(register Es_index pos, register Es_index start, register Es_index delta);
+Pkg_private Es_status ps_set_scratch_max_len(Es_handle esh, Es_index max_len);
 
 #endif
 
@@ -0,0 +1,1346 @@
+#ifndef lint
+#ifdef sccs
+static char     sccsid[] = "@(#)ps_tree.c 1.1 93/06/28";
+#endif
+#endif
+
+/*
+ *	(c) Copyright 1989 Sun Microsystems, Inc. Sun design patents
+ *	pending in the U.S. and foreign countries. See LEGAL NOTICE
+ *	file for terms of the license.
+ */
+
+/*
+ * Entity stream implementation for manager of two other streams, with the
+ * pieces kept in a balanced tree rather than a finger table.
+ *
+ * This is a drop-in replacement for the piece stream of ps_impl.c: it is
+ * created with the same arguments, writes the same records to the scratch
+ * stream (so UNDO and bounded scratch streams behave the same way), and
+ * answers the same attributes.  Only the representation of the pieces
+ * differs.  The finger table is a flat array, so every edit shifts its tail
+ * and adds the edit's delta to every later piece, which makes a keystroke
+ * near the top of a heavily edited document cost O(pieces).  Here the
+ * pieces are the nodes of a rope (see ps_impl.h), in which positions are
+ * implicit, so locating, splitting, inserting and deleting pieces are all
+ * O(log pieces).
+ *
+ * Every edit splits the rope at the end points of the affected range and
+ * joins the parts back together.  The scratch stream is written before the
+ * parts are joined, so a failed es_replace(scratch, ...) is backed out by
+ * joining the unchanged parts.
+ */
+
+#include <xview_private/ps_tree_.h>
+#include <xview_private/ps_impl_.h>
+#include <xview_private/attr_.h>
+#include <xview_private/gettext_.h>
+#include <stdio.h>
+#include <xview_private/portable.h>
+#include <xview_private/ps_impl.h>
+#include <xview_private/txt_18impl.h>
+#include <xview/pkg.h>
+#include <xview/attrol.h>
+#include <xview/textsw.h>
+#ifdef SVR4
+#include <stdlib.h>
+#endif /* SVR4 */
+
+static Es_handle pt_NEW(void);
+static Pt_node pt_new_node(Es_index source_and_pos, Es_index length, unsigned int priority);
+static unsigned int pt_random(void);
+static void pt_free(Pt_node tree);
+static int pt_count(Pt_node tree);
+static Pt_node pt_join(Pt_node left, Pt_node right);
+static int pt_split(Pt_node tree, Es_index pos, Pt_node *left, Pt_node *right);
+static Pt_node pt_find(Pt_node tree, Es_index pos, Es_index *start);
+static void pt_grow(Pt_node tree, Es_index pos, Es_index delta);
+static Pt_node pt_copy(Pt_node tree, Es_index first, Es_index last_plus_one, int *failed);
+static Pt_node pt_locate(Piece_tree private, Es_index pos, Es_index *start);
+static int pt_insert(Piece_tree private, Es_index pos, Pt_node pieces);
+static int pt_delete(Piece_tree private, Es_index first, Es_index last_plus_one);
+#ifdef XV_DEBUG
+static Es_index pt_pieces_are_consistent(Pt_node tree);
+#endif
+static Es_status pt_commit(Es_handle esh);
+static Es_handle pt_destroy(Es_handle esh);
+static caddr_t pt_get(Es_handle esh, Es_attribute attribute, ...);
+static Es_index pt_get_length(Es_handle esh);
+static Es_index pt_get_position(Es_handle esh);
+static Es_index pt_set_position(Es_handle esh, register Es_index pos);
+static Es_index pt_read(Es_handle esh, unsigned int len, register CHAR *bufp, unsigned int *resultp);
+static void pt_original_hole(Piece_tree private, Es_index gap);
+static void pt_scratch_hole(Piece_tree private, Es_index next_pos, unsigned int len, CHAR *bufp, unsigned int *resultp);
+static Es_index pt_replace(Es_handle esh, Es_index last_plus_one, int count, CHAR *buf, int *count_used);
+static Es_index pt_record_pieces(Es_handle esh, Pt_node tree, Es_index *next);
+static Es_index pt_write_record(Es_handle esh, Piece_tree private, Es_index last_plus_one, int count, CHAR *buf, int *count_used, Pt_node deleted, Es_index *contents_start, Es_index *deleted_length);
+static Es_handle pt_pieces_for_span(Es_handle esh, Es_index first, Es_index last_plus_one, Es_handle to_recycle);
+static Es_status pt_insert_pieces(Es_handle esh, Es_handle to_insert);
+static Es_status pt_undo_to_mark(Es_handle esh, Es_index mark, int (*notify_proc)(), caddr_t notify_data);
+static int pt_set(Es_handle esh, Attr_attribute *attrs);
+
+static struct es_ops pt_ops = {
+    pt_commit,
+    pt_destroy,
+    pt_get,
+    pt_get_length,
+    pt_get_position,
+    pt_set_position,
+    pt_read,
+    pt_replace,
+    pt_set
+};
+
+#define	PT_WEIGHT(node)					\
+	((node) ? (node)->weight : 0)
+#define	PT_FIX_WEIGHT(node)				\
+	(node)->weight = PT_WEIGHT((node)->left) + (node)->length + \
+			 PT_WEIGHT((node)->right)
+
+#define	INVALIDATE_CURRENT(private)			\
+	(private)->current = (Pt_node) 0
+
+static          Es_handle
+pt_NEW()
+{
+    Es_handle       esh = NEW(Es_object);
+    register Piece_tree private = NEW(struct piece_tree_object);
+
+    if (esh == NULL || private == NULL)
+	goto AllocFailed;
+    private->table.magic = PT_MAGIC;
+    esh->data = (caddr_t) private;
+    esh->ops = &pt_ops;
+    return (esh);
+
+AllocFailed:
+    if (private)
+	free((char *) private);
+    if (esh)
+	free((char *) esh);
+    return ((Es_handle) NULL);
+}
+
+Pkg_private          Es_handle
+ps_tree_create(client_data, original, scratch)
+    Xv_opaque       client_data;
+    Es_handle       original, scratch;
+{
+    Es_handle       esh;
+    register Piece_tree private;
+    register Piece_table table;
+
+    if (es_set_position(scratch, 0) != 0) {
+	xv_error((Xv_opaque)scratch,
+		 ERROR_STRING,
+		 XV_MSG("ps_tree_create(): cannot reset scratch stream"),
+		 ERROR_PKG, TEXTSW,
+		 NULL);
+	return (NULL);
+    }
+    if ((esh = pt_NEW()) == NULL)
+	goto AllocFailed;
+    private = ABS_TO_TREE(esh);
+    table = &private->table;
+    table->position = 0;
+    table->length = (original != ES_NULL) ? es_get_length(original) : 0;
+    if (table->length > 0) {
+	private->root = pt_new_node(
+		PS_MAKE_ORIGINAL_SANDP(es_set_position(original, 0)),
+		table->length, pt_random());
+	if (private->root == NULL) {
+	    (void) pt_destroy(esh);
+	    goto AllocFailed;
+	}
+    }
+    table->original = original;
+    table->scratch = scratch;
+    table->last_write_plus_one = ES_INFINITY;
+    table->rec_start = ES_INFINITY;
+    table->rec_insert = ES_INFINITY;
+    table->oldest_not_undone_mark = ES_INFINITY;
+    table->rec_insert_len = 0;
+    table->client_data = client_data;
+    table->scratch_max_len = ES_INFINITY;
+    /* scratch_length need not be valid, but must be < scratch_max_len */
+    table->scratch_length = 0;
+    table->scratch_ops = (Es_ops) 0;
+    table->status = ES_SUCCESS;
+    return (esh);
+
+AllocFailed:
+    xv_error((Xv_object)NULL,
+	     ERROR_STRING,
+	     XV_MSG("ps_tree_create(): alloc failure"),
+	     ERROR_PKG, TEXTSW,
+	     NULL);
+    return (NULL);
+}
+
+/*
+ * Rope primitives.  Positions passed to these are relative to the start of
+ * the (sub)tree; zero-length pieces are never kept in a tree.
+ */
+
+static          Pt_node
+pt_new_node(source_and_pos, length, priority)
+    Es_index        source_and_pos, length;
+    unsigned int    priority;
+{
+    register Pt_node node = NEW(Piece_tree_node);
+
+    if (node) {
+	node->source_and_pos = source_and_pos;
+	node->length = node->weight = length;
+	node->priority = priority;
+    }
+    return (node);
+}
+
+static unsigned int
+pt_random()
+{
+    static unsigned int seed = 0x2545f491;
+
+    seed ^= seed << 13;
+    seed ^= seed >> 17;
+    seed ^= seed << 5;
+    return (seed);
+}
+
+static void
+pt_free(tree)
+    register Pt_node tree;
+{
+    if (tree) {
+	pt_free(tree->left);
+	pt_free(tree->right);
+	free((char *) tree);
+    }
+}
+
+static int
+pt_count(tree)
+    register Pt_node tree;
+{
+    return (tree ? pt_count(tree->left) + 1 + pt_count(tree->right) : 0);
+}
+
+static          Pt_node
+pt_join(left, right)
+    register Pt_node left, right;
+/* Returns the concatenation of the pieces in left and then right. */
+{
+    if (left == NULL)
+	return (right);
+    if (right == NULL)
+	return (left);
+    if (left->priority >= right->priority) {
+	left->right = pt_join(left->right, right);
+	PT_FIX_WEIGHT(left);
+	return (left);
+    } else {
+	right->left = pt_join(left, right->left);
+	PT_FIX_WEIGHT(right);
+	return (right);
+    }
+}
+
+static int
+pt_split(tree, pos, left, right)
+    register Pt_node tree;
+    Es_index        pos;
+    Pt_node        *left, *right;
+/*
+ * Splits tree into the pieces before pos and those from pos on, splitting
+ * the piece that straddles pos in two.  Returns 0, with tree untouched, iff
+ * that needs a node and none can be allocated; the allocation is the last
+ * step of the descent, so nothing has been modified at that point.
+ */
+{
+    register Es_index offset;
+    Pt_node         tail;
+
+    if (tree == NULL) {
+	*left = *right = NULL;
+	return (1);
+    }
+    offset = pos - PT_WEIGHT(tree->left);
+    if (offset <= 0) {
+	if (!pt_split(tree->left, pos, left, &tail))
+	    return (0);
+	tree->left = tail;
+	PT_FIX_WEIGHT(tree);
+	*right = tree;
+    } else if (offset >= tree->length) {
+	if (!pt_split(tree->right, offset - tree->length, &tail, right))
+	    return (0);
+	tree->right = tail;
+	PT_FIX_WEIGHT(tree);
+	*left = tree;
+    } else {
+	/* The priority of tree keeps tail above tree's right subtree. */
+	tail = pt_new_node((Es_index) 0, tree->length - offset,
+			   tree->priority);
+	if (tail == NULL)
+	    return (0);
+	PS_SET_SANDP(*tail, PS_SANDP_POS(*tree) + offset,
+		     PS_SANDP_SOURCE(*tree));
+	tail->right = tree->right;
+	PT_FIX_WEIGHT(tail);
+	tree->right = NULL;
+	tree->length = offset;
+	PT_FIX_WEIGHT(tree);
+	*left = tree;
+	*right = tail;
+    }
+    return (1);
+}
+
+static          Pt_node
+pt_find(tree, pos, start)
+    register Pt_node tree;
+    register Es_index pos;
+    Es_index       *start;
+/* Returns the piece containing pos, and its position in *start. */
+{
+    register Es_index skipped = 0;
+
+    while (tree) {
+	if (pos < PT_WEIGHT(tree->left)) {
+	    tree = tree->left;
+	    continue;
+	}
+	pos -= PT_WEIGHT(tree->left);
+	skipped += PT_WEIGHT(tree->left);
+	if (pos < tree->length) {
+	    *start = skipped;
+	    return (tree);
+	}
+	pos -= tree->length;
+	skipped += tree->length;
+	tree = tree->right;
+    }
+    return ((Pt_node) 0);
+}
+
+static void
+pt_grow(tree, pos, delta)
+    register Pt_node tree;
+    register Es_index pos;
+    Es_index        delta;
+/* Lengthens the piece containing pos by delta. */
+{
+    while (tree) {
+	tree->weight += delta;
+	if (pos < PT_WEIGHT(tree->left)) {
+	    tree = tree->left;
+	    continue;
+	}
+	pos -= PT_WEIGHT(tree->left);
+	if (pos < tree->length) {
+	    tree->length += delta;
+	    return;
+	}
+	pos -= tree->length;
+	tree = tree->right;
+    }
+    ASSERT(0);
+}
+
+static          Pt_node
+pt_copy(tree, first, last_plus_one, failed)
+    register Pt_node tree;
+    Es_index        first, last_plus_one;
+    int            *failed;
+/*
+ * Returns a copy of the pieces of tree in [first..last_plus_one), trimming
+ * the pieces at either end.  The copy keeps the priorities, so it is a
+ * valid treap.  If a node cannot be allocated *failed is set and the
+ * partial copy must be freed by the caller.
+ */
+{
+    register Pt_node copy;
+    Es_index        start, stop_plus_one, offset;
+
+    if (tree == NULL || first >= last_plus_one)
+	return ((Pt_node) 0);
+    start = PT_WEIGHT(tree->left);
+    stop_plus_one = start + tree->length;
+    if (last_plus_one <= start)
+	return (pt_copy(tree->left, first, last_plus_one, failed));
+    if (first >= stop_plus_one)
+	return (pt_copy(tree->right, first - stop_plus_one,
+			last_plus_one - stop_plus_one, failed));
+    offset = (first > start) ? first - start : 0;
+    copy = pt_new_node((Es_index) 0,
+		       ((last_plus_one < stop_plus_one) ?
+			last_plus_one : stop_plus_one) - start - offset,
+		       tree->priority);
+    if (copy == NULL) {
+	*failed = TRUE;
+	return ((Pt_node) 0);
+    }
+    PS_SET_SANDP(*copy, PS_SANDP_POS(*tree) + offset,
+		 PS_SANDP_SOURCE(*tree));
+    copy->left = pt_copy(tree->left, first, start, failed);
+    copy->right = pt_copy(tree->right, (Es_index) 0,
+			  last_plus_one - stop_plus_one, failed);
+    PT_FIX_WEIGHT(copy);
+    return (copy);
+}
+
+#ifdef XV_DEBUG
+static          Es_index
+pt_pieces_are_consistent(tree)
+    register Pt_node tree;
+/* Returns the weight of tree after checking it. */
+{
+    Es_index        weight;
+
+    if (tree == NULL)
+	return (0);
+    ASSUME(0 < tree->length);
+    ASSUME(tree->left == NULL || tree->left->priority <= tree->priority);
+    ASSUME(tree->right == NULL || tree->right->priority <= tree->priority);
+    weight = pt_pieces_are_consistent(tree->left) + tree->length +
+	pt_pieces_are_consistent(tree->right);
+    ASSUME(weight == tree->weight);
+    return (weight);
+}
+
+#endif
+
+/*
+ * Operations on the rope of a stream.  Positions passed to these are
+ * positions in the stream, which for a stream made by ES_HANDLE_FOR_SPAN
+ * start at private->first.
+ */
+
+static          Pt_node
+pt_locate(private, pos, start)
+    register Piece_tree private;
+    Es_index        pos, *start;
+/*
+ * Returns the piece containing pos, and its position in *start.  The piece
+ * is remembered, so sequential reads do not descend the tree each time.
+ */
+{
+    register Pt_node node = private->current;
+
+    if (node && private->current_pos <= pos &&
+	pos < private->current_pos + node->length) {
+	*start = private->current_pos;
+	return (node);
+    }
+    node = pt_find(private->root, pos - private->first, start);
+    if (node) {
+	*start += private->first;
+	private->current = node;
+	private->current_pos = *start;
+    }
+    return (node);
+}
+
+static int
+pt_insert(private, pos, pieces)
+    register Piece_tree private;
+    Es_index        pos;
+    Pt_node         pieces;
+/* Inserts the tree pieces at pos; returns 0 iff out of memory. */
+{
+    Pt_node         left, right;
+
+    if (pieces == NULL)
+	return (1);
+    if (!pt_split(private->root, pos - private->first, &left, &right))
+	return (0);
+    private->root = pt_join(pt_join(left, pieces), right);
+    INVALIDATE_CURRENT(private);
+    return (1);
+}
+
+static int
+pt_delete(private, first, last_plus_one)
+    register Piece_tree private;
+    Es_index        first, last_plus_one;
+/* Deletes the pieces in [first..last_plus_one); returns 0 iff out of memory. */
+{
+    Pt_node         left, middle, right;
+
+    if (first >= last_plus_one)
+	return (1);
+    first -= private->first;
+    last_plus_one -= private->first;
+    if (!pt_split(private->root, first, &left, &right))
+	return (0);
+    if (!pt_split(right, last_plus_one - first, &middle, &right)) {
+	private->root = pt_join(left, right);
+	return (0);
+    }
+    pt_free(middle);
+    private->root = pt_join(left, right);
+    INVALIDATE_CURRENT(private);
+    return (1);
+}
+
+/* ARGSUSED */
+static          Es_status
+pt_commit(esh)
+    Es_handle       esh;
+{
+    return (ES_SUCCESS);
+}
+
+static          Es_handle
+pt_destroy(esh)
+    Es_handle       esh;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+
+    free((char *) esh);
+    pt_free(private->root);
+    free((char *) private);
+    return NULL;
+}
+
+static          Es_index
+pt_get_length(esh)
+    Es_handle       esh;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    return (private->table.length);
+}
+
+static          Es_index
+pt_get_position(esh)
+    Es_handle       esh;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    return (private->table.position);
+}
+
+static          Es_index
+pt_set_position(esh, pos)
+    Es_handle       esh;
+    register Es_index pos;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+
+    if (pos > private->table.length) {
+	ASSUME(pos == ES_INFINITY || private->table.parent);
+	pos = private->table.length;
+    } else if (pos < private->first) {
+	pos = private->first;
+    }
+    private->table.position = pos;
+    return (private->table.position);
+}
+
+static          Es_index
+pt_read(esh, len, bufp, resultp)
+    Es_handle       esh;
+    unsigned int    len;
+    register CHAR  *bufp;
+    unsigned int   *resultp;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_table table = &private->table;
+    register Pt_node node;
+    register Es_index delta;
+    register Es_handle current_esh;
+    Es_index        start, current_pos, next_pos;
+    int             read_count, to_read;
+
+    if (table->length - table->position < len) {
+	len = table->length - table->position;
+    }
+    *resultp = 0;
+    while (len > 0 &&
+	   (node = pt_locate(private, table->position, &start)) != NULL) {
+	delta = table->position - start;
+	current_esh = (PS_SANDP_SOURCE(*node) ?
+		       table->scratch : table->original);
+	current_pos = PS_SANDP_POS(*node) + delta;
+	next_pos = es_set_position(current_esh, current_pos);
+	ASSERT(next_pos == current_pos);
+	to_read = node->length - delta;
+	if (to_read > len)
+	    to_read = len;
+	next_pos = es_read(current_esh, to_read, bufp, &read_count);
+	/*
+	 * BUG ALERT!  If we ever support entities that are not bytes, the
+	 * following addition must have a "* es_get(current_esh,
+	 * ES_SIZE_OF_ENTITY)"
+	 */
+	bufp += read_count;
+	len -= read_count;
+	*resultp += read_count;
+	table->position += read_count;
+	if (read_count < to_read) {
+	    if (current_esh == table->original) {
+		pt_original_hole(private,
+				 next_pos - (current_pos + read_count));
+	    } else {
+		ASSUME(read_count == 0);
+		pt_scratch_hole(private, next_pos, len, bufp, resultp);
+	    }
+	    /* As in ps_impl.c, a short read ends the read. */
+	    break;
+	}
+    }
+    ASSUME(pt_pieces_are_consistent(private->root) ==
+	   table->length - private->first);
+    return (table->position);
+}
+
+static void
+pt_original_hole(private, gap)
+    register Piece_tree private;
+    Es_index        gap;
+/*
+ * The original entity stream has holes in it, and the initialization
+ * assumed it was contiguous, so the piece at the current position must
+ * start gap entities further on in the original, and be that much shorter.
+ */
+{
+    register Piece_table table = &private->table;
+    Pt_node         left, piece, right;
+    Es_index        start, pos = table->position - private->first;
+
+    piece = pt_find(private->root, pos, &start);
+    if (piece == NULL || !pt_split(private->root, pos, &left, &right))
+	return;
+    /* The rest of the piece now starts right, so no node is needed. */
+    (void) pt_split(right, start + piece->length - pos, &piece, &right);
+    ASSERT(piece && piece->left == NULL && piece->right == NULL);
+    if (gap >= piece->length) {
+	gap = piece->length;
+	free((char *) piece);
+	piece = NULL;
+    } else {
+	piece->length -= gap;
+	PS_SET_ORIGINAL_SANDP(*piece, PS_SANDP_POS(*piece) + gap);
+	PT_FIX_WEIGHT(piece);
+    }
+    private->root = pt_join(pt_join(left, piece), right);
+    INVALIDATE_CURRENT(private);
+    table->length -= gap;
+}
+
+static void
+pt_scratch_hole(private, next_pos, len, bufp, resultp)
+    register Piece_tree private;
+    Es_index        next_pos;
+    unsigned int    len;
+    CHAR           *bufp;
+    unsigned int   *resultp;
+/*
+ * The scratch entity stream has wrapped around, making a hole from
+ * [0..scratch_first_valid), and next_pos is the first valid scratch index.
+ * Moves the position to the next piece that references valid scratch
+ * indices (WARNING: there may not be one), and combines the pieces skipped
+ * over as these are now completely invalid.  If nothing has been read yet,
+ * the wrap message is read instead.
+ */
+{
+    register Piece_table table = &private->table;
+    register Pt_node node;
+    register Es_index delta;
+    Es_index        hole_start = table->position;
+    Es_index        start, pos, original_len;
+    Es_index        invalid_start, invalid_stop_plus_one, invalid_sandp;
+    int             invalid_count = 0;
+
+    ASSUME(SCRATCH_HAS_WRAPPED(table) ||
+	   (table->parent &&
+	    SCRATCH_HAS_WRAPPED(ABS_TO_REP(table->parent))));
+    invalid_start = invalid_stop_plus_one = hole_start;
+    invalid_sandp = 0;
+    for (pos = hole_start; (node = pt_locate(private, pos, &start)) != NULL;
+	 pos = start + node->length) {
+	if (!PS_SANDP_SOURCE(*node)) {
+	    table->position = start;
+	    break;
+	}
+	delta = PS_SANDP_POS(*node);
+	if (delta >= next_pos) {
+	    /*
+	     * next_pos not referenced by pieces => go to start this piece,
+	     * which is first beyond next_pos
+	     */
+	    next_pos = delta;
+	} else if (next_pos >= delta + node->length) {
+	    if (invalid_count++ == 0) {
+		invalid_start = start;
+		invalid_sandp = node->source_and_pos;
+	    }
+	    invalid_stop_plus_one = start + node->length;
+	    continue;
+	}
+	table->position = (next_pos - delta) + start;
+	break;
+    }
+    if (node == NULL)
+	table->position = table->length;
+    /*
+     * Although the pieces are correct it speeds up later reads if "runs of
+     * now invalid scratch references" are combined.
+     */
+    if (invalid_count > 1 &&
+	(node = pt_new_node(invalid_sandp,
+			    invalid_stop_plus_one - invalid_start,
+			    pt_random())) != NULL) {
+	/* Both are at piece boundaries, so neither needs a node. */
+	(void) pt_delete(private, invalid_start, invalid_stop_plus_one);
+	(void) pt_insert(private, invalid_start, node);
+    }
+    /*
+     * A read at the beginning of the scratch stream which tries to read out
+     * of the start of the hole should give the client (an appropriate part
+     * of) wrap_msg.
+     */
+    if (*resultp != 0)
+	return;
+    original_len = private->first;
+    for (pos = private->first;
+	 (node = pt_locate(private, pos, &start)) != NULL &&
+	 !PS_SANDP_SOURCE(*node);
+	 pos = start + node->length)
+	original_len = start + node->length;
+    ASSUME(original_len <= hole_start);
+    *resultp = ps_wrap_msg_read(hole_start, original_len, table->position,
+				len, bufp);
+}
+
+/*
+ * The routines pt_replace, pt_insert_pieces, and pt_undo_to_mark must
+ * write and read the same scratch records as their ps_impl.c counterparts.
+ */
+static          Es_index
+pt_replace(esh, last_plus_one, count, buf, count_used)
+    Es_handle       esh;
+    Es_index        last_plus_one;
+    int             count, *count_used;
+    CHAR           *buf;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_table table = &private->table;
+    register Es_handle scratch;
+    Es_index        scratch_length, es_temp, new_rec_insert;
+    Es_index        delta, deleted_length = 0, pos;
+    Pt_node         left, middle, right, node = NULL;
+    int             long_temp;
+    int             replace_used;
+
+    *count_used = 0;
+    if (buf == NULL && count != 0) {
+	table->status = ES_INVALID_ARGUMENTS;
+	return (ES_CANNOT_SET);
+    }
+    if (table->parent != NULL) {
+	table->status = ES_INVALID_HANDLE;
+	return (ES_CANNOT_SET);
+    }
+    scratch = table->scratch;
+    scratch_length = es_set_position(scratch, ES_INFINITY);
+    if (last_plus_one > table->length) {
+	last_plus_one = table->length;
+    }
+    ASSUME(last_plus_one >= table->position);
+    pos = table->position;
+    if (last_plus_one <= pos && count == 0) {
+	/* Nothing replaced by nothing => leave well enough alone! */
+	return (pos);
+    }
+    INVALIDATE_CURRENT(private);
+    if (last_plus_one <= pos && pos == table->last_write_plus_one &&
+	table->length != 0) {
+	/*
+	 * Extension of the previous replace: its inserted text is at the
+	 * end of the scratch stream, so just append to it.  As in ps_impl.c,
+	 * an empty stream always starts a new record.
+	 */
+	if (table->rec_insert_len == 0) {
+	    /* Last replace was a delete, so no scratch piece exists */
+	    node = pt_new_node((Es_index) 0, (Es_index) count, pt_random());
+	    if (node == NULL || !pt_split(private->root, pos, &left, &right))
+		goto Alloc_Failed;
+	}
+	es_temp = es_replace(scratch, ES_INFINITY, count, buf, count_used);
+	if (es_temp == ES_CANNOT_SET) {
+	    if (node)
+		private->root = pt_join(left, right);
+	    goto Error_Return;
+	}
+	ASSUME(count == *count_used);
+	if (node) {
+	    PS_SET_SCRATCH_SANDP(*node,
+				 table->rec_insert + SIZEOF(long_temp));
+	    private->root = pt_join(pt_join(left, node), right);
+	} else {
+	    pt_grow(private->root, pos - 1, (Es_index) count);
+	}
+	delta = count;		/* total change to length */
+	table->rec_insert_len += count;
+	/* Correct the insert length */
+	long_temp = table->rec_insert_len;
+	es_temp = es_set_position(scratch, table->rec_insert);
+	ASSERT(es_temp == table->rec_insert);
+	/*
+	 *  BIG BUG:  sizeof(long_temp) has to be divisable by sizeof(CHAR)
+	 */
+	es_temp = es_replace(scratch,
+			     table->rec_insert + SIZEOF(long_temp),
+			     SIZEOF(long_temp), (CHAR *) &long_temp,
+			     &replace_used);
+    } else {
+	/* Split out the pieces to be replaced, and a piece for the new. */
+	if (count != 0 &&
+	    (node = pt_new_node((Es_index) 0, (Es_index) count,
+				pt_random())) == NULL)
+	    goto Alloc_Failed;
+	if (!pt_split(private->root, pos, &left, &right))
+	    goto Alloc_Failed;
+	if (!pt_split(right, last_plus_one - pos, &middle, &right)) {
+	    private->root = pt_join(left, right);
+	    goto Alloc_Failed;
+	}
+	/*
+	 * Make sure all es_replace(scratch, ...) succeed before modifying
+	 * private->... any further.
+	 */
+	new_rec_insert =
+	    pt_write_record(scratch, private, last_plus_one, count, buf,
+			    count_used, middle, &es_temp, &deleted_length);
+	if (new_rec_insert == ES_CANNOT_SET) {
+	    private->root = pt_join(pt_join(left, middle), right);
+	    if (node)
+		free((char *) node);
+	    goto Error_Return;
+	}
+	pt_free(middle);
+	if (node) {
+	    ASSERT(es_temp == new_rec_insert + SIZEOF(long_temp));
+	    PS_SET_SCRATCH_SANDP(*node, es_temp);
+	}
+	private->root = pt_join(pt_join(left, node), right);
+	delta = count - deleted_length;	/* total change to length */
+	table->rec_insert = new_rec_insert;
+	table->rec_insert_len = count;
+	table->rec_start = scratch_length;
+	if (table->oldest_not_undone_mark == ES_INFINITY)
+	    table->oldest_not_undone_mark = scratch_length;
+	ASSUME(count == *count_used);
+    }
+    /* Adjust position, etc. to reflect the overall replace */
+    table->length += delta;
+    table->position = pos + count;
+    table->last_write_plus_one = table->position;
+    ASSUME(pt_pieces_are_consistent(private->root) == table->length);
+    return (table->position);
+
+Alloc_Failed:
+    if (node)
+	free((char *) node);
+    table->status = ES_CHECK_ERRNO;
+    return (ES_CANNOT_SET);
+
+Error_Return:
+    table->status = (Es_status) es_get(scratch, ES_STATUS);
+    /*
+     * Copy scratch status first in case attempt to "back out" failed
+     * es_replace's modify the status.
+     */
+    (void) es_set_position(scratch, scratch_length);
+    (void) es_replace(scratch, ES_INFINITY, 0, (CHAR *)NULL, count_used);
+    ASSUME(pt_pieces_are_consistent(private->root) == table->length);
+    return (ES_CANNOT_SET);
+}
+
+static          Es_index
+pt_record_pieces(esh, tree, next)
+    Es_handle       esh;
+    register Pt_node tree;
+    Es_index       *next;
+/*
+ * Appends a deleted_piece for each of the pieces in tree, in order, to esh.
+ * Returns their total length; *next is left at ES_CANNOT_SET if an
+ * es_replace fails.
+ */
+{
+    struct deleted_piece d_header;
+    Es_index        result;
+    int             dummy;
+
+    if (tree == NULL || *next == ES_CANNOT_SET)
+	return (0);
+    result = pt_record_pieces(esh, tree->left, next);
+    if (*next == ES_CANNOT_SET)
+	return (result);
+    d_header.source_and_pos = tree->source_and_pos;
+    result += (d_header.length = tree->length);
+    /*
+     *  BIG BUG:  This is a very bad hack.  If sizeof(d_header)
+     *  is not divisable by sizeof(CHAR), then we will be in big problem.
+     */
+    *next = es_replace(esh, ES_INFINITY,
+		       SIZEOF(d_header), (CHAR *) &d_header, &dummy);
+    return (result + pt_record_pieces(esh, tree->right, next));
+}
+
+/* Returns the new value for private->table.rec_insert */
+static          Es_index
+pt_write_record(esh, private, last_plus_one, count, buf, count_used,
+		deleted, contents_start, deleted_length)
+    register Es_handle esh;
+    register Piece_tree private;
+    Es_index        last_plus_one;
+    int             count;
+    CHAR           *buf;
+    int            *count_used;
+    Pt_node         deleted;
+    Es_index       *contents_start, *deleted_length;
+{
+    Es_index        result;
+    int             replace_used;
+
+    /* Write the record header (and possibly) deleted pieces. */
+    result = ps_write_record_header(esh, &private->table, last_plus_one,
+				    pt_count(deleted));
+    if (result == ES_CANNOT_SET)
+	return (ES_CANNOT_SET);
+    *deleted_length = pt_record_pieces(esh, deleted, &result);
+    if (result == ES_CANNOT_SET)
+	return (ES_CANNOT_SET);
+    /*
+     *  BIG BUG:  sizeof(count) has to be divisable by sizeof(CHAR)
+     */
+    *contents_start =
+	es_replace(esh, ES_INFINITY, SIZEOF(count),
+		   (CHAR *) &count, &replace_used);
+    if (*contents_start == ES_CANNOT_SET)
+	return (ES_CANNOT_SET);
+    /* Do the insert */
+    if (count != 0 &&
+	es_replace(esh, ES_INFINITY, count, buf, count_used) ==
+	ES_CANNOT_SET)
+	return (ES_CANNOT_SET);
+    return (result);
+}
+
+static          Es_handle
+pt_pieces_for_span(esh, first, last_plus_one, to_recycle)
+    Es_handle       esh;
+    Es_index        first, last_plus_one;
+    Es_handle       to_recycle;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_tree r_private;
+    Es_handle       result;
+    int             failed = FALSE;
+
+    if (last_plus_one > private->table.length)
+	last_plus_one = private->table.length;
+    if (first < private->first)
+	first = private->first;
+    if (first >= last_plus_one) {
+	goto Bad_Args;
+    }
+    if (to_recycle) {
+	result = to_recycle;
+	r_private = ABS_TO_TREE(result);
+	ASSUME(r_private->table.magic == PT_MAGIC &&
+	       r_private->table.parent == esh);
+	pt_free(r_private->root);
+	r_private->root = NULL;
+	INVALIDATE_CURRENT(r_private);
+    } else {
+	result = pt_NEW();
+	if (result == (Es_handle) 0)
+	    return (result);
+	r_private = ABS_TO_TREE(result);
+	r_private->table.parent = esh;
+	r_private->table.original = private->table.original;
+	r_private->table.scratch = private->table.scratch;
+	r_private->table.last_write_plus_one = r_private->table.rec_insert =
+	    r_private->table.rec_start = ES_CANNOT_SET;
+	r_private->table.rec_insert_len = -1;
+    }
+    r_private->root = pt_copy(private->root, first - private->first,
+			      last_plus_one - private->first, &failed);
+    if (failed) {
+	es_destroy(result);
+	return ((Es_handle) 0);
+    }
+    r_private->first = first;
+    r_private->table.position = first;
+    r_private->table.length = last_plus_one;
+    return (result);
+
+Bad_Args:
+    if (to_recycle)
+	es_destroy(to_recycle);
+    return ((Es_handle) 0);
+}
+
+static          Es_status
+pt_insert_pieces(esh, to_insert)
+    Es_handle       esh, to_insert;
+/*
+ * Inserts the pieces of to_insert, which must have been made by
+ * ES_HANDLE_FOR_SPAN on a stream with the same scratch stream.  As in
+ * ps_impl.c, the scratch record has start == stop_plus_one and the inserted
+ * pieces as its deleted pieces.
+ */
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_table table = &private->table;
+    register Es_handle scratch = table->scratch;
+    Piece_tree      insert = ABS_TO_TREE(to_insert);
+    Pt_node         pieces;
+    Es_index        scratch_length, es_temp, delta;
+    int             failed = FALSE;
+    int             long_temp;
+    int             replace_used;
+
+    pieces = pt_copy(insert->root, (Es_index) 0, PT_WEIGHT(insert->root),
+		     &failed);
+    if (failed) {
+	pt_free(pieces);
+	return (ES_CHECK_ERRNO);
+    }
+    if (pieces == NULL)
+	return (ES_SUCCESS);
+    delta = pieces->weight;
+    /* Write the record before the pieces are joined into the rope. */
+    scratch_length = es_set_position(scratch, ES_INFINITY);
+    es_temp = ps_write_record_header(scratch, table, table->position,
+				     pt_count(pieces));
+    if (es_temp != ES_CANNOT_SET) {
+	(void) pt_record_pieces(scratch, pieces, &es_temp);
+    }
+    if (es_temp != ES_CANNOT_SET) {
+	/* Can modify private->... iff es_replace succeeds */
+	table->rec_insert = es_temp;
+	table->rec_start = scratch_length;
+	if (table->oldest_not_undone_mark == ES_INFINITY)
+	    table->oldest_not_undone_mark = scratch_length;
+	long_temp = 0;
+	/*
+	 * BIG BUG:  sizeof(long_temp) has to be divisable by sizeof(CHAR)
+	 */
+	(void) es_replace(scratch, ES_INFINITY,
+			  SIZEOF(long_temp), (CHAR *) &long_temp,
+			  &replace_used);
+    }
+    if (!pt_insert(private, table->position, pieces)) {
+	pt_free(pieces);
+	return (ES_CHECK_ERRNO);
+    }
+    /* Adjust position, etc. to reflect the overall replace */
+    table->last_write_plus_one = ES_INFINITY;
+    table->length += delta;
+    table->position += delta;
+    return (ES_SUCCESS);
+}
+
+static          Es_status
+pt_undo_to_mark(esh, mark, notify_proc, notify_data)
+    Es_handle       esh;
+    Es_index        mark;
+    int             (*notify_proc) ();
+    caddr_t         notify_data;
+/*
+ * The notify_proc gets called with the notify_data, the start of the
+ * affected range, and the delta.  Thus a negative delta means
+ * [start..start-delta) contains the affected positions, while a positive
+ * delta indicates an insertion of entities to fill the range
+ * [start..start+delta).
+ */
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_table table = &private->table;
+    register Es_handle scratch = table->scratch;
+    register Es_index current_pos, scratch_pos;
+    Es_index        save_pos = table->position;
+    Es_index        delta, mark_pos = mark;
+    struct piece_record_header r_header;
+    struct deleted_piece d_header;
+    Pt_node         pieces, node;
+    Es_status       status = ES_SUCCESS;
+    int             i;
+    int             read;
+    int             insert_len;
+
+    if (es_get_length(scratch) == 0)
+	return (status);
+    /*
+     * For a bounded scratch stream, the mark_pos may now be invalid and need
+     * to be adjusted.  The new value need not be exactly at a record header
+     * (luckily, else all of the record headers would have to be read twice).
+     */
+    if (SCRATCH_HAS_WRAPPED(table) &&
+	mark_pos < SCRATCH_FIRST_VALID(table)) {
+	mark_pos = SCRATCH_FIRST_VALID(table);
+    }
+    /* Read back the information from the scratch source and undo it */
+    for (; (table->rec_start != ES_INFINITY) &&
+	 (table->rec_start >= mark_pos);
+	 table->rec_start = r_header.pos_prev_rec) {
+	(void) es_set_position(scratch, table->rec_start);
+	/*
+	 *  BIG BUG:  sizeof(r_header) has to be divisable by sizeof(CHAR)
+	 */
+	(void) es_read(scratch, SIZEOF(r_header),
+		       (CHAR *) &r_header, &read);
+	ASSUME(read == SIZEOF(r_header));
+	/*
+	 * Check to see if piece is flagged as already undone. If not, make
+	 * sure it is flagged now.
+	 */
+	if (r_header.flags & PS_ALREADY_UNDONE)
+	    continue;
+	r_header.flags |= PS_ALREADY_UNDONE;
+	(void) es_set_position(scratch, table->rec_start);
+	/*
+	 *  BIG BUG:  sizeof(r_header) has to be divisable by sizeof(CHAR)
+	 */
+	(void) es_replace(scratch, table->rec_start + SIZEOF(r_header),
+			  SIZEOF(r_header), (CHAR *) &r_header, &read);
+	ASSUME(read == SIZEOF(r_header));
+	if (table->oldest_not_undone_mark == table->rec_start)
+	    table->oldest_not_undone_mark = ES_INFINITY;
+	current_pos = r_header.start;
+	if ((r_header.start == r_header.stop_plus_one) &&
+	    (r_header.dp_count != 0)) {
+	    /*
+	     * Remove the inserted pieces.  As later edits may have split
+	     * them, only their total length is used.
+	     */
+	    for (delta = 0, i = r_header.dp_count; i > 0; i--) {
+		/*
+		 *  BIG BUG:  sizeof(d_header) has to be divisable
+		 *  by sizeof(CHAR)sizeof
+		 */
+		(void) es_read(scratch, SIZEOF(d_header),
+			       (CHAR *) &d_header, &read);
+		delta -= d_header.length;
+	    }
+	    if (!pt_delete(private, current_pos, current_pos - delta)) {
+		status = ES_CHECK_ERRNO;
+		break;
+	    }
+	    save_pos = ps_adjust_pos_after_edit(save_pos, current_pos, delta);
+	    table->length += delta;
+	    if (notify_proc) {
+		scratch_pos = es_get_position(scratch);
+		notify_proc(notify_data, current_pos, delta);
+		(void) es_set_position(scratch, scratch_pos);
+	    }
+	} else {
+	    /* Put back the deleted pieces */
+	    for (pieces = NULL, i = 0; i < r_header.dp_count; i++) {
+		/*
+		 *  BIG BUG:  sizeof(d_header) has to be divisable by
+		 *  sizeof(CHAR)sizeof
+		 */
+		(void) es_read(scratch, SIZEOF(d_header),
+			       (CHAR *) &d_header, &read);
+		node = pt_new_node((Es_index) d_header.source_and_pos,
+				   (Es_index) d_header.length, pt_random());
+		if (node == NULL)
+		    break;
+		pieces = pt_join(pieces, node);
+		current_pos += d_header.length;
+	    }
+	    if (i < r_header.dp_count || !pt_insert(private, r_header.start,
+						    pieces)) {
+		pt_free(pieces);
+		status = ES_CHECK_ERRNO;
+		break;
+	    }
+	    ASSERT(current_pos == r_header.stop_plus_one);
+	    delta = r_header.stop_plus_one - r_header.start;
+	    save_pos = ps_adjust_pos_after_edit(save_pos, r_header.start,
+						delta);
+	    if (delta != 0) {	/* 0 iff no deleted pieces. */
+		table->length += delta;
+		if (notify_proc) {
+		    scratch_pos = es_get_position(scratch);
+		    notify_proc(notify_data, r_header.start, delta);
+		    (void) es_set_position(scratch, scratch_pos);
+		}
+	    }
+	}
+	/*
+	 *  BIG BUG:  sizeof(insert_len) has to be divisable by
+	 *  sizeof(CHAR)sizeof
+	 */
+	(void) es_read(scratch, SIZEOF(insert_len),
+		       (CHAR *) &insert_len, &read);
+	if (insert_len > 0) {
+	    /*
+	     * Remove the inserted text. Note that the user sequence: type-in
+	     * edit-char type-in ... can cause this insert to span multiple
+	     * pieces.
+	     */
+	    if (!pt_delete(private, current_pos, current_pos + insert_len)) {
+		status = ES_CHECK_ERRNO;
+		break;
+	    }
+	    save_pos =
+		ps_adjust_pos_after_edit(save_pos, current_pos, -insert_len);
+	    table->length -= insert_len;
+	    if (notify_proc)
+		notify_proc(notify_data, current_pos, -insert_len);
+	}
+	ASSUME(pt_pieces_are_consistent(private->root) == table->length);
+    }
+    (void) es_set_position(scratch, ES_INFINITY);
+    table->position = save_pos;
+    table->last_write_plus_one = ES_INFINITY;
+    return (status);
+}
+
+static          caddr_t
+#ifdef ANSI_FUNC_PROTO
+pt_get(Es_handle esh, Es_attribute attribute, ...)
+#else
+pt_get(esh, attribute, va_alist)
+    Es_handle       esh;
+    Es_attribute    attribute;
+va_dcl
+#endif
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_table table = &private->table;
+    Es_index        first, last_plus_one;
+    Es_handle       pieces_for_span, to_recycle;
+    va_list         args;
+
+    if ((table->magic != PT_MAGIC) && (attribute != ES_TYPE))
+	return ((caddr_t) 0);
+    switch (attribute) {
+      case ES_CLIENT_DATA:
+	return ((caddr_t) table->client_data);
+      case ES_UNDO_MARK:
+	table->last_write_plus_one = ES_INFINITY;
+	/* +1 below is because 0 == ES_NULL_UNDO_MARK */
+	return ((caddr_t) (es_get_length(table->scratch) + 1));
+      case ES_HANDLE_FOR_SPAN:
+	VA_START(args, attribute);
+#ifdef lint
+	first = (args ? 0 : 0);
+	last_plus_one = 0;
+	to_recycle = 0;
+#else
+	first = va_arg(args, Es_index);
+	last_plus_one = va_arg(args, Es_index);
+	to_recycle = va_arg(args, Es_handle);
+#endif
+	pieces_for_span =
+	    pt_pieces_for_span(esh, first, last_plus_one, to_recycle);
+	va_end(args);
+	return ((caddr_t) pieces_for_span);
+      case ES_HAS_EDITS:
+	return ((caddr_t)(long)(table->oldest_not_undone_mark != ES_INFINITY));
+      case ES_PS_ORIGINAL:
+	return ((caddr_t) (table->original));
+      case ES_PS_SCRATCH:
+	return ((caddr_t) (table->scratch));
+      case ES_PS_SCRATCH_MAX_LEN:
+	return ((caddr_t) (table->scratch_max_len));
+      case ES_STATUS:
+	return ((caddr_t) (table->status));
+      case ES_SIZE_OF_ENTITY:
+	return (es_get(table->original, ES_SIZE_OF_ENTITY));
+      case ES_TYPE:
+	return ((caddr_t) ES_TYPE_PIECE);
+      default:
+	return (0);
+    }
+}
+
+static int
+pt_set(esh, attrs)
+    Es_handle       esh;
+    Attr_attribute  *attrs;
+{
+    register Piece_tree private = ABS_TO_TREE(esh);
+    register Piece_table table = &private->table;
+    int             (*notify_proc) () = (int (*) ()) 0;
+    caddr_t         notify_data = 0;
+    Es_index        undo_mark;
+    Es_index        first;
+    Es_handle       to_recycle;
+    Es_status       status_dummy = ES_SUCCESS;
+    register Es_status *status;
+
+    status = &status_dummy;
+    if (table->magic != PT_MAGIC)
+	*status = ES_INVALID_TYPE;
+    for (; *attrs && (*status == ES_SUCCESS); attrs = attr_next(attrs)) {
+	switch ((Es_attribute) * attrs) {
+	  case ES_CLIENT_DATA:
+	    table->client_data = attrs[1];
+	    break;
+	  case ES_HANDLE_TO_INSERT:
+	    to_recycle = (Es_handle) attrs[1];
+	    if (table->scratch_max_len == ES_INFINITY &&
+		to_recycle->ops == &pt_ops &&
+		(ABS_TO_REP(to_recycle))->scratch == table->scratch) {
+		*status = pt_insert_pieces(esh, to_recycle);
+	    } else {
+		/*
+		 * When scratch is bounded, or the pieces are not ours,
+		 * copy contents, not pieces.
+		 */
+		*status = es_copy(to_recycle, esh, FALSE);
+	    }
+	    break;
+	  case ES_PS_ORIGINAL:
+	    /*
+	     * Caller should destroy the old table->original iff return
+	     * value is ES_SUCCESS, allowing for caller to recover in case of
+	     * errors.
+	     */
+	    to_recycle = (Es_handle) attrs[1];
+	    first = es_get_position(table->original);
+	    if (to_recycle == ES_NULL) {
+		*status = ES_INVALID_HANDLE;
+	    } else if (es_get_length(table->original) !=
+		       es_get_length(to_recycle)) {
+		*status = ES_INCONSISTENT_LENGTH;
+	    } else if (first != es_set_position(to_recycle, first)) {
+		*status = ES_INCONSISTENT_POS;
+	    } else {
+		table->original = to_recycle;
+	    }
+	    break;
+	  case ES_PS_SCRATCH_MAX_LEN:
+	    *status = ps_set_scratch_max_len(esh, (Es_index) attrs[1]);
+	    break;
+	  case ES_STATUS:
+	    table->status = (Es_status) attrs[1];
+	    break;
+	  case ES_STATUS_PTR:
+	    status = (Es_status *) attrs[1];
+	    *status = status_dummy;
+	    break;
+	  case ES_UNDO_MARK:
+	    /* -1 below is because 0 == ES_NULL_UNDO_MARK */
+	    undo_mark = ((Es_index) attrs[1]) - 1;
+	    *status = pt_undo_to_mark(esh, undo_mark, notify_proc,
+				      notify_data);
+	    break;
+	  case ES_UNDO_NOTIFY_PAIR:
+	    notify_proc = (int (*) ()) attrs[1];
+	    notify_data = (char *) attrs[2];
+	    break;
+	  default:
+	    break;
+	}
+    }
+    return ((*status == ES_SUCCESS));
+}
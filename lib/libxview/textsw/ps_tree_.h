@@ -0,0 +1,10 @@
+#if !defined(PS_TREE__H)
+#define PS_TREE__H
+
+#include <xview/pkg.h>
+#include <xview_private/es.h>
+
+Pkg_private Es_handle ps_tree_create(Xv_opaque client_data, Es_handle original, Es_handle scratch);
+
+#endif
+
@@ -77,6 +77,12 @@
 #define	TEXTSW_MARK_MOVE_AT_INSERT	0x1
 #define	TEXTSW_MARK_READ_ONLY		0x2
 
+/*
+ * Flags for use with textsw_find_all
+ */
+#define	TEXTSW_FIND_ALL_DEFAULTS	0x0
+#define	TEXTSW_FIND_ALL_REGEX		0x1	/* Not with OW_I18N */
+
 /*
  * PRIVATE #defines
  */
@@ -114,6 +120,7 @@
 
 #define	TEXTSW_ATTR_RECT_PAIR		ATTR_TYPE(ATTR_BASE_RECT_PTR, 2)
 #define	TEXTSW_ATTR_REPLACE_5		ATTR_TYPE(ATTR_BASE_INT, 5)
+#define	TEXTSW_ATTR_INT_PAIR		ATTR_TYPE(ATTR_BASE_INT, 2)
 
 /* 
  * Bit flags returned by textsw_process_event 
@@ -328,7 +335,13 @@ typedef enum {
 				TEXTSW_ATTR(TEXTSW_ATTR_RECT_PAIR,	75),
 	TEXTSW_ACTION_SPLIT_VIEW	= TEXTSW_ATTR(ATTR_OPAQUE,	80),
 	TEXTSW_ACTION_STORING_FILE	= TEXTSW_ATTR(ATTR_STRING,	85),
-	TEXTSW_ACTION_WRITE_FAILED	= TEXTSW_ATTR(ATTR_NO_VALUE,	90)
+	TEXTSW_ACTION_WRITE_FAILED	= TEXTSW_ATTR(ATTR_NO_VALUE,	90),
+	/*
+	 * Public Attributes (continued)
+	 */
+	TEXTSW_ACTION_FOUND_ALL		=
+				TEXTSW_ATTR(TEXTSW_ATTR_INT_PAIR,	95)
+	/* Args are: matches so far, percent of text scanned */
 } Textsw_action;
 
 /*
@@ -501,6 +514,10 @@ EXTERN_FUNCTION (void textsw_file_lines_visible, (Textsw textsw, int *top, int *
 
 EXTERN_FUNCTION (int textsw_find_bytes, (Textsw textsw, Textsw_index *first, Textsw_index *last_plus_one, char *buf, unsigned int buf_len, unsigned int flags));
 
+EXTERN_FUNCTION (int textsw_find_all, (Textsw textsw, char *pattern, unsigned int pattern_len, unsigned int flags));
+
+EXTERN_FUNCTION (void textsw_find_all_clear, (Textsw textsw));
+
 EXTERN_FUNCTION (Textsw_index textsw_find_mark, (Textsw textsw, Textsw_mark mark));
 
 EXTERN_FUNCTION (Textsw textsw_first, (Textsw textsw));
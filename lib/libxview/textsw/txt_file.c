@@ -24,6 +24,7 @@ static char     sccsid[] = "@(#)txt_file.c 20.81 93/06/28";
 #include <xview_private/txt_disp_.h>
 #include <xview_private/txt_edit_.h>
 #include <xview_private/txt_event_.h>
+#include <xview_private/txt_findall_.h>
 #include <xview_private/txt_input_.h>
 #include <xview_private/txt_once_.h>
 #include <xview_private/txt_popup_.h>
@@ -291,6 +292,7 @@ textsw_replace_esh(textsw, new_esh)
 		  EV_DISPLAY_LEVEL, EV_DISPLAY_NONE,
 		  EV_CHAIN_ESH, new_esh,
 		  NULL);
+    textsw_find_all_restart(textsw);
     textsw->state &= ~TXTSW_EDITED;
     textsw_destroy_esh(textsw, save_esh);
     /* Following two calls are inefficient textsw_re-init_undo. */
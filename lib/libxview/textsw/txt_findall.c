@@ -0,0 +1,579 @@
+#ifndef lint
+#ifdef sccs
+static char     sccsid[] = "@(#)txt_findall.c 1.1 93/06/28";
+#endif
+#endif
+
+/*
+ *	(c) Copyright 1989 Sun Microsystems, Inc. Sun design patents
+ *	pending in the U.S. and foreign countries. See LEGAL NOTICE
+ *	file for terms of the license.
+ */
+
+/*
+ * Find all: highlight every match of a pattern, in the background.
+ *
+ * The text is scanned in slices of TXTSW_FIND_ALL_SLICE characters, one per
+ * tick of an interval timer, so that a large file never holds up input or
+ * repainting.  Each match becomes an EV_BDRY_MATCH pair in the chain's
+ * match_bdry table, which ev_display paints light gray.  The ev code keeps
+ * the pairs and the scan position current across edits, and collects edits
+ * to text that has already been scanned into match_dirty (see
+ * ev_match_after_edit); each tick rescans that range before moving on.
+ *
+ * Plain patterns use the same search as ev_find_in_esh.  Regular
+ * expressions are POSIX extended ones compiled with REG_NEWLINE, and are
+ * run over whole lines wherever possible.
+ */
+
+#include <xview_private/txt_findall_.h>
+#include <xview_private/ev_display_.h>
+#include <xview_private/ev_once_.h>
+#include <xview_private/ev_op_bdry_.h>
+#include <xview_private/gettext_.h>
+#include <xview_private/txt_attr_.h>
+#include <xview_private/txt_edit_.h>
+#include <xview_private/txt_event_.h>
+#include <xview_private/primal.h>
+#include <xview_private/txt_impl.h>
+#include <xview_private/ev_impl.h>
+#include <xview_private/txt_18impl.h>
+#include <sys/time.h>
+#ifndef OW_I18N
+#include <regex.h>
+#endif
+
+#define	TXTSW_FIND_ALL_SLICE	65536
+
+struct textsw_find_all {
+    Textsw_folio    folio;
+    CHAR           *pattern;
+    int             pattern_length;
+    unsigned        flags;
+    int             skip[EV_FIND_SKIP_SIZE];
+#ifndef OW_I18N
+    regex_t         regex;
+#endif
+    CHAR           *buf;
+    int             bufsize;
+    int             count;
+    int             timer_on;
+};
+typedef struct textsw_find_all *Textsw_find_all;
+
+#define	TXTSW_FIND_ALL_IS_REGEX(_fa)					\
+	((_fa)->flags & TEXTSW_FIND_ALL_REGEX)
+
+static Notify_value textsw_find_all_tick(Notify_client client, int which);
+static void textsw_find_all_set_timer(Textsw_find_all fa, int on);
+static void textsw_find_all_rescan(Textsw_find_all fa, Ev_range *dirty);
+static Es_index textsw_find_all_scan(Textsw_find_all fa, Es_index first, Es_index last_plus_one, int to_the_end, Ev_range *added);
+#ifndef OW_I18N
+static int textsw_find_all_regex(Textsw_find_all fa, Es_index pos, int cut, int keep, int bol, int eflags, Ev_range *added);
+#endif
+static int textsw_find_all_read(Es_handle esh, Es_index *first, Es_index last_plus_one, CHAR *buf, Es_index *next);
+static Es_index textsw_find_all_line(Textsw_find_all fa, Es_index pos, int forward);
+
+/*
+ * Starts highlighting every match of pattern, replacing any earlier find.
+ * Returns 0, or -1 if the pattern is empty or the regular expression does
+ * not compile.
+ */
+Xv_public int
+textsw_find_all(abstract, pattern, pattern_len, flags)
+    Textsw          abstract;
+    char           *pattern;
+    unsigned        pattern_len;
+    unsigned        flags;
+{
+    Textsw_folio    folio = FOLIO_FOR_VIEW(VIEW_ABS_TO_REP(abstract));
+    Ev_chain_pd_handle private;
+    register Textsw_find_all fa;
+
+    textsw_find_all_clear(abstract);
+    if (pattern_len == 0)
+	return -1;
+    fa = NEW(struct textsw_find_all);
+    fa->folio = folio;
+    fa->flags = flags;
+    fa->pattern = MALLOC(pattern_len + 1);
+#ifdef OW_I18N
+    {
+	int             unconverted_bytes = pattern_len, big_len_flag;
+
+	fa->pattern_length = textsw_mbstowcs_by_mblen(fa->pattern, pattern,
+				      &unconverted_bytes, &big_len_flag);
+	if (big_len_flag || fa->pattern_length == 0 ||
+	    TXTSW_FIND_ALL_IS_REGEX(fa))
+	    goto Error;
+    }
+#else
+    XV_BCOPY(pattern, fa->pattern, pattern_len);
+    fa->pattern_length = pattern_len;
+#endif
+    fa->pattern[fa->pattern_length] = 0;
+#ifndef OW_I18N
+    if (TXTSW_FIND_ALL_IS_REGEX(fa)) {
+	if (regcomp(&fa->regex, fa->pattern, REG_EXTENDED | REG_NEWLINE))
+	    goto Error;
+    } else
+#endif
+	ev_find_skip_table(fa->pattern, fa->pattern_length, FALSE, fa->skip);
+    /* Room for the carried overlap and regexec's terminating null */
+    fa->bufsize = MAX(TXTSW_FIND_ALL_SLICE, 2 * fa->pattern_length) + 1;
+    fa->buf = MALLOC(fa->bufsize);
+    folio->find_all = fa;
+    private = EV_CHAIN_PRIVATE(folio->views);
+    private->match_scanned = private->match_resume = 0;
+    private->match_dirty.first = private->match_dirty.last_plus_one =
+	ES_INFINITY;
+    textsw_find_all_set_timer(fa, TRUE);
+    return 0;
+Error:
+    free((char *) fa->pattern);
+    free((char *) fa);
+    return -1;
+}
+
+/* Stops any find started by textsw_find_all, and removes its highlighting. */
+Xv_public void
+textsw_find_all_clear(abstract)
+    Textsw          abstract;
+{
+    Textsw_folio    folio = FOLIO_FOR_VIEW(VIEW_ABS_TO_REP(abstract));
+    Ev_range        removed;
+
+    if (folio->find_all == NULL)
+	return;
+    removed.first = ES_INFINITY;
+    removed.last_plus_one = 0;
+    if (ev_remove_matches(folio->views, 0, ES_INFINITY, &removed))
+	ev_display_range(folio->views, removed.first, removed.last_plus_one);
+    textsw_find_all_destroy(folio);
+}
+
+Pkg_private void
+textsw_find_all_destroy(folio)
+    Textsw_folio    folio;
+{
+    register Textsw_find_all fa = folio->find_all;
+    Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(folio->views);
+
+    if (fa == NULL)
+	return;
+    textsw_find_all_set_timer(fa, FALSE);
+#ifndef OW_I18N
+    if (TXTSW_FIND_ALL_IS_REGEX(fa))
+	regfree(&fa->regex);
+#endif
+    free((char *) fa->buf);
+    free((char *) fa->pattern);
+    free((char *) fa);
+    folio->find_all = NULL;
+    private->match_scanned = ES_CANNOT_SET;
+    private->match_dirty.first = private->match_dirty.last_plus_one =
+	ES_INFINITY;
+}
+
+/*
+ * Called when the folio gets a new esh: the matches were for the old text,
+ * so start over on the new one.
+ */
+Pkg_private void
+textsw_find_all_restart(folio)
+    Textsw_folio    folio;
+{
+    register Textsw_find_all fa = folio->find_all;
+    Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(folio->views);
+    Ev_range        removed;
+
+    if (fa == NULL)
+	return;
+    removed.first = ES_INFINITY;
+    removed.last_plus_one = 0;
+    (void) ev_remove_matches(folio->views, 0, ES_INFINITY, &removed);
+    fa->count = 0;
+    private->match_scanned = private->match_resume = 0;
+    private->match_dirty.first = private->match_dirty.last_plus_one =
+	ES_INFINITY;
+    textsw_find_all_set_timer(fa, TRUE);
+}
+
+/* Called for EV_ACTION_MATCH: an edit may have left work to do. */
+Pkg_private void
+textsw_find_all_edited(folio)
+    Textsw_folio    folio;
+{
+    if (folio->find_all)
+	textsw_find_all_set_timer(folio->find_all, TRUE);
+}
+
+static void
+textsw_find_all_set_timer(fa, on)
+    register Textsw_find_all fa;
+    int             on;
+{
+    if (on == fa->timer_on)
+	return;
+    /* fa is the client, as the folio's own timer blinks the caret. */
+    if (NOTIFY_FUNC_NULL == notify_set_itimer_func((Notify_client) fa,
+		       textsw_find_all_tick, ITIMER_REAL,
+		       on ? &NOTIFY_POLLING_ITIMER : &NOTIFY_NO_ITIMER,
+		       (struct itimerval *) 0)) {
+	notify_perror(XV_MSG("textsw find all timer"));
+	return;
+    }
+    fa->timer_on = on;
+}
+
+/* ARGSUSED */
+static          Notify_value
+textsw_find_all_tick(client, which)
+    Notify_client   client;
+    int             which;
+{
+    register Textsw_find_all fa = (Textsw_find_all) client;
+    Ev_chain        chain = fa->folio->views;
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    Es_index        length = es_get_length(chain->esh);
+    Es_index        first, last_plus_one, resume;
+    Ev_range        dirty, added;
+
+    if (private->match_dirty.first != ES_INFINITY) {
+	dirty = private->match_dirty;
+	private->match_dirty.first = private->match_dirty.last_plus_one =
+	    ES_INFINITY;
+	if (dirty.last_plus_one > length)
+	    dirty.last_plus_one = length;
+	if (dirty.first > dirty.last_plus_one)
+	    dirty.first = dirty.last_plus_one;
+	textsw_find_all_rescan(fa, &dirty);
+    } else if (private->match_resume < length) {
+	first = private->match_resume;
+	last_plus_one = MIN(first + fa->bufsize - 1, length);
+	added.first = ES_INFINITY;
+	added.last_plus_one = 0;
+	resume = textsw_find_all_scan(fa, first, last_plus_one,
+				      last_plus_one == length, &added);
+	private->match_scanned = last_plus_one;
+	private->match_resume = (last_plus_one == length) ? length : resume;
+	if (added.first < added.last_plus_one)
+	    ev_display_range(chain, added.first, added.last_plus_one);
+    } else {
+	textsw_find_all_set_timer(fa, FALSE);
+	return (NOTIFY_DONE);
+    }
+    textsw_notify(fa->folio->first_view, TEXTSW_ACTION_FOUND_ALL, fa->count,
+		  (length == 0) ? 100 : (int)
+		  ((double) MIN(private->match_resume, length) * 100 / length),
+		  NULL);
+    return (NOTIFY_DONE);
+}
+
+/*
+ * Replaces the matches in and around the edited range *dirty.  The range is
+ * first widened to take in every match start that the edit could affect,
+ * and then to the extent of the matches removed from it.
+ */
+static void
+textsw_find_all_rescan(fa, dirty)
+    register Textsw_find_all fa;
+    Ev_range       *dirty;
+{
+    Ev_chain        chain = fa->folio->views;
+    register Ev_chain_pd_handle private = EV_CHAIN_PRIVATE(chain);
+    Es_index        length = es_get_length(chain->esh);
+    Ev_range        removed, added, tail;
+    Es_index        resume;
+    int             removed_count;
+
+    removed = *dirty;
+    if (TXTSW_FIND_ALL_IS_REGEX(fa)) {
+	removed.first = textsw_find_all_line(fa, dirty->first, FALSE);
+	removed.last_plus_one =
+	    textsw_find_all_line(fa, dirty->last_plus_one, TRUE);
+	/* A match spanning lines can widen it again, so iterate. */
+	do {
+	    *dirty = removed;
+	    fa->count -= ev_remove_matches(chain, dirty->first,
+					   dirty->last_plus_one, &removed);
+	    removed.first = textsw_find_all_line(fa, removed.first, FALSE);
+	    removed.last_plus_one =
+		textsw_find_all_line(fa, removed.last_plus_one - 1, TRUE);
+	} while (removed.first != dirty->first ||
+		 removed.last_plus_one != dirty->last_plus_one);
+    } else {
+	removed.first = MAX(dirty->first - (fa->pattern_length - 1), 0);
+	removed.last_plus_one =
+	    MIN(dirty->last_plus_one + (fa->pattern_length - 1), length);
+	fa->count -= ev_remove_matches(chain, removed.first,
+				       removed.last_plus_one, &removed);
+    }
+    added.first = ES_INFINITY;
+    added.last_plus_one = 0;
+    resume = removed.first;
+    for (;;) {
+	if (removed.last_plus_one >= private->match_resume) {
+	    /*
+	     * The edit reached text the scan has yet to settle, so drop what
+	     * remains after it and let the scan resume from there.  Every
+	     * match ends at or before match_resume.
+	     */
+	    fa->count -= ev_remove_matches(chain, removed.first, ES_INFINITY,
+					   &removed);
+	    if (TXTSW_FIND_ALL_IS_REGEX(fa))
+		removed.first = textsw_find_all_line(fa, removed.first, FALSE);
+	    if (removed.first < private->match_resume)
+		private->match_resume = removed.first;
+	    break;
+	}
+	/*
+	 * Plain matches do not overlap, so one found across the end of the
+	 * window displaces those it runs into, which may in turn free text
+	 * for another.  Follow that chain until it stops.
+	 */
+	tail.first = tail.last_plus_one = removed.last_plus_one;
+	removed_count = 0;
+	if (!TXTSW_FIND_ALL_IS_REGEX(fa)) {
+	    tail.last_plus_one = MIN(tail.first + fa->pattern_length - 1,
+				     length);
+	    removed_count = ev_remove_matches(chain, tail.first,
+					      tail.last_plus_one, &tail);
+	    fa->count -= removed_count;
+	    removed.last_plus_one = MAX(removed.last_plus_one,
+					tail.last_plus_one);
+	    if (removed.last_plus_one >= private->match_resume)
+		continue;
+	}
+	resume = textsw_find_all_scan(fa, resume, removed.last_plus_one,
+				      TRUE, &added);
+	if (removed_count == 0)
+	    break;
+    }
+    removed.first = MIN(removed.first, added.first);
+    removed.last_plus_one = MAX(removed.last_plus_one, added.last_plus_one);
+    ev_display_range(chain, removed.first,
+		     MIN(removed.last_plus_one, length));
+}
+
+/*
+ * Records the matches that lie within [first, last_plus_one), widening
+ * *added to cover them.  Returns the first position at which a match could
+ * yet start; matches ending by last_plus_one have all been found before it.
+ * Unless to_the_end, a regular expression is not run over the last partial
+ * line, whose start is returned instead.
+ */
+static          Es_index
+textsw_find_all_scan(fa, first, last_plus_one, to_the_end, added)
+    register Textsw_find_all fa;
+    Es_index        first, last_plus_one;
+    int             to_the_end;
+    register Ev_range *added;
+{
+    Ev_chain        chain = fa->folio->views;
+    register CHAR  *buf = fa->buf;
+    Es_index        pos = first, next, stop, match_first;
+    register int    found, from, fill;
+    int             at_end, bol = TRUE;
+
+#ifndef OW_I18N
+    if (TXTSW_FIND_ALL_IS_REGEX(fa) && first > 0) {
+	CHAR            c;
+	int             read;
+
+	/* Is first at the beginning of a line? */
+	(void) es_set_position(chain->esh, first - 1);
+	(void) es_read(chain->esh, 1, &c, &read);
+	bol = (read == 0 || c == '\n');
+    }
+#endif
+    while (pos < last_plus_one) {
+	stop = MIN(last_plus_one, pos + fa->bufsize - 1);
+	fill = textsw_find_all_read(chain->esh, &pos, stop, buf, &next);
+	if (fill == 0) {
+	    if (next <= pos)
+		break;		/* Stream shrank under us */
+	    pos = next;
+	    continue;
+	}
+	/* A short read without a gap means the stream shrank under us. */
+	at_end = (pos + fill >= last_plus_one ||
+		  (next == pos + fill && pos + fill < stop));
+#ifndef OW_I18N
+	if (TXTSW_FIND_ALL_IS_REGEX(fa)) {
+	    int             cut = fill, keep = fill, eflags = 0;
+
+	    /*
+	     * Run over whole lines only, unless this is all the text there is
+	     * to scan.  Of a line too long for the buffer, take the matches
+	     * starting in its first half, and go on from there.
+	     */
+	    if (next != pos + fill) {
+		eflags = REG_NOTEOL;	/* No match spans a gap */
+	    } else if (!at_end || !to_the_end) {
+		for (found = fill; found > 0 && buf[found - 1] != '\n';)
+		    found--;
+		if (found > 0) {
+		    cut = keep = found;
+		} else if (at_end && pos != first) {
+		    return (pos);
+		} else {
+		    keep = MAX(fill / 2, 1);
+		    eflags = REG_NOTEOL;
+		}
+	    }
+	    found = textsw_find_all_regex(fa, pos, cut, keep, bol, eflags,
+					  added);
+	    if (keep < cut) {
+		stop = pos + found;
+		bol = FALSE;
+	    } else {
+		stop = (cut < fill) ? pos + cut : next;
+		bol = TRUE;
+	    }
+	    if (at_end)
+		return (stop);
+	    pos = stop;
+	    continue;
+	}
+#endif
+	from = 0;
+	while ((found = ev_find_forward_in_buf(buf, from, fill, fa->pattern,
+				       fa->pattern_length, fa->skip)) >= 0) {
+	    match_first = pos + found;
+	    ev_add_match(chain, match_first,
+			 match_first + fa->pattern_length);
+	    fa->count++;
+	    if (match_first < added->first)
+		added->first = match_first;
+	    added->last_plus_one = match_first + fa->pattern_length;
+	    from = found + fa->pattern_length;
+	}
+	if (next != pos + fill) {
+	    /* No match spans a gap in the entity indices. */
+	    pos = next;
+	    continue;
+	}
+	/* The tail that may start a match is read again next time. */
+	if (from < fill - fa->pattern_length + 1)
+	    from = fill - fa->pattern_length + 1;
+	if (at_end)
+	    return (pos + from);
+	pos += from;
+    }
+    return (MAX(pos, first));
+}
+
+#ifndef OW_I18N
+/*
+ * Records the regular expression matches in fa->buf[0, cut), which holds
+ * the text at pos, that start before keep.  Unless keep == cut, the line
+ * runs on past cut, and a match reaching cut is left for the next call to
+ * start at; only one that fills the buffer is taken as it is.  Returns the
+ * offset at which the scan is to go on.
+ */
+static int
+textsw_find_all_regex(fa, pos, cut, keep, bol, eflags, added)
+    register Textsw_find_all fa;
+    Es_index        pos;
+    int             cut, keep, bol, eflags;
+    register Ev_range *added;
+{
+    register CHAR  *buf = fa->buf;
+    regmatch_t      match;
+    register int    from = 0;
+
+    buf[cut] = '\0';
+    while (from < keep) {
+	if ((from == 0) ? !bol : buf[from - 1] != '\n')
+	    eflags |= REG_NOTBOL;
+	else
+	    eflags &= ~REG_NOTBOL;
+	if (regexec(&fa->regex, buf + from, 1, &match, eflags) != 0)
+	    break;
+	match.rm_so += from;
+	match.rm_eo += from;
+	if (match.rm_so >= keep)
+	    break;
+	if (keep < cut && match.rm_eo >= cut && match.rm_so > 0)
+	    return (match.rm_so);
+	if (match.rm_eo == match.rm_so) {
+	    /* Empty matches are not highlighted. */
+	    from = match.rm_eo + 1;
+	    continue;
+	}
+	ev_add_match(fa->folio->views, pos + match.rm_so, pos + match.rm_eo);
+	fa->count++;
+	if (pos + match.rm_so < added->first)
+	    added->first = pos + match.rm_so;
+	added->last_plus_one = pos + match.rm_eo;
+	from = match.rm_eo;
+    }
+    return (MAX(from, keep));
+}
+#endif
+
+/*
+ * Reads the text from *first up to last_plus_one into buf, stopping short
+ * at a gap in the entity indices.  *first is moved to where the text read
+ * actually starts, and *next is set to where reading can continue.
+ */
+static int
+textsw_find_all_read(esh, first, last_plus_one, buf, next)
+    Es_handle       esh;
+    Es_index       *first, last_plus_one;
+    CHAR           *buf;
+    Es_index       *next;
+{
+    register Es_index pos, new_pos;
+    register int    fill = 0;
+    int             read;
+
+    pos = es_set_position(esh, *first);
+    if (pos == ES_CANNOT_SET) {
+	*next = *first;
+	return (0);
+    }
+    *first = pos;
+    while (pos < last_plus_one) {
+	new_pos = es_read(esh, (int) (last_plus_one - pos), buf + fill,
+			  &read);
+	fill += read;
+	if (new_pos != pos + read) {
+	    pos = new_pos;
+	    break;
+	}
+	if (read == 0)
+	    break;
+	pos = new_pos;
+    }
+    *next = pos;
+    return (fill);
+}
+
+/*
+ * Returns the start of the line containing pos or, if forward, the start of
+ * the next line.
+ */
+static          Es_index
+textsw_find_all_line(fa, pos, forward)
+    Textsw_find_all fa;
+    Es_index        pos;
+    int             forward;
+{
+    Es_handle       esh = fa->folio->views->esh;
+    Es_index        first, last_plus_one;
+    CHAR            newline = '\n';
+
+    if (forward) {
+	ev_find_in_esh(esh, &newline, 1, MAX(pos, 0), 1, EV_FIND_DEFAULT,
+		       &first, &last_plus_one);
+	return ((first == ES_CANNOT_SET) ? es_get_length(esh)
+					 : last_plus_one);
+    }
+    if (pos <= 0)
+	return (0);
+    ev_find_in_esh(esh, &newline, 1, pos, 1, EV_FIND_BACKWARD,
+		   &first, &last_plus_one);
+    return ((first == ES_CANNOT_SET) ? 0 : last_plus_one);
+}
@@ -0,0 +1,11 @@
+#if !defined(TXT_FINDALL__H)
+#define TXT_FINDALL__H
+
+#include <xview/pkg.h>
+#include <xview_private/txt_impl.h>
+
+Pkg_private void textsw_find_all_destroy(Textsw_folio folio);
+Pkg_private void textsw_find_all_restart(Textsw_folio folio);
+Pkg_private void textsw_find_all_edited(Textsw_folio folio);
+
+#endif
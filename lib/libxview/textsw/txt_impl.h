@@ -301,6 +301,8 @@ typedef struct textsw_object {
 	int		  (*layout_proc)(); /* interposed window layout proc */
 	Xv_Window	  focus_view;	/* view window with the kbd focus */
 	unsigned	  accel_menus:1; /* Are core menu items accelerated */
+	struct textsw_find_all
+			 *find_all;	/* See txt_findall.c */
 #ifdef OW_I18N
 	int		  blocking_newline; /* This is used for bug# 1090046 */
 	int		  need_im; /* TRUE if XV_IM and XV_USE_IM are TRUE */
@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)txt_line.c 1.26 93/06/28";
  */
 
 #include <xview_private/txt_line_.h>
+#include <xview_private/ev_lines_.h>
 #include <xview_private/ev_once_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/txt_popup_.h>
@@ -77,15 +78,10 @@ do_sel_line_proc(folio, ie)
     } else {
 	buf[0] = '\n';
 	buf_fill_len = 1;
-	if (line_no == 1) {
-	    prev = 0;
-	} else {
-	    ev_find_in_esh(folio->views->esh, buf, buf_fill_len,
-		       (Es_index) 0, (u_int) line_no - 1, 0, &first, &prev);
-	    if (first == ES_CANNOT_SET) {
-		window_bell(WINDOW_FROM_VIEW(view));
-		return TRUE;
-	    }
+	prev = ev_position_after_newlines(folio->views, line_no - 1);
+	if (prev == ES_CANNOT_SET) {
+	    window_bell(WINDOW_FROM_VIEW(view));
+	    return TRUE;
 	}
 	ev_find_in_esh(folio->views->esh, buf, buf_fill_len,
 		       prev, 1, 0, &first, &last_plus_one);
@@ -17,6 +17,7 @@ static char     sccsid[] = "@(#)txt_menu.c 20.91 93/06/29";
 #include <xview_private/txt_menu_.h>
 #include <xview_private/defaults_.h>
 #include <xview_private/ev_display_.h>
+#include <xview_private/ev_lines_.h>
 #include <xview_private/ev_once_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/txt_caret_.h>
@@ -1242,7 +1243,7 @@ Press \"Continue\" to proceed."),
 		     textsw->views, &first, &last_plus_one, EV_SEL_PRIMARY);
 	    if (first >= last_plus_one)
 		break;
-	    count = ev_newlines_in_esh(textsw->views->esh, 0, first);
+	    count = ev_line_for_position(textsw->views, first);
 	    (void) sprintf(msg, 
 		XV_MSG("Selection starts in line %d."), 
 		count + 1);
@@ -25,12 +25,14 @@ static char	sccsid[] = "@(#)txt_once.c 20.131 93/06/28";
 #include <xview_private/gettext_.h>
 #include <xview_private/pf_.h>
 #include <xview_private/ps_impl_.h>
+#include <xview_private/ps_tree_.h>
 #include <xview_private/txt_attr_.h>
 #include <xview_private/txt_again_.h>
 #include <xview_private/txt_attr_.h>
 #include <xview_private/txt_event_.h>
 #include <xview_private/txt_file_.h>
 #include <xview_private/txt_filter_.h>
+#include <xview_private/txt_findall_.h>
 #include <xview_private/txt_input_.h>
 #include <xview_private/txt_menu_.h>
 #include <xview_private/txt_scroll_.h>
@@ -196,6 +198,9 @@ textsw_view_chain_notify(folio, attributes)
 		textsw_notify(view, TEXTSW_ACTION_PAINTED, rect, NULL);
 	    }
 	    break;
+	  case EV_ACTION_MATCH:
+	    textsw_find_all_edited(folio);
+	    break;
 	  case EV_ACTION_SCROLL:
 	    if (view && (folio->notify_level & TEXTSW_NOTIFY_SCROLL)) {
 		from_rect = (Rect *) attrs[1];
@@ -631,7 +636,10 @@ textsw_init_internal(folio, status, default_notify_proc, attrs)
     if (*defaults) {
 	ATTR_CONSUME(*defaults);
 	folio->es_create = (Es_handle(*) ()) defaults[1];
-    } else
+    } else if (defaults_get_boolean("text.pieceTree", "Text.PieceTree",
+				    False))
+	folio->es_create = ps_tree_create;
+    else
 	folio->es_create = ps_create;
     defaults = attr_find((Attr_avlist)attrs, TEXTSW_CLIENT_DATA);
     if (*defaults) {
@@ -967,6 +975,7 @@ textsw_folio_cleanup(folio)
     Frame parent_frame = (Frame)xv_get(textsw,WIN_FRAME);
 
     textsw_init_again(folio, 0);/* Flush AGAIN info */
+    textsw_find_all_destroy(folio);
     /*
      * Clean up of AGAIN info requires valid esh in case of piece frees.
      * textsw_destroy_esh may try to give Shelf to Seln. Svc., so need to
@@ -19,6 +19,7 @@ static char     sccsid[] = "@(#)txt_selsvc.c 20.64 93/06/29";
 #include <xview_private/es_file_.h>
 #include <xview_private/ev_display_.h>
 #include <xview_private/ev_edit_.h>
+#include <xview_private/ev_lines_.h>
 #include <xview_private/ev_once_.h>
 #include <xview_private/ev_op_bdry_.h>
 #include <xview_private/gettext_.h>
@@ -1907,11 +1908,8 @@ textsw_seln_svc_reply(attr, context, max_length)
 	switch (cont_data->span_level) {
 	  case EI_SPAN_LINE:{
 		int             line_number;
-		if (cont_data->first == 0)
-		    line_number = 0;
-		else
-		    line_number = ev_newlines_in_esh(textsw->views->esh,
-						     0, cont_data->first);
+		line_number = ev_line_for_position(textsw->views,
+						   cont_data->first);
 		*context->response_pointer++ = (caddr_t)(long)line_number;
 		break;
 	    }
@@ -17,10 +17,83 @@
  * Characters past length position are undefined.
  * Line is otherwise null terminated.
  */
-extern CHAR	**image;
-extern char	**screenmode;
-extern int	ttysw_top, ttysw_bottom, ttysw_left, ttysw_right;
-extern int	cursrow, curscol;
+
+#define TTYSW_HIST_BYTES	(1024 * 1024)	/* default scrollback budget */
+
+/*
+ * Everything that describes one terminal: its character image and modes,
+ * the window they are painted on, and the state of the escape sequence
+ * parser.  Each ttysw folio has one (see ttysw_terminal_create); ttysw_term
+ * points to the one being worked on, and every way into the ttysw from the
+ * notifier, a public function or a callback selects it with
+ * ttysw_use_terminal before touching any of the names below.
+ */
+struct ttysw_terminal {
+	/* Character image (cim_size.c) */
+	CHAR	**image;
+	char	**screenmode;
+	CHAR	*lines_ptr;
+	char	*mode_ptr;
+	CHAR	**temp_image;		/* ttysw_imagerepair only */
+	char	**temp_mode;
+	CHAR	*temp_lines_ptr;
+	char	*temp_mode_ptr;
+	int	maxright, maxbottom;
+	int	top, bottom, left, right;	/* dimensions of window */
+	int	cursrow, curscol;
+	char	boldify;		/* mode of characters being written */
+	/* Physical screen (csr_init.c, csr_change.c) */
+	Xv_opaque pixwin;		/* the view being painted */
+	int	winheightp, winwidthp;
+	int	delaypainting;
+	int	cursor;			/* NOCURSOR, UNDERCURSOR, BLOCKCURSOR */
+	int	caretx, carety, lxhome;
+	short	charcursx, charcursy;
+#ifdef OW_I18N
+	int	curs_width;
+#endif
+	int	boldstyle, inverse_mode, underline_mode;
+	/* Painting deferred to the next refresh (csr_change.c) */
+	int	deferred;		/* output is only being noted */
+	int	refresh_set;		/* refresh timer is running */
+	int	repaint_all;		/* whole window needs painting */
+	int	scrolled;		/* rows the screen moved up meanwhile */
+	int	parsed;			/* characters of output meanwhile */
+	short	*damage;		/* per row, first column to repaint */
+	/* Lines scrolled off the top (cim_hist.c) */
+	struct ttysw_history *history;
+	int	hist_bytes;		/* budget for it, 0 for none */
+	int	hist_offset;		/* rows the view is scrolled back */
+	Xv_opaque hist_scrollbar;
+	/* Escape sequence parser (ttyansi.c) */
+	int	state;			/* ALPHA, SKIPPING, etc, possibly w/ |ESC */
+	int	saved_state;
+	int	prefix;			/* prefix to arg */
+	int	scrlins;		/* How many lines to scroll when you have to */
+	int	fillfunc;		/* 0 -> reverse video */
+	CHAR	strtype;		/* type of ansi string sequence */
+	int	av[10];			/* args in ESCBRKT sequences, -1 => defaulted */
+	int	ac;			/* number of args in av */
+	int	handle_escape_status;	/* not a return code, for compatibility */
+#ifdef OW_I18N
+	int	saved_row, saved_col;	/* \E7 and \E8 */
+	int	scroll_bottom;		/* to implement scroll region change */
+	int	pre_edit_rows_scrolled;
+#endif
+};
+
+extern struct ttysw_terminal	*ttysw_term;
+
+#define image		(ttysw_term->image)
+#define screenmode	(ttysw_term->screenmode)
+#define ttysw_top	(ttysw_term->top)
+#define ttysw_bottom	(ttysw_term->bottom)
+#define ttysw_left	(ttysw_term->left)
+#define ttysw_right	(ttysw_term->right)
+#define cursrow		(ttysw_term->cursrow)
+#define curscol		(ttysw_term->curscol)
+#define boldify		(ttysw_term->boldify)
+#define csr_pixwin	(ttysw_term->pixwin)
  
 #ifdef OW_I18N
 #define LINE_LENGTH(line)     (((unsigned char)((unsigned char *)(line))[-1]))
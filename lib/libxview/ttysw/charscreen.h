@@ -25,24 +25,26 @@
  */
 #if !defined(__linux__) || defined(__DEFINE_CHARSCREEN_VARS)
 int	chrheight, chrwidth, chrbase;
-int	winheightp, winwidthp;
 int	chrleftmargin;
 
 struct	pixfont *pixfont;
+#else /* __linux__ && !__DEFINE_CHARSCREEN_VARS */
+extern int	chrheight, chrwidth, chrbase;
+extern int	chrleftmargin;
+extern struct	pixfont *pixfont;
+#endif
 
 /*
+ * The size of the window in pixels belongs to the current terminal (see
+ * charimage.h), as does delaypainting.
+ *
  * If delaypainting, delay painting.  Set when clear screen.
  * When input will block then paint characters (! white space) of entire image
  * and turn delaypainting off.
  */
-int	delaypainting;
-#else /* __linux__ && !__DEFINE_CHARSCREEN_VARS */
-extern int	chrheight, chrwidth, chrbase;
-extern int	winheightp, winwidthp;
-extern int	chrleftmargin;
-extern struct	pixfont *pixfont;
-extern int	delaypainting;
-#endif
+#define winheightp	(ttysw_term->winheightp)
+#define winwidthp	(ttysw_term->winwidthp)
+#define delaypainting	(ttysw_term->delaypainting)
 
 #if defined(cplus)
 void	ttysw_pstring(CHAR *s, char mode, int col, int row, int op);
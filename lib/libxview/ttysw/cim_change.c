@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)cim_change.c 20.19 93/06/28";
  */
 
 #include <xview_private/cim_change_.h>
+#include <xview_private/cim_hist_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/i18n_impl.h>
 #include <sys/types.h>
@@ -26,8 +27,6 @@ static char     sccsid[] = "@(#)cim_change.c 20.19 93/06/28";
 
 static void reverse(int a, int b);
 
-char            boldify;
-
 #define JF
 
 Pkg_private void
@@ -160,6 +159,36 @@ ttysw_writePartialLine(s, curscolStart)
     (void) ttysw_pstring(s, boldify, curscolStart, cursrow, PIX_SRC);
 }
 
+#ifndef OW_I18N
+/*
+ * Same as ttysw_writePartialLine for the first count characters of s, which
+ * need not be null-terminated.  They go straight into the line and are
+ * painted from there.
+ */
+Pkg_private void
+ttysw_writeChars(s, count, curscolStart)
+    CHAR           *s;
+    int             count;
+    register int    curscolStart;
+{
+    register CHAR  *line = image[cursrow];
+    register int    curscolEnd = curscolStart + count;
+    CHAR            csave;
+
+    if ((int)LINE_LENGTH(line) < curscolStart)
+	(void) ttysw_vpos(cursrow, curscolStart);
+    (void) memcpy(line + curscolStart, s, count);
+    (void) memset(screenmode[cursrow] + curscolStart, boldify, count);
+    if ((int)LINE_LENGTH(line) < curscolEnd)
+	setlinelength(line, curscolEnd);
+    csave = line[curscolEnd];
+    line[curscolEnd] = '\0';
+    (void) ttysw_pstring(line + curscolStart, boldify, curscolStart, cursrow,
+			 PIX_SRC);
+    line[curscolEnd] = csave;
+}
+#endif
+
 #ifdef JF
 Pkg_private void
 ttysw_cim_scroll(n)
@@ -171,6 +200,7 @@ ttysw_cim_scroll(n)
     printf(" ttysw_cim_scroll(%d)	\n", n);
 #endif
     if (n > 0) {		/* text moves UP screen	 */
+	ttysw_hist_save(ttysw_top, ttysw_top + MIN(n, ttysw_bottom - ttysw_top));
 	(void) delete_lines(ttysw_top, n);
     } else {			/* (n<0)	text moves DOWN	screen	 */
 	new = ttysw_bottom + n;
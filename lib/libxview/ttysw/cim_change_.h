@@ -13,6 +13,9 @@ Pkg_private void ttysw_inverse_mode(void);
 void ttysw_noinverse_mode(void);
 Pkg_private void ttysw_clear_mode(void);
 Pkg_private void ttysw_writePartialLine(CHAR *s, register int curscolStart);
+#ifndef OW_I18N
+Pkg_private void ttysw_writeChars(CHAR *s, int count, register int curscolStart);
+#endif
 #define JF
 #ifdef JF
 Pkg_private void ttysw_cim_scroll(register int n);
@@ -0,0 +1,392 @@
+#ifndef lint
+#ifdef sccs
+static char     sccsid[] = "@(#)cim_hist.c 1.1 93/06/28";
+#endif
+#endif
+
+/*
+ *	(c) Copyright 1989 Sun Microsystems, Inc. Sun design patents
+ *	pending in the U.S. and foreign countries. See LEGAL NOTICE
+ *	file for terms of the license.
+ */
+
+/*
+ * Scrollback of the character image.
+ *
+ * Lines that scroll off the top of the screen are packed into a ring of a
+ * fixed number of bytes, the oldest being dropped to make room for the
+ * newest.  A packed line is its length, its characters (trailing blanks are
+ * never in the image), and the runs of its modes, of which a line of plain
+ * text has none.  The lines never wrap around the end of the ring; a second
+ * ring holds the offset of each, so line n is found in one step.  Both come
+ * out of the budget: the offsets may take up to 1/HIST_INDEX_SHARE of it,
+ * and once they have, a new line drops the oldest even if the text has
+ * room (only a run of empty lines gets there).
+ *
+ * A tty subwindow with a history has a vertical scrollbar.  Scrolling back
+ * defers the painting of output (see ttysw_pdefer) and paints the history
+ * instead; output, or making a selection, brings the screen back.
+ */
+
+#include <xview_private/cim_hist_.h>
+#include <xview_private/cim_size_.h>
+#include <xview_private/csr_change_.h>
+#include <xview_private/ttyselect_.h>
+#include <sys/types.h>
+#include <stdio.h>
+#include <string.h>
+#include <pixrect/pixrect.h>
+#include <pixrect/pixfont.h>
+#include <xview/rect.h>
+#include <xview/rectlist.h>
+#include <xview/pixwin.h>
+#include <xview/pkg.h>
+#include <xview/attrol.h>
+#include <xview/scrollbar.h>
+#include <xview_private/i18n_impl.h>
+#include <xview_private/ttyansi.h>
+#include <xview_private/charimage.h>
+#include <xview_private/charscreen.h>
+#include <xview_private/portable.h>
+
+#define HIST_MIN_BYTES	4096	/* holds any packed line */
+#define HIST_HEADER	2	/* length, number of mode runs */
+#define HIST_MIN_LINES	256
+#define HIST_INDEX_SHARE 8	/* of the budget the offsets may have */
+
+struct ttysw_history {
+    char           *text;		/* ring of packed lines */
+    int             size;		/* of text */
+    int             tail;		/* where the next line goes */
+    int            *lines;		/* ring of offsets in text */
+    int             max_lines, first, count;
+    int             line_limit;		/* max_lines may not pass this */
+    int             changed;		/* since the scrollbar was set */
+};
+
+#define LINE_OFFSET(hist, n)						\
+	((hist)->lines[((hist)->first + (n)) % (hist)->max_lines])
+
+static void ttysw_hist_append(struct ttysw_history *hist, CHAR *line, char *mode);
+static int ttysw_hist_room(struct ttysw_history *hist, int need);
+static int ttysw_hist_grow(struct ttysw_history *hist);
+static void ttysw_hist_drop(struct ttysw_history *hist);
+
+/*
+ * Give the current terminal a history of hist_bytes, unless it is a
+ * termsw, whose textsw keeps its own.
+ */
+Pkg_private void
+ttysw_hist_create(ttysw)
+    Ttysw_folio     ttysw;
+{
+    register struct ttysw_terminal *term;
+    register struct ttysw_history *hist;
+    int             size, index_size;
+
+    ttysw_use_terminal(ttysw);
+    term = ttysw_term;
+    if (term->history || term->hist_bytes <= 0 || TTY_IS_TERMSW(ttysw))
+	return;
+    size = MAX(term->hist_bytes,
+	       HIST_MIN_BYTES + HIST_MIN_LINES * sizeof(int));
+    index_size = MAX(size / HIST_INDEX_SHARE, HIST_MIN_LINES * sizeof(int));
+    size -= index_size;
+    if ((hist = (struct ttysw_history *) calloc(1, sizeof(*hist))) == NULL)
+	return;
+    hist->text = malloc((unsigned) size);
+    hist->lines = (int *) malloc(HIST_MIN_LINES * sizeof(int));
+    if (hist->text == NULL || hist->lines == NULL) {
+	if (hist->text)
+	    free(hist->text);
+	if (hist->lines)
+	    free((char *) hist->lines);
+	free((char *) hist);
+	return;
+    }
+    hist->size = size;
+    hist->max_lines = HIST_MIN_LINES;
+    hist->line_limit = index_size / sizeof(int);
+    hist->changed = TRUE;
+    term->history = hist;
+    if (term->hist_scrollbar)
+	(void) xv_set(term->hist_scrollbar, XV_SHOW, TRUE, NULL);
+    else
+	term->hist_scrollbar = xv_create(TTY_PUBLIC(ttysw), SCROLLBAR,
+					 SCROLLBAR_DIRECTION, SCROLLBAR_VERTICAL,
+					 SCROLLBAR_SPLITTABLE, FALSE,
+					 NULL);
+    ttysw_hist_update();
+}
+
+/*
+ * Free the history of the current terminal.  Its scrollbar is left to the
+ * window tree.
+ */
+Pkg_private void
+ttysw_hist_free()
+{
+    register struct ttysw_history *hist = ttysw_term->history;
+
+    if (hist == NULL)
+	return;
+    free(hist->text);
+    free((char *) hist->lines);
+    free((char *) hist);
+    ttysw_term->history = NULL;
+    ttysw_term->hist_offset = 0;
+}
+
+/*
+ * TTY_SCROLLBACK_BYTES: a new budget starts a new, empty history.
+ */
+Pkg_private void
+ttysw_hist_set_size(ttysw, bytes)
+    Ttysw_folio     ttysw;
+    int             bytes;
+{
+    register struct ttysw_terminal *term;
+
+    ttysw_use_terminal(ttysw);
+    term = ttysw_term;
+    term->hist_bytes = MAX(bytes, 0);
+    if (term->history) {
+	ttysw_hist_view(ttysw, 0);
+	ttysw_hist_free();
+	if (term->hist_bytes == 0 && term->hist_scrollbar)
+	    (void) xv_set(term->hist_scrollbar, XV_SHOW, FALSE, NULL);
+    } else if (ttysw->view == NULL)
+	return;			/* the rest is done at XV_END_CREATE */
+    ttysw_hist_create(ttysw);
+}
+
+/*
+ * Add rows fromrow up to torow of the image, about to scroll off, to the
+ * history.
+ */
+Pkg_private void
+ttysw_hist_save(fromrow, torow)
+    int             fromrow, torow;
+{
+    register struct ttysw_history *hist = ttysw_term->history;
+
+    if (hist == NULL)
+	return;
+    for (; fromrow < torow; fromrow++)
+	ttysw_hist_append(hist, image[fromrow], screenmode[fromrow]);
+    hist->changed = TRUE;
+}
+
+Pkg_private int
+ttysw_hist_lines()
+{
+    return (ttysw_term->history ? ttysw_term->history->count : 0);
+}
+
+/*
+ * Unpack line n of the history, 0 being the oldest, into line and mode,
+ * which have the room of a row of the image.  Returns its length.
+ */
+Pkg_private int
+ttysw_hist_line(n, line, mode)
+    int             n;
+    CHAR           *line;
+    char           *mode;
+{
+    register struct ttysw_history *hist = ttysw_term->history;
+    register char  *p = hist->text + LINE_OFFSET(hist, n);
+    int             length = (unsigned char) p[0];
+    int             runs = (unsigned char) p[1];
+    register int    col, run;
+
+    XV_BCOPY(p + HIST_HEADER, (char *) line, length * sizeof(CHAR));
+    p += HIST_HEADER + length * sizeof(CHAR);
+    if (runs == 0)
+	(void) memset(mode, MODE_CLEAR, length);
+    for (col = 0; runs--; p += 2, col += run) {
+	run = (unsigned char) p[0];
+	(void) memset(mode + col, p[1], run);
+    }
+    setlinelength(line, length);
+    return (length);
+}
+
+/*
+ * Show the screen offset rows back into the history, 0 being the live
+ * screen.
+ */
+Pkg_private void
+ttysw_hist_view(ttysw, offset)
+    Ttysw_folio     ttysw;
+    int             offset;
+{
+    register struct ttysw_terminal *term = ttysw_term;
+
+    if (term->history == NULL)
+	return;
+    if (offset > term->history->count)
+	offset = term->history->count;
+    if (offset < 0)
+	offset = 0;
+    if (offset == term->hist_offset)
+	return;
+    if (term->hist_offset == 0) {
+	/* Nothing but this paints until the view is back on the screen. */
+	if (ttysw->ttysw_primary.sel_made)
+	    ttysel_deselect(&ttysw->ttysw_primary, SELN_PRIMARY);
+	if (ttysw->ttysw_secondary.sel_made)
+	    ttysel_deselect(&ttysw->ttysw_secondary, SELN_SECONDARY);
+	(void) ttysw_pflush();
+	(void) ttysw_removeCursor();
+	(void) ttysw_pdefer();
+	if (!term->deferred) {
+	    (void) ttysw_drawCursor(cursrow, curscol);
+	    return;
+	}
+    }
+    term->hist_offset = offset;
+    if (offset == 0) {
+	term->repaint_all = TRUE;
+	(void) ttysw_pflush();
+    } else
+	(void) ttysw_pdisplayhistory();
+    term->history->changed = TRUE;
+    ttysw_hist_update();
+}
+
+/*
+ * SCROLLBAR_REQUEST.  The offset is worked out from the scrollbar alone,
+ * as lines may have been added since it posted the request.
+ */
+Pkg_private void
+ttysw_hist_scroll(ttysw, sb)
+    Ttysw_folio     ttysw;
+    Scrollbar       sb;
+{
+    long            start, last;
+
+    if (ttysw_term->history == NULL)
+	return;
+    start = (long) xv_get(sb, SCROLLBAR_VIEW_START);
+    last = (long) xv_get(sb, SCROLLBAR_OBJECT_LENGTH) -
+	(long) xv_get(sb, SCROLLBAR_VIEW_LENGTH);
+    ttysw_hist_view(ttysw, (int) (last - start));
+}
+
+/*
+ * Bring the scrollbar up to date, if the history or the view changed.
+ */
+Pkg_private void
+ttysw_hist_update()
+{
+    register struct ttysw_terminal *term = ttysw_term;
+    register struct ttysw_history *hist = term->history;
+    int             rows = ttysw_bottom - ttysw_top;
+
+    if (hist == NULL || !hist->changed || term->hist_scrollbar == XV_NULL)
+	return;
+    hist->changed = FALSE;
+    (void) xv_set(term->hist_scrollbar,
+		  SCROLLBAR_PIXELS_PER_UNIT, chrheight,
+		  SCROLLBAR_OBJECT_LENGTH, hist->count + rows,
+		  SCROLLBAR_VIEW_LENGTH, rows,
+		  SCROLLBAR_VIEW_START, hist->count - term->hist_offset,
+		  NULL);
+}
+
+static void
+ttysw_hist_append(hist, line, mode)
+    register struct ttysw_history *hist;
+    CHAR           *line;
+    char           *mode;
+{
+    int             length = LINE_LENGTH(line);
+    register int    col, run, runs = 0;
+    register char  *p;
+    int             need, offset;
+
+    for (col = 0; col < length; col++)
+	if (mode[col] != MODE_CLEAR)
+	    break;
+    if (col < length) {
+	for (col = 1, runs = 1; col < length; col++)
+	    if (mode[col] != mode[col - 1])
+		runs++;
+    }
+    need = HIST_HEADER + length * sizeof(CHAR) + 2 * runs;
+    if (hist->count == hist->max_lines && !ttysw_hist_grow(hist))
+	ttysw_hist_drop(hist);
+    offset = ttysw_hist_room(hist, need);
+    p = hist->text + offset;
+    p[0] = length;
+    p[1] = runs;
+    XV_BCOPY((char *) line, p + HIST_HEADER, length * sizeof(CHAR));
+    p += HIST_HEADER + length * sizeof(CHAR);
+    for (col = 0; runs--; col += run) {
+	for (run = 1; col + run < length && mode[col + run] == mode[col];
+	     run++);
+	*p++ = run;
+	*p++ = mode[col];
+    }
+    hist->lines[(hist->first + hist->count) % hist->max_lines] = offset;
+    hist->count++;
+    hist->tail = offset + need;
+}
+
+/*
+ * Returns where need bytes can go, dropping the oldest lines until there
+ * is room for them after the newest.
+ */
+static int
+ttysw_hist_room(hist, need)
+    register struct ttysw_history *hist;
+    int             need;
+{
+    register int    head;
+
+    for (;;) {
+	if (hist->count == 0)
+	    return (hist->tail = 0);
+	head = LINE_OFFSET(hist, 0);
+	if (hist->tail > head) {
+	    if (hist->tail + need <= hist->size)
+		return (hist->tail);
+	    hist->tail = 0;	/* the end of the ring stays unused */
+	} else if (hist->tail + need <= head)
+	    return (hist->tail);
+	else
+	    ttysw_hist_drop(hist);
+    }
+}
+
+static int
+ttysw_hist_grow(hist)
+    register struct ttysw_history *hist;
+{
+    register int   *lines;
+    register int    n, max_lines;
+
+    max_lines = MIN(2 * hist->max_lines, hist->line_limit);
+    if (max_lines <= hist->max_lines)
+	return (0);
+    lines = (int *) malloc((unsigned) (max_lines * sizeof(int)));
+    if (lines == NULL)
+	return (0);
+    for (n = 0; n < hist->count; n++)
+	lines[n] = LINE_OFFSET(hist, n);
+    free((char *) hist->lines);
+    hist->lines = lines;
+    hist->first = 0;
+    hist->max_lines = max_lines;
+    return (1);
+}
+
+static void
+ttysw_hist_drop(hist)
+    register struct ttysw_history *hist;
+{
+    hist->first = (hist->first + 1) % hist->max_lines;
+    hist->count--;
+    if (ttysw_term->hist_offset > hist->count)
+	ttysw_term->hist_offset = hist->count;
+}
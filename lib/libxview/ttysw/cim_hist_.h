@@ -0,0 +1,19 @@
+#if !defined(CIM_HIST__H)
+#define CIM_HIST__H
+
+#include <xview/pkg.h>
+#include <xview/scrollbar.h>
+#include <xview_private/tty_impl.h>
+
+Pkg_private void ttysw_hist_create(Ttysw_folio ttysw);
+Pkg_private void ttysw_hist_free(void);
+Pkg_private void ttysw_hist_set_size(Ttysw_folio ttysw, int bytes);
+Pkg_private void ttysw_hist_save(int fromrow, int torow);
+Pkg_private int ttysw_hist_lines(void);
+Pkg_private int ttysw_hist_line(int n, CHAR *line, char *mode);
+Pkg_private void ttysw_hist_view(Ttysw_folio ttysw, int offset);
+Pkg_private void ttysw_hist_scroll(Ttysw_folio ttysw, Scrollbar sb);
+Pkg_private void ttysw_hist_update(void);
+
+#endif
+
@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)cim_size.c 20.32 93/06/28";
  */
 
 #include <xview_private/cim_size_.h>
+#include <xview_private/cim_hist_.h>
 #include <xview_private/csr_init_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/tty_main_.h>
@@ -40,18 +41,69 @@ static char     sccsid[] = "@(#)cim_size.c 20.32 93/06/28";
 #include <xview_private/charscreen.h>
 #include <xview_private/portable.h>
 
-CHAR          **image;		/* BUG ALERT! Get rid of this global. */
-char          **screenmode;     /* BUG ALERT! Get rid of this global. */
-static CHAR    *lines_ptr;
-static char     *mode_ptr;      /* BUG ALERT! Get rid of this global. */
-static CHAR   **temp_image;
-static char     **temp_mode;    /* BUG ALERT! Get rid of this
-                                                 * global. */
-static CHAR    *temp_lines_ptr;
-static char     *temp_mode_ptr; /* BUG ALERT! Get rid of this
-                                                 * global. */
+/* Current until the first ttysw is created, so ttysw_term is never NULL. */
+static struct ttysw_terminal ttysw_default_terminal;
 
-static int      maxright, maxbottom;
+struct ttysw_terminal *ttysw_term = &ttysw_default_terminal;
+
+#define lines_ptr	(ttysw_term->lines_ptr)
+#define mode_ptr	(ttysw_term->mode_ptr)
+#define temp_image	(ttysw_term->temp_image)
+#define temp_mode	(ttysw_term->temp_mode)
+#define temp_lines_ptr	(ttysw_term->temp_lines_ptr)
+#define temp_mode_ptr	(ttysw_term->temp_mode_ptr)
+#define maxright	(ttysw_term->maxright)
+#define maxbottom	(ttysw_term->maxbottom)
+
+/*
+ * Allocate the terminal state of a new ttysw and make it the current one.
+ */
+Pkg_private int
+ttysw_terminal_create(ttysw)
+    Ttysw          *ttysw;
+{
+    register struct ttysw_terminal *term;
+
+    term = (struct ttysw_terminal *) calloc(1, sizeof(struct ttysw_terminal));
+    if (term == NULL)
+	return (0);
+    term->cursor = BLOCKCURSOR | LIGHTCURSOR;
+    term->scrlins = 1;
+    ttysw->terminal = term;
+    ttysw_term = term;
+    return (1);
+}
+
+/*
+ * Free the terminal state of a ttysw, character image included.
+ */
+Pkg_private void
+ttysw_terminal_destroy(ttysw)
+    Ttysw          *ttysw;
+{
+    if (ttysw->terminal == NULL)
+	return;
+    ttysw_term = ttysw->terminal;
+    ttysw_hist_free();
+    xv_tty_free_image_and_mode();
+    if (ttysw->terminal->damage)
+	free((char *) ttysw->terminal->damage);
+    free((char *) ttysw->terminal);
+    ttysw->terminal = NULL;
+    ttysw_term = &ttysw_default_terminal;
+}
+
+/*
+ * Make the terminal of ttysw the one the character image, screen and
+ * escape sequence routines work on.
+ */
+Pkg_private void
+ttysw_use_terminal(ttysw)
+    Ttysw          *ttysw;
+{
+    if (ttysw && ttysw->terminal)
+	ttysw_term = ttysw->terminal;
+}
 
 /*
  * Initialize initial character image.
@@ -193,6 +245,9 @@ ttysw_imagerepair(ttysw_view)
     int             topstart;
     int             i;
 
+    /* Damage noted for the old size means nothing for the new one. */
+    if (ttysw_term->deferred)
+	ttysw_term->repaint_all = TRUE;
     /*
      * Get new image and image description
      */
@@ -245,6 +300,9 @@ ttysw_imagerepair(ttysw_view)
     image = oldimage;
     oldimage = (CHAR **) 0;
 
+    /* Rows that no longer fit go to the history, as if scrolled off. */
+    ttysw_hist_save(ttysw_top, topstart);
+
     for (oldrow = topstart, row = 0; oldrow < oldbottom; oldrow++, row++) {
 	register int    sl = STRLEN(image[oldrow]);
 #ifdef	DEBUG_LINELENGTH_WHEN_WRAP
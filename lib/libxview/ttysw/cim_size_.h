@@ -4,6 +4,9 @@
 #include <xview/pkg.h>
 #include <xview_private/tty_impl.h>
 
+Pkg_private int ttysw_terminal_create(Ttysw *ttysw);
+Pkg_private void ttysw_terminal_destroy(Ttysw *ttysw);
+Pkg_private void ttysw_use_terminal(Ttysw *ttysw);
 Pkg_private int xv_tty_imageinit(Ttysw *ttysw, Xv_object window);
 Pkg_private void xv_tty_imagealloc(Ttysw *ttysw, int for_temp);
 Pkg_private void xv_tty_free_image_and_mode(void);
@@ -14,6 +14,7 @@ static char     sccsid[] = "@(#)csr_change.c 20.51 93/06/28";
  */
 
 #include <xview_private/csr_change_.h>
+#include <xview_private/cim_hist_.h>
 #include <xview_private/ttyansi_.h>
 #include <xview_private/tty_newtxt_.h>
 #include <xview_private/ttyselect_.h>
@@ -40,6 +41,7 @@ static char     sccsid[] = "@(#)csr_change.c 20.51 93/06/28";
 
 #include <xview_private/charimage.h>
 #include <xview_private/charscreen.h>
+#include <xview_private/portable.h>
 #undef CTRL
 #include <xview_private/ttyansi.h>
 #include <xview_private/term_impl.h>
@@ -61,15 +63,19 @@ extern char *xv_shell_prompt;
 
 #define TTYSW_HOME_CHAR	'A'
 
-extern Xv_Window csr_pixwin;
-extern int      cursor;		/* NOCURSOR, UNDERCURSOR, BLOCKCURSOR */
-
+static void ttysw_pdamage(int col, int fromrow, int torow);
+static void ttysw_pscrolled(int count);
 static void ttysw_displayrow(register int row, register int leftcol);
+static void ttysw_displayline(CHAR *line, char *mode, register int row, register int leftcol);
 static void ttysw_paintCursor(int op);
 
-static int      caretx, carety, lxhome;
-static short    charcursx, charcursy;
-
+/* State of the current terminal's screen, see charimage.h */
+#define cursor		(ttysw_term->cursor)
+#define caretx		(ttysw_term->caretx)
+#define carety		(ttysw_term->carety)
+#define lxhome		(ttysw_term->lxhome)
+#define charcursx	(ttysw_term->charcursx)
+#define charcursy	(ttysw_term->charcursy)
 
 #ifdef  OW_I18N
 /*
@@ -77,12 +83,17 @@ static short    charcursx, charcursy;
  *      drawn , so that when deleting the cursor , we can construct
  *      the reversed image easily.
  */
-static  int     curs_width;
+#define curs_width	(ttysw_term->curs_width)
 #endif
 
-static int      boldstyle, inverse_mode, underline_mode;
+#define UNDAMAGED	0x7FFF		/* in ttysw_term->damage */
+
+#define boldstyle	(ttysw_term->boldstyle)
+#define inverse_mode	(ttysw_term->inverse_mode)
+#define underline_mode	(ttysw_term->underline_mode)
 
 extern struct timeval ttysw_bell_tv;	/* initialized to 1/10 second */
+extern int      do_cursor_draw;
 
 static u_short  ttysw_gray17_data[16] = {	/* really 16-2/3	 */
     0x8208, 0x2082, 0x0410, 0x1041, 0x4104, 0x0820, 0x8208, 0x2082,
@@ -225,6 +236,10 @@ ttysw_pstring(s, mode, col, row, op)
     }
     if (s == 0)
 	return;
+    if (ttysw_term->deferred) {
+	ttysw_pdamage(col, row, row + 1);
+	return;
+    }
     ttysw_fixup_display_mode(&mode);
 
 #ifdef  OW_I18N
@@ -329,6 +344,10 @@ ttysw_pclearline(fromcol, tocol, row)
 
     if (delaypainting)
 	return;
+    if (ttysw_term->deferred) {
+	ttysw_pdamage(fromcol, row, row + 1);
+	return;
+    }
     (void) tty_background(csr_pixwin, 
 			  col_to_x(fromcol)-klu1284, row_to_y(row),
 			  col_to_x(tocol) - col_to_x(fromcol)+klu1284,
@@ -342,6 +361,10 @@ ttysw_pcopyline(tocol, fromcol, count, row)
     int             pix_width = (count * chrwidth);
     if (delaypainting)
 	return;
+    if (ttysw_term->deferred) {
+	ttysw_pdamage(MIN(tocol, fromcol), row, row + 1);
+	return;
+    }
     (void) tty_copyarea(csr_pixwin,
 		     col_to_x(fromcol)-1, row_to_y(row), pix_width+1, chrheight,
 			col_to_x(tocol)-1, row_to_y(row));
@@ -354,6 +377,10 @@ ttysw_pclearscreen(fromrow, torow)
 {
     if (delaypainting)
 	return;
+    if (ttysw_term->deferred) {
+	ttysw_pdamage(0, fromrow, torow);
+	return;
+    }
     (void) tty_background(csr_pixwin, col_to_x(ttysw_left)-1,
 			  row_to_y(fromrow),
 			  winwidthp+1, row_to_y(torow - fromrow), PIX_CLR);
@@ -365,15 +392,138 @@ ttysw_pcopyscreen(fromrow, torow, count)
 {
     if (delaypainting)
 	return;
+    if (ttysw_term->deferred) {
+	if (torow == ttysw_top && fromrow > torow &&
+	    fromrow + count == ttysw_bottom)
+	    ttysw_pscrolled(fromrow - torow);
+	else
+	    ttysw_pdamage(0, torow, torow + count);
+	return;
+    }
     (void) tty_copyarea(csr_pixwin,
 			col_to_x(ttysw_left)-1, row_to_y(fromrow), winwidthp+1, row_to_y(count),
 			col_to_x(ttysw_left)-1, row_to_y(torow));
     tty_synccopyarea(csr_pixwin);
 }
 
+/*
+ * Defer painting output.  Until ttysw_pflush the routines above only note
+ * the first column of each row that changed and how far the whole screen
+ * scrolled up, so that a burst of output is painted once, with a single
+ * copy for all of its line feeds.  The cursor must be off the screen.
+ */
+Pkg_private void
+ttysw_pdefer()
+{
+    register struct ttysw_terminal *term = ttysw_term;
+    register int    row;
+
+    if (term->deferred)
+	return;
+    if (term->damage == NULL) {
+	term->damage = (short *) malloc((unsigned) term->maxbottom *
+					sizeof(short));
+	if (term->damage == NULL)
+	    return;
+    }
+    for (row = 0; row < term->maxbottom; row++)
+	term->damage[row] = UNDAMAGED;
+    term->scrolled = 0;
+    term->repaint_all = FALSE;
+    term->deferred = TRUE;
+}
+
+/*
+ * Paint what changed since ttysw_pdefer and put the cursor back, unless
+ * output is being processed right now.
+ */
+Pkg_private void
+ttysw_pflush()
+{
+    register struct ttysw_terminal *term = ttysw_term;
+    register int    row, first;
+    int             x;
+
+    term->refresh_set = FALSE;
+    term->parsed = 0;
+    ttysw_hist_update();
+    if (!term->deferred || term->hist_offset)
+	return;
+    term->deferred = FALSE;
+    if (term->repaint_all)
+	(void) ttysw_pdisplayscreen(1);
+    else if (!delaypainting) {	/* else it will repaint everything itself */
+	if (term->scrolled)
+	    (void) ttysw_pcopyscreen(ttysw_top + term->scrolled, ttysw_top,
+				     ttysw_bottom - ttysw_top - term->scrolled);
+	for (row = ttysw_top; row < ttysw_bottom; row++) {
+	    if ((first = term->damage[row]) == UNDAMAGED)
+		continue;
+	    x = col_to_x(first) - (first == 0 ? 1 : 0);
+	    (void) tty_background(csr_pixwin, x, row_to_y(row),
+				  col_to_x(ttysw_left) + winwidthp - x,
+				  chrheight, PIX_CLR);
+	    ttysw_displayrow(row, first);
+	}
+    }
+    if (do_cursor_draw)
+	(void) ttysw_drawCursor(charcursy, charcursx);
+}
+
+static void
+ttysw_pdamage(col, fromrow, torow)
+    int             col, fromrow, torow;
+{
+    register short *damage = ttysw_term->damage;
+
+    if (col < 0)
+	col = 0;
+    if (fromrow < 0)
+	fromrow = 0;
+    if (torow > ttysw_bottom)
+	torow = ttysw_bottom;
+    for (; fromrow < torow; fromrow++)
+	if (col < damage[fromrow])
+	    damage[fromrow] = col;
+}
+
+/*
+ * The rows from ttysw_top to ttysw_bottom moved up count rows: so do their
+ * damage, and the rows uncovered at the bottom have to be painted.
+ */
+static void
+ttysw_pscrolled(count)
+    int             count;
+{
+    register struct ttysw_terminal *term = ttysw_term;
+    int             rows = ttysw_bottom - ttysw_top;
+
+    term->scrolled += count;
+    if (term->scrolled >= rows) {
+	/* Nothing left worth copying */
+	term->scrolled = 0;
+	ttysw_pdamage(0, ttysw_top, ttysw_bottom);
+	return;
+    }
+    XV_BCOPY((char *) (term->damage + ttysw_top + count),
+	     (char *) (term->damage + ttysw_top),
+	     (rows - count) * sizeof(short));
+    ttysw_pdamage(0, ttysw_bottom - count, ttysw_bottom);
+}
+
 static void
 ttysw_displayrow(row, leftcol)
 	register int row, leftcol;
+{
+	ttysw_displayline(image[row], screenmode[row], row, leftcol);
+}
+
+/* Paint line, with modes mode, on row from leftcol on. */
+static void
+ttysw_displayline(line, mode, row, leftcol)
+	CHAR		*line;
+	char		*mode;
+	register int	row, leftcol;
 {
 	register int	colstart, blanks, colfirst;
 	register CHAR  *strstart, *strfirst;
@@ -384,7 +534,7 @@ ttysw_displayrow(row, leftcol)
 	colfirst = 0;
 	colstart = leftcol;
 
-	if ((unsigned char)leftcol < LINE_LENGTH(image[row])) {
+	if ((unsigned char)leftcol < LINE_LENGTH(line)) {
 #ifdef OW_I18N
 		strfirst = NULL_CHARP;
 #else
@@ -392,8 +542,8 @@ ttysw_displayrow(row, leftcol)
 #endif
 		modefirst = MODE_CLEAR;
 		blanks = 1;
-		for (strstart = image[row] + leftcol,
-		     modestart = screenmode[row] + leftcol; *strstart;
+		for (strstart = line + leftcol,
+		     modestart = mode + leftcol; *strstart;
 		     strstart++, modestart++, colstart++) {
 		    /*
 		     * Find beginning of bold string
@@ -443,6 +593,10 @@ ttysw_pdisplayscreen(dontrestorecursor)
     int row;
 
     delaypainting = 0;
+    if (ttysw_term->deferred) {
+	ttysw_term->repaint_all = TRUE;
+	return;
+    }
     /*
      * refresh the entire image.
      */
@@ -460,6 +614,34 @@ ttysw_pdisplayscreen(dontrestorecursor)
 	(void) ttysw_removeCursor();
 }
 
+/*
+ * Paint the screen ttysw_term->hist_offset rows back into the history.
+ */
+Pkg_private void
+ttysw_pdisplayhistory()
+{
+    register struct ttysw_terminal *term = ttysw_term;
+    struct rect    *rect;
+    CHAR            line[256 + 2];	/* as a row of the image */
+    char            mode[256 + 2];
+    int             count = ttysw_hist_lines();
+    int             row, n, deferred = term->deferred;
+
+    term->deferred = FALSE;		/* painting it is all we do */
+    rect = (struct rect *) xv_get(csr_pixwin, WIN_RECT);
+    (void) tty_background(csr_pixwin, 0, 0,
+			  rect->r_width+1, rect->r_height, PIX_CLR);
+    for (row = ttysw_top; row < ttysw_bottom; row++) {
+	n = count - term->hist_offset + row - ttysw_top;
+	if (n < count) {
+	    (void) ttysw_hist_line(n, line + 1, mode + 1);
+	    ttysw_displayline(line + 1, mode + 1, row, 0);
+	} else
+	    ttysw_displayline(image[n - count], screenmode[n - count], row, 0);
+    }
+    term->deferred = deferred;
+}
+
 /* ARGSUSED */
 Pkg_private void
 ttysw_prepair(eventp)
@@ -474,12 +656,19 @@ ttysw_prepair(eventp)
 	/* 
 	 * Handles expose and graphics expose events for the ttysw.   
 	 */
+	(void) ttysw_pflush();
 
 	/* Get the expose events, ignore textsw caret checking with -10000 */
 	exposed = tty_calc_exposed_lines(csr_pixwin, eventp, -10000);
 
 	leftcol = x_to_col(exposed->leftmost);
 
+	if (ttysw_term->hist_offset) {
+		ttysw_pdisplayhistory();
+		tty_clear_clip_rectangles(csr_pixwin);
+		return;
+	}
+
 	/* 
 	 * Check damage on for cursor:
 	 * When the cursor is light, it actually appears
@@ -596,7 +785,7 @@ int yChar, xChar;
     charcursy = yChar;
     caretx = col_to_x(xChar);
     carety = row_to_y(yChar);
-    if (delaypainting || cursor == NOCURSOR)
+    if (delaypainting || ttysw_term->deferred || cursor == NOCURSOR)
 	return;
 #ifdef  OW_I18N
 /*
@@ -674,7 +863,7 @@ ttysw_paintCursor(op)
 Pkg_private void
 ttysw_removeCursor()
 {
-    if (delaypainting || cursor == NOCURSOR)
+    if (delaypainting || ttysw_term->deferred || cursor == NOCURSOR)
 	return;
 #ifdef  OW_I18N
 /*
@@ -723,6 +912,8 @@ ttysw_pselectionhilite(r, sel_rank)
 {
     struct rect     rectlock;
 
+    /* Highlighting is xor'ed, so the screen must be up to date. */
+    (void) ttysw_pflush();
     rectlock = *r;
     rect_marginadjust(&rectlock, 1);
     if (sel_rank == SELN_PRIMARY)
@@ -21,7 +21,10 @@ Pkg_private void ttysw_pclearscreen(int fromrow, int torow);
 Pkg_private void ttysw_pcopyscreen(int fromrow, int torow, int count);
 
 
+Pkg_private void ttysw_pdefer(void);
+Pkg_private void ttysw_pflush(void);
 Pkg_private void ttysw_pdisplayscreen(int dontrestorecursor);
+Pkg_private void ttysw_pdisplayhistory(void);
 Pkg_private void ttysw_prepair(XEvent *eventp);
 Pkg_private void ttysw_drawCursor(int yChar, int xChar);
 
@@ -50,8 +50,6 @@ static char     sccsid[] = "@(#)csr_init.c 20.31 93/06/28";
 #include <xview_private/term_impl.h>
 #endif /* FULL_R5 */
 #endif /* OW_I18N */
-	
-Xv_Window       csr_pixwin;
 
 /*
  * Character screen initialization
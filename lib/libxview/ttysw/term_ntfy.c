@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)term_ntfy.c 20.60 93/06/28";
  */
 #include <xview_private/term_ntfy_.h>
 #include <xview_private/attr_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/txt_dbx_.h>
 #include <xview_private/txt_sel_.h>
@@ -132,6 +133,7 @@ ttysw_text_event(textsw, event, arg, type)
 			? event_action(event) : event_id(event);
     register int    down_event = event_is_down(event);
 
+    ttysw_use_terminal(ttysw);
     if (!down_event && (action >= ASCII_FIRST) && (action <= ASCII_LAST))
 	return (NOTIFY_DONE);
 
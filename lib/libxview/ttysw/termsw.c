@@ -44,6 +44,7 @@ static char     sccsid[] = "@(#)termsw.c 1.59 93/06/28";
 #include <xview_private/term_impl.h>
 #include <xview_private/portable.h>
 #include <xview/scrollbar.h>
+#include <xview_private/charimage.h>
 #include <xview_private/charscreen.h>
 #include <X11/Xlib.h>
 #ifdef OW_I18N
@@ -67,8 +68,6 @@ static void termsw_register_view(Termsw termsw_public, Xv_Window termsw_view_pub
 static void termsw_unlink_view(register Termsw_folio folio, register Termsw_view_handle view);
 static void termsw_unregister_view(Termsw termsw_public, Xv_Window termsw_view_public);
 
-Pkg_private Xv_Window csr_pixwin;
-
 /*
  * Key data for notice hung off frame
  */
@@ -15,6 +15,8 @@ static char     sccsid[] = "@(#)tty.c 20.64 93/06/28";
 
 #include <xview_private/tty_.h>
 #include <xview_private/attr_.h>
+#include <xview_private/cim_hist_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/csr_init_.h>
 #include <xview_private/defaults_.h>
@@ -42,6 +44,7 @@ static char     sccsid[] = "@(#)tty.c 20.64 93/06/28";
 #include <xview/termsw.h>
 #include <xview_private/term_impl.h>
 #include <xview/scrollbar.h>
+#include <xview_private/charimage.h>
 #include <xview_private/charscreen.h>
 
 #ifdef SVR4
@@ -74,8 +77,6 @@ static void tty_handle_death(Ttysw_folio tty_folio_private, int pid, union wait
 static void tty_handle_death(Ttysw_folio tty_folio_private, int pid, int *status, struct rusage *rusage);
 #endif
 
-extern Xv_Window csr_pixwin;
-
 static Pixfont* change_font;
 
 /*****************************************************************************/
@@ -161,6 +162,7 @@ tty_view_init(parent, tty_view_public, avlist)
      * BUG ALERT!  Re-arrange code to pass this pixwin into the appropriate
      * layer instead of just smashing it set from here!
      */
+    ttysw_use_terminal(TTY_PRIVATE_FROM_ANY_PUBLIC(parent));
     csr_pixwin = tty_view_public;
 
 
@@ -218,6 +220,7 @@ ttysw_set_internal(tty_public, avlist)
     Tty		ttysw_pub;
 #endif
 
+    ttysw_use_terminal(ttysw);
     for (attrs = avlist; *attrs; attrs = attr_next(attrs)) {
 	switch ((int)attrs[0]) {
 
@@ -304,6 +307,10 @@ ttysw_set_internal(tty_public, avlist)
 	    (void) ttysw_set_underline_mode((int) attrs[1]);
 	    break;
 
+	  case TTY_SCROLLBACK_BYTES:
+	    ttysw_hist_set_size(ttysw, (int) attrs[1]);
+	    break;
+
 	  case WIN_FONT:
 	    {
 
@@ -362,6 +369,7 @@ ttysw_set_internal(tty_public, avlist)
 		do_fork = TRUE;
 	    if (ttysw->view)
 		ttysw_resize(ttysw->view);
+	    ttysw_hist_create(ttysw);
 
             if( change_font )
             {
@@ -495,6 +503,9 @@ ttysw_get_internal(tty_public, status, attr, args)
       case TTY_TTY_FD:
 	return (Xv_opaque) ttysw->ttysw_tty;
 
+      case TTY_SCROLLBACK_BYTES:
+	return (Xv_opaque) ttysw->terminal->hist_bytes;
+
       case WIN_TYPE:		/* SunView1.X compatibility */
 	return (Xv_opaque) TTY_TYPE;
 
@@ -610,6 +621,7 @@ ttysw_view_destroy(ttysw_view_public, status)
 
 
     if ((status != DESTROY_CHECKING) && (status != DESTROY_SAVE_YOURSELF)) {
+	ttysw_use_terminal(ttysw_view_private->folio);
 	csr_pixwin = (Xv_Window)NULL;
 	free((char *) ttysw_view_private);
     }
@@ -87,6 +87,7 @@ typedef enum {
 	TTY_PAGE_MODE		= TTY_ATTR(ATTR_BOOLEAN,	20),
 	TTY_QUIT_ON_CHILD_DEATH
 				= TTY_ATTR(ATTR_BOOLEAN,	25),
+	TTY_SCROLLBACK_BYTES	= TTY_ATTR(ATTR_INT,		70),
 	/*
 	 * Private attributes 
 	 */
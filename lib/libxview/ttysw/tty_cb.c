@@ -19,6 +19,7 @@ static char     sccsid[] = "@(#)tty_cb.c %I 93/06/28";
 #include <xview/ttysw.h>
 #include <xview/termsw.h>
 #include <xview_private/tty_impl.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/term_impl.h>
 #include <xview_private/i18n_impl.h>
 #include <xview_private/charimage.h>
@@ -49,6 +50,7 @@ XPointer 	callback_data;
 
     ttysw_public = (Tty)client_data;
     folio = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw_public);
+    ttysw_use_terminal(folio);
 
 
     folio->im_first_col = TTYSW_GET_COL(folio);
@@ -98,6 +100,7 @@ XIMPreeditDrawCallbackStruct 	*callback_data;
 
     ttysw_public = (Tty)client_data;
     folio = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw_public);
+    ttysw_use_terminal(folio);
 
     if( !folio->preedit_state ) {
 	tty_text_start(ic, client_data, callback_data);
@@ -375,6 +378,7 @@ XPointer 	callback_data;
 
     ttysw_public = (Tty)client_data;
     folio = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw_public);
+    ttysw_use_terminal(folio);
 
     folio->preedit_state = FALSE;
 
@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)tty_compat.c 20.21 93/06/28";
  */
 
 #include <xview_private/tty_compat_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/tty_main_.h>
 #include <sys/types.h>
 #include <sys/time.h>
@@ -52,7 +53,10 @@ ttysw_input(ttysw0, addr, len)
     char           *addr;
     int             len;
 {
-    return (ttysw_input_it(TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw0), addr, len));
+    Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw0);
+
+    ttysw_use_terminal(ttysw);
+    return (ttysw_input_it(ttysw, addr, len));
 }
 
 #ifdef OW_I18N
@@ -62,7 +66,10 @@ ttysw_input_wcs(ttysw0, addr, len)
     wchar_t           *addr;
     int               len;
 {
-    return (ttysw_input_it_wcs(TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw0), addr, len));
+    Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw0);
+
+    ttysw_use_terminal(ttysw);
+    return (ttysw_input_it_wcs(ttysw, addr, len));
 }
 #endif
 
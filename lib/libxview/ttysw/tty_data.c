@@ -23,7 +23,6 @@ static char     sccsid[] = "@(#)tty_data.c 20.17 93/06/28";
 #include <xview_private/ttyansi.h>
 
 
-int             cursor = BLOCKCURSOR | LIGHTCURSOR;
 int		tty_has_new_bufmod;			/* used to defeat 5.0
 							   user-land pty
 							   buffering hack
@@ -59,11 +59,15 @@
  * implementation.  They are considered private to the implementation.
  */
 
+#define TTYSW_OBUF_MIN	2048	/* output buffer to start with */
+#define TTYSW_OBUF_MAX	65536	/* most it grows to, see ttysw_pty_input */
+
 struct cbuf {
     CHAR               *cb_rbp;    /* read pointer */
     CHAR               *cb_wbp;    /* write pointer */
     CHAR               *cb_ebp;    /* end of buffer */
-    CHAR                cb_buf[2048];
+    CHAR               *cb_buf;    /* cb_first, or grown */
+    CHAR                cb_first[TTYSW_OBUF_MIN];
 };
 
 struct input_cbuf {
@@ -122,6 +126,9 @@ typedef struct ttysubwindow {
     struct cbuf         ttysw_obuf;		/* output buffer */
     /* pty and subprocess */
     int                 ttysw_pty;	/* master (pty) file descriptor */
+    /* Accelerators to avoid excessive notifier activity */
+    int                 waiting_for_pty_input;	/* input func is set */
+    int                 waiting_for_pty_output;	/* output func is set */
     int                 ttysw_tty;	/* slave (tty) file descriptor */
     char		tty_name[20];	/* slave (tty) file name */
     int                 ttysw_ttyslot;		/* ttyslot in utmp for tty */
@@ -186,6 +193,7 @@ typedef struct ttysubwindow {
 #endif
     int			pass_thru_modifiers;  /* Modifiers we don't interpret */
     int			eight_bit_output; /* Print eight bit characters? */
+    struct ttysw_terminal *terminal;	/* Screen model; see charimage.h */
 }   Ttysw;
 
 typedef Ttysw		*Ttysw_folio;
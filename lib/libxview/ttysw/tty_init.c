@@ -93,6 +93,7 @@ static char     sccsid[] = "@(#)tty_init.c 20.71 93/06/28";
 #include <xview/scrollbar.h>
 #include <xview_private/term_impl.h>
 #include <xview_private/tty_impl.h>	/* for WE_TTYPARMS */
+#include <xview_private/charimage.h>
 #include <xview_private/charscreen.h>
 #include <xview_private/draw_impl.h>
 
@@ -241,6 +242,10 @@ ttysw_init_folio_internal(tty_public)
 
     ((Xv_tty *) tty_public)->private_data = (Xv_opaque) ttysw;
     ttysw->public_self = (Tty) tty_public;
+    if (!ttysw_terminal_create(ttysw)) {
+	free((char *) ttysw);
+	return ((Xv_opaque) NULL);
+    }
 
     ttysw->ttysw_eventop = ttysw_eventstd;
     /* Following call only affect appearance of ttysw, not termsw */
@@ -256,6 +261,10 @@ ttysw_init_folio_internal(tty_public)
 				    defaults_lookup(
 						    (char *) defaults_get_string("term.underlineStyle", "Term.UnderlineStyle", "Enable"),
 					       inverse_and_underline_mode));
+    /* The history itself is made at XV_END_CREATE, and never for a termsw */
+    ttysw->terminal->hist_bytes = defaults_get_integer_check(
+		"term.scrollbackBytes", "Term.ScrollbackBytes",
+		TTYSW_HIST_BYTES, 0, 64 * TTYSW_HIST_BYTES);
 
     ttysw->ttysw_ibuf.cb_rbp = ttysw->ttysw_ibuf.cb_buf;
     ttysw->ttysw_ibuf.cb_wbp = ttysw->ttysw_ibuf.cb_buf;
@@ -278,6 +287,7 @@ ttysw_init_folio_internal(tty_public)
 	&ttysw->ttysw_ibuf.cb_buf[sizeof(ttysw->ttysw_ibuf.cb_buf)];
 #endif
 #endif
+    ttysw->ttysw_obuf.cb_buf = ttysw->ttysw_obuf.cb_first;
     ttysw->ttysw_obuf.cb_rbp = ttysw->ttysw_obuf.cb_buf;
     ttysw->ttysw_obuf.cb_wbp = ttysw->ttysw_obuf.cb_buf;
 #if 1
@@ -285,19 +295,9 @@ ttysw_init_folio_internal(tty_public)
      * So we keep one spare byte at its end to prevent overwriting other data.
      * martin-2.buck@student.uni-ulm.de
      */
-    ttysw->ttysw_obuf.cb_ebp =
-#ifdef OW_I18N
-        &ttysw->ttysw_obuf.cb_buf[sizeof(ttysw->ttysw_obuf.cb_buf)/sizeof(CHAR) - 1];
+    ttysw->ttysw_obuf.cb_ebp = &ttysw->ttysw_obuf.cb_buf[TTYSW_OBUF_MIN - 1];
 #else
-	&ttysw->ttysw_obuf.cb_buf[sizeof(ttysw->ttysw_obuf.cb_buf) - 1];
-#endif
-#else
-    ttysw->ttysw_obuf.cb_ebp =
-#ifdef OW_I18N
-        &ttysw->ttysw_obuf.cb_buf[sizeof(ttysw->ttysw_obuf.cb_buf)/sizeof(CHAR)];
-#else
-	&ttysw->ttysw_obuf.cb_buf[sizeof(ttysw->ttysw_obuf.cb_buf)];
-#endif
+    ttysw->ttysw_obuf.cb_ebp = &ttysw->ttysw_obuf.cb_buf[TTYSW_OBUF_MIN];
 #endif
     ttysw->ttysw_kmtp = ttysw->ttysw_kmt;
 
@@ -306,6 +306,7 @@ ttysw_init_folio_internal(tty_public)
     xv_set(tty_public, XV_HELP_DATA, "xview:ttysw", NULL);
 
     if (ttyinit(ttysw) == XV_ERROR) {
+	ttysw_terminal_destroy(ttysw);
 	free((char *) ttysw);
 	return ((Xv_opaque) NULL);
     }
@@ -699,6 +700,10 @@ ttysw_done(ttysw_folio_private)
 	free((char *) ttysw_folio_private->im_attr);
 #endif
 
+    if (ttysw_folio_private->ttysw_obuf.cb_buf !=
+	ttysw_folio_private->ttysw_obuf.cb_first)
+	free((char *) ttysw_folio_private->ttysw_obuf.cb_buf);
+    ttysw_terminal_destroy(ttysw_folio_private);
     free((char *) ttysw_folio_private);
 }
 
@@ -16,6 +16,8 @@ static char     sccsid[] = "@(#)tty_main.c 20.93 93/06/28";
  */
 
 #include <xview_private/tty_main_.h>
+#include <xview_private/cim_hist_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/tty_menu_.h>
@@ -65,12 +67,13 @@ static char     sccsid[] = "@(#)tty_main.c 20.93 93/06/28";
 #include <xview_private/tty_impl.h>
 #include <xview_private/draw_impl.h>
 #include <xview/sel_svc.h>
+#include <xview_private/charimage.h>
+#include <xview_private/charscreen.h>
 
 #ifdef OW_I18N
 #include <widec.h>
 #include <wctype.h>
 #include <stdlib.h>
-#include <xview_private/charimage.h>
 #ifdef FULL_R5
 #include <X11/Xlib.h>
 #endif /* FULL_R5 */    
@@ -96,6 +99,8 @@ static int ttysw_process_point(register Ttysw_folio ttysw, register struct input
 static int ttysw_process_adjust(register Ttysw_folio ttysw, register struct inputevent *ie);
 static int ttysw_process_motion(register Ttysw_folio ttysw, register struct inputevent *ie);
 static int ttysw_process_keyboard(Ttysw_folio ttysw, struct inputevent *ie);
+static void ttysw_pty_read(register Ttysw_folio ttysw, int pty);
+static int ttysw_grow_obuf(register Ttysw_folio ttysw);
 
 /*
  * jcb	-- remove continual cursor repaint in shelltool windows also known to
@@ -116,6 +121,8 @@ extern int	tty_has_new_bufmod;
 #define	oebp	ttysw->ttysw_obuf.cb_ebp
 #define	obuf	ttysw->ttysw_obuf.cb_buf
 
+#define	TTYSW_USEC_READ	5000	/* most time spent reading a batch */
+
 /* #ifdef TERMSW */
 /*
  * The basic strategy for building a line-oriented command subwindow
@@ -514,8 +521,8 @@ ttysw_process_STI(ttysw, cp, cc)
  * 5) The data buffer we're given is large enough to hold an iocblk plus
  *    associated data.
  */
-Pkg_private void
-ttysw_pty_input(ttysw, pty)
+static void
+ttysw_pty_read(ttysw, pty)
     register Ttysw_folio	ttysw;
     int				pty;
 {
@@ -558,6 +565,8 @@ get_some_more:
      * will not write outside of the buffer.
      */
     databuf.maxlen = ((oebp - owbp) - mb_buf_length) - 1;
+    if (databuf.maxlen > MB_BUF_MAX - mb_buf_length - 1)
+	databuf.maxlen = MB_BUF_MAX - mb_buf_length - 1;
     databuf.buf = (char *)mb_data;
 #else /* OW_I18N */
     databuf.maxlen = oebp - owbp;
@@ -825,8 +834,8 @@ process_mb_buf:
 
 #else	/* XV_USE_SVR4_PTYS */
 
-Pkg_private void
-ttysw_pty_input(ttysw, pty)
+static void
+ttysw_pty_read(ttysw, pty)
     register Ttysw_folio ttysw;
     int             pty;
 {
@@ -961,6 +970,65 @@ ttysw_pty_input(ttysw, pty)
 
 #endif 	/* XV_USE_SVR4_PTYS */
 
+/*
+ * Read the program's output in batches: keep reading the pty for as long
+ * as each read fills what room there is, growing the output buffer up to
+ * TTYSW_OBUF_MAX and for at most TTYSW_USEC_READ, so that a busy program
+ * costs one trip through the notifier, and one parse, per batch rather
+ * than per read.
+ */
+Pkg_private void
+ttysw_pty_input(ttysw, pty)
+    register Ttysw_folio ttysw;
+    int             pty;
+{
+    struct timeval  start, now;
+    CHAR           *wbp;
+    int             room;
+
+    (void) gettimeofday(&start, (struct timezone *) 0);
+    for (;;) {
+	if (oebp - owbp < TTYSW_OBUF_MIN / 2 && !ttysw_grow_obuf(ttysw))
+	    return;
+	wbp = owbp;
+	room = oebp - owbp;
+	ttysw_pty_read(ttysw, pty);
+	/* Less than asked for: the pty has been drained. */
+	if (owbp - wbp < room / 2 || ttysw->ttysw_flags & TTYSW_FL_FROZEN)
+	    return;
+	(void) gettimeofday(&now, (struct timezone *) 0);
+	if ((now.tv_sec - start.tv_sec) * 1000000 +
+	    (now.tv_usec - start.tv_usec) >= TTYSW_USEC_READ)
+	    return;
+    }
+}
+
+/*
+ * Double the output buffer, keeping what is in it.  Returns 0 once it is
+ * TTYSW_OBUF_MAX characters.
+ */
+static int
+ttysw_grow_obuf(ttysw)
+    register Ttysw_folio ttysw;
+{
+    int             size = oebp - obuf + 1;	/* with the spare one */
+    CHAR           *buf;
+
+    if (size >= TTYSW_OBUF_MAX)
+	return (0);
+    size = MIN(2 * size, TTYSW_OBUF_MAX);
+    if ((buf = (CHAR *) malloc((unsigned) size * sizeof(CHAR))) == NULL)
+	return (0);
+    XV_BCOPY((char *) orbp, (char *) buf, (owbp - orbp) * sizeof(CHAR));
+    owbp = buf + (owbp - orbp);
+    orbp = buf;
+    if (obuf != ttysw->ttysw_obuf.cb_first)
+	free((char *) obuf);
+    obuf = buf;
+    oebp = buf + size - 1;
+    return (1);
+}
+
 /*
  * Send program output to terminal emulator.
  */
@@ -973,6 +1041,9 @@ ttysw_consume_output(ttysw_view)
     short           is_not_text;
     int             cc;
 
+    /* Output shows the screen again, if scrolled back into the history. */
+    if (ttysw_term->hist_offset && owbp > orbp)
+	ttysw_hist_view(ttysw, 0);
     /* cache the cursor removal and re-render once in this set -- jcb */
     if (is_not_text = !ttysw_getopt((Ttysw_folio) ttysw, TTYOPT_TEXT)) {
 	(void) ttysw_removeCursor();
@@ -993,6 +1064,8 @@ ttysw_consume_output(ttysw_view)
 	} else
 	    ttysw->implicit_commit = 0;		/* turn off the flag */
 #endif
+	    /* Paint it at the next refresh, see ttysw_reset_conditions */
+	    (void) ttysw_pdefer();
 	}
 #ifdef DEBUG
 	printf("ttysw_consume_output(), calling ttysw_output_it() %d <%s>\n",
@@ -1013,6 +1086,8 @@ ttysw_consume_output(ttysw_view)
         }
 #endif
 	orbp += cc;
+	if (ttysw_term->deferred)
+	    ttysw_term->parsed += cc;
 	if (orbp == owbp)
 	    orbp = owbp = obuf;
     }
@@ -1254,13 +1329,16 @@ Pkg_private void
 ttysw_handle_itimer(ttysw)
     register Ttysw_folio ttysw;
 {
-    if (ttysw->ttysw_primary.sel_made) {
-	ttysel_deselect(&ttysw->ttysw_primary, SELN_PRIMARY);
-    }
-    if (ttysw->ttysw_secondary.sel_made) {
-	ttysel_deselect(&ttysw->ttysw_secondary, SELN_SECONDARY);
+    if (delaypainting) {
+	if (ttysw->ttysw_primary.sel_made) {
+	    ttysel_deselect(&ttysw->ttysw_primary, SELN_PRIMARY);
+	}
+	if (ttysw->ttysw_secondary.sel_made) {
+	    ttysel_deselect(&ttysw->ttysw_secondary, SELN_SECONDARY);
+	}
+	(void) ttysw_pdisplayscreen(0);
     }
-    (void) ttysw_pdisplayscreen(0);
+    (void) ttysw_pflush();
 }
 
 /*
@@ -1277,6 +1355,12 @@ ttysw_eventstd(ttysw_view_public, ie)
     register Ttysw_folio ttysw = TTY_PRIVATE_FROM_ANY_VIEW(ttysw_view_public);
     register Tty    tty_public = TTY_PUBLIC(ttysw);
 
+    /* Callers need not have made this terminal current */
+    ttysw_use_terminal(ttysw);
+    /* Selections are made on the screen, not in the history. */
+    if (ttysw_term->hist_offset && win_inputposevent(ie) &&
+	(event_action(ie) == ACTION_SELECT || event_action(ie) == ACTION_ADJUST))
+	ttysw_hist_view(ttysw, 0);
     switch (event_action(ie)) {
       case KBD_USE:
       case KBD_DONE:
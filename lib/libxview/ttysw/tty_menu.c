@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)tty_menu.c 20.68 93/06/28";
  */
 
 #include <xview_private/tty_menu_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/gettext_.h>
 #include <xview_private/termsw_.h>
 #include <xview_private/tty_main_.h>
@@ -250,6 +251,7 @@ ttysw_menu_page(menu, mi)
     Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw_public);
 
 
+    ttysw_use_terminal(ttysw);
     if (ttysw->ttysw_flags & TTYSW_FL_FROZEN)
 	(void) ttysw_freeze(ttysw->view, 0);
     else
@@ -274,6 +276,7 @@ ttysw_menu_copy(menu, mi)
     Xv_Notice	tty_notice;
 
 
+    ttysw_use_terminal(ttysw);
     if (!ttysw_do_copy(ttysw)) {
 	Frame           frame = xv_get(ttysw_public, WIN_FRAME);
 	tty_notice = xv_get(frame, XV_KEY_DATA, (Attr_attribute)tty_notice_key, NULL);
@@ -324,6 +327,7 @@ ttysw_menu_paste(menu, mi)
     Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(ttysw_public);
     Xv_Notice	tty_notice;
 
+    ttysw_use_terminal(ttysw);
 #ifdef OW_I18N
     ttysw_implicit_commit(ttysw, 1);
 #endif
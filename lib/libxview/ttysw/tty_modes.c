@@ -55,12 +55,8 @@ static char sccsid[] = "@(#)tty_modes.c 20.54 93/06/28";
 #include <xview_private/ttyansi_.h>
 #include <xview_private/txt_disp_.h>
 #include <xview_private/txt_impl.h>
+#include <xview_private/charimage.h>
 
-int extern ttysw_waiting_for_pty_input;
-
-extern Xv_Window csr_pixwin;
-extern CHAR **image;
-extern char **screenmode;
 #ifdef SVR4
 extern int doremote;
 #endif
@@ -86,6 +82,7 @@ Ttysw_view_handle ttysw_view;
 	int win_ic_stat;
 #endif
 
+	ttysw_use_terminal(ttysw);
 	if (!ttysw_getopt(ttysw, TTYOPT_TEXT)) {
 		/* Already acting as a ttysw. */
 		return (-1);
@@ -154,12 +151,12 @@ Ttysw_view_handle ttysw_view;
 		ttysw_lighten_cursor();
 	}
 
-	if (!ttysw_waiting_for_pty_input) {
+	if (!ttysw->waiting_for_pty_input) {
 		(void)notify_set_input_func((Notify_client)(TTY_PUBLIC(ttysw)),
 					    ttysw_pty_input_pending,
 					    ttysw->ttysw_pty);
 		/* Wait for child process to die */
-		ttysw_waiting_for_pty_input = 1;
+		ttysw->waiting_for_pty_input = 1;
 	}
 	(void)ttysw_pdisplayscreen(FALSE);
 
@@ -217,6 +214,7 @@ Ttysw_view_handle ttysw_view;
 	Textsw_folio text_folio;
 #endif
 
+	ttysw_use_terminal(ttysw);
 	if ((!TTY_IS_TERMSW(ttysw)) || ttysw_getopt(ttysw, TTYOPT_TEXT))
 		return (-1);
 
@@ -226,6 +224,7 @@ Ttysw_view_handle ttysw_view;
 
 	termsw = TERMSW_PRIVATE(TTY_PUBLIC(ttysw));
 
+	(void) ttysw_pflush();
 	(void)notify_set_itimer_func(
 	    (Notify_client)(ttysw), ttysw_itimer_expired, ITIMER_REAL,
 	    (struct itimerval *)0, (struct itimerval *)0);
@@ -268,12 +267,12 @@ Ttysw_view_handle ttysw_view;
 #endif
 		ttysw->remote = ttysw->pending_remote;
 
-	if (!ttysw_waiting_for_pty_input) {
+	if (!ttysw->waiting_for_pty_input) {
 		(void)notify_set_input_func((Notify_client)(TTY_PUBLIC(ttysw)),
 					    ttysw_pty_input_pending,
 					    ttysw->ttysw_pty);
 		/* Wait for child process to die */
-		ttysw_waiting_for_pty_input = 1;
+		ttysw->waiting_for_pty_input = 1;
 	}
 	textsw_display_view(textsw_view, (Rect *)0);
 	if (xv_get(textsw, WIN_KBD_FOCUS)) {
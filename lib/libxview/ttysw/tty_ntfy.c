@@ -15,6 +15,7 @@ static char     sccsid[] = "@(#)tty_ntfy.c 20.45 93/06/28";
  */
 
 #include <xview_private/tty_ntfy_.h>
+#include <xview_private/cim_hist_.h>
 #include <xview_private/cim_size_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/defaults_.h>
@@ -52,6 +53,7 @@ static char     sccsid[] = "@(#)tty_ntfy.c 20.45 93/06/28";
 #include <xview/frame.h>
 #include <xview/termsw.h>
 #include <xview/window.h>
+#include <xview/scrollbar.h>
 #include <xview_private/tty_impl.h>
 #include <xview_private/term_impl.h>
 #include <xview_private/ultrix_cpt.h>
@@ -74,6 +76,8 @@ static char     sccsid[] = "@(#)tty_ntfy.c 20.45 93/06/28";
 #define ITIMER_NULL   ((struct itimerval *)0)
 
 #define	TTYSW_USEC_DELAY 100000
+#define	TTYSW_USEC_REFRESH 16667	/* paint output at most 60 times a second */
+#define	TTYSW_PARSE_AHEAD (4 * TTYSW_OBUF_MAX)	/* output per refresh, at most */
 /* Duplicate of what's in ttysw_tio.c */
 
 static Notify_value ttysw_pty_output_pending(Tty tty_public, int pty);
@@ -89,11 +93,6 @@ Notify_func     ttysw_cached_pri;	/* Default prioritizer */
  * d();
  */
 
-/* Accelerator to avoid excessive notifier activity */
-int             ttysw_waiting_for_pty_input;
-/* Accelerator to avoid excessive notifier activity */
-static int ttysw_waiting_for_pty_output;
-
 /* shorthand - Duplicate of what's in ttysw_main.c */
 
 #define	iwbp	ttysw->ttysw_ibuf.cb_wbp
@@ -111,7 +110,7 @@ ttysw_interpose(ttysw_folio)
 
     (void) notify_set_input_func((Notify_client) ttysw_folio_public,
 			   ttysw_pty_input_pending, ttysw_folio->ttysw_pty);
-    ttysw_waiting_for_pty_input = 1;
+    ttysw_folio->waiting_for_pty_input = 1;
     ttysw_cached_pri = notify_set_prioritizer_func(
 		     (Notify_client) ttysw_folio_public, ttysw_prioritizer);
 }
@@ -278,6 +277,11 @@ ttysw_event(ttysw_view_public, event, arg, type)
 {
     Ttysw_folio     ttysw_folio_private = TTY_PRIVATE_FROM_ANY_VIEW(ttysw_view_public);
 
+    ttysw_use_terminal(ttysw_folio_private);
+    if (event_action(event) == SCROLLBAR_REQUEST && ttysw_term->history) {
+	ttysw_hist_scroll(ttysw_folio_private, (Scrollbar) arg);
+	return (NOTIFY_DONE);
+    }
     if ((*(ttysw_folio_private)->ttysw_eventop) (ttysw_view_public, event) == TTY_DONE)
 #ifdef OW_I18N
 	/*
@@ -316,7 +320,10 @@ ttysw_pty_output_pending(tty_public, pty)
     Tty             tty_public;
     int             pty;
 {
-    (void) ttysw_pty_output(TTY_PRIVATE_FROM_ANY_PUBLIC(tty_public), pty);
+    Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(tty_public);
+
+    ttysw_use_terminal(ttysw);
+    (void) ttysw_pty_output(ttysw, pty);
     return (NOTIFY_DONE);
 }
 
@@ -325,7 +332,10 @@ ttysw_pty_input_pending(tty_public, pty)
     Tty             tty_public;
     int             pty;
 {
-    (void) ttysw_pty_input(TTY_PRIVATE_FROM_ANY_PUBLIC(tty_public), pty);
+    Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(tty_public);
+
+    ttysw_use_terminal(ttysw);
+    (void) ttysw_pty_input(ttysw, pty);
     return (NOTIFY_DONE);
 }
 
@@ -335,7 +345,10 @@ ttysw_itimer_expired(tty_public, which)
     Tty             tty_public;
     int             which;
 {
-    (void) ttysw_handle_itimer(TTY_PRIVATE_FROM_ANY_PUBLIC(tty_public));
+    Ttysw_folio     ttysw = TTY_PRIVATE_FROM_ANY_PUBLIC(tty_public);
+
+    ttysw_use_terminal(ttysw);
+    (void) ttysw_handle_itimer(ttysw);
     return (NOTIFY_DONE);
 }
 
@@ -348,6 +361,8 @@ ttysw_reset_conditions(ttysw_view)
 {
     register Ttysw_folio ttysw = TTY_FOLIO_FROM_TTY_VIEW_HANDLE(ttysw_view);
     static struct itimerval ttysw_itimerval = {{0, 0}, {0, TTYSW_USEC_DELAY}};
+    static struct itimerval ttysw_refresh_itimerval =
+	{{0, 0}, {0, TTYSW_USEC_REFRESH}};
     register int    pty = ttysw->ttysw_pty;
     Termsw_folio    termsw;
 
@@ -358,11 +373,11 @@ ttysw_reset_conditions(ttysw_view)
     if ((iwbp > irbp && ttysw_pty_output_ok(ttysw)) ||
 	    (ttysw_getopt(ttysw, TTYOPT_TEXT) && termsw != NULL &&
 	    termsw->pty_eot > -1)) {
-	if (!ttysw_waiting_for_pty_output) {
+	if (!ttysw->waiting_for_pty_output) {
 	    /* Wait for output to complete on pty */
 	    (void) notify_set_output_func((Notify_client) (TTY_PUBLIC(ttysw)),
 					  ttysw_pty_output_pending, pty);
-	    ttysw_waiting_for_pty_output = 1;
+	    ttysw->waiting_for_pty_output = 1;
 	    /*
 	     * Pty timer is no longer needed because the pty driver bug that
 	     * causes the ttysw to lock up is fixed.
@@ -370,38 +385,53 @@ ttysw_reset_conditions(ttysw_view)
 	     */
 	}
     } else {
-	if (ttysw_waiting_for_pty_output) {
+	if (ttysw->waiting_for_pty_output) {
 	    /* Don't wait for output to complete on pty any more */
 	    (void) notify_set_output_func((Notify_client) (TTY_PUBLIC(ttysw)),
 					  NOTIFY_FUNC_NULL, pty);
-	    ttysw_waiting_for_pty_output = 0;
+	    ttysw->waiting_for_pty_output = 0;
 	}
     }
-    /* Set pty input pending */
-    if (owbp == orbp) {
-	if (!ttysw_waiting_for_pty_input) {
+    /*
+     * Set pty input pending, unless so much output has come in since the
+     * last refresh that painting has fallen behind: then the program waits
+     * for the next one.
+     */
+    if (owbp == orbp && ttysw_term->parsed < TTYSW_PARSE_AHEAD) {
+	if (!ttysw->waiting_for_pty_input) {
 	    (void) notify_set_input_func((Notify_client) (TTY_PUBLIC(ttysw)),
 					 ttysw_pty_input_pending, pty);
-	    ttysw_waiting_for_pty_input = 1;
+	    ttysw->waiting_for_pty_input = 1;
 	}
     } else {
-	if (ttysw_waiting_for_pty_input) {
+	if (ttysw->waiting_for_pty_input) {
 	    (void) notify_set_input_func((Notify_client) (TTY_PUBLIC(ttysw)),
 					 NOTIFY_FUNC_NULL, pty);
-	    ttysw_waiting_for_pty_input = 0;
+	    ttysw->waiting_for_pty_input = 0;
 	}
     }
     /*
      * Try to optimize displaying by waiting for image to be completely
      * filled after being cleared (vi(^F ^B) page) before painting.
      */
-    if (!ttysw_getopt(ttysw, TTYOPT_TEXT) && delaypainting)
+    if (!ttysw_getopt(ttysw, TTYOPT_TEXT) && delaypainting) {
 	(void) notify_set_itimer_func((Notify_client) (TTY_PUBLIC(ttysw)),
 				      ttysw_itimer_expired,
 				ITIMER_REAL, &ttysw_itimerval, ITIMER_NULL);
+	ttysw_term->refresh_set = TRUE;
+    } else if (ttysw_term->deferred && !ttysw_term->refresh_set) {
+	/*
+	 * Paint the output deferred by ttysw_consume_output when the
+	 * display next refreshes, however much more arrives meanwhile.
+	 */
+	(void) notify_set_itimer_func((Notify_client) (TTY_PUBLIC(ttysw)),
+				      ttysw_itimer_expired,
+			ITIMER_REAL, &ttysw_refresh_itimerval, ITIMER_NULL);
+	ttysw_term->refresh_set = TRUE;
+    }
 #ifdef DEBUG
    printf("ttysw_reset_conditions() waiting_for_pty_output=%d, waiting_for_pty_input=%d\n",
-	ttysw_waiting_for_pty_output, ttysw_waiting_for_pty_input);
+	ttysw->waiting_for_pty_output, ttysw->waiting_for_pty_input);
 #endif
 }
 
@@ -425,6 +455,7 @@ ttysw_prioritizer(tty_public, nfd, ibits_ptr, obits_ptr, ebits_ptr,
     int             count = *event_count_ptr;
 
 
+    ttysw_use_terminal(ttysw);
     ttysw->ttysw_flags |= TTYSW_FL_IN_PRIORITIZER;
     if (*auto_sigbits_ptr) {
 	/* Send itimers */
@@ -12,6 +12,7 @@ static char     sccsid[] = "@(#)ttyansi.c 20.43 93/06/28";
 
 #include <xview_private/ttyansi_.h>
 #include <xview_private/cim_change_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/term_ntfy_.h>
 #include <xview_private/termsw_.h>
@@ -37,6 +38,8 @@ static char     sccsid[] = "@(#)ttyansi.c 20.43 93/06/28";
 #include <xview_private/ev_impl.h>
 #undef CTRL
 #include <xview_private/ttyansi.h>
+#include <xview_private/charimage.h>
+#include <xview_private/charscreen.h>
 
 #include <xview/sel_attrs.h>
 
@@ -51,6 +54,9 @@ static int get_end_of_line(Textsw textsw);
 static int do_linefeed(Textsw textsw);
 static int ansi_lf(Ttysw_view_handle ttysw_view, CHAR *addr, register int len);
 static int ansi_char(Ttysw_view_handle ttysw_view, register CHAR *addr, int olen);
+#ifndef OW_I18N
+static int ansi_printable_span(register CHAR *addr, register int max);
+#endif
 
 /*
  * jcb	-- remove continual cursor repaint in shelltool windows also known to
@@ -71,32 +77,17 @@ int             tty_new_cursor_row, tty_new_cursor_col;
 #define notcontrol(c)	((c >= ' ') && (c != '\177'))
 #endif
 
-/* Logical state of window */
-int             curscol;	/* cursor column */
-int             cursrow;	/* cursor row */
-extern int      cursor;
-/* 0 -> NOCURSOR, 1 -> UNDERCURSOR, 2 -> BLOCKCURSOR */
+/*
+ * The logical state of the window (cursor, dimensions) and of the escape
+ * sequence parser is kept in the current terminal, see charimage.h.
+ */
 
 /* extern  int scroll_disabled_from_menu; */
-static int      state;		/* ALPHA, SKIPPING, etc, possibly w/ |ESC */
-static int      saved_state;
-static int      prefix;		/* prefix to arg */
-static int      scrlins = 1;	/* How many lines to scroll when you have to */
-static int      fillfunc;	/* 0 -> reverse video */
-static CHAR     strtype;        /* type of ansi string sequence */
-
-/* dimensions of window */
-int             ttysw_top;	/* top row of window (0 for now) */
-int             ttysw_bottom;	/* bottom row of window */
-int             ttysw_left;	/* left column of window (0 for now) */
-int             ttysw_right;	/* right column of window */
 
 #ifdef OW_I18N
 /* implement scroll region per Japanese users' requests */
 #define SCROLL(scroll_bottom, bottom)  \
     ((scroll_bottom) ? scroll_bottom : bottom)
-int scroll_bottom = 0; /* to implement scroll region change */
-int pre_edit_rows_scrolled; /* updated in ansi_lf, used in ttysw callbacks */
 #endif
 
 /*
@@ -365,15 +356,15 @@ ttysw_ansi_string(data, type, c)
 void
 ttysw_save_state()
 {
-    saved_state = state;
-    state = S_ALPHA;
+    ttysw_term->saved_state = ttysw_term->state;
+    ttysw_term->state = S_ALPHA;
 }
 
 /* NOT USED */
 void
 ttysw_restore_state()
 {
-    state = saved_state;
+    ttysw_term->state = ttysw_term->saved_state;
 }
 
 
@@ -617,12 +608,6 @@ do_linefeed(textsw)
 #undef BUFSIZE
 }
 
-/*
- * This is a static instead of a return code, for backward compatibility
- * reasons.
- */
-static int      handle_escape_status = 0;
-
 Xv_public int
 ttysw_output(ttysw_public, addr, len0)
     Tty             ttysw_public;
@@ -691,9 +676,7 @@ ttysw_output_it(ttysw_view, addr, len0)
     int             len0;
 {
     Ttysw_folio     ttysw = TTY_FOLIO_FROM_TTY_VIEW_HANDLE(ttysw_view);
-    static int      av[10];	/* args in ESCBRKT sequences.	 */
-    /* -1 => defaulted		 */
-    static int      ac;		/* number of args in av		 */
+    register struct ttysw_terminal *term;
 #define BUFSIZE 8192
     Textsw          textsw;
     Ev_chain	    views;
@@ -704,11 +687,9 @@ ttysw_output_it(ttysw_view, addr, len0)
     CHAR            *cp = buf;
     register int    len = 0;
     int             upper_context;
-#ifdef OW_I18N
-    /* implement save and restore cursor per Japanese users' requests */
-    static int      saved_row, saved_col; /* \E7 and \E8 */
-#endif
 
+    ttysw_use_terminal(ttysw);
+    term = ttysw_term;
     addr[len0] = '\0';
     if (TTY_IS_TERMSW(ttysw)) {
 	textsw = (Textsw) TTY_PUBLIC(ttysw);
@@ -723,92 +704,92 @@ ttysw_output_it(ttysw_view, addr, len0)
     }
     for (; len < len0 && !(ttysw->ttysw_flags & TTYSW_FL_FROZEN);
 	 len++, addr++) {
-	if (state & S_ESC) {
+	if (term->state & S_ESC) {
 	    switch (*addr) {
 	      case NUL:
 	      case DEL:
 		/* all ignored */
 		continue;
 	      case '[':	/* Begin X3.64 escape code sequence */
-		ac = 0;
-		prefix = 0;
-		av[0] = -1;
-		state = S_ESCBRKT;
+		term->ac = 0;
+		term->prefix = 0;
+		term->av[0] = -1;
+		term->state = S_ESCBRKT;
 		continue;
 
 	      case 'P':	/* ANSI Device Control String */
 	      case ']':	/* ANSI Operating System Command */
 	      case '^':	/* ANSI Privacy Message */
 	      case '_':	/* ANSI Application Program Command */
-		state = S_STRING;
-		strtype = *addr;
+		term->state = S_STRING;
+		term->strtype = *addr;
 		continue;
 
 	      case '?':
 		/* simulate DEL char for systems that can't xmit it. */
 		*addr = DEL;
-		state &= ~S_ESC;
+		term->state &= ~S_ESC;
 		break;
 
 #ifdef OW_I18N
               case '7': /* \E7 is save cursor */
-                        saved_row = cursrow;
-                        saved_col = curscol;
-                        state &= ~S_ESC;
+                        term->saved_row = cursrow;
+                        term->saved_col = curscol;
+                        term->state &= ~S_ESC;
                         continue;
 
               case '8': /* \E8 is restore cursor */
-                        ttysw_pos(saved_col, saved_row);
-                        state &= ~S_ESC;
+                        ttysw_pos(term->saved_col, term->saved_row);
+                        term->state &= ~S_ESC;
                         continue;
 #endif
 
 	      case '\\':	/* ANSI string terminator */
-		if (state == (S_STRING | S_ESC)) {
-		    ttysw_handlestring(ttysw, strtype, 0);
-		    state = S_ALPHA;
+		if (term->state == (S_STRING | S_ESC)) {
+		    ttysw_handlestring(ttysw, term->strtype, 0);
+		    term->state = S_ALPHA;
 		    continue;
 		}
 		/* FALL THROUGH */
 
 	      default:
-		state &= ~S_ESC;
+		term->state &= ~S_ESC;
 		continue;
 	    }
 	}
-	switch (state) {
+	switch (term->state) {
 	  case S_ESCBRKT:
-	    if (prefix == 0 && *addr >= '<' && *addr <= '?')
-		prefix = *addr;
+	    if (term->prefix == 0 && *addr >= '<' && *addr <= '?')
+		term->prefix = *addr;
 	    else if (*addr >= '0' && *addr <= '9') {
-		if (av[ac] == -1)
-		    av[ac] = 0;
-		av[ac] = ((short) av[ac]) * 10 + *addr - '0';
+		if (term->av[term->ac] == -1)
+		    term->av[term->ac] = 0;
+		term->av[term->ac] = ((short) term->av[term->ac]) * 10 + *addr - '0';
 		/* short for inline muls */
 	    } else if (*addr == ';') {
-		av[ac] |= prefix << 24;
-		ac++;
-		av[ac] = -1;
-		prefix = 0;
+		term->av[term->ac] |= term->prefix << 24;
+		term->ac++;
+		term->av[term->ac] = -1;
+		term->prefix = 0;
 	    } else {
 		/* XXX - should only terminate on valid end char */
-		av[ac] |= prefix << 24;
-		ac++;
-		switch (ttysw_handleescape(ttysw_view, *addr, ac, av)) {
+		term->av[term->ac] |= term->prefix << 24;
+		term->ac++;
+		switch (ttysw_handleescape(ttysw_view, *addr, term->ac, term->av)) {
 		  case TTY_OK:
-		    state = S_SKIPPING;
+		    term->state = S_SKIPPING;
 		  case TTY_DONE:
-		    state = S_ALPHA;
+		    term->state = S_ALPHA;
 		  default:{
 		    }
 		}
-		if (handle_escape_status) {
-		    handle_escape_status = 0;
+		if (term->handle_escape_status) {
+		    term->handle_escape_status = 0;
 		    (void) ttysw_setopt((Ttysw_folio) ttysw_view, TTYOPT_TEXT, 0);
 		    return (0);
 		}
-		ac = 0;
-		prefix = 0;
+		term->ac = 0;
+		term->prefix = 0;
 	    }
 	    break;
 
@@ -816,23 +797,23 @@ ttysw_output_it(ttysw_view, addr, len0)
 	    /* Waiting for char from cols 4-7 to end esc string */
 	    if (*addr < '@')
 		break;
-	    state = S_ALPHA;
+	    term->state = S_ALPHA;
 	    break;
 
 	  case S_STRING:
 	    if (notcontrol(*addr))
-		ttysw_handlestring(ttysw, strtype, *addr);
+		ttysw_handlestring(ttysw, term->strtype, *addr);
 	    else if (*addr == CTRL('['))
-		state |= S_ESC;
+		term->state |= S_ESC;
 	    break;
 
 	  case S_ALPHA:
 	  default:
 	    if (ttysw_getopt(ttysw, TTYOPT_TEXT)) {
-		state = S_ALPHA;
+		term->state = S_ALPHA;
 		switch (*addr) {
 		  case CTRL('['):	/* Escape */
-		    state |= S_ESC;
+		    term->state |= S_ESC;
 		    /* spit out what we have so far */
 		    cp = from_pty_to_textsw(textsw, cp, buf);
     		    if (TTY_IS_TERMSW(ttysw)) {
@@ -846,7 +827,6 @@ ttysw_output_it(ttysw_view, addr, len0)
 		    }
 		    break;
 		  case CTRL('G'):{
-			extern Xv_Window csr_pixwin;
 			Xv_Window       tmp_pixwin = csr_pixwin;
 			csr_pixwin = textsw;
 			ttysw_blinkscreen();
@@ -1096,7 +1076,7 @@ ttysw_output_it(ttysw_view, addr, len0)
 		    curscol = 0;
 		    break;
 		  case CTRL('['):
-		    state |= S_ESC;
+		    term->state |= S_ESC;
 		    break;
 		  case DEL:	/* ignored */
 		    break;
@@ -1111,7 +1091,7 @@ ttysw_output_it(ttysw_view, addr, len0)
 		    }
 		}
 	    }			/* if (TTYOPT_TEXT) */
-	}			/* switch (state) */
+	}			/* switch (term->state) */
     }				/* for (; *addr; addr++) */
 ret:
     if (ttysw_getopt(ttysw, TTYOPT_TEXT)) {
@@ -1141,7 +1121,7 @@ Pkg_private void
 ttysw_lighten_cursor()
 {
     (void) ttysw_removeCursor();
-    cursor |= LIGHTCURSOR;
+    ttysw_term->cursor |= LIGHTCURSOR;
     (void) ttysw_restoreCursor();
 }
 
@@ -1149,7 +1129,7 @@ Pkg_private void
 ttysw_restore_cursor()
 {
     (void) ttysw_removeCursor();
-    cursor &= ~LIGHTCURSOR;
+    ttysw_term->cursor &= ~LIGHTCURSOR;
     (void) ttysw_restoreCursor();
 }
 
@@ -1160,11 +1140,10 @@ ansi_lf(ttysw_view, addr, len)
     register int    len;
 {
     register Ttysw_folio ttysw = TTY_FOLIO_FROM_TTY_VIEW_HANDLE(ttysw_view);
-    register int    lfs = scrlins;
-    extern int      delaypainting;
+    register int    lfs = ttysw_term->scrlins;
 
 #ifdef OW_I18N
-    if (ttysw->ttysw_lpp >= (SCROLL(scroll_bottom, ttysw_bottom))) {
+    if (ttysw->ttysw_lpp >= (SCROLL(ttysw_term->scroll_bottom, ttysw_bottom))) {
 #else
     if (ttysw->ttysw_lpp >= ttysw_bottom) {
 #endif
@@ -1172,7 +1151,7 @@ ansi_lf(ttysw_view, addr, len)
 	    return (0);
     }
 #ifdef OW_I18N
-    if (cursrow < (SCROLL(scroll_bottom, ttysw_bottom) - 1)) {
+    if (cursrow < (SCROLL(ttysw_term->scroll_bottom, ttysw_bottom) - 1)) {
 #else
     if (cursrow < ttysw_bottom - 1) {
 #endif
@@ -1180,12 +1159,12 @@ ansi_lf(ttysw_view, addr, len)
 	cursrow++;
 	if (ttysw->ttysw_opt & (1 << TTYOPT_PAGEMODE))
 	    ttysw->ttysw_lpp++;
-	if (!scrlins)		/* ...clear line */
+	if (!ttysw_term->scrlins)		/* ...clear line */
 	    (void) ttysw_deleteChar(ttysw_left, ttysw_right, cursrow);
     } else {
 	if (delaypainting)
 	    (void) ttysw_pdisplayscreen(1);
-	if (!scrlins) {		/* Just wrap to top of screen and clr line */
+	if (!ttysw_term->scrlins) {		/* Just wrap to top of screen and clr line */
 	    ttysw_pos(curscol, 0);
 	    (void) ttysw_deleteChar(ttysw_left, ttysw_right, cursrow);
 	} else {
@@ -1205,8 +1184,8 @@ ansi_lf(ttysw_view, addr, len)
 	    }
 #ifdef OW_I18N
             if (lfs + ttysw->ttysw_lpp >
-                SCROLL(scroll_bottom, ttysw_bottom))
-                    lfs = SCROLL(scroll_bottom, ttysw_bottom)
+                SCROLL(ttysw_term->scroll_bottom, ttysw_bottom))
+                    lfs = SCROLL(ttysw_term->scroll_bottom, ttysw_bottom)
                         - ttysw->ttysw_lpp;
 #else
 	    if (lfs + ttysw->ttysw_lpp > ttysw_bottom)
@@ -1222,6 +1201,7 @@ ansi_lf(ttysw_view, addr, len)
     return (lfs);
 }
 
+#ifdef OW_I18N
 static int
 ansi_char(ttysw_view, addr, olen)
     Ttysw_view_handle ttysw_view;
@@ -1232,32 +1212,21 @@ ansi_char(ttysw_view, addr, olen)
     CHAR            buf[300];
     register CHAR   *cp = &buf[0];
     int             curscolstart = curscol;
-#ifdef  OW_I18N
     int             colwidth; /* column width of a char */
-#endif
 
     for (;;) {
 	*cp++ = *addr;
-#ifdef  OW_I18N
         colwidth = tty_character_size( *addr );
-#endif
 	/* Update cursor position.  Inline for speed. */
-#ifdef  OW_I18N
         if (curscol < ttysw_right - colwidth)
             curscol += colwidth;
-#else
-	if (curscol < ttysw_right - 1)
-	    curscol++;
-#endif
 	else {
 	    /* Wrap to col 1 then pretend LF seen */
-#ifdef OW_I18N
 	    if ( curscol + colwidth > ttysw_right ) {
 		*cp--;
 		addr--;
 		len++;
 	    }
-#endif
             *cp = (CHAR)'\0';
 	    (void) ttysw_writePartialLine(buf, curscolstart);
 	    curscol = 0;
@@ -1266,11 +1235,7 @@ ansi_char(ttysw_view, addr, olen)
 	}
 	if (len > 0) {
 	    if (notcontrol(*(addr + 1))
-#ifdef OW_I18N
                 && cp < &buf[sizeof(buf) / sizeof(CHAR) - 1]) {
-#else
-		&& cp < &buf[sizeof(buf) - 1]) {
-#endif
 		len--;
 		addr++;
 		continue;
@@ -1284,6 +1249,73 @@ ansi_char(ttysw_view, addr, olen)
     return (olen - len);
 }
 
+#else /* OW_I18N */
+
+/*
+ * Word at a time tests for a byte below ' ', or above '~' (which also
+ * catches DEL and eight bit characters), in a word.
+ */
+#define ANSI_ONES		(~0UL / 255)
+#define ANSI_HIGHS		(ANSI_ONES * 0x80)
+#define ANSI_HAS_LESS(w, n)	(((w) - ANSI_ONES * (n)) & ~(w) & ANSI_HIGHS)
+#define ANSI_HAS_MORE(w, n)	((((w) + ANSI_ONES * (127 - (n))) | (w)) & ANSI_HIGHS)
+
+/*
+ * Returns how many of the (at most max) characters at addr are printable.
+ * Plain ASCII text is classified a word at a time; anything else falls
+ * back to notcontrol() one character at a time.
+ */
+static int
+ansi_printable_span(addr, max)
+    register CHAR  *addr;
+    register int    max;
+{
+    register int    n = 0;
+    unsigned long   word;
+
+    for (;;) {
+	while (n + (int) sizeof(word) <= max) {
+	    (void) memcpy((char *) &word, addr + n, sizeof(word));
+	    if (ANSI_HAS_LESS(word, ' ') | ANSI_HAS_MORE(word, '~'))
+		break;
+	    n += sizeof(word);
+	}
+	if (n < max && notcontrol(addr[n]))
+	    n++;
+	else
+	    return (n);
+    }
+}
+
+/*
+ * Write the run of printable characters starting at addr (olen characters
+ * are left, addr included) that fits on the rest of the line straight into
+ * the character image, and wrap if it reaches the right margin.  Returns how
+ * many characters past addr were used.
+ */
+static int
+ansi_char(ttysw_view, addr, olen)
+    Ttysw_view_handle ttysw_view;
+    register CHAR  *addr;
+    int             olen;
+{
+    register int    count, room = ttysw_right - curscol;
+
+    if (room < 1)
+	room = 1;
+    count = ansi_printable_span(addr, MIN(olen, room));
+    (void) ttysw_writeChars(addr, count, curscol);
+    if (curscol + count < ttysw_right) {
+	curscol += count;
+	return (count - 1);
+    }
+    /* Wrap to col 1 then pretend LF seen */
+    curscol = 0;
+    (void) ansi_lf(ttysw_view, addr + count - 1, olen - count + 1);
+    return (count - 1);
+}
+#endif /* OW_I18N */
+
 Pkg_private int
 ttysw_ansi_escape(ttysw_view_public, c, ac, av)
     Tty_view        ttysw_view_public;
@@ -1379,28 +1411,28 @@ ttysw_ansi_escape(ttysw_view_public, c, ac, av)
 	    }
 	    break;
 	  case 'p':
-	    if (!fillfunc) {
+	    if (!ttysw_term->fillfunc) {
 		(void) ttysw_screencomp();
-		fillfunc = 1 - fillfunc;
+		ttysw_term->fillfunc = 1 - ttysw_term->fillfunc;
 	    }
 	    break;
 	  case 'q':
-	    if (fillfunc) {
+	    if (ttysw_term->fillfunc) {
 		(void) ttysw_screencomp();
-		fillfunc = 1 - fillfunc;
+		ttysw_term->fillfunc = 1 - ttysw_term->fillfunc;
 	    }
 	    break;
 	  case 'r':
 #ifdef OW_I18N
-            ttysw_cim_scroll(SCROLL(scroll_bottom, ttysw_bottom) -av[1]);
-            scroll_bottom = av[1];
-            ttysw_pos(curscol, scroll_bottom - 1);
+            ttysw_cim_scroll(SCROLL(ttysw_term->scroll_bottom, ttysw_bottom) -av[1]);
+            ttysw_term->scroll_bottom = av[1];
+            ttysw_pos(curscol, ttysw_term->scroll_bottom - 1);
 #else
-	    scrlins = av0;
+	    ttysw_term->scrlins = av0;
 #endif
 	    break;
 	  case 's':
-	    scrlins = 1;
+	    ttysw_term->scrlins = 1;
 	    (void) ttysw_clear_mode();
 	    break;
 	  default:
@@ -1419,7 +1451,7 @@ ttysw_ansi_escape(ttysw_view_public, c, ac, av)
 				textsw_find_mark_i18n(textsw, termsw->user_mark)
 				- (Textsw_index) termsw->pty_owes_newline :
                           (Textsw_index) xv_get(textsw, TEXTSW_LENGTH_I18N))) {
-		        handle_escape_status = 1;
+		        ttysw_term->handle_escape_status = 1;
 		    }
 		}
 	    } else {
@@ -1434,7 +1466,7 @@ ttysw_ansi_escape(ttysw_view_public, c, ac, av)
 		    if (erase_chars(textsw,
 				textsw_find_mark_i18n(textsw, termsw->pty_mark),
 				(Textsw_index) get_end_of_line(textsw))) {
-		        handle_escape_status = 1;
+		        ttysw_term->handle_escape_status = 1;
 		    }
 		}
 	    } else {
@@ -11,6 +11,7 @@ static char     sccsid[] = "@(#)ttyselect.c 20.47 93/06/29";
  */
 
 #include <xview_private/ttyselect_.h>
+#include <xview_private/cim_size_.h>
 #include <xview_private/csr_change_.h>
 #include <xview_private/defaults_.h>
 #include <xview_private/getlogindr_.h>
@@ -756,7 +757,6 @@ static void
 my_write_string(start, end, row)
     int             start, end, row;
 {
-    extern char     boldify;
     CHAR           *str = image[row];
     CHAR            temp_char = (CHAR)'\0';
 #ifdef OW_I18N
@@ -1245,6 +1245,7 @@ ttysel_function(ttysw, buffer)
     Seln_response   response;
     Seln_holder    *holder;
 
+    ttysw_use_terminal(ttysw);
     response = seln_figure_response(buffer, &holder);
     switch (response) {
       case SELN_IGNORE:
@@ -1417,6 +1418,7 @@ ttysel_reply(request, context, buffer_length)
     struct ttyselection *ttysel;
 
     ttysw = (struct ttysubwindow *) context->client_data;
+    ttysw_use_terminal(ttysw);
     ttysel = ttysel_from_rank(ttysw, context->rank);
 #ifndef OW_I18N		/* ??? */
     if (!ttysel->sel_made) {
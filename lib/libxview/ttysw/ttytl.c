@@ -40,6 +40,7 @@ static char     sccsid[] = "@(#)ttytl.c 20.42 93/06/28";
 #endif
 #include <xview_private/tty_impl.h>
 #include <xview_private/term_impl.h>
+#include <xview_private/charimage.h>
 #include <xview_private/charscreen.h>
 
 